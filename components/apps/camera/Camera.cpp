@@ -27,6 +27,9 @@
 #include "app_video.h"
 #include "app_pedestrian_detect.h"
 #include "app_humanface_detect.h"
+#include "app_detect_overlay.h"
+#include "app_video_plane.h"
+#include "display/app_ui_perf.h"
 #include "app_camera_pipeline.hpp"
 #include "Camera.hpp"
 #include "ui/ui.h"
@@ -52,9 +55,11 @@ static const char *TAG = "Camera";
 
 // AI detection variables
 // static void **detect_buf;
-static vector<vector<int>> detect_bound;
-static vector<vector<int>> detect_keypoints;
 static std::list<dl::detect::result_t> detect_results;
+static std::list<dl::detect::result_t> overlay_results;
+static bool overlay_dirty = false;
+static detect_overlay_t *detect_overlay = NULL;
+static app_video_plane_t *video_plane = NULL;
 static PedestrianDetect *ped_detect = NULL;
 static HumanFaceDetect *hum_detect = NULL;
 static pipeline_handle_t feed_pipeline;
@@ -118,6 +123,8 @@ bool Camera::run(void)
     // UI initialization
     ui_camera_init();
 
+    detect_overlay = app_detect_overlay_create(ui_ImageCameraShotImage, _hor_res, _ver_res);
+
     // The following is the additional UI initialization
     _img_album_buffer = (uint8_t *)heap_caps_aligned_alloc(128, _img_refresh_dsc.data_size, MALLOC_CAP_SPIRAM);
     if (_img_album_buffer == NULL) {
@@ -199,6 +206,23 @@ bool Camera::run(void)
 
     }, LV_EVENT_CLICKED, this);
 
+#if CONFIG_APP_VIDEO_PLANE_ENABLE
+    // Frames and detection boxes go straight to the frame buffers, the image only keeps its place
+    if (app_video_plane_new(lv_disp_get_default(), &video_plane) == ESP_OK) {
+        lv_area_t image_area;
+        lv_obj_update_layout(ui_ImageCameraShotImage);
+        lv_obj_get_coords(ui_ImageCameraShotImage, &image_area);
+        app_video_plane_set_window(video_plane, &image_area, 0, 0);
+        app_video_plane_exclude(video_plane, ui_PanelCameraShotControlBg);
+        app_video_plane_exclude(video_plane, ui_PanelCameraShotAlbum);
+        app_video_plane_exclude(video_plane, ui_ButtonCameraShotBtn);
+        app_video_plane_exclude(video_plane, mode_switch_btn);
+        lv_obj_set_style_img_opa(ui_ImageCameraShotImage, LV_OPA_TRANSP, 0);
+    } else {
+        video_plane = NULL;
+    }
+#endif
+
     return true;
 }
 
@@ -233,6 +257,11 @@ bool Camera::close(void)
     app_video_stream_task_stop(_camera_ctlr_handle);
     app_video_stream_wait_stop();
 
+    app_detect_overlay_delete(detect_overlay);
+    detect_overlay = NULL;
+    app_video_plane_delete(video_plane);
+    video_plane = NULL;
+
     if (_img_album_buffer) {
         heap_caps_free(_img_album_buffer);
         _img_album_buffer = NULL;
@@ -458,61 +487,50 @@ static void camera_video_frame_operation(uint8_t *camera_buf, uint8_t camera_buf
             camera_pipeline_done_element(feed_pipeline, input_element);
         }
 
-        // Get detection results
+        // Get detection results, they are shown on the overlay layer and never painted into camera_buf
         camera_pipeline_buffer_element *detect_element = camera_pipeline_recv_element(detect_pipeline, 0);
         if (detect_element) {
-            // Process detection results
-            detect_keypoints.clear();
-            detect_bound.clear();
-            
+            overlay_results.clear();
+
             for (const auto& res : *(detect_element->detect_results)) {
                 const auto& box = res.box;
                 // Check if bounding box is valid
                 if (box.size() >= 4 && std::any_of(box.begin(), box.end(), [](int v) { return v != 0; })) {
-                    detect_bound.push_back(box);
-
-                    // Process keypoints only in face detection mode
-                    if ((current_bits & CAMERA_EVENT_HUMAN_DETECT) && 
-                        res.keypoint.size() >= 10 && 
-                        std::any_of(res.keypoint.begin(), res.keypoint.end(), [](int v) { return v != 0; })) {
-                        detect_keypoints.push_back(res.keypoint);
-                    }
+                    overlay_results.push_back(res);
                 }
             }
+            overlay_dirty = true;
 
             camera_pipeline_queue_element_index(detect_pipeline, detect_element->index);
         }
-
-        // Draw detection results
-        uint16_t *rgb_buf = reinterpret_cast<uint16_t*>(camera_buf);
-        for (size_t i = 0; i < detect_bound.size(); i++) {
-            const auto& bound = detect_bound[i];
-            // Check if current bounding box is valid
-            if (bound.size() >= 4 && std::any_of(bound.begin(), bound.end(), [](int v) { return v != 0; })) {
-                // Draw bounding box
-                draw_rectangle_rgb(rgb_buf, camera_buf_hes, camera_buf_ves,
-                                 bound[0], bound[1], bound[2], bound[3],
-                                 0, 0, 255, 0, 0, 3);
-
-                // Draw keypoints in face detection mode
-                if ((current_bits & CAMERA_EVENT_HUMAN_DETECT) && 
-                    i < detect_keypoints.size() && 
-                    detect_keypoints[i].size() >= 10) {
-                    draw_green_points(rgb_buf, detect_keypoints[i]);
-                }
-            }
-        }
+    } else if (!overlay_results.empty()) {
+        overlay_results.clear();
+        overlay_dirty = true;
     }
 
     // Update display if not in delete state
+    int64_t show_start = esp_timer_get_time();
     if (!(current_bits & CAMERA_EVENT_DELETE) && bsp_display_lock(100)) {
-        if (ui_ImageCameraShotImage) {
-            lv_canvas_set_buffer(ui_ImageCameraShotImage, camera_buf, 
-                               camera_buf_hes, camera_buf_ves, 
-                               LV_IMG_CF_TRUE_COLOR);
+        if (video_plane) {
+            if (overlay_dirty) {
+                app_video_plane_set_boxes(video_plane, overlay_results, current_bits & CAMERA_EVENT_HUMAN_DETECT);
+                overlay_dirty = false;
+            }
+            app_video_plane_draw(video_plane, camera_buf, camera_buf_hes, camera_buf_ves);
+        } else {
+            if (ui_ImageCameraShotImage) {
+                lv_canvas_set_buffer(ui_ImageCameraShotImage, camera_buf, 
+                                   camera_buf_hes, camera_buf_ves, 
+                                   LV_IMG_CF_TRUE_COLOR);
+            }
+            if (overlay_dirty) {
+                app_detect_overlay_update(detect_overlay, overlay_results, current_bits & CAMERA_EVENT_HUMAN_DETECT);
+                overlay_dirty = false;
+            }
+            lv_refr_now(NULL);
         }
-        lv_refr_now(NULL);
         bsp_display_unlock();
+        app_ui_perf_preview_frame(esp_timer_get_time() - show_start);
     }
 
 #if FPS_PRINT
@@ -0,0 +1,201 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "app_detect_overlay.h"
+
+#define OVERLAY_BOX_BORDER_WIDTH            (3)
+#define OVERLAY_KEYPOINT_SIZE               (7)
+
+static const char *TAG = "app_detect_overlay";
+
+typedef struct {
+    lv_area_t area;
+    bool visible;
+} overlay_item_state_t;
+
+struct detect_overlay_t {
+    lv_obj_t *parent;
+    uint32_t src_width;
+    uint32_t src_height;
+    lv_obj_t *boxes[DETECT_OVERLAY_BOX_MAX];
+    lv_obj_t *points[DETECT_OVERLAY_BOX_MAX * DETECT_OVERLAY_KEYPOINT_NUM];
+    overlay_item_state_t box_state[DETECT_OVERLAY_BOX_MAX];
+    overlay_item_state_t point_state[DETECT_OVERLAY_BOX_MAX * DETECT_OVERLAY_KEYPOINT_NUM];
+};
+
+static lv_style_t style_box;
+static lv_style_t style_point;
+static bool style_inited = false;
+
+static void overlay_style_init(void)
+{
+    if (style_inited) {
+        return;
+    }
+
+    lv_style_init(&style_box);
+    lv_style_set_bg_opa(&style_box, LV_OPA_TRANSP);
+    lv_style_set_border_color(&style_box, lv_color_hex(0xFF0000));
+    lv_style_set_border_width(&style_box, OVERLAY_BOX_BORDER_WIDTH);
+    lv_style_set_border_opa(&style_box, LV_OPA_COVER);
+    lv_style_set_radius(&style_box, 0);
+
+    lv_style_init(&style_point);
+    lv_style_set_bg_color(&style_point, lv_color_hex(0x00FF00));
+    lv_style_set_bg_opa(&style_point, LV_OPA_COVER);
+    lv_style_set_radius(&style_point, 0);
+
+    style_inited = true;
+}
+
+static lv_obj_t *overlay_item_create(lv_obj_t *parent, lv_style_t *style)
+{
+    lv_obj_t *obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(obj);
+    lv_obj_add_style(obj, style, 0);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(obj, LV_OBJ_FLAG_IGNORE_LAYOUT | LV_OBJ_FLAG_HIDDEN);
+
+    return obj;
+}
+
+static void overlay_item_show(lv_obj_t *obj, overlay_item_state_t *state, const lv_area_t *area)
+{
+    if (!state->visible || !_lv_area_is_equal(&state->area, area)) {
+        lv_obj_set_pos(obj, area->x1, area->y1);
+        lv_obj_set_size(obj, lv_area_get_width(area), lv_area_get_height(area));
+        state->area = *area;
+    }
+    if (!state->visible) {
+        lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        state->visible = true;
+    }
+}
+
+static void overlay_item_hide(lv_obj_t *obj, overlay_item_state_t *state)
+{
+    if (state->visible) {
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+        state->visible = false;
+    }
+}
+
+detect_overlay_t *app_detect_overlay_create(lv_obj_t *parent, uint32_t src_width, uint32_t src_height)
+{
+    if (parent == NULL || src_width == 0 || src_height == 0) {
+        ESP_LOGE(TAG, "Invalid overlay arguments");
+        return NULL;
+    }
+
+    detect_overlay_t *overlay = (detect_overlay_t *)heap_caps_calloc(1, sizeof(detect_overlay_t), MALLOC_CAP_DEFAULT);
+    if (overlay == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate overlay");
+        return NULL;
+    }
+
+    overlay_style_init();
+
+    overlay->parent = parent;
+    overlay->src_width = src_width;
+    overlay->src_height = src_height;
+
+    for (int i = 0; i < DETECT_OVERLAY_BOX_MAX; i++) {
+        overlay->boxes[i] = overlay_item_create(parent, &style_box);
+    }
+    for (int i = 0; i < DETECT_OVERLAY_BOX_MAX * DETECT_OVERLAY_KEYPOINT_NUM; i++) {
+        overlay->points[i] = overlay_item_create(parent, &style_point);
+    }
+
+    return overlay;
+}
+
+void app_detect_overlay_update(detect_overlay_t *overlay, const std::list<dl::detect::result_t> &results, bool show_keypoints)
+{
+    if (overlay == NULL) {
+        return;
+    }
+
+    lv_coord_t dst_width = lv_obj_get_width(overlay->parent);
+    lv_coord_t dst_height = lv_obj_get_height(overlay->parent);
+    int box_num = 0;
+    int point_num = 0;
+
+    for (const auto &res : results) {
+        if (box_num >= DETECT_OVERLAY_BOX_MAX) {
+            break;
+        }
+        if (res.box.size() < 4) {
+            continue;
+        }
+
+        lv_area_t area;
+        area.x1 = res.box[0] * dst_width / (int)overlay->src_width;
+        area.y1 = res.box[1] * dst_height / (int)overlay->src_height;
+        area.x2 = res.box[2] * dst_width / (int)overlay->src_width;
+        area.y2 = res.box[3] * dst_height / (int)overlay->src_height;
+        if (area.x2 <= area.x1 || area.y2 <= area.y1) {
+            continue;
+        }
+        overlay_item_show(overlay->boxes[box_num], &overlay->box_state[box_num], &area);
+        box_num++;
+
+        if (!show_keypoints || res.keypoint.size() < DETECT_OVERLAY_KEYPOINT_NUM * 2) {
+            continue;
+        }
+        for (int k = 0; k < DETECT_OVERLAY_KEYPOINT_NUM; k++) {
+            lv_coord_t x = res.keypoint[2 * k] * dst_width / (int)overlay->src_width;
+            lv_coord_t y = res.keypoint[2 * k + 1] * dst_height / (int)overlay->src_height;
+            lv_area_t point = {
+                .x1 = (lv_coord_t)(x - OVERLAY_KEYPOINT_SIZE / 2),
+                .y1 = (lv_coord_t)(y - OVERLAY_KEYPOINT_SIZE / 2),
+                .x2 = (lv_coord_t)(x + OVERLAY_KEYPOINT_SIZE / 2),
+                .y2 = (lv_coord_t)(y + OVERLAY_KEYPOINT_SIZE / 2),
+            };
+            overlay_item_show(overlay->points[point_num], &overlay->point_state[point_num], &point);
+            point_num++;
+        }
+    }
+
+    for (int i = box_num; i < DETECT_OVERLAY_BOX_MAX; i++) {
+        overlay_item_hide(overlay->boxes[i], &overlay->box_state[i]);
+    }
+    for (int i = point_num; i < DETECT_OVERLAY_BOX_MAX * DETECT_OVERLAY_KEYPOINT_NUM; i++) {
+        overlay_item_hide(overlay->points[i], &overlay->point_state[i]);
+    }
+}
+
+void app_detect_overlay_clear(detect_overlay_t *overlay)
+{
+    if (overlay == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < DETECT_OVERLAY_BOX_MAX; i++) {
+        overlay_item_hide(overlay->boxes[i], &overlay->box_state[i]);
+    }
+    for (int i = 0; i < DETECT_OVERLAY_BOX_MAX * DETECT_OVERLAY_KEYPOINT_NUM; i++) {
+        overlay_item_hide(overlay->points[i], &overlay->point_state[i]);
+    }
+}
+
+void app_detect_overlay_delete(detect_overlay_t *overlay)
+{
+    if (overlay == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < DETECT_OVERLAY_BOX_MAX; i++) {
+        lv_obj_del(overlay->boxes[i]);
+    }
+    for (int i = 0; i < DETECT_OVERLAY_BOX_MAX * DETECT_OVERLAY_KEYPOINT_NUM; i++) {
+        lv_obj_del(overlay->points[i]);
+    }
+
+    heap_caps_free(overlay);
+}
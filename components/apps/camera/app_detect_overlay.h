@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <list>
+#include "lvgl.h"
+#include "dl_detect_base.hpp"
+
+#define DETECT_OVERLAY_BOX_MAX              (10)
+#define DETECT_OVERLAY_KEYPOINT_NUM         (5)
+
+typedef struct detect_overlay_t detect_overlay_t;
+
+/**
+ * @brief Create a detection overlay layer on top of a camera preview object.
+ *
+ * Boxes and keypoints are rendered as a small pool of LVGL objects that are children of
+ * the preview object, so the camera frame buffers are never written to. Detection
+ * coordinates are given in source frame pixels and scaled to the size of the parent.
+ *
+ * Must be called with the display lock held.
+ *
+ * @param parent     Object showing the camera frame (canvas or image).
+ * @param src_width  Width of the frames the detection coordinates refer to.
+ * @param src_height Height of the frames the detection coordinates refer to.
+ * @return Overlay handle, or NULL if allocation failed.
+ */
+detect_overlay_t *app_detect_overlay_create(lv_obj_t *parent, uint32_t src_width, uint32_t src_height);
+
+/**
+ * @brief Show the latest detection results on the overlay.
+ *
+ * Only objects whose geometry changed are touched, unused pool entries are hidden.
+ * Must be called with the display lock held.
+ *
+ * @param overlay        Overlay handle.
+ * @param results        Detection results in source frame coordinates.
+ * @param show_keypoints Draw the five face keypoints of each result when available.
+ */
+void app_detect_overlay_update(detect_overlay_t *overlay, const std::list<dl::detect::result_t> &results, bool show_keypoints);
+
+/**
+ * @brief Hide every box and keypoint of the overlay.
+ *
+ * Must be called with the display lock held.
+ *
+ * @param overlay Overlay handle.
+ */
+void app_detect_overlay_clear(detect_overlay_t *overlay);
+
+/**
+ * @brief Delete the overlay and its LVGL objects.
+ *
+ * Must be called with the display lock held, before the parent object is deleted.
+ *
+ * @param overlay Overlay handle.
+ */
+void app_detect_overlay_delete(detect_overlay_t *overlay);
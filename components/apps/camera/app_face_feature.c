@@ -0,0 +1,278 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "img_kernels.h"
+#include "app_face_feature.h"
+
+static const char *TAG = "app_face_feature";
+
+/* Eye positions in the aligned crop */
+#define CROP_EYE_LEFT_X             (20.0f)
+#define CROP_EYE_RIGHT_X            (44.0f)
+#define CROP_EYE_Y                  (24.0f)
+
+#define HOG_CELLS                   (4)
+#define HOG_BINS                    (8)
+#define HOG_CELL_SIZE               (APP_FACE_CROP_SIZE / HOG_CELLS)
+#define HOG_CLIP                    (0.2f)
+
+/* Quality references */
+#define QUALITY_EYE_DIST_MIN        (16.0f)           /* Eye distance (frame pixels) scoring 0 */
+#define QUALITY_EYE_DIST_GOOD       (48.0f)           /* Eye distance (frame pixels) scoring 1 */
+#define QUALITY_SHARPNESS_GOOD      (120.0f)          /* Laplacian variance scoring 1 */
+#define QUALITY_CLIP_LOW            (16)
+#define QUALITY_CLIP_HIGH           (240)
+
+#define KP_LEFT_EYE                 (0)
+#define KP_LEFT_MOUTH               (2)
+#define KP_NOSE                     (4)
+#define KP_RIGHT_EYE                (6)
+#define KP_RIGHT_MOUTH              (8)
+
+struct app_face_feature_t {
+    img_buf_t crop;
+};
+
+static inline float clampf(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+esp_err_t app_face_feature_new(app_face_feature_t **ret_feature)
+{
+    ESP_RETURN_ON_FALSE(ret_feature, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    app_face_feature_t *feature = (app_face_feature_t *)heap_caps_calloc(1, sizeof(app_face_feature_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(feature, ESP_ERR_NO_MEM, TAG, "Failed to allocate feature extractor");
+
+    void *crop_data = heap_caps_malloc(APP_FACE_CROP_SIZE * APP_FACE_CROP_SIZE, MALLOC_CAP_DEFAULT);
+    if (crop_data == NULL) {
+        heap_caps_free(feature);
+        ESP_LOGE(TAG, "Failed to allocate crop buffer");
+        return ESP_ERR_NO_MEM;
+    }
+    img_buf_init(&feature->crop, crop_data, APP_FACE_CROP_SIZE, APP_FACE_CROP_SIZE, IMG_FMT_Y8);
+
+    *ret_feature = feature;
+    return ESP_OK;
+}
+
+void app_face_feature_delete(app_face_feature_t *feature)
+{
+    if (feature == NULL) {
+        return;
+    }
+
+    heap_caps_free(feature->crop.data);
+    heap_caps_free(feature);
+}
+
+static float quality_exposure(const img_buf_t *crop)
+{
+    uint32_t sum = 0;
+    uint32_t clipped = 0;
+    int n = crop->width * crop->height;
+
+    for (int i = 0; i < n; i++) {
+        uint8_t p = crop->data[i];
+        sum += p;
+        clipped += (p < QUALITY_CLIP_LOW || p > QUALITY_CLIP_HIGH) ? 1 : 0;
+    }
+
+    float mean = (float)sum / n;
+    float level = 1.0f - fabsf(mean - 128.0f) / 128.0f;
+    float clip = 1.0f - 2.0f * clipped / n;
+    return clampf(level, 0.0f, 1.0f) * clampf(clip, 0.0f, 1.0f);
+}
+
+static float quality_pose(const int *kp, float eye_dist)
+{
+    float eye_mid_x = (kp[KP_LEFT_EYE] + kp[KP_RIGHT_EYE]) * 0.5f;
+    float eye_mid_y = (kp[KP_LEFT_EYE + 1] + kp[KP_RIGHT_EYE + 1]) * 0.5f;
+    float mouth_mid_y = (kp[KP_LEFT_MOUTH + 1] + kp[KP_RIGHT_MOUTH + 1]) * 0.5f;
+
+    /* Nose offset from the eye midline grows with yaw, its height between eyes and mouth with pitch */
+    float yaw = fabsf(kp[KP_NOSE] - eye_mid_x) / eye_dist;
+    float roll = fabsf(atan2f(kp[KP_RIGHT_EYE + 1] - kp[KP_LEFT_EYE + 1], kp[KP_RIGHT_EYE] - kp[KP_LEFT_EYE]));
+    float face_h = mouth_mid_y - eye_mid_y;
+    float pitch = face_h > 1.0f ? fabsf((kp[KP_NOSE + 1] - eye_mid_y) / face_h - 0.55f) : 1.0f;
+
+    return clampf(1.0f - yaw * 2.5f, 0.0f, 1.0f) *
+           clampf(1.0f - roll / 0.6f, 0.0f, 1.0f) *
+           clampf(1.0f - pitch * 2.5f, 0.0f, 1.0f);
+}
+
+static void hog_embedding(const img_buf_t *crop, float *embedding)
+{
+    const int size = APP_FACE_CROP_SIZE;
+    const uint8_t *p = crop->data;
+
+    memset(embedding, 0, APP_FACE_FEATURE_DIM * sizeof(float));
+
+    for (int y = 1; y < size - 1; y++) {
+        int cell_row = (y / HOG_CELL_SIZE) * HOG_CELLS;
+        for (int x = 1; x < size - 1; x++) {
+            float gx = (float)p[y * size + x + 1] - p[y * size + x - 1];
+            float gy = (float)p[(y + 1) * size + x] - p[(y - 1) * size + x];
+            float mag = sqrtf(gx * gx + gy * gy);
+            if (mag == 0.0f) {
+                continue;
+            }
+
+            /* Unsigned orientation in [0, pi), split linearly between the two nearest bins */
+            float angle = atan2f(gy, gx);
+            if (angle < 0.0f) {
+                angle += (float)M_PI;
+            }
+            float pos = angle * (HOG_BINS / (float)M_PI) - 0.5f;
+            int bin0 = (int)floorf(pos);
+            float w1 = pos - bin0;
+            int bin1 = bin0 + 1;
+            bin0 = (bin0 + HOG_BINS) % HOG_BINS;
+            bin1 = bin1 % HOG_BINS;
+
+            float *cell = embedding + (cell_row + x / HOG_CELL_SIZE) * HOG_BINS;
+            cell[bin0] += mag * (1.0f - w1);
+            cell[bin1] += mag * w1;
+        }
+    }
+
+    /* L2 normalize, clip dominant bins, normalize again */
+    for (int pass = 0; pass < 2; pass++) {
+        float norm = 0.0f;
+        for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+            norm += embedding[i] * embedding[i];
+        }
+        norm = sqrtf(norm) + 1e-6f;
+        for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+            embedding[i] /= norm;
+            if (pass == 0 && embedding[i] > HOG_CLIP) {
+                embedding[i] = HOG_CLIP;
+            }
+        }
+    }
+}
+
+esp_err_t app_face_feature_extract(app_face_feature_t *feature, const uint16_t *frame, int width, int height,
+                                   const int keypoints[10], app_face_quality_t *quality, float *embedding)
+{
+    ESP_RETURN_ON_FALSE(feature && frame && keypoints, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    /* The detector names eyes from the subject's point of view, order them by image x */
+    const int *kp = keypoints;
+    float lx = kp[KP_LEFT_EYE], ly = kp[KP_LEFT_EYE + 1];
+    float rx = kp[KP_RIGHT_EYE], ry = kp[KP_RIGHT_EYE + 1];
+    if (lx > rx) {
+        float tx = lx, ty = ly;
+        lx = rx;
+        ly = ry;
+        rx = tx;
+        ry = ty;
+    }
+
+    float ex = rx - lx, ey = ry - ly;
+    float eye_dist = sqrtf(ex * ex + ey * ey);
+    if (eye_dist < 4.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* Crop (u, v) -> frame: rotate and scale around the left eye */
+    float scale = eye_dist / (CROP_EYE_RIGHT_X - CROP_EYE_LEFT_X);
+    float c = ex / eye_dist * scale, s = ey / eye_dist * scale;
+    float m[6] = {
+        c, -s, lx - c * CROP_EYE_LEFT_X + s * CROP_EYE_Y,
+        s, c, ly - s * CROP_EYE_LEFT_X - c * CROP_EYE_Y,
+    };
+
+    img_buf_t src;
+    img_buf_init(&src, (void *)frame, width, height, IMG_FMT_RGB565);
+    img_rgb565_to_gray_affine(&src, m, &feature->crop);
+
+    if (quality) {
+        quality->size = clampf((eye_dist - QUALITY_EYE_DIST_MIN) / (QUALITY_EYE_DIST_GOOD - QUALITY_EYE_DIST_MIN), 0.0f, 1.0f);
+        quality->sharpness = clampf(img_laplacian_var_y8(&feature->crop) / QUALITY_SHARPNESS_GOOD, 0.0f, 1.0f);
+        quality->exposure = quality_exposure(&feature->crop);
+        quality->pose = quality_pose(kp, eye_dist);
+        quality->score = quality->size * quality->sharpness * quality->exposure * quality->pose;
+    }
+
+    if (embedding) {
+        hog_embedding(&feature->crop, embedding);
+    }
+
+    return ESP_OK;
+}
+
+float app_face_feature_similarity(const float *a, const float *b)
+{
+    float dot = 0.0f;
+    for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+        dot += a[i] * b[i];
+    }
+    return dot;
+}
+
+void app_face_enroll_begin(app_face_enroll_t *enroll, int keep)
+{
+    memset(enroll, 0, sizeof(app_face_enroll_t));
+    enroll->keep = keep < 1 ? 1 : (keep > APP_FACE_ENROLL_KEEP_MAX ? APP_FACE_ENROLL_KEEP_MAX : keep);
+}
+
+bool app_face_enroll_add(app_face_enroll_t *enroll, float quality, const float *embedding)
+{
+    enroll->frames++;
+
+    int slot = enroll->count;
+    if (enroll->count >= enroll->keep) {
+        slot = 0;
+        for (int i = 1; i < enroll->count; i++) {
+            if (enroll->quality[i] < enroll->quality[slot]) {
+                slot = i;
+            }
+        }
+        if (quality <= enroll->quality[slot]) {
+            return false;
+        }
+    } else {
+        enroll->count++;
+    }
+
+    enroll->quality[slot] = quality;
+    memcpy(enroll->embedding[slot], embedding, APP_FACE_FEATURE_DIM * sizeof(float));
+    return true;
+}
+
+float app_face_enroll_finish(const app_face_enroll_t *enroll, float *embedding)
+{
+    memset(embedding, 0, APP_FACE_FEATURE_DIM * sizeof(float));
+    if (enroll->count == 0) {
+        return 0.0f;
+    }
+
+    float quality_sum = 0.0f;
+    for (int k = 0; k < enroll->count; k++) {
+        for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+            embedding[i] += enroll->embedding[k][i];
+        }
+        quality_sum += enroll->quality[k];
+    }
+
+    float norm = 0.0f;
+    for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+        norm += embedding[i] * embedding[i];
+    }
+    norm = sqrtf(norm) + 1e-6f;
+    for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+        embedding[i] /= norm;
+    }
+
+    return quality_sum / enroll->count;
+}
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_FACE_FEATURE_DIM        (128)             /*!< Length of a face embedding */
+#define APP_FACE_CROP_SIZE          (64)              /*!< Side of the aligned face crop in pixels */
+#define APP_FACE_ENROLL_KEEP_MAX    (8)               /*!< Upper bound for the best frames kept by an enrollment */
+
+/**
+ * @brief Face crop quality, every component is in [0, 1].
+ */
+typedef struct {
+    float size;                                       /*!< Eye distance in the frame compared to a comfortable one */
+    float sharpness;                                  /*!< Laplacian variance of the aligned crop */
+    float exposure;                                   /*!< Mean level and clipping of the aligned crop */
+    float pose;                                       /*!< Frontality from the keypoints (yaw, roll, pitch) */
+    float score;                                      /*!< Product of the components above */
+} app_face_quality_t;
+
+typedef struct app_face_feature_t app_face_feature_t;
+
+/**
+ * @brief Create a feature extractor. Holds the crop buffers, one per calling task.
+ *
+ * @param ret_feature Returned extractor handle.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM on failure.
+ */
+esp_err_t app_face_feature_new(app_face_feature_t **ret_feature);
+
+/**
+ * @brief Delete a feature extractor.
+ */
+void app_face_feature_delete(app_face_feature_t *feature);
+
+/**
+ * @brief Align a detected face, score its quality and compute its embedding.
+ *
+ * The face is cut out of the frame so that both eyes land on fixed positions of a
+ * APP_FACE_CROP_SIZE square luma crop, which removes roll and scale. The embedding is a
+ * histogram of oriented gradients over a 4 x 4 grid with 8 orientation bins per cell,
+ * L2-normalized, so it can be compared with a dot product.
+ *
+ * @param feature   Extractor handle.
+ * @param frame     RGB565 frame.
+ * @param width     Frame width in pixels.
+ * @param height    Frame height in pixels.
+ * @param keypoints Detector keypoints: left eye, left mouth corner, nose, right eye, right mouth corner (x, y each).
+ * @param quality   Returned quality, may be NULL.
+ * @param embedding Returned embedding of APP_FACE_FEATURE_DIM values, may be NULL to only score the face.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the keypoints are degenerate.
+ */
+esp_err_t app_face_feature_extract(app_face_feature_t *feature, const uint16_t *frame, int width, int height,
+                                   const int keypoints[10], app_face_quality_t *quality, float *embedding);
+
+/**
+ * @brief Cosine similarity of two normalized embeddings, in [-1, 1].
+ */
+float app_face_feature_similarity(const float *a, const float *b);
+
+/**
+ * @brief Enrollment session, keeps the best scored embeddings of a burst.
+ */
+typedef struct {
+    int keep;                                         /*!< Number of embeddings kept */
+    int count;                                        /*!< Embeddings currently kept */
+    int frames;                                       /*!< Frames offered to the session */
+    float quality[APP_FACE_ENROLL_KEEP_MAX];
+    float embedding[APP_FACE_ENROLL_KEEP_MAX][APP_FACE_FEATURE_DIM];
+} app_face_enroll_t;
+
+/**
+ * @brief Start an enrollment session that keeps the `keep` best embeddings.
+ */
+void app_face_enroll_begin(app_face_enroll_t *enroll, int keep);
+
+/**
+ * @brief Offer one scored embedding; replaces the worst kept one if it scores higher.
+ *
+ * @return true if the embedding was kept.
+ */
+bool app_face_enroll_add(app_face_enroll_t *enroll, float quality, const float *embedding);
+
+/**
+ * @brief Average the kept embeddings into one normalized embedding.
+ *
+ * @param enroll    Session.
+ * @param embedding Returned embedding of APP_FACE_FEATURE_DIM values.
+ * @return Mean quality of the kept frames, 0 if nothing was kept.
+ */
+float app_face_enroll_finish(const app_face_enroll_t *enroll, float *embedding);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,607 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "app_face_gallery.h"
+
+static const char *TAG = "app_face_gallery";
+
+#define GALLERY_FILE_MAGIC          (0x4C414746)      /* "FGAL" */
+#define GALLERY_RECORD_MAGIC        (0x31524746)      /* "FGR1" */
+#define GALLERY_VERSION             (2)
+#define GALLERY_VERSION_V1          (1)               /* No id high-water mark in the header, still read */
+
+#define GALLERY_RECORD_ADD          (1)
+#define GALLERY_RECORD_DEL          (2)
+
+#define GALLERY_READ_BUF_SIZE       (16 * 1024)
+#define GALLERY_PATH_MAX            (64)
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t feature_dim;
+    uint32_t next_id;                                 /* Ids below this were handed out before the log was written */
+} gallery_file_header_t;
+
+#define GALLERY_V1_HEADER_SIZE      (offsetof(gallery_file_header_t, next_id))
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t length;                                  /* Payload bytes following the header */
+    uint32_t seq;
+    uint32_t id;
+    uint32_t crc;                                     /* CRC32 of type .. id and the payload */
+} gallery_record_header_t;
+
+typedef struct __attribute__((packed)) {
+    char name[APP_FACE_GALLERY_NAME_LEN];
+    uint8_t coffee_ratio;
+    uint8_t water_ratio;
+    uint8_t milk_ratio;
+    uint8_t reserved;
+    float scale;
+    int8_t feature[APP_FACE_FEATURE_DIM];
+} gallery_profile_payload_t;
+
+#define GALLERY_ADD_RECORD_SIZE     (sizeof(gallery_record_header_t) + sizeof(gallery_profile_payload_t))
+#define GALLERY_DEL_RECORD_SIZE     (sizeof(gallery_record_header_t))
+
+struct app_face_gallery_t {
+    app_face_gallery_config_t config;
+    char path[GALLERY_PATH_MAX];
+    char tmp_path[GALLERY_PATH_MAX + 4];
+    FILE *file;
+    app_face_gallery_record_t *records;               /* Live profiles sorted by id */
+    int count;
+    int capacity;
+    uint32_t next_id;
+    uint32_t next_seq;
+    uint32_t file_bytes;
+    uint32_t dead_bytes;
+    app_face_gallery_stats_t stats;
+};
+
+static uint32_t record_crc(const gallery_record_header_t *header, const void *payload)
+{
+    uint32_t crc = esp_rom_crc32_le(0, &header->type, offsetof(gallery_record_header_t, crc) - offsetof(gallery_record_header_t, type));
+    if (header->length) {
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)payload, header->length);
+    }
+    return crc;
+}
+
+/* Index of the first record with id >= `id` */
+static int index_lower_bound(const app_face_gallery_t *gallery, uint32_t id)
+{
+    int lo = 0, hi = gallery->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (gallery->records[mid].id < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static esp_err_t index_reserve(app_face_gallery_t *gallery)
+{
+    if (gallery->count < gallery->capacity) {
+        return ESP_OK;
+    }
+
+    int capacity = gallery->capacity ? gallery->capacity * 2 : 16;
+    app_face_gallery_record_t *records = (app_face_gallery_record_t *)heap_caps_realloc(gallery->records,
+                                         capacity * sizeof(app_face_gallery_record_t), MALLOC_CAP_SPIRAM);
+    ESP_RETURN_ON_FALSE(records, ESP_ERR_NO_MEM, TAG, "Failed to grow index to %d", capacity);
+    gallery->records = records;
+    gallery->capacity = capacity;
+    return ESP_OK;
+}
+
+static esp_err_t index_put(app_face_gallery_t *gallery, const app_face_gallery_record_t *record)
+{
+    int pos = index_lower_bound(gallery, record->id);
+    if (pos < gallery->count && gallery->records[pos].id == record->id) {
+        gallery->records[pos] = *record;
+        gallery->dead_bytes += GALLERY_ADD_RECORD_SIZE;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_ERROR(index_reserve(gallery), TAG, "Failed to index record %u", (unsigned)record->id);
+
+    if (pos < gallery->count) {
+        memmove(&gallery->records[pos + 1], &gallery->records[pos], (gallery->count - pos) * sizeof(app_face_gallery_record_t));
+    }
+    gallery->records[pos] = *record;
+    gallery->count++;
+    return ESP_OK;
+}
+
+static bool index_delete(app_face_gallery_t *gallery, uint32_t id)
+{
+    int pos = index_lower_bound(gallery, id);
+    if (pos >= gallery->count || gallery->records[pos].id != id) {
+        return false;
+    }
+
+    memmove(&gallery->records[pos], &gallery->records[pos + 1], (gallery->count - pos - 1) * sizeof(app_face_gallery_record_t));
+    gallery->count--;
+    gallery->dead_bytes += GALLERY_ADD_RECORD_SIZE;
+    return true;
+}
+
+static void payload_from_record(const app_face_gallery_record_t *record, gallery_profile_payload_t *payload)
+{
+    memset(payload, 0, sizeof(*payload));
+    strncpy(payload->name, record->name, sizeof(payload->name) - 1);
+    payload->coffee_ratio = record->coffee_ratio;
+    payload->water_ratio = record->water_ratio;
+    payload->milk_ratio = record->milk_ratio;
+    payload->scale = record->scale;
+    memcpy(payload->feature, record->feature, sizeof(payload->feature));
+}
+
+static void record_from_payload(uint32_t id, const gallery_profile_payload_t *payload, app_face_gallery_record_t *record)
+{
+    record->id = id;
+    memcpy(record->name, payload->name, sizeof(record->name));
+    record->name[sizeof(record->name) - 1] = '\0';
+    record->coffee_ratio = payload->coffee_ratio;
+    record->water_ratio = payload->water_ratio;
+    record->milk_ratio = payload->milk_ratio;
+    record->scale = payload->scale;
+    memcpy(record->feature, payload->feature, sizeof(record->feature));
+}
+
+static esp_err_t write_record(FILE *file, uint8_t type, uint32_t seq, uint32_t id, const gallery_profile_payload_t *payload)
+{
+    uint8_t buf[GALLERY_ADD_RECORD_SIZE];
+    gallery_record_header_t *header = (gallery_record_header_t *)buf;
+
+    header->magic = GALLERY_RECORD_MAGIC;
+    header->type = type;
+    header->reserved = 0;
+    header->length = payload ? sizeof(*payload) : 0;
+    header->seq = seq;
+    header->id = id;
+    if (payload) {
+        memcpy(buf + sizeof(*header), payload, sizeof(*payload));
+    }
+    header->crc = record_crc(header, buf + sizeof(*header));
+
+    size_t size = sizeof(*header) + header->length;
+    return fwrite(buf, 1, size, file) == size ? ESP_OK : ESP_FAIL;
+}
+
+/* Append one record at the end of the log, rolling back the file on a partial write */
+static esp_err_t append_record(app_face_gallery_t *gallery, uint8_t type, uint32_t id, const gallery_profile_payload_t *payload)
+{
+    uint32_t size = payload ? GALLERY_ADD_RECORD_SIZE : GALLERY_DEL_RECORD_SIZE;
+
+    ESP_RETURN_ON_FALSE(gallery->file, ESP_ERR_INVALID_STATE, TAG, "Log is not open");
+    esp_err_t ret = fseek(gallery->file, gallery->file_bytes, SEEK_SET) == 0 ? ESP_OK : ESP_FAIL;
+    if (ret == ESP_OK) {
+        ret = write_record(gallery->file, type, gallery->next_seq, id, payload);
+    }
+    if (ret == ESP_OK && fflush(gallery->file) != 0) {
+        ret = ESP_FAIL;
+    }
+    if (ret == ESP_OK && gallery->config.sync_writes && fsync(fileno(gallery->file)) != 0) {
+        ret = ESP_FAIL;
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to append record for id %u", (unsigned)id);
+        fflush(gallery->file);
+        if (ftruncate(fileno(gallery->file), gallery->file_bytes) != 0) {
+            /* The next append overwrites the partial record, a reopen cuts it off as torn */
+            ESP_LOGE(TAG, "Failed to roll back the log to %u bytes", (unsigned)gallery->file_bytes);
+        }
+        return ret;
+    }
+
+    gallery->file_bytes += size;
+    gallery->next_seq++;
+    return ESP_OK;
+}
+
+static void file_header_init(gallery_file_header_t *file_header, uint32_t next_id)
+{
+    file_header->magic = GALLERY_FILE_MAGIC;
+    file_header->version = GALLERY_VERSION;
+    file_header->feature_dim = APP_FACE_FEATURE_DIM;
+    file_header->next_id = next_id;
+}
+
+static esp_err_t replay_log(app_face_gallery_t *gallery)
+{
+    FILE *file = gallery->file;
+    gallery_file_header_t file_header;
+
+    size_t header_bytes = fread(&file_header, 1, sizeof(file_header), file);
+    bool v1 = header_bytes >= GALLERY_V1_HEADER_SIZE && file_header.magic == GALLERY_FILE_MAGIC &&
+              file_header.version == GALLERY_VERSION_V1;
+    if (v1) {
+        /* A version 1 log has no high-water mark, ids start after the largest one in the log */
+        file_header.next_id = 1;
+        header_bytes = GALLERY_V1_HEADER_SIZE;
+        ESP_RETURN_ON_FALSE(fseek(file, header_bytes, SEEK_SET) == 0, ESP_FAIL, TAG, "Failed to seek past log header");
+    } else if (header_bytes != sizeof(file_header)) {
+        /* Empty or torn header: start a fresh log */
+        rewind(file);
+        file_header_init(&file_header, 1);
+        ESP_RETURN_ON_FALSE(fwrite(&file_header, 1, sizeof(file_header), file) == sizeof(file_header) && fflush(file) == 0,
+                            ESP_FAIL, TAG, "Failed to write log header");
+        ESP_RETURN_ON_FALSE(ftruncate(fileno(file), sizeof(file_header)) == 0, ESP_FAIL, TAG, "Failed to truncate log");
+        gallery->file_bytes = sizeof(file_header);
+        gallery->next_id = 1;
+        gallery->next_seq = 1;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(file_header.magic == GALLERY_FILE_MAGIC &&
+                        (file_header.version == GALLERY_VERSION || file_header.version == GALLERY_VERSION_V1) &&
+                        file_header.feature_dim == APP_FACE_FEATURE_DIM, ESP_ERR_INVALID_VERSION, TAG,
+                        "Unsupported log (magic 0x%08x, version %d, dim %d)", (unsigned)file_header.magic,
+                        file_header.version, file_header.feature_dim);
+
+    uint32_t offset = header_bytes;
+    uint32_t max_id = 0;
+    uint32_t max_seq = 0;
+    gallery_record_header_t header;
+    gallery_profile_payload_t payload;
+
+    while (fread(&header, 1, sizeof(header), file) == sizeof(header)) {
+        if (header.magic != GALLERY_RECORD_MAGIC ||
+                (header.type == GALLERY_RECORD_ADD && header.length != sizeof(payload)) ||
+                (header.type == GALLERY_RECORD_DEL && header.length != 0) ||
+                (header.type != GALLERY_RECORD_ADD && header.type != GALLERY_RECORD_DEL)) {
+            break;
+        }
+        if (header.length && fread(&payload, 1, header.length, file) != header.length) {
+            break;
+        }
+        if (record_crc(&header, &payload) != header.crc) {
+            break;
+        }
+
+        if (header.type == GALLERY_RECORD_ADD) {
+            app_face_gallery_record_t record;
+            record_from_payload(header.id, &payload, &record);
+            ESP_RETURN_ON_ERROR(index_put(gallery, &record), TAG, "Failed to index record");
+        } else {
+            index_delete(gallery, header.id);
+            gallery->dead_bytes += GALLERY_DEL_RECORD_SIZE;
+        }
+
+        max_id = header.id > max_id ? header.id : max_id;
+        max_seq = header.seq > max_seq ? header.seq : max_seq;
+        offset += sizeof(header) + header.length;
+        gallery->stats.records_scanned++;
+    }
+
+    struct stat st;
+    uint32_t size = fstat(fileno(file), &st) == 0 ? (uint32_t)st.st_size : offset;
+    if (size > offset) {
+        ESP_LOGW(TAG, "Dropping %u torn bytes at the end of the log", (unsigned)(size - offset));
+        fflush(file);
+        ESP_RETURN_ON_FALSE(ftruncate(fileno(file), offset) == 0, ESP_FAIL, TAG, "Failed to truncate log");
+        gallery->stats.truncated_bytes = size - offset;
+    }
+
+    gallery->file_bytes = offset;
+    gallery->next_id = max_id + 1 > file_header.next_id ? max_id + 1 : file_header.next_id;
+    gallery->next_seq = max_seq + 1;
+    return ESP_OK;
+}
+
+esp_err_t app_face_gallery_open(const app_face_gallery_config_t *config, app_face_gallery_t **ret_gallery)
+{
+    esp_err_t ret = ESP_OK;
+    int64_t start_us = esp_timer_get_time();
+
+    ESP_RETURN_ON_FALSE(config && config->path && ret_gallery, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(strlen(config->path) < GALLERY_PATH_MAX, ESP_ERR_INVALID_ARG, TAG, "Path too long");
+
+    app_face_gallery_t *gallery = (app_face_gallery_t *)heap_caps_calloc(1, sizeof(app_face_gallery_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(gallery, ESP_ERR_NO_MEM, TAG, "Failed to allocate gallery");
+    gallery->config = *config;
+    strcpy(gallery->path, config->path);
+    snprintf(gallery->tmp_path, sizeof(gallery->tmp_path), "%s.tmp", config->path);
+    gallery->config.path = gallery->path;
+
+    /* A compaction writes the temporary log completely before removing the old one */
+    struct stat st;
+    if (stat(gallery->path, &st) == 0) {
+        remove(gallery->tmp_path);
+    } else if (stat(gallery->tmp_path, &st) == 0) {
+        ESP_LOGW(TAG, "Recovering log from an interrupted compaction");
+        rename(gallery->tmp_path, gallery->path);
+    }
+
+    gallery->file = fopen(gallery->path, "r+b");
+    if (gallery->file == NULL) {
+        gallery->file = fopen(gallery->path, "w+b");
+    }
+    ESP_GOTO_ON_FALSE(gallery->file, ESP_FAIL, err, TAG, "Failed to open %s", gallery->path);
+    setvbuf(gallery->file, NULL, _IOFBF, GALLERY_READ_BUF_SIZE);
+
+    ESP_GOTO_ON_ERROR(replay_log(gallery), err, TAG, "Failed to load %s", gallery->path);
+
+    gallery->stats.load_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "Loaded %d profiles from %s (%u records, %u bytes, %u dead) in %d ms", gallery->count, gallery->path,
+             (unsigned)gallery->stats.records_scanned, (unsigned)gallery->file_bytes, (unsigned)gallery->dead_bytes,
+             (int)(gallery->stats.load_us / 1000));
+
+    *ret_gallery = gallery;
+    return ESP_OK;
+
+err:
+    app_face_gallery_close(gallery);
+    return ret;
+}
+
+void app_face_gallery_close(app_face_gallery_t *gallery)
+{
+    if (gallery == NULL) {
+        return;
+    }
+
+    if (gallery->file) {
+        fclose(gallery->file);
+    }
+    heap_caps_free(gallery->records);
+    heap_caps_free(gallery);
+}
+
+static void maybe_compact(app_face_gallery_t *gallery)
+{
+    uint32_t live_bytes = gallery->file_bytes - gallery->dead_bytes;
+    if (gallery->dead_bytes >= gallery->config.compact_min_bytes && gallery->dead_bytes > live_bytes) {
+        app_face_gallery_compact(gallery);
+    }
+}
+
+esp_err_t app_face_gallery_put(app_face_gallery_t *gallery, app_face_gallery_record_t *record)
+{
+    ESP_RETURN_ON_FALSE(gallery && record, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    app_face_gallery_record_t stored = *record;
+    if (stored.id == 0) {
+        stored.id = gallery->next_id;
+    }
+    stored.name[sizeof(stored.name) - 1] = '\0';
+
+    /* Make sure the index can take the record before it hits the log */
+    ESP_RETURN_ON_ERROR(index_reserve(gallery), TAG, "Failed to store profile");
+
+    gallery_profile_payload_t payload;
+    payload_from_record(&stored, &payload);
+    ESP_RETURN_ON_ERROR(append_record(gallery, GALLERY_RECORD_ADD, stored.id, &payload), TAG, "Failed to store profile");
+
+    index_put(gallery, &stored);
+    if (stored.id >= gallery->next_id) {
+        gallery->next_id = stored.id + 1;
+    }
+    record->id = stored.id;
+
+    maybe_compact(gallery);
+    return ESP_OK;
+}
+
+esp_err_t app_face_gallery_delete(app_face_gallery_t *gallery, uint32_t id)
+{
+    ESP_RETURN_ON_FALSE(gallery, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(app_face_gallery_find(gallery, id), ESP_ERR_NOT_FOUND, TAG, "No profile with id %u", (unsigned)id);
+
+    ESP_RETURN_ON_ERROR(append_record(gallery, GALLERY_RECORD_DEL, id, NULL), TAG, "Failed to delete profile");
+
+    index_delete(gallery, id);
+    gallery->dead_bytes += GALLERY_DEL_RECORD_SIZE;
+
+    maybe_compact(gallery);
+    return ESP_OK;
+}
+
+int app_face_gallery_count(const app_face_gallery_t *gallery)
+{
+    return gallery ? gallery->count : 0;
+}
+
+const app_face_gallery_record_t *app_face_gallery_get(const app_face_gallery_t *gallery, int index)
+{
+    if (!gallery || index < 0 || index >= gallery->count) {
+        return NULL;
+    }
+    return &gallery->records[index];
+}
+
+const app_face_gallery_record_t *app_face_gallery_find(const app_face_gallery_t *gallery, uint32_t id)
+{
+    if (!gallery) {
+        return NULL;
+    }
+
+    int pos = index_lower_bound(gallery, id);
+    if (pos < gallery->count && gallery->records[pos].id == id) {
+        return &gallery->records[pos];
+    }
+    return NULL;
+}
+
+esp_err_t app_face_gallery_compact(app_face_gallery_t *gallery)
+{
+    esp_err_t ret = ESP_OK;
+    int64_t start_us = esp_timer_get_time();
+
+    ESP_RETURN_ON_FALSE(gallery, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    FILE *tmp = fopen(gallery->tmp_path, "wb");
+    ESP_RETURN_ON_FALSE(tmp, ESP_FAIL, TAG, "Failed to create %s", gallery->tmp_path);
+    setvbuf(tmp, NULL, _IOFBF, GALLERY_READ_BUF_SIZE);
+
+    /* Deleted ids vanish from the log here, the header keeps them from being handed out again */
+    gallery_file_header_t file_header;
+    file_header_init(&file_header, gallery->next_id);
+    ESP_GOTO_ON_FALSE(fwrite(&file_header, 1, sizeof(file_header), tmp) == sizeof(file_header), ESP_FAIL, err, TAG,
+                      "Failed to write log header");
+
+    gallery_profile_payload_t payload;
+    for (int i = 0; i < gallery->count; i++) {
+        payload_from_record(&gallery->records[i], &payload);
+        ESP_GOTO_ON_ERROR(write_record(tmp, GALLERY_RECORD_ADD, i + 1, gallery->records[i].id, &payload), err, TAG,
+                          "Failed to write compacted record");
+    }
+    ESP_GOTO_ON_FALSE(fflush(tmp) == 0 && fsync(fileno(tmp)) == 0, ESP_FAIL, err, TAG, "Failed to sync compacted log");
+    fclose(tmp);
+    tmp = NULL;
+
+    /* FAT can not rename over an existing file; open() recovers from a crash between these two */
+    fclose(gallery->file);
+    gallery->file = NULL;
+    remove(gallery->path);
+    ESP_RETURN_ON_FALSE(rename(gallery->tmp_path, gallery->path) == 0, ESP_FAIL, TAG, "Failed to replace log");
+
+    gallery->file = fopen(gallery->path, "r+b");
+    ESP_RETURN_ON_FALSE(gallery->file, ESP_FAIL, TAG, "Failed to reopen %s", gallery->path);
+    setvbuf(gallery->file, NULL, _IOFBF, GALLERY_READ_BUF_SIZE);
+
+    uint32_t old_bytes = gallery->file_bytes;
+    gallery->file_bytes = sizeof(file_header) + gallery->count * GALLERY_ADD_RECORD_SIZE;
+    gallery->dead_bytes = 0;
+    gallery->next_seq = gallery->count + 1;
+    gallery->stats.compactions++;
+
+    ESP_LOGI(TAG, "Compacted %s: %u -> %u bytes in %d ms", gallery->path, (unsigned)old_bytes,
+             (unsigned)gallery->file_bytes, (int)((esp_timer_get_time() - start_us) / 1000));
+    return ESP_OK;
+
+err:
+    if (tmp) {
+        fclose(tmp);
+    }
+    remove(gallery->tmp_path);
+    return ret;
+}
+
+void app_face_gallery_get_stats(const app_face_gallery_t *gallery, app_face_gallery_stats_t *stats)
+{
+    *stats = gallery->stats;
+    stats->count = gallery->count;
+    stats->file_bytes = gallery->file_bytes;
+    stats->dead_bytes = gallery->dead_bytes;
+}
+
+void app_face_gallery_quantize(const float *embedding, app_face_gallery_record_t *record)
+{
+    float max_abs = 0.0f;
+    for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+        float v = fabsf(embedding[i]);
+        max_abs = v > max_abs ? v : max_abs;
+    }
+
+    record->scale = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+    for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+        record->feature[i] = (int8_t)lroundf(embedding[i] / record->scale);
+    }
+}
+
+void app_face_gallery_dequantize(const app_face_gallery_record_t *record, float *embedding)
+{
+    for (int i = 0; i < APP_FACE_FEATURE_DIM; i++) {
+        embedding[i] = record->feature[i] * record->scale;
+    }
+}
+
+esp_err_t app_face_gallery_benchmark(const char *path)
+{
+    static const int sizes[] = {10, 1000, 10000};
+    uint32_t rng = 0x12345678;
+
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        app_face_gallery_t *gallery = NULL;
+        app_face_gallery_config_t config = {
+            .path = path,
+            .sync_writes = false,
+            .compact_min_bytes = UINT32_MAX,
+        };
+        char tmp_path[GALLERY_PATH_MAX + 4];
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+        remove(path);
+        remove(tmp_path);
+
+        ESP_RETURN_ON_ERROR(app_face_gallery_open(&config, &gallery), TAG, "Benchmark open failed");
+
+        int64_t start_us = esp_timer_get_time();
+        for (int i = 0; i < n; i++) {
+            app_face_gallery_record_t record = {};
+            float embedding[APP_FACE_FEATURE_DIM];
+            for (int k = 0; k < APP_FACE_FEATURE_DIM; k++) {
+                rng = rng * 1664525 + 1013904223;
+                embedding[k] = (int32_t)rng / 2147483648.0f;
+            }
+            snprintf(record.name, sizeof(record.name), "user%d", i);
+            app_face_gallery_quantize(embedding, &record);
+            if (app_face_gallery_put(gallery, &record) != ESP_OK) {
+                app_face_gallery_close(gallery);
+                return ESP_FAIL;
+            }
+        }
+        int64_t fill_us = esp_timer_get_time() - start_us;
+        app_face_gallery_close(gallery);
+
+        config.sync_writes = true;
+        ESP_RETURN_ON_ERROR(app_face_gallery_open(&config, &gallery), TAG, "Benchmark reopen failed");
+        app_face_gallery_stats_t stats;
+        app_face_gallery_get_stats(gallery, &stats);
+
+        app_face_gallery_record_t record = *app_face_gallery_get(gallery, n / 2);
+        record.id = 0;
+        start_us = esp_timer_get_time();
+        esp_err_t ret = app_face_gallery_put(gallery, &record);
+        int64_t put_us = esp_timer_get_time() - start_us;
+
+        start_us = esp_timer_get_time();
+        if (ret == ESP_OK) {
+            ret = app_face_gallery_delete(gallery, app_face_gallery_get(gallery, 0)->id);
+        }
+        int64_t delete_us = esp_timer_get_time() - start_us;
+
+        start_us = esp_timer_get_time();
+        if (ret == ESP_OK) {
+            ret = app_face_gallery_compact(gallery);
+        }
+        int64_t compact_us = esp_timer_get_time() - start_us;
+
+        ESP_LOGI(TAG, "Benchmark %5d profiles: fill %d ms, open %d ms (%d us/profile), %u bytes, "
+                 "synced put %d us, synced delete %d us, compact %d ms",
+                 n, (int)(fill_us / 1000), (int)(stats.load_us / 1000), (int)(stats.load_us / n),
+                 (unsigned)stats.file_bytes, (int)put_us, (int)delete_us, (int)(compact_us / 1000));
+
+        app_face_gallery_close(gallery);
+        remove(path);
+        ESP_RETURN_ON_ERROR(ret, TAG, "Benchmark failed");
+    }
+
+    return ESP_OK;
+}
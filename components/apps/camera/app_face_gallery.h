@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "app_face_feature.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************
+ * Face gallery
+ * Append-only log of face profiles on a file system. Every add, update or delete appends one
+ * CRC protected record; a delete is a tombstone. The whole log is replayed into an in-memory
+ * index sorted by id when the gallery is opened, a torn record at the end (power loss during a
+ * write) is cut off. Once superseded records take more space than live ones, the log is
+ * rewritten with only the live records. Ids are never reused: the rewritten log keeps the next
+ * free id in its header.
+ **************************************************************************************************/
+
+#define APP_FACE_GALLERY_NAME_LEN       (32)
+
+/**
+ * @brief Face profile as kept in the gallery. The embedding is stored as int8 with one scale.
+ */
+typedef struct {
+    uint32_t id;                                      /*!< Unique id, assigned by the gallery */
+    char name[APP_FACE_GALLERY_NAME_LEN];             /*!< Display name, NUL terminated */
+    uint8_t coffee_ratio;                             /*!< Coffee ratio (0-100) */
+    uint8_t water_ratio;                              /*!< Water ratio (0-100) */
+    uint8_t milk_ratio;                               /*!< Milk ratio (0-100) */
+    float scale;                                      /*!< Dequantization scale of `feature` */
+    int8_t feature[APP_FACE_FEATURE_DIM];             /*!< Quantized embedding */
+} app_face_gallery_record_t;
+
+/**
+ * @brief Gallery configuration.
+ */
+typedef struct {
+    const char *path;                                 /*!< Log file path, e.g. "/sdcard/faces.log" */
+    bool sync_writes;                                 /*!< fsync() after every record, keeps each operation durable */
+    uint32_t compact_min_bytes;                       /*!< Never compact while fewer dead bytes than this */
+} app_face_gallery_config_t;
+
+/**
+ * @brief Gallery statistics.
+ */
+typedef struct {
+    int count;                                        /*!< Live profiles */
+    uint32_t file_bytes;                              /*!< Log size */
+    uint32_t dead_bytes;                              /*!< Bytes taken by superseded records and tombstones */
+    uint32_t records_scanned;                         /*!< Records replayed at open */
+    uint32_t truncated_bytes;                         /*!< Torn bytes cut off at open */
+    uint32_t compactions;                             /*!< Compactions since open */
+    int64_t load_us;                                  /*!< Time to open and replay the log */
+} app_face_gallery_stats_t;
+
+typedef struct app_face_gallery_t app_face_gallery_t;
+
+/**
+ * @brief Open a gallery, creating the log if it does not exist.
+ *
+ * @param config Gallery configuration; `path` is copied.
+ * @param ret_gallery Returned gallery handle.
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_INVALID_VERSION: The log was written with another format or embedding size
+ *      - ESP_ERR_NO_MEM: Out of memory
+ *      - ESP_FAIL: File system error
+ */
+esp_err_t app_face_gallery_open(const app_face_gallery_config_t *config, app_face_gallery_t **ret_gallery);
+
+/**
+ * @brief Close a gallery and free its index.
+ */
+void app_face_gallery_close(app_face_gallery_t *gallery);
+
+/**
+ * @brief Add or update a profile.
+ *
+ * A record with `id` 0 is added under a new id, otherwise the profile with that id is replaced.
+ * On success `record->id` holds the id of the stored profile.
+ */
+esp_err_t app_face_gallery_put(app_face_gallery_t *gallery, app_face_gallery_record_t *record);
+
+/**
+ * @brief Delete a profile.
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if there is no profile with that id.
+ */
+esp_err_t app_face_gallery_delete(app_face_gallery_t *gallery, uint32_t id);
+
+/**
+ * @brief Number of live profiles.
+ */
+int app_face_gallery_count(const app_face_gallery_t *gallery);
+
+/**
+ * @brief Profile at `index` (0 .. count - 1), in id order. Valid until the next modification.
+ */
+const app_face_gallery_record_t *app_face_gallery_get(const app_face_gallery_t *gallery, int index);
+
+/**
+ * @brief Profile with the given id, or NULL. Valid until the next modification.
+ */
+const app_face_gallery_record_t *app_face_gallery_find(const app_face_gallery_t *gallery, uint32_t id);
+
+/**
+ * @brief Rewrite the log with only the live profiles.
+ */
+esp_err_t app_face_gallery_compact(app_face_gallery_t *gallery);
+
+/**
+ * @brief Get the gallery statistics.
+ */
+void app_face_gallery_get_stats(const app_face_gallery_t *gallery, app_face_gallery_stats_t *stats);
+
+/**
+ * @brief Quantize a float embedding into a record.
+ */
+void app_face_gallery_quantize(const float *embedding, app_face_gallery_record_t *record);
+
+/**
+ * @brief Dequantize the embedding of a record.
+ */
+void app_face_gallery_dequantize(const app_face_gallery_record_t *record, float *embedding);
+
+/**
+ * @brief Measure add, open, delete and compaction times for galleries of 10, 1k and 10k profiles.
+ *
+ * Uses a scratch log at `path`, which is removed afterwards. Results are logged.
+ */
+esp_err_t app_face_gallery_benchmark(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,235 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "app_face_tracker.h"
+
+static const char *TAG = "app_face_tracker";
+
+typedef struct {
+    bool used;
+    app_face_track_t track;
+    int missed;
+    int since_verify;
+    int vote_identity[APP_FACE_TRACKER_MAX_VOTES];
+    float vote_similarity[APP_FACE_TRACKER_MAX_VOTES];
+} tracker_slot_t;
+
+struct app_face_tracker_t {
+    app_face_tracker_config_t config;
+    tracker_slot_t slots[APP_FACE_TRACKER_MAX_TRACKS];
+    int next_track_id;
+    app_face_tracker_stats_t stats;
+};
+
+esp_err_t app_face_tracker_new(const app_face_tracker_config_t *config, app_face_tracker_t **ret_tracker)
+{
+    ESP_RETURN_ON_FALSE(config && ret_tracker, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(config->vote_frames > 0 && config->vote_frames <= APP_FACE_TRACKER_MAX_VOTES,
+                        ESP_ERR_INVALID_ARG, TAG, "vote_frames must be 1..%d", APP_FACE_TRACKER_MAX_VOTES);
+
+    app_face_tracker_t *tracker = (app_face_tracker_t *)heap_caps_calloc(1, sizeof(app_face_tracker_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(tracker, ESP_ERR_NO_MEM, TAG, "Failed to allocate face tracker");
+    tracker->config = *config;
+    tracker->next_track_id = 1;
+
+    *ret_tracker = tracker;
+    return ESP_OK;
+}
+
+void app_face_tracker_delete(app_face_tracker_t *tracker)
+{
+    heap_caps_free(tracker);
+}
+
+void app_face_tracker_reset(app_face_tracker_t *tracker)
+{
+    memset(tracker->slots, 0, sizeof(tracker->slots));
+}
+
+static float box_iou(const int *a, const int *b)
+{
+    int x0 = a[0] > b[0] ? a[0] : b[0];
+    int y0 = a[1] > b[1] ? a[1] : b[1];
+    int x1 = a[2] < b[2] ? a[2] : b[2];
+    int y1 = a[3] < b[3] ? a[3] : b[3];
+    if (x1 <= x0 || y1 <= y0) {
+        return 0.0f;
+    }
+
+    float inter = (float)(x1 - x0) * (y1 - y0);
+    float area_a = (float)(a[2] - a[0]) * (a[3] - a[1]);
+    float area_b = (float)(b[2] - b[0]) * (b[3] - b[1]);
+    return inter / (area_a + area_b - inter);
+}
+
+static void slot_start_round(tracker_slot_t *slot)
+{
+    slot->track.votes = 0;
+    slot->since_verify = 0;
+}
+
+int app_face_tracker_update(app_face_tracker_t *tracker, const int (*boxes)[4], int box_num,
+                            int *slots, int *lost_ids, int lost_max)
+{
+    bool matched[APP_FACE_TRACKER_MAX_TRACKS] = {false};
+    int lost_num = 0;
+
+    tracker->stats.detections += box_num;
+
+    /* Greedy association: repeatedly take the best remaining (box, track) pair */
+    for (int i = 0; i < box_num; i++) {
+        slots[i] = -1;
+    }
+    for (int round = 0; round < box_num; round++) {
+        float best_iou = tracker->config.iou_threshold;
+        int best_box = -1, best_slot = -1;
+        for (int i = 0; i < box_num; i++) {
+            if (slots[i] >= 0) {
+                continue;
+            }
+            for (int s = 0; s < APP_FACE_TRACKER_MAX_TRACKS; s++) {
+                if (!tracker->slots[s].used || matched[s]) {
+                    continue;
+                }
+                float iou = box_iou(boxes[i], tracker->slots[s].track.box);
+                if (iou >= best_iou) {
+                    best_iou = iou;
+                    best_box = i;
+                    best_slot = s;
+                }
+            }
+        }
+        if (best_box < 0) {
+            break;
+        }
+        slots[best_box] = best_slot;
+        matched[best_slot] = true;
+    }
+
+    /* Age the tracks that were not seen */
+    for (int s = 0; s < APP_FACE_TRACKER_MAX_TRACKS; s++) {
+        tracker_slot_t *slot = &tracker->slots[s];
+        if (!slot->used || matched[s]) {
+            continue;
+        }
+        if (++slot->missed >= tracker->config.lost_frames) {
+            ESP_LOGD(TAG, "Track %d lost", slot->track.track_id);
+            if (lost_ids && lost_num < lost_max) {
+                lost_ids[lost_num++] = slot->track.track_id;
+            }
+            slot->used = false;
+        }
+    }
+
+    /* Update matched tracks, start new ones for the rest */
+    for (int i = 0; i < box_num; i++) {
+        tracker_slot_t *slot;
+        if (slots[i] < 0) {
+            int s = 0;
+            while (s < APP_FACE_TRACKER_MAX_TRACKS && tracker->slots[s].used) {
+                s++;
+            }
+            if (s == APP_FACE_TRACKER_MAX_TRACKS) {
+                continue;
+            }
+            slot = &tracker->slots[s];
+            memset(slot, 0, sizeof(*slot));
+            slot->used = true;
+            slot->track.track_id = tracker->next_track_id++;
+            slot->track.identity = -1;
+            slots[i] = s;
+            tracker->stats.tracks++;
+        } else {
+            slot = &tracker->slots[slots[i]];
+        }
+
+        memcpy(slot->track.box, boxes[i], sizeof(slot->track.box));
+        slot->track.age++;
+        slot->missed = 0;
+        slot->since_verify++;
+    }
+
+    return lost_num;
+}
+
+bool app_face_tracker_needs_recognition(const app_face_tracker_t *tracker, int slot)
+{
+    if (slot < 0 || slot >= APP_FACE_TRACKER_MAX_TRACKS || !tracker->slots[slot].used) {
+        return false;
+    }
+
+    const tracker_slot_t *s = &tracker->slots[slot];
+    if (!s->track.confirmed || s->track.votes < tracker->config.vote_frames) {
+        return true;
+    }
+    return s->track.similarity < tracker->config.reverify_below && s->since_verify >= tracker->config.reverify_interval;
+}
+
+void app_face_tracker_vote(app_face_tracker_t *tracker, int slot, int identity, float similarity)
+{
+    if (slot < 0 || slot >= APP_FACE_TRACKER_MAX_TRACKS || !tracker->slots[slot].used) {
+        return;
+    }
+
+    tracker_slot_t *s = &tracker->slots[slot];
+    tracker->stats.recognitions++;
+
+    /* A re-verification of a confirmed track starts a fresh round of votes */
+    if (s->track.confirmed && s->track.votes >= tracker->config.vote_frames) {
+        slot_start_round(s);
+    }
+
+    s->vote_identity[s->track.votes] = identity;
+    s->vote_similarity[s->track.votes] = similarity;
+    s->track.votes++;
+    s->since_verify = 0;
+
+    if (s->track.votes < tracker->config.vote_frames) {
+        return;
+    }
+
+    /* Majority vote, ties broken by the summed similarity */
+    int best_identity = -1, best_count = 0;
+    float best_sum = 0.0f;
+    for (int i = 0; i < s->track.votes; i++) {
+        int count = 0;
+        float sum = 0.0f;
+        for (int j = 0; j < s->track.votes; j++) {
+            if (s->vote_identity[j] == s->vote_identity[i]) {
+                count++;
+                sum += s->vote_similarity[j];
+            }
+        }
+        if (count > best_count || (count == best_count && sum > best_sum)) {
+            best_identity = s->vote_identity[i];
+            best_count = count;
+            best_sum = sum;
+        }
+    }
+
+    s->track.identity = best_identity;
+    s->track.similarity = best_sum / best_count;
+    s->track.confirmed = true;
+    ESP_LOGD(TAG, "Track %d confirmed as %d (%d/%d votes, similarity %.2f)", s->track.track_id, best_identity,
+             best_count, s->track.votes, s->track.similarity);
+}
+
+const app_face_track_t *app_face_tracker_get(const app_face_tracker_t *tracker, int slot)
+{
+    if (slot < 0 || slot >= APP_FACE_TRACKER_MAX_TRACKS || !tracker->slots[slot].used) {
+        return NULL;
+    }
+    return &tracker->slots[slot].track;
+}
+
+void app_face_tracker_get_stats(const app_face_tracker_t *tracker, app_face_tracker_stats_t *stats)
+{
+    *stats = tracker->stats;
+}
@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_FACE_TRACKER_MAX_TRACKS     (4)           /*!< Faces followed at the same time */
+#define APP_FACE_TRACKER_MAX_VOTES      (8)           /*!< Upper bound for `vote_frames` */
+
+/**
+ * @brief Face tracker configuration.
+ */
+typedef struct {
+    float iou_threshold;                              /*!< Minimum box overlap to continue a track */
+    int vote_frames;                                  /*!< Recognitions voted over before a track is confirmed */
+    int lost_frames;                                  /*!< Detections without a match before a track is dropped */
+    float reverify_below;                             /*!< Confirmed tracks matched below this similarity keep being re-verified */
+    int reverify_interval;                            /*!< Detections between two re-verifications of such a track */
+} app_face_tracker_config_t;
+
+#define APP_FACE_TRACKER_DEFAULT_CONFIG() {                                  \
+        .iou_threshold = CONFIG_APP_FACE_TRACK_IOU / 100.0f,                  \
+        .vote_frames = CONFIG_APP_FACE_TRACK_VOTE_FRAMES,                     \
+        .lost_frames = CONFIG_APP_FACE_TRACK_LOST_FRAMES,                     \
+        .reverify_below = CONFIG_APP_FACE_TRACK_REVERIFY_BELOW / 100.0f,      \
+        .reverify_interval = CONFIG_APP_FACE_TRACK_REVERIFY_INTERVAL,         \
+    }
+
+/**
+ * @brief One followed face.
+ */
+typedef struct {
+    int track_id;                                     /*!< Unique id, never reused */
+    int box[4];                                       /*!< Last box, x0 y0 x1 y1 */
+    int identity;                                     /*!< Voted identity, -1 for an unknown face */
+    float similarity;                                 /*!< Mean similarity of the votes for `identity` */
+    int votes;                                        /*!< Votes collected in the current round */
+    bool confirmed;                                   /*!< Voting finished, `identity` is valid */
+    int age;                                          /*!< Detections this track was matched in */
+} app_face_track_t;
+
+/**
+ * @brief Tracker statistics.
+ */
+typedef struct {
+    uint32_t detections;                              /*!< Face boxes fed to the tracker */
+    uint32_t recognitions;                            /*!< Votes, i.e. recognitions actually run */
+    uint32_t tracks;                                  /*!< Tracks started */
+} app_face_tracker_stats_t;
+
+typedef struct app_face_tracker_t app_face_tracker_t;
+
+/**
+ * @brief Create a face tracker.
+ */
+esp_err_t app_face_tracker_new(const app_face_tracker_config_t *config, app_face_tracker_t **ret_tracker);
+
+/**
+ * @brief Delete a face tracker.
+ */
+void app_face_tracker_delete(app_face_tracker_t *tracker);
+
+/**
+ * @brief Drop all tracks.
+ */
+void app_face_tracker_reset(app_face_tracker_t *tracker);
+
+/**
+ * @brief Associate the boxes of one detection with the current tracks.
+ *
+ * Boxes are matched greedily by overlap (IoU); unmatched boxes start new tracks when a slot is
+ * free, tracks that missed `lost_frames` detections in a row are dropped.
+ *
+ * @param tracker  Tracker handle.
+ * @param boxes    Face boxes, x0 y0 x1 y1.
+ * @param box_num  Number of boxes.
+ * @param slots    Returned track slot per box, -1 if the box could not be tracked.
+ * @param lost_ids Returned ids of the tracks dropped by this update, may be NULL.
+ * @param lost_max Capacity of `lost_ids`.
+ * @return Number of dropped tracks written to `lost_ids`.
+ */
+int app_face_tracker_update(app_face_tracker_t *tracker, const int (*boxes)[4], int box_num,
+                            int *slots, int *lost_ids, int lost_max);
+
+/**
+ * @brief Whether the face in `slot` needs a recognition on this detection.
+ *
+ * True while voting, and every `reverify_interval` detections for a confirmed track whose
+ * similarity is below `reverify_below`, until that new round of votes is complete.
+ */
+bool app_face_tracker_needs_recognition(const app_face_tracker_t *tracker, int slot);
+
+/**
+ * @brief Record a recognition result for the face in `slot`.
+ *
+ * @param tracker    Tracker handle.
+ * @param slot       Track slot.
+ * @param identity   Matched identity, -1 for no match.
+ * @param similarity Similarity of the best match.
+ */
+void app_face_tracker_vote(app_face_tracker_t *tracker, int slot, int identity, float similarity);
+
+/**
+ * @brief Track in `slot`, or NULL if the slot is free.
+ */
+const app_face_track_t *app_face_tracker_get(const app_face_tracker_t *tracker, int slot);
+
+/**
+ * @brief Get the tracker statistics.
+ */
+void app_face_tracker_get_stats(const app_face_tracker_t *tracker, app_face_tracker_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
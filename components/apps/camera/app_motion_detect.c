@@ -0,0 +1,175 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "img_kernels.h"
+#include "app_motion_detect.h"
+
+static const char *TAG = "app_motion_detect";
+
+struct app_motion_gate_t {
+    app_motion_gate_config_t config;
+    img_buf_t frame;                                  /* Full frame view, data set per feed */
+    img_buf_t sample;                                 /* RGB565 sparse sample of the frame */
+    img_buf_t luma;                                   /* Luma of the sample */
+    uint8_t *cells;                                   /* Per-cell mean luma of the last frame */
+    bool has_reference;
+    bool motion;
+    int frames_since_detect;
+    int64_t last_detect_us;
+    int64_t last_face_us;
+    app_motion_gate_stats_t stats;
+    int64_t stats_start_us;
+};
+
+esp_err_t app_motion_gate_new(const app_motion_gate_config_t *config, int width, int height, app_motion_gate_t **ret_gate)
+{
+    esp_err_t ret = ESP_OK;
+    app_motion_gate_t *gate = NULL;
+
+    ESP_RETURN_ON_FALSE(config && ret_gate && width > 0 && height > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(config->sample_step > 0 && config->grid_cols > 0 && config->grid_rows > 0,
+                        ESP_ERR_INVALID_ARG, TAG, "Invalid grid configuration");
+
+    int sample_w = width / config->sample_step;
+    int sample_h = height / config->sample_step;
+    ESP_RETURN_ON_FALSE(sample_w >= config->grid_cols && sample_h >= config->grid_rows,
+                        ESP_ERR_INVALID_ARG, TAG, "Grid is finer than the sampled frame");
+
+    gate = (app_motion_gate_t *)heap_caps_calloc(1, sizeof(app_motion_gate_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(gate, ESP_ERR_NO_MEM, TAG, "Failed to allocate motion gate");
+    gate->config = *config;
+
+    img_buf_init(&gate->frame, NULL, width, height, IMG_FMT_RGB565);
+
+    void *sample_data = heap_caps_malloc(sample_w * sample_h * 2, MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(sample_data, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate sample buffer");
+    img_buf_init(&gate->sample, sample_data, sample_w, sample_h, IMG_FMT_RGB565);
+
+    void *luma_data = heap_caps_malloc(sample_w * sample_h, MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(luma_data, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate luma buffer");
+    img_buf_init(&gate->luma, luma_data, sample_w, sample_h, IMG_FMT_Y8);
+
+    gate->cells = (uint8_t *)heap_caps_calloc(config->grid_cols * config->grid_rows, 1, MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(gate->cells, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate grid");
+
+    gate->stats_start_us = esp_timer_get_time();
+    *ret_gate = gate;
+    return ESP_OK;
+
+err:
+    app_motion_gate_delete(gate);
+    return ret;
+}
+
+void app_motion_gate_delete(app_motion_gate_t *gate)
+{
+    if (gate == NULL) {
+        return;
+    }
+
+    heap_caps_free(gate->sample.data);
+    heap_caps_free(gate->luma.data);
+    heap_caps_free(gate->cells);
+    heap_caps_free(gate);
+}
+
+static bool motion_check(app_motion_gate_t *gate, const uint16_t *frame)
+{
+    const app_motion_gate_config_t *cfg = &gate->config;
+    int cell_w = gate->luma.width / cfg->grid_cols;
+    int cell_h = gate->luma.height / cfg->grid_rows;
+    uint32_t cell_area = cell_w * cell_h;
+    int cell_num = cfg->grid_cols * cfg->grid_rows;
+    uint8_t cells[cell_num];
+
+    gate->frame.data = (uint8_t *)frame;
+    img_resize_nearest(&gate->frame, &gate->sample);
+    img_rgb565_to_gray((const uint16_t *)gate->sample.data, gate->luma.data, gate->luma.width * gate->luma.height);
+
+    int32_t delta_sum = 0;
+    for (int row = 0; row < cfg->grid_rows; row++) {
+        for (int col = 0; col < cfg->grid_cols; col++) {
+            int i = row * cfg->grid_cols + col;
+            cells[i] = img_box_sum_y8(&gate->luma, col * cell_w, row * cell_h, cell_w, cell_h) / cell_area;
+            delta_sum += (int32_t)cells[i] - gate->cells[i];
+        }
+    }
+
+    bool had_reference = gate->has_reference;
+    int changed = 0;
+    if (had_reference) {
+        /* Ignore a uniform brightness shift, e.g. from auto exposure */
+        int32_t global = delta_sum / cell_num;
+        for (int i = 0; i < cell_num; i++) {
+            int32_t diff = (int32_t)cells[i] - gate->cells[i] - global;
+            if (abs(diff) >= cfg->cell_threshold) {
+                changed++;
+            }
+        }
+    }
+
+    memcpy(gate->cells, cells, cell_num);
+    gate->has_reference = true;
+
+    return !had_reference || changed >= cfg->min_cells;
+}
+
+bool app_motion_gate_feed(app_motion_gate_t *gate, const uint16_t *frame)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    gate->motion = motion_check(gate, frame);
+    gate->frames_since_detect++;
+
+    int64_t now_us = esp_timer_get_time();
+    gate->stats.frames++;
+    gate->stats.motion_frames += gate->motion ? 1 : 0;
+    gate->stats.motion_time_us += now_us - start_us;
+
+    bool face_recent = gate->last_face_us && (now_us - gate->last_face_us) < (int64_t)gate->config.face_hold_ms * 1000;
+    bool active = (gate->motion || face_recent) && gate->frames_since_detect >= gate->config.active_interval_frames;
+    bool idle_due = (now_us - gate->last_detect_us) >= (int64_t)gate->config.idle_interval_ms * 1000;
+
+    return active || idle_due;
+}
+
+void app_motion_gate_report(app_motion_gate_t *gate, bool face_found, uint32_t detect_us)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    gate->frames_since_detect = 0;
+    gate->last_detect_us = now_us;
+    if (face_found) {
+        gate->last_face_us = now_us;
+    }
+
+    gate->stats.detect_runs++;
+    gate->stats.detect_time_us += detect_us;
+}
+
+bool app_motion_gate_has_motion(const app_motion_gate_t *gate)
+{
+    return gate->motion;
+}
+
+void app_motion_gate_get_stats(app_motion_gate_t *gate, app_motion_gate_stats_t *stats, bool reset)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    *stats = gate->stats;
+    stats->elapsed_us = now_us - gate->stats_start_us;
+
+    if (reset) {
+        memset(&gate->stats, 0, sizeof(gate->stats));
+        gate->stats_start_us = now_us;
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Motion gate configuration.
+ */
+typedef struct {
+    int sample_step;                                  /*!< Take one pixel every `sample_step` pixels in x and y */
+    int grid_cols;                                    /*!< Number of grid cells horizontally */
+    int grid_rows;                                    /*!< Number of grid cells vertically */
+    int cell_threshold;                               /*!< Mean luma change (0-255) for a cell to count as moving */
+    int min_cells;                                    /*!< Moving cells needed to report motion */
+    int active_interval_frames;                       /*!< Min frames between detections while there is activity */
+    uint32_t idle_interval_ms;                        /*!< Detection cadence on a static scene */
+    uint32_t face_hold_ms;                            /*!< Keep detecting this long after the last face */
+} app_motion_gate_config_t;
+
+#define APP_MOTION_GATE_DEFAULT_CONFIG() {                              \
+        .sample_step = 8,                                               \
+        .grid_cols = 16,                                                \
+        .grid_rows = 12,                                                \
+        .cell_threshold = CONFIG_APP_MOTION_GATE_CELL_THRESHOLD,        \
+        .min_cells = CONFIG_APP_MOTION_GATE_MIN_CELLS,                  \
+        .active_interval_frames = CONFIG_APP_MOTION_GATE_ACTIVE_INTERVAL, \
+        .idle_interval_ms = CONFIG_APP_MOTION_GATE_IDLE_INTERVAL_MS,    \
+        .face_hold_ms = CONFIG_APP_MOTION_GATE_FACE_HOLD_MS,            \
+    }
+
+/**
+ * @brief Motion gate statistics, accumulated since the last reset.
+ */
+typedef struct {
+    uint32_t frames;                                  /*!< Frames fed to the gate */
+    uint32_t motion_frames;                           /*!< Frames where motion was found */
+    uint32_t detect_runs;                             /*!< Detections the gate allowed */
+    uint64_t motion_time_us;                          /*!< Time spent in the motion check */
+    uint64_t detect_time_us;                          /*!< Time spent in the gated detections */
+    uint64_t elapsed_us;                              /*!< Wall time covered by these counters */
+} app_motion_gate_stats_t;
+
+typedef struct app_motion_gate_t app_motion_gate_t;
+
+/**
+ * @brief Create a motion gate for frames of the given size.
+ *
+ * @param config Gate configuration.
+ * @param width  Frame width in pixels.
+ * @param height Frame height in pixels.
+ * @param ret_gate Returned gate handle.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM on failure.
+ */
+esp_err_t app_motion_gate_new(const app_motion_gate_config_t *config, int width, int height, app_motion_gate_t **ret_gate);
+
+/**
+ * @brief Delete a motion gate.
+ */
+void app_motion_gate_delete(app_motion_gate_t *gate);
+
+/**
+ * @brief Run the motion check on a frame and decide whether the detector should run on it.
+ *
+ * The frame is sampled on a sparse grid into a small luma image, whose per-cell means are
+ * compared against the previous frame after removing the global brightness change. Detection
+ * is allowed when there is motion or a face was seen recently (at most every
+ * `active_interval_frames`), or when `idle_interval_ms` passed since the last detection.
+ *
+ * @param gate  Gate handle.
+ * @param frame RGB565 frame, read only.
+ * @return true if the detector should run on this frame.
+ */
+bool app_motion_gate_feed(app_motion_gate_t *gate, const uint16_t *frame);
+
+/**
+ * @brief Report the outcome of a detection the gate allowed.
+ *
+ * @param gate       Gate handle.
+ * @param face_found Whether the detection found a face.
+ * @param detect_us  Time the detection took.
+ */
+void app_motion_gate_report(app_motion_gate_t *gate, bool face_found, uint32_t detect_us);
+
+/**
+ * @brief Whether the last fed frame contained motion.
+ */
+bool app_motion_gate_has_motion(const app_motion_gate_t *gate);
+
+/**
+ * @brief Get the gate statistics.
+ *
+ * @param gate  Gate handle.
+ * @param stats Returned statistics.
+ * @param reset Start a new statistics window after reading.
+ */
+void app_motion_gate_get_stats(app_motion_gate_t *gate, app_motion_gate_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,184 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "img_kernels.h"
+#include "app_presence_detect.h"
+
+static const char *TAG = "app_presence";
+
+struct app_presence_t {
+    app_presence_config_t config;
+    img_buf_t frame;                                  /* Full frame view, data set per feed */
+    img_buf_t luma;                                   /* Downsampled luma of the last frame */
+    uint16_t *background;                             /* Background luma, 8.8 fixed point */
+    int pixel_num;
+    bool has_background;
+    bool present;
+    int area;
+    int enter_count;
+    int64_t last_sample_us;
+    int64_t last_active_us;
+};
+
+esp_err_t app_presence_new(const app_presence_config_t *config, int width, int height, app_presence_t **ret_presence)
+{
+    esp_err_t ret = ESP_OK;
+    app_presence_t *presence = NULL;
+
+    ESP_RETURN_ON_FALSE(config && ret_presence && width > 0 && height > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+    ESP_RETURN_ON_FALSE(config->downsample > 0 && config->learn_shift > 0 && config->learn_shift < 8,
+                        ESP_ERR_INVALID_ARG, TAG, "Invalid configuration");
+
+    int luma_w = width / config->downsample;
+    int luma_h = height / config->downsample;
+    ESP_RETURN_ON_FALSE(luma_w > 0 && luma_h > 0, ESP_ERR_INVALID_ARG, TAG, "Frame is smaller than the downsample factor");
+
+    presence = (app_presence_t *)heap_caps_calloc(1, sizeof(app_presence_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(presence, ESP_ERR_NO_MEM, TAG, "Failed to allocate presence detector");
+    presence->config = *config;
+    presence->pixel_num = luma_w * luma_h;
+
+    img_buf_init(&presence->frame, NULL, width, height, IMG_FMT_RGB565);
+
+    void *luma_data = heap_caps_malloc(presence->pixel_num, MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(luma_data, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate luma buffer");
+    img_buf_init(&presence->luma, luma_data, luma_w, luma_h, IMG_FMT_Y8);
+
+    presence->background = (uint16_t *)heap_caps_malloc(presence->pixel_num * sizeof(uint16_t), MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(presence->background, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate background");
+
+    *ret_presence = presence;
+    return ESP_OK;
+
+err:
+    app_presence_delete(presence);
+    return ret;
+}
+
+void app_presence_delete(app_presence_t *presence)
+{
+    if (presence == NULL) {
+        return;
+    }
+
+    heap_caps_free(presence->luma.data);
+    heap_caps_free(presence->background);
+    heap_caps_free(presence);
+}
+
+bool app_presence_due(const app_presence_t *presence)
+{
+    return (esp_timer_get_time() - presence->last_sample_us) >= (int64_t)presence->config.sample_interval_ms * 1000;
+}
+
+static void background_set(app_presence_t *presence)
+{
+    const uint8_t *luma = presence->luma.data;
+    uint16_t *bg = presence->background;
+
+    for (int i = 0; i < presence->pixel_num; i++) {
+        bg[i] = (uint16_t)luma[i] << 8;
+    }
+}
+
+app_presence_event_t app_presence_feed(app_presence_t *presence, const uint16_t *frame)
+{
+    const app_presence_config_t *cfg = &presence->config;
+    int64_t now_us = esp_timer_get_time();
+
+    presence->last_sample_us = now_us;
+    presence->frame.data = (uint8_t *)frame;
+    img_rgb565_to_gray_downsample(&presence->frame, cfg->downsample, &presence->luma);
+
+    const uint8_t *luma = presence->luma.data;
+    uint16_t *bg = presence->background;
+
+    if (!presence->has_background) {
+        background_set(presence);
+        presence->has_background = true;
+        presence->last_active_us = now_us;
+        return APP_PRESENCE_EVENT_NONE;
+    }
+
+    /* Ignore a uniform brightness shift, e.g. from auto exposure. The median difference is
+     * used, a person filling part of the frame would drag the mean along. */
+    uint16_t hist[511] = {0};
+    for (int i = 0; i < presence->pixel_num; i++) {
+        hist[(int32_t)luma[i] - (bg[i] >> 8) + 255]++;
+    }
+    int32_t global = -255;
+    for (int count = 0; global < 255; global++) {
+        count += hist[global + 255];
+        if (count * 2 >= presence->pixel_num) {
+            break;
+        }
+    }
+
+    /* Foreground pixels adapt 8x slower, so a person standing still is not absorbed right away */
+    int foreground = 0;
+    for (int i = 0; i < presence->pixel_num; i++) {
+        int32_t target = (int32_t)luma[i] << 8;
+        int32_t diff = (int32_t)luma[i] - (bg[i] >> 8) - global;
+        bool fg = abs(diff) >= cfg->pixel_threshold;
+        foreground += fg ? 1 : 0;
+        bg[i] += (target - bg[i]) >> (fg ? cfg->learn_shift + 3 : cfg->learn_shift);
+    }
+    presence->area = foreground * 1000 / presence->pixel_num;
+
+    bool active = presence->area >= cfg->enter_permille;
+    if (active) {
+        presence->last_active_us = now_us;
+    }
+
+    if (!presence->present) {
+        presence->enter_count = active ? presence->enter_count + 1 : 0;
+        if (presence->enter_count >= cfg->enter_samples) {
+            presence->present = true;
+            presence->enter_count = 0;
+            ESP_LOGD(TAG, "Enter, area %d", presence->area);
+            return APP_PRESENCE_EVENT_ENTER;
+        }
+    } else if ((now_us - presence->last_active_us) >= (int64_t)cfg->leave_ms * 1000) {
+        presence->present = false;
+        ESP_LOGD(TAG, "Leave, area %d", presence->area);
+        return APP_PRESENCE_EVENT_LEAVE;
+    }
+
+    return APP_PRESENCE_EVENT_NONE;
+}
+
+void app_presence_reject(app_presence_t *presence)
+{
+    if (presence->has_background) {
+        background_set(presence);
+    }
+    presence->present = false;
+    presence->enter_count = 0;
+}
+
+void app_presence_reset(app_presence_t *presence)
+{
+    presence->has_background = false;
+    presence->present = false;
+    presence->enter_count = 0;
+    presence->area = 0;
+}
+
+bool app_presence_is_present(const app_presence_t *presence)
+{
+    return presence->present;
+}
+
+int app_presence_get_area(const app_presence_t *presence)
+{
+    return presence->area;
+}
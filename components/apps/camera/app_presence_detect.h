@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Presence detector configuration.
+ */
+typedef struct {
+    int downsample;                                   /*!< Frame is averaged down by this factor in x and y */
+    uint32_t sample_interval_ms;                      /*!< Minimum time between two analysed frames */
+    int pixel_threshold;                              /*!< Luma difference (0-255) to the background for a foreground pixel */
+    int enter_permille;                               /*!< Foreground area (per mille of the frame) that counts as someone present */
+    int enter_samples;                                /*!< Consecutive samples above `enter_permille` before reporting presence */
+    uint32_t leave_ms;                                /*!< Time below the threshold before reporting that the person left */
+    int learn_shift;                                  /*!< Background learning rate, 1 / 2^learn_shift per sample */
+} app_presence_config_t;
+
+#define APP_PRESENCE_DEFAULT_CONFIG() {                                     \
+        .downsample = 16,                                                   \
+        .sample_interval_ms = CONFIG_APP_PRESENCE_SAMPLE_INTERVAL_MS,       \
+        .pixel_threshold = CONFIG_APP_PRESENCE_PIXEL_THRESHOLD,             \
+        .enter_permille = CONFIG_APP_PRESENCE_ENTER_PERMILLE,               \
+        .enter_samples = 2,                                                 \
+        .leave_ms = CONFIG_APP_PRESENCE_LEAVE_MS,                           \
+        .learn_shift = 3,                                                   \
+    }
+
+typedef enum {
+    APP_PRESENCE_EVENT_NONE = 0,                      /*!< Nothing changed, or the frame was not analysed */
+    APP_PRESENCE_EVENT_ENTER,                         /*!< Someone showed up in front of the camera */
+    APP_PRESENCE_EVENT_LEAVE,                         /*!< The scene is back to the background */
+} app_presence_event_t;
+
+typedef struct app_presence_t app_presence_t;
+
+/**
+ * @brief Create a presence detector for frames of the given size.
+ *
+ * @param config Detector configuration.
+ * @param width  Frame width in pixels.
+ * @param height Frame height in pixels.
+ * @param ret_presence Returned detector handle.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG or ESP_ERR_NO_MEM on failure.
+ */
+esp_err_t app_presence_new(const app_presence_config_t *config, int width, int height, app_presence_t **ret_presence);
+
+/**
+ * @brief Delete a presence detector.
+ */
+void app_presence_delete(app_presence_t *presence);
+
+/**
+ * @brief Whether the next frame should be fed, i.e. `sample_interval_ms` passed since the last one.
+ *
+ * Cheap enough to call for every camera frame.
+ */
+bool app_presence_due(const app_presence_t *presence);
+
+/**
+ * @brief Analyse a frame.
+ *
+ * The frame is averaged down to a small luma image and compared against a background that is
+ * learned over time, so a person standing still in front of the machine keeps counting as
+ * present. Uniform brightness changes are ignored.
+ *
+ * @param presence Detector handle.
+ * @param frame    RGB565 frame, read only.
+ * @return Presence change caused by this frame.
+ */
+app_presence_event_t app_presence_feed(app_presence_t *presence, const uint16_t *frame);
+
+/**
+ * @brief Reject the last reported presence, e.g. when a person detector did not confirm it.
+ *
+ * The current foreground is merged into the background so the same scene does not trigger again.
+ */
+void app_presence_reject(app_presence_t *presence);
+
+/**
+ * @brief Forget the background, e.g. after the camera was used for something else.
+ */
+void app_presence_reset(app_presence_t *presence);
+
+/**
+ * @brief Whether someone is currently present.
+ */
+bool app_presence_is_present(const app_presence_t *presence);
+
+/**
+ * @brief Foreground area of the last analysed frame, per mille of the frame.
+ */
+int app_presence_get_area(const app_presence_t *presence);
+
+#ifdef __cplusplus
+}
+#endif
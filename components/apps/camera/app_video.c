@@ -40,6 +40,7 @@ typedef struct {
     app_video_frame_operation_cb_t user_camera_video_frame_operation_cb;
     TaskHandle_t video_stream_task_handle;
     EventGroupHandle_t video_event_group;
+    volatile uint32_t frame_interval_ms;
 } app_video_t;
 
 static app_video_t app_camera_video;
@@ -78,7 +79,7 @@ esp_err_t app_video_main(i2c_master_bus_handle_t i2c_bus_handle)
     return esp_video_init(&cam_config);
 }
 
-int app_video_open(char *dev, video_fmt_t init_fmt)
+int app_video_open(const char *dev, video_fmt_t init_fmt)
 {
     struct v4l2_format default_format;
     struct v4l2_capability capability;
@@ -354,6 +355,13 @@ static void video_stream_task(void *arg)
 
         ESP_ERROR_CHECK(video_free_video_frame(video_fd));
 
+        uint32_t interval_ms = app_camera_video.frame_interval_ms;
+        if (interval_ms) {
+            // Hold off the next dequeue, the driver drops the frames that find no free buffer
+            xEventGroupWaitBits(app_camera_video.video_event_group, VIDEO_TASK_DELETE, pdFALSE, pdFALSE,
+                                pdMS_TO_TICKS(interval_ms));
+        }
+
         if(xEventGroupGetBits(app_camera_video.video_event_group) & VIDEO_TASK_DELETE) {
             xEventGroupClearBits(app_camera_video.video_event_group, VIDEO_TASK_DELETE);
             ESP_ERROR_CHECK(video_stream_stop(video_fd));
@@ -393,6 +401,13 @@ esp_err_t app_video_stream_task_stop(int video_fd)
     return ESP_OK;
 }
 
+esp_err_t app_video_set_frame_interval(uint32_t interval_ms)
+{
+    app_camera_video.frame_interval_ms = interval_ms;
+
+    return ESP_OK;
+}
+
 esp_err_t app_video_register_frame_operation_cb(app_video_frame_operation_cb_t operation_cb)
 {
     app_camera_video.user_camera_video_frame_operation_cb = operation_cb;
@@ -56,7 +56,7 @@ esp_err_t app_video_main(i2c_master_bus_handle_t i2c_bus_handle);
  * @return Returns the file descriptor for the opened video device on success;
  *         returns -1 on failure, indicating an error occurred during the operation.
  */
-int app_video_open(char *dev, video_fmt_t init_fmt);
+int app_video_open(const char *dev, video_fmt_t init_fmt);
 
 /**
  * @brief Set up video capture buffers.
@@ -120,6 +120,18 @@ esp_err_t app_video_stream_task_start(int video_fd, int core_id);
  */
 esp_err_t app_video_stream_task_stop(int video_fd);
 
+/**
+ * @brief Limit the rate at which frames reach the frame operation callback.
+ *
+ * The stream task waits `interval_ms` after handing back each frame. The sensor keeps running,
+ * but once every buffer is filled the driver drops frames instead of converting and copying
+ * them, so the callback gets at most one frame per interval, up to one interval old.
+ *
+ * @param interval_ms Minimum time between two frames, 0 for the full sensor rate.
+ * @return ESP_OK on success.
+ */
+esp_err_t app_video_set_frame_interval(uint32_t interval_ms);
+
 /**
  * @brief Register a callback for frame operations.
  *
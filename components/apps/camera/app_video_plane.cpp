@@ -0,0 +1,304 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_cache.h"
+#include "esp_heap_caps.h"
+#include "driver/ppa.h"
+#include "img_kernels.h"
+#include "app_detect_overlay.h"
+#include "display/app_fb_sync.h"
+#include "app_video_plane.h"
+
+#define PLANE_BOX_BORDER_WIDTH              (3)
+#define PLANE_KEYPOINT_SIZE                 (7)
+#define PLANE_BOX_COLOR                     (0xFF0000)
+#define PLANE_KEYPOINT_COLOR                (0x00FF00)
+
+static const char *TAG = "app_video_plane";
+
+struct app_video_plane_t {
+    lv_disp_t *disp;
+    void *fbs[2];
+    size_t fb_size;
+    int hor_res;
+    int ver_res;
+    ppa_client_handle_t ppa;
+
+    lv_area_t window;
+    int src_x;
+    int src_y;
+    lv_obj_t *excludes[APP_VIDEO_PLANE_MAX_EXCLUDES];
+    int exclude_num;
+
+    lv_area_t boxes[DETECT_OVERLAY_BOX_MAX];
+    int box_num;
+    lv_area_t points[DETECT_OVERLAY_BOX_MAX * DETECT_OVERLAY_KEYPOINT_NUM];
+    int point_num;
+
+    lv_area_t rects[APP_VIDEO_PLANE_MAX_RECTS];
+    int rect_num;
+};
+
+esp_err_t app_video_plane_new(lv_disp_t *disp, app_video_plane_t **ret_plane)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->driver && ret_plane, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    lv_disp_drv_t *drv = disp->driver;
+    lv_disp_draw_buf_t *draw_buf = drv->draw_buf;
+    uint32_t px = (uint32_t)drv->hor_res * drv->ver_res;
+    ESP_RETURN_ON_FALSE(drv->direct_mode && draw_buf && draw_buf->buf1 && draw_buf->buf2 && draw_buf->size >= px,
+                        ESP_ERR_NOT_SUPPORTED, TAG, "Display does not render to two full frame buffers");
+
+    app_video_plane_t *plane = (app_video_plane_t *)heap_caps_calloc(1, sizeof(app_video_plane_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(plane, ESP_ERR_NO_MEM, TAG, "Failed to allocate video plane");
+
+    ppa_client_config_t ppa_config = {};
+    ppa_config.oper_type = PPA_OPERATION_SRM;
+    ppa_config.max_pending_trans_num = 1;
+    esp_err_t ret = ppa_register_client(&ppa_config, &plane->ppa);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register PPA client");
+        heap_caps_free(plane);
+        return ret;
+    }
+
+    plane->disp = disp;
+    plane->fbs[0] = draw_buf->buf1;
+    plane->fbs[1] = draw_buf->buf2;
+    plane->hor_res = drv->hor_res;
+    plane->ver_res = drv->ver_res;
+    plane->fb_size = px * sizeof(lv_color_t);
+    lv_area_set(&plane->window, 0, 0, plane->hor_res - 1, plane->ver_res - 1);
+
+    *ret_plane = plane;
+    return ESP_OK;
+}
+
+void app_video_plane_delete(app_video_plane_t *plane)
+{
+    if (plane == NULL) {
+        return;
+    }
+
+    ppa_unregister_client(plane->ppa);
+    heap_caps_free(plane);
+}
+
+void app_video_plane_set_window(app_video_plane_t *plane, const lv_area_t *area, int src_x, int src_y)
+{
+    lv_area_t screen;
+    lv_area_set(&screen, 0, 0, plane->hor_res - 1, plane->ver_res - 1);
+    if (!_lv_area_intersect(&plane->window, area, &screen)) {
+        lv_area_set(&plane->window, 0, 0, -1, -1);
+    }
+    plane->src_x = src_x + (plane->window.x1 - area->x1);
+    plane->src_y = src_y + (plane->window.y1 - area->y1);
+}
+
+esp_err_t app_video_plane_exclude(app_video_plane_t *plane, lv_obj_t *obj)
+{
+    ESP_RETURN_ON_FALSE(obj, ESP_ERR_INVALID_ARG, TAG, "Invalid object");
+    ESP_RETURN_ON_FALSE(plane->exclude_num < APP_VIDEO_PLANE_MAX_EXCLUDES, ESP_ERR_NO_MEM, TAG, "Too many excluded widgets");
+
+    plane->excludes[plane->exclude_num++] = obj;
+    return ESP_OK;
+}
+
+void app_video_plane_clear_excludes(app_video_plane_t *plane)
+{
+    plane->exclude_num = 0;
+}
+
+static lv_area_t frame_to_screen(const app_video_plane_t *plane, int x1, int y1, int x2, int y2)
+{
+    lv_area_t area;
+    int dx = plane->window.x1 - plane->src_x;
+    int dy = plane->window.y1 - plane->src_y;
+    lv_area_set(&area, x1 + dx, y1 + dy, x2 + dx, y2 + dy);
+    return area;
+}
+
+void app_video_plane_set_boxes(app_video_plane_t *plane, const std::list<dl::detect::result_t> &results, bool show_keypoints)
+{
+    plane->box_num = 0;
+    plane->point_num = 0;
+
+    for (const auto &res : results) {
+        if (plane->box_num >= DETECT_OVERLAY_BOX_MAX) {
+            break;
+        }
+        if (res.box.size() < 4 || res.box[2] <= res.box[0] || res.box[3] <= res.box[1]) {
+            continue;
+        }
+        plane->boxes[plane->box_num++] = frame_to_screen(plane, res.box[0], res.box[1], res.box[2], res.box[3]);
+
+        if (!show_keypoints || res.keypoint.size() < DETECT_OVERLAY_KEYPOINT_NUM * 2) {
+            continue;
+        }
+        for (int k = 0; k < DETECT_OVERLAY_KEYPOINT_NUM; k++) {
+            int x = res.keypoint[2 * k];
+            int y = res.keypoint[2 * k + 1];
+            plane->points[plane->point_num++] = frame_to_screen(plane, x - PLANE_KEYPOINT_SIZE / 2, y - PLANE_KEYPOINT_SIZE / 2,
+                                                                x + PLANE_KEYPOINT_SIZE / 2, y + PLANE_KEYPOINT_SIZE / 2);
+        }
+    }
+}
+
+/* Split `a` into the parts not covered by `cut` */
+static int area_subtract(const lv_area_t *a, const lv_area_t *cut, lv_area_t *out)
+{
+    lv_area_t c;
+    if (!_lv_area_intersect(&c, a, cut)) {
+        out[0] = *a;
+        return 1;
+    }
+
+    int n = 0;
+    if (c.y1 > a->y1) {
+        lv_area_set(&out[n++], a->x1, a->y1, a->x2, c.y1 - 1);
+    }
+    if (c.y2 < a->y2) {
+        lv_area_set(&out[n++], a->x1, c.y2 + 1, a->x2, a->y2);
+    }
+    if (c.x1 > a->x1) {
+        lv_area_set(&out[n++], a->x1, c.y1, c.x1 - 1, c.y2);
+    }
+    if (c.x2 < a->x2) {
+        lv_area_set(&out[n++], c.x2 + 1, c.y1, a->x2, c.y2);
+    }
+    return n;
+}
+
+static void plane_update_rects(app_video_plane_t *plane, uint32_t width, uint32_t height)
+{
+    lv_area_t frame = frame_to_screen(plane, 0, 0, width - 1, height - 1);
+
+    plane->rect_num = 0;
+    if (!_lv_area_intersect(&plane->rects[0], &plane->window, &frame)) {
+        return;
+    }
+    plane->rect_num = 1;
+
+    for (int i = 0; i < plane->exclude_num; i++) {
+        lv_obj_t *obj = plane->excludes[i];
+        if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN)) {
+            continue;
+        }
+
+        lv_area_t cut;
+        lv_obj_get_coords(obj, &cut);
+        lv_area_increase(&cut, _lv_obj_get_ext_draw_size(obj), _lv_obj_get_ext_draw_size(obj));
+
+        lv_area_t next[APP_VIDEO_PLANE_MAX_RECTS];
+        int next_num = 0;
+        for (int r = 0; r < plane->rect_num; r++) {
+            lv_area_t parts[4];
+            int part_num = area_subtract(&plane->rects[r], &cut, parts);
+            if (next_num + part_num > APP_VIDEO_PLANE_MAX_RECTS) {
+                ESP_LOGW(TAG, "Too many rectangles, widget %d is drawn over", i);
+                return;
+            }
+            memcpy(&next[next_num], parts, part_num * sizeof(lv_area_t));
+            next_num += part_num;
+        }
+        memcpy(plane->rects, next, next_num * sizeof(lv_area_t));
+        plane->rect_num = next_num;
+    }
+}
+
+static void plane_fill(app_video_plane_t *plane, img_buf_t *fb, const lv_area_t *area, uint32_t color)
+{
+    for (int r = 0; r < plane->rect_num; r++) {
+        lv_area_t clip;
+        if (!_lv_area_intersect(&clip, area, &plane->rects[r])) {
+            continue;
+        }
+        img_fill_rect(fb, clip.x1, clip.y1, lv_area_get_width(&clip), lv_area_get_height(&clip), color);
+    }
+}
+
+static void plane_paint_boxes(app_video_plane_t *plane, void *buffer)
+{
+    if (plane->box_num == 0) {
+        return;
+    }
+
+    img_buf_t fb;
+    img_buf_init(&fb, buffer, plane->hor_res, plane->ver_res, IMG_FMT_RGB565);
+    uint32_t box_color = lv_color_hex(PLANE_BOX_COLOR).full;
+    uint32_t point_color = lv_color_hex(PLANE_KEYPOINT_COLOR).full;
+    int y_min = plane->ver_res;
+    int y_max = -1;
+
+    for (int i = 0; i < plane->box_num; i++) {
+        const lv_area_t *b = &plane->boxes[i];
+        lv_area_t edges[4];
+        lv_area_set(&edges[0], b->x1, b->y1, b->x2, b->y1 + PLANE_BOX_BORDER_WIDTH - 1);
+        lv_area_set(&edges[1], b->x1, b->y2 - PLANE_BOX_BORDER_WIDTH + 1, b->x2, b->y2);
+        lv_area_set(&edges[2], b->x1, b->y1, b->x1 + PLANE_BOX_BORDER_WIDTH - 1, b->y2);
+        lv_area_set(&edges[3], b->x2 - PLANE_BOX_BORDER_WIDTH + 1, b->y1, b->x2, b->y2);
+        for (int e = 0; e < 4; e++) {
+            plane_fill(plane, &fb, &edges[e], box_color);
+        }
+        y_min = LV_MIN(y_min, b->y1);
+        y_max = LV_MAX(y_max, b->y2);
+    }
+    for (int i = 0; i < plane->point_num; i++) {
+        plane_fill(plane, &fb, &plane->points[i], point_color);
+        y_min = LV_MIN(y_min, plane->points[i].y1);
+        y_max = LV_MAX(y_max, plane->points[i].y2);
+    }
+
+    /* The PPA wrote around the CPU cache, the boxes went through it: write them back for the DPI */
+    y_min = LV_MAX(y_min, 0);
+    y_max = LV_MIN(y_max, plane->ver_res - 1);
+    if (y_max >= y_min) {
+        esp_cache_msync((uint8_t *)buffer + (size_t)y_min * fb.stride, (size_t)(y_max - y_min + 1) * fb.stride,
+                        ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+    }
+}
+
+esp_err_t app_video_plane_draw(app_video_plane_t *plane, const void *frame, uint32_t width, uint32_t height)
+{
+    ESP_RETURN_ON_FALSE(plane && frame, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    plane_update_rects(plane, width, height);
+    // The boxes are painted by the CPU, keep them off cache lines a buffer sync is still writing
+    app_fb_sync_wait();
+
+    for (int f = 0; f < 2; f++) {
+        for (int r = 0; r < plane->rect_num; r++) {
+            const lv_area_t *rect = &plane->rects[r];
+            ppa_srm_oper_config_t srm = {};
+            srm.in.buffer = frame;
+            srm.in.pic_w = width;
+            srm.in.pic_h = height;
+            srm.in.block_w = lv_area_get_width(rect);
+            srm.in.block_h = lv_area_get_height(rect);
+            srm.in.block_offset_x = rect->x1 - plane->window.x1 + plane->src_x;
+            srm.in.block_offset_y = rect->y1 - plane->window.y1 + plane->src_y;
+            srm.in.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+            srm.out.buffer = plane->fbs[f];
+            srm.out.buffer_size = plane->fb_size;
+            srm.out.pic_w = plane->hor_res;
+            srm.out.pic_h = plane->ver_res;
+            srm.out.block_offset_x = rect->x1;
+            srm.out.block_offset_y = rect->y1;
+            srm.out.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+            srm.rotation_angle = PPA_SRM_ROTATION_ANGLE_0;
+            srm.scale_x = 1.0f;
+            srm.scale_y = 1.0f;
+            srm.mode = PPA_TRANS_MODE_BLOCKING;
+            ESP_RETURN_ON_ERROR(ppa_do_scale_rotate_mirror(plane->ppa, &srm), TAG, "PPA blit failed");
+        }
+        plane_paint_boxes(plane, plane->fbs[f]);
+    }
+
+    return ESP_OK;
+}
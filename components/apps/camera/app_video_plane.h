@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <list>
+#include "esp_err.h"
+#include "lvgl.h"
+#include "dl_detect_base.hpp"
+
+#define APP_VIDEO_PLANE_MAX_EXCLUDES        (8)       /*!< Widgets that can sit on top of the video */
+#define APP_VIDEO_PLANE_MAX_RECTS           (32)      /*!< Rectangles the visible window is split into */
+
+typedef struct app_video_plane_t app_video_plane_t;
+
+/**
+ * @brief Create a video plane on a display.
+ *
+ * The plane copies camera frames with the PPA straight into both DPI frame buffers that LVGL
+ * renders to in direct mode, so a preview frame costs one 2D-DMA copy per buffer instead of a
+ * full LVGL refresh. LVGL keeps rendering its widgets on its own schedule; areas covered by
+ * excluded widgets are left untouched, detection boxes are painted by the plane itself.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED if the display does not render in direct mode to two full
+ *         frame buffers.
+ */
+esp_err_t app_video_plane_new(lv_disp_t *disp, app_video_plane_t **ret_plane);
+
+/**
+ * @brief Delete a video plane.
+ */
+void app_video_plane_delete(app_video_plane_t *plane);
+
+/**
+ * @brief Set where frames appear on screen.
+ *
+ * @param area  Screen area showing the frame, clipped to the display.
+ * @param src_x Frame column shown at `area->x1`.
+ * @param src_y Frame row shown at `area->y1`.
+ */
+void app_video_plane_set_window(app_video_plane_t *plane, const lv_area_t *area, int src_x, int src_y);
+
+/**
+ * @brief Keep the plane from drawing over a widget (including its shadow and outline).
+ *
+ * Hidden widgets are ignored. Excluded widgets must outlive the plane or be removed with
+ * app_video_plane_clear_excludes().
+ */
+esp_err_t app_video_plane_exclude(app_video_plane_t *plane, lv_obj_t *obj);
+
+/**
+ * @brief Forget all excluded widgets.
+ */
+void app_video_plane_clear_excludes(app_video_plane_t *plane);
+
+/**
+ * @brief Detection boxes painted over the following frames, in frame coordinates.
+ */
+void app_video_plane_set_boxes(app_video_plane_t *plane, const std::list<dl::detect::result_t> &results, bool show_keypoints);
+
+/**
+ * @brief Put one RGB565 frame on screen.
+ *
+ * Must be called with the display lock held, so LVGL is not rendering into the frame buffers.
+ */
+esp_err_t app_video_plane_draw(app_video_plane_t *plane, const void *frame, uint32_t width, uint32_t height);
@@ -0,0 +1,414 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "app_anim.h"
+
+#define ANIM_PX_SIZE                        (LV_IMG_PX_SIZE_ALPHA_BYTE)
+#define ANIM_MIN_DELAY_MS                   (10)                /* lv_gif's timer period, for frames without a delay */
+#define ANIM_MAX_LATE_MS                    (200)               /* Restart the pacing rather than catch up */
+#define ANIM_DECODE_PERIOD_MS               (20)                /* Period of the timer building the cache */
+#define ANIM_DECODE_SLICE_US                (4000)              /* LVGL task time it may take per period */
+
+static const char *TAG = "app_anim";
+
+typedef struct {
+    lv_area_t area;                                   /* Changed pixels in the canvas, x2 < x1 if none */
+    uint32_t delay_ms;                                /* Time the frame stays on screen */
+    uint8_t *data;                                    /* The area's pixels, ANIM_PX_SIZE bytes each */
+} anim_frame_t;
+
+typedef struct app_anim_t {
+    lv_obj_t *obj;                                    /* Container placed by the caller */
+    lv_obj_t *player;                                 /* lv_img over the canvas, or lv_gif when decoding live */
+    lv_timer_t *timer;                                /* Ours, or lv_gif's when decoding live */
+    lv_timer_cb_t gif_timer_cb;                       /* lv_gif's own, wrapped for timing */
+    lv_img_dsc_t img;                                 /* Over the canvas */
+    const void *src;
+    gd_GIF *decoder;                                  /* Open while the cache is being built */
+    lv_timer_t *decode_timer;
+    size_t max_bytes;
+    uint8_t *canvas;
+    anim_frame_t *frames;
+    uint32_t frame_num;
+    uint32_t frame_cap;
+    uint32_t frame;                                   /* On screen */
+    uint32_t next_ms;                                 /* LVGL tick the next frame is due at */
+    int64_t run_start_us;                             /* 0 while paused */
+    int64_t period_start_us;
+    app_anim_stats_t stats;
+} app_anim_t;
+
+static void anim_count_step(app_anim_t *anim, int64_t start_us)
+{
+    uint32_t time_us = esp_timer_get_time() - start_us;
+    anim->stats.step_us += time_us;
+    if (time_us > anim->stats.max_step_us) {
+        anim->stats.max_step_us = time_us;
+    }
+}
+
+static void anim_free_cache(app_anim_t *anim)
+{
+    for (uint32_t i = 0; i < anim->frame_num; i++) {
+        heap_caps_free(anim->frames[i].data);
+    }
+    heap_caps_free(anim->frames);
+    heap_caps_free(anim->canvas);
+    anim->frames = NULL;
+    anim->frame_num = 0;
+    anim->frame_cap = 0;
+    anim->canvas = NULL;
+    anim->stats.cache_bytes = 0;
+}
+
+/* Opens the GIF and allocates the canvas, anim_decode_frames() then fills the cache */
+static esp_err_t anim_decode_begin(app_anim_t *anim)
+{
+    int64_t start_us = esp_timer_get_time();
+    anim->decoder = (lv_img_src_get_type(anim->src) == LV_IMG_SRC_FILE) ? gd_open_gif_file((const char *)anim->src) :
+                    gd_open_gif_data(((const lv_img_dsc_t *)anim->src)->data);
+    ESP_RETURN_ON_FALSE(anim->decoder, ESP_ERR_NOT_FOUND, TAG, "Can not open the GIF");
+
+    gd_GIF *gif = anim->decoder;
+    size_t total = gif->width * ANIM_PX_SIZE * gif->height;
+    ESP_RETURN_ON_FALSE(total <= anim->max_bytes, ESP_ERR_NO_MEM, TAG, "%dx%d canvas is over the budget",
+                        gif->width, gif->height);
+    anim->canvas = heap_caps_calloc(1, total, MALLOC_CAP_SPIRAM);
+    ESP_RETURN_ON_FALSE(anim->canvas, ESP_ERR_NO_MEM, TAG, "No memory for the canvas");
+    anim->stats.cache_bytes = total;
+
+    anim->img.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    anim->img.header.w = gif->width;
+    anim->img.header.h = gif->height;
+    anim->img.data_size = total;
+    anim->img.data = anim->canvas;
+    anim->stats.decode_us = esp_timer_get_time() - start_us;
+    return ESP_OK;
+}
+
+/* Decodes frames into the cache for about `time_us`, sets `done` once the last one is in */
+static esp_err_t anim_decode_frames(app_anim_t *anim, int64_t time_us, bool *done)
+{
+    gd_GIF *gif = anim->decoder;
+    const uint32_t stride = gif->width * ANIM_PX_SIZE;
+    int64_t start_us = esp_timer_get_time();
+    *done = false;
+
+    // The canvas follows the decoded frames, so each frame is compared with the one before it
+    int ret;
+    while ((ret = gd_get_frame(gif)) > 0) {
+        gd_render_frame(gif, gif->canvas);
+
+        // The first frame is kept whole, playback restarts from it
+        lv_area_t area = { .x1 = gif->width, .y1 = gif->height, .x2 = -1, .y2 = -1 };
+        if (anim->frame_num == 0) {
+            area = (lv_area_t) { .x1 = 0, .y1 = 0, .x2 = gif->width - 1, .y2 = gif->height - 1 };
+        }
+        for (int y = 0; y < gif->height && anim->frame_num > 0; y++) {
+            const uint8_t *src = gif->canvas + y * stride;
+            const uint8_t *dst = anim->canvas + y * stride;
+            if (memcmp(src, dst, stride) == 0) {
+                continue;
+            }
+            int first = 0;
+            int last = stride - 1;
+            while (src[first] == dst[first]) {
+                first++;
+            }
+            while (src[last] == dst[last]) {
+                last--;
+            }
+            area.x1 = LV_MIN(area.x1, first / ANIM_PX_SIZE);
+            area.x2 = LV_MAX(area.x2, last / ANIM_PX_SIZE);
+            area.y1 = LV_MIN(area.y1, y);
+            area.y2 = y;
+        }
+
+        if (anim->frame_num == anim->frame_cap) {
+            uint32_t frame_cap = anim->frame_cap ? anim->frame_cap * 2 : 16;
+            anim_frame_t *frames = heap_caps_realloc(anim->frames, frame_cap * sizeof(anim_frame_t), MALLOC_CAP_DEFAULT);
+            ESP_RETURN_ON_FALSE(frames, ESP_ERR_NO_MEM, TAG, "No memory for %d frames", (int)frame_cap);
+            anim->frames = frames;
+            anim->frame_cap = frame_cap;
+        }
+        anim_frame_t *frame = &anim->frames[anim->frame_num++];
+        frame->area = area;
+        frame->delay_ms = LV_MAX(gif->gce.delay * 10, ANIM_MIN_DELAY_MS);
+        frame->data = NULL;
+        if (area.x2 >= area.x1) {
+            uint32_t row_size = lv_area_get_width(&area) * ANIM_PX_SIZE;
+            size_t size = row_size * lv_area_get_height(&area);
+            ESP_RETURN_ON_FALSE(anim->stats.cache_bytes + size <= anim->max_bytes, ESP_ERR_NO_MEM, TAG,
+                                "%d frames are over the budget", (int)anim->frame_num);
+            frame->data = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+            ESP_RETURN_ON_FALSE(frame->data, ESP_ERR_NO_MEM, TAG, "No memory for frame %d", (int)anim->frame_num);
+            anim->stats.cache_bytes += size;
+            for (int y = area.y1; y <= area.y2; y++) {
+                uint32_t offset = y * stride + area.x1 * ANIM_PX_SIZE;
+                memcpy(frame->data + (y - area.y1) * row_size, gif->canvas + offset, row_size);
+                memcpy(anim->canvas + offset, gif->canvas + offset, row_size);
+            }
+        }
+
+        if (esp_timer_get_time() - start_us >= time_us) {
+            break;
+        }
+    }
+    anim->stats.decode_us += esp_timer_get_time() - start_us;
+    if (ret > 0) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_FALSE(ret == 0 && anim->frame_num > 0, ESP_ERR_INVALID_RESPONSE, TAG, "Invalid GIF data");
+
+    *done = true;
+    return ESP_OK;
+}
+
+static void anim_apply(app_anim_t *anim, const anim_frame_t *frame, lv_area_t *dirty)
+{
+    if (!frame->data) {
+        return;
+    }
+
+    const lv_area_t *area = &frame->area;
+    uint32_t stride = anim->img.header.w * ANIM_PX_SIZE;
+    uint32_t row_size = lv_area_get_width(area) * ANIM_PX_SIZE;
+    for (int y = area->y1; y <= area->y2; y++) {
+        memcpy(anim->canvas + y * stride + area->x1 * ANIM_PX_SIZE, frame->data + (y - area->y1) * row_size, row_size);
+    }
+    dirty->x1 = LV_MIN(dirty->x1, area->x1);
+    dirty->y1 = LV_MIN(dirty->y1, area->y1);
+    dirty->x2 = LV_MAX(dirty->x2, area->x2);
+    dirty->y2 = LV_MAX(dirty->y2, area->y2);
+}
+
+static void anim_invalidate(app_anim_t *anim, const lv_area_t *dirty)
+{
+    if (dirty->x2 < dirty->x1) {
+        return;
+    }
+
+    lv_area_t coords;
+    lv_obj_get_coords(anim->player, &coords);
+    lv_area_t area = {
+        .x1 = coords.x1 + dirty->x1,
+        .y1 = coords.y1 + dirty->y1,
+        .x2 = coords.x1 + dirty->x2,
+        .y2 = coords.y1 + dirty->y2,
+    };
+    lv_img_cache_invalidate_src(&anim->img);
+    lv_obj_invalidate_area(anim->player, &area);
+    anim->stats.dirty_px += lv_area_get_size(dirty);
+}
+
+static void anim_set_period(app_anim_t *anim, uint32_t now_ms)
+{
+    int32_t period_ms = (int32_t)(anim->next_ms - now_ms);
+    lv_timer_set_period(anim->timer, LV_MAX(period_ms, 1));
+}
+
+static void anim_timer_cb(lv_timer_t *t)
+{
+    app_anim_t *anim = (app_anim_t *)t->user_data;
+    int64_t start_us = esp_timer_get_time();
+    uint32_t now_ms = lv_tick_get();
+    if ((int32_t)(now_ms - anim->next_ms) < 0) {
+        anim_set_period(anim, now_ms);
+        return;
+    }
+    if (now_ms - anim->next_ms > ANIM_MAX_LATE_MS) {
+        anim->next_ms = now_ms;
+    }
+
+    // Every frame that is due goes into the canvas, only the last one is rendered
+    lv_area_t dirty = { .x1 = LV_COORD_MAX, .y1 = LV_COORD_MAX, .x2 = -1, .y2 = -1 };
+    uint32_t applied = 0;
+    while ((int32_t)(now_ms - anim->next_ms) >= 0) {
+        anim->frame = (anim->frame + 1) % anim->frame_num;
+        anim_apply(anim, &anim->frames[anim->frame], &dirty);
+        anim->next_ms += anim->frames[anim->frame].delay_ms;
+        applied++;
+    }
+    anim_invalidate(anim, &dirty);
+    anim_set_period(anim, now_ms);
+
+    anim->stats.frames++;
+    anim->stats.skipped += applied - 1;
+    anim_count_step(anim, start_us);
+}
+
+static void anim_gif_timer_cb(lv_timer_t *t)
+{
+    lv_gif_t *gif = (lv_gif_t *)t->user_data;
+    app_anim_t *anim = (app_anim_t *)lv_obj_get_user_data((lv_obj_t *)gif);
+    int64_t start_us = esp_timer_get_time();
+    uint32_t last_call = gif->last_call;
+
+    anim->gif_timer_cb(t);
+    if (gif->last_call != last_call) {
+        anim->stats.frames++;
+        anim->stats.dirty_px += (uint32_t)gif->imgdsc.header.w * gif->imgdsc.header.h;
+    }
+    anim_count_step(anim, start_us);
+}
+
+static void anim_create_player(app_anim_t *anim)
+{
+    if (anim->stats.cached || anim->decoder) {
+        anim->player = lv_img_create(anim->obj);
+        lv_img_set_src(anim->player, &anim->img);
+        anim->timer = lv_timer_create(anim_timer_cb, ANIM_MIN_DELAY_MS, anim);
+    } else {
+        anim->player = lv_gif_create(anim->obj);
+        lv_gif_set_src(anim->player, anim->src);
+        lv_obj_set_user_data(anim->player, anim);
+        anim->timer = ((lv_gif_t *)anim->player)->timer;
+        anim->gif_timer_cb = anim->timer->timer_cb;
+        anim->timer->timer_cb = anim_gif_timer_cb;
+    }
+    lv_obj_set_size(anim->player, LV_PCT(100), LV_PCT(100));
+    lv_timer_pause(anim->timer);
+}
+
+/* Closes the GIF, and with `ret` failed drops the cache and switches to lv_gif */
+static void anim_decode_end(app_anim_t *anim, esp_err_t ret)
+{
+    gd_close_gif(anim->decoder);
+    anim->decoder = NULL;
+    lv_timer_del(anim->decode_timer);
+    anim->decode_timer = NULL;
+    if (ret == ESP_OK) {
+        anim->stats.cached = true;
+        anim->stats.cache_frames = anim->frame_num;
+        ESP_LOGI(TAG, "%dx%d GIF, %d frames cached in %d KB, decoded in %d ms", anim->img.header.w, anim->img.header.h,
+                 (int)anim->frame_num, (int)(anim->stats.cache_bytes / 1024), (int)(anim->stats.decode_us / 1000));
+        return;
+    }
+
+    ESP_LOGW(TAG, "GIF not cached (%s), decoding it live", esp_err_to_name(ret));
+    lv_obj_del(anim->player);
+    lv_timer_del(anim->timer);
+    lv_img_cache_invalidate_src(&anim->img);
+    anim_free_cache(anim);
+    anim_create_player(anim);
+}
+
+static void anim_decode_timer_cb(lv_timer_t *t)
+{
+    app_anim_t *anim = (app_anim_t *)t->user_data;
+    bool done = false;
+    esp_err_t ret = anim_decode_frames(anim, ANIM_DECODE_SLICE_US, &done);
+    if (ret != ESP_OK || done) {
+        anim_decode_end(anim, ret);
+    }
+}
+
+esp_err_t app_anim_create(lv_obj_t *parent, const void *src, const app_anim_config_t *config,
+                          app_anim_handle_t *ret_anim)
+{
+    ESP_RETURN_ON_FALSE(parent && src && config && ret_anim, ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    app_anim_t *anim = heap_caps_calloc(1, sizeof(app_anim_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(anim, ESP_ERR_NO_MEM, TAG, "No memory for the player");
+    anim->src = src;
+    anim->max_bytes = config->cache_max_bytes;
+
+    anim->obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(anim->obj);
+    lv_obj_clear_flag(anim->obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+
+    // The cache is built a slice at a time on an LVGL timer, playing from the canvas meanwhile
+    // would show a partial animation, so app_anim_set_running() finishes it first
+    esp_err_t ret = anim->max_bytes ? anim_decode_begin(anim) : ESP_OK;
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "GIF not cached (%s), decoding it live", esp_err_to_name(ret));
+        if (anim->decoder) {
+            gd_close_gif(anim->decoder);
+            anim->decoder = NULL;
+        }
+        anim_free_cache(anim);
+    }
+    anim_create_player(anim);
+    if (anim->decoder) {
+        anim->decode_timer = lv_timer_create(anim_decode_timer_cb, ANIM_DECODE_PERIOD_MS, anim);
+    }
+    anim->period_start_us = esp_timer_get_time();
+
+    *ret_anim = anim;
+    return ESP_OK;
+}
+
+lv_obj_t *app_anim_get_obj(app_anim_handle_t anim)
+{
+    return anim->obj;
+}
+
+void app_anim_set_running(app_anim_handle_t anim, bool running)
+{
+    int64_t now_us = esp_timer_get_time();
+    if (!running) {
+        if (anim->run_start_us) {
+            anim->stats.run_us += now_us - anim->run_start_us;
+            anim->run_start_us = 0;
+        }
+        lv_timer_pause(anim->timer);
+        return;
+    }
+
+    if (anim->decoder) {
+        // Started before the cache was built
+        bool done = false;
+        esp_err_t ret = anim_decode_frames(anim, INT64_MAX, &done);
+        anim_decode_end(anim, ret);
+    }
+    if (anim->stats.cached) {
+        // The first frame covers the whole canvas
+        lv_area_t dirty = { .x1 = LV_COORD_MAX, .y1 = LV_COORD_MAX, .x2 = -1, .y2 = -1 };
+        anim->frame = 0;
+        anim_apply(anim, &anim->frames[0], &dirty);
+        anim_invalidate(anim, &dirty);
+        anim->next_ms = lv_tick_get() + anim->frames[0].delay_ms;
+        anim_set_period(anim, lv_tick_get());
+        anim->stats.frames++;
+    } else {
+        lv_gif_t *gif = (lv_gif_t *)anim->player;
+        if (!gif->gif) {
+            return;
+        }
+        lv_gif_restart(anim->player);
+    }
+    if (!anim->run_start_us) {
+        anim->run_start_us = now_us;
+    }
+    lv_timer_resume(anim->timer);
+}
+
+void app_anim_get_stats(app_anim_handle_t anim, app_anim_stats_t *stats, bool reset)
+{
+    int64_t now_us = esp_timer_get_time();
+    *stats = anim->stats;
+    stats->elapsed_us = now_us - anim->period_start_us;
+    if (anim->run_start_us) {
+        stats->run_us += now_us - anim->run_start_us;
+    }
+
+    if (reset) {
+        anim->stats.frames = 0;
+        anim->stats.skipped = 0;
+        anim->stats.step_us = 0;
+        anim->stats.max_step_us = 0;
+        anim->stats.dirty_px = 0;
+        anim->stats.run_us = 0;
+        anim->period_start_us = now_us;
+        if (anim->run_start_us) {
+            anim->run_start_us = now_us;
+        }
+    }
+}
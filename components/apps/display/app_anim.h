@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct app_anim_t *app_anim_handle_t;
+
+/**
+ * @brief Animation player configuration.
+ */
+typedef struct {
+    size_t cache_max_bytes;                           /*!< PSRAM the decoded frames may take, 0 to decode live with lv_gif */
+} app_anim_config_t;
+
+/**
+ * @brief Animation player counters.
+ */
+typedef struct {
+    bool cached;                                      /*!< Played from the frame cache, otherwise decoded live by lv_gif */
+    uint32_t cache_frames;                            /*!< Frames in the cache */
+    uint32_t cache_bytes;                             /*!< PSRAM taken by the cache, canvas included */
+    uint32_t decode_us;                               /*!< LVGL task time spent building the cache */
+    uint32_t frames;                                  /*!< Frames put on screen */
+    uint32_t skipped;                                 /*!< Frames that were due together with a later one and not shown */
+    uint64_t step_us;                                 /*!< LVGL task time spent stepping the animation */
+    uint32_t max_step_us;                             /*!< Longest step */
+    uint64_t dirty_px;                                /*!< Pixels invalidated for LVGL to render */
+    int64_t run_us;                                   /*!< Time the animation was running */
+    int64_t elapsed_us;                               /*!< Time covered by the counters */
+} app_anim_stats_t;
+
+/**
+ * @brief Create a GIF player.
+ *
+ * With a cache budget the GIF is decoded once and only the rectangle of pixels that changed from
+ * the previous frame is kept for each frame. Playing a frame is then a copy of that rectangle
+ * into the canvas of an lv_img, and only the rectangle is invalidated. Frames follow the delays
+ * of the GIF on the LVGL tick, as with lv_gif; when the LVGL task falls behind, the frames that
+ * are due are applied together and only the last one is rendered. If the GIF does not fit the
+ * budget or cannot be decoded, the player falls back to an lv_gif object, timed the same way.
+ *
+ * The cache is built by an LVGL timer a few milliseconds at a time, so that the LVGL task keeps
+ * rendering and reading touches meanwhile; starting the player before the cache is complete
+ * finishes it at once. The player starts paused. Must be called with the display lock held.
+ *
+ * @param src GIF file path or `LV_IMG_CF_RAW` descriptor, as taken by lv_gif_set_src(). Must stay
+ *            valid while the cache is being built.
+ * @param[out] ret_anim Player handle.
+ * @return
+ *      - ESP_OK: Success, check the `cached` counter for the mode
+ *      - ESP_ERR_NO_MEM: No memory for the player
+ */
+esp_err_t app_anim_create(lv_obj_t *parent, const void *src, const app_anim_config_t *config,
+                          app_anim_handle_t *ret_anim);
+
+/**
+ * @brief LVGL object of the player, to place, size and show it.
+ */
+lv_obj_t *app_anim_get_obj(app_anim_handle_t anim);
+
+/**
+ * @brief Start the animation from its first frame, or pause it.
+ *
+ * A paused animation takes no time on the LVGL task. Must be called with the display lock held.
+ */
+void app_anim_set_running(app_anim_handle_t anim, bool running);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period. The cache counters are kept.
+ */
+void app_anim_get_stats(app_anim_handle_t anim, app_anim_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
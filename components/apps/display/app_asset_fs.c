@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "app_asset_fs.h"
+
+#define ASSET_FS_MAGIC                      (0x314E4241)  /* 'ABN1', see tools/asset_bundle.py */
+#define ASSET_FS_VERSION                    (1)
+
+static const char *TAG = "app_asset_fs";
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint32_t file_num;
+    uint32_t slot_num;                                /* Power of 2 */
+    uint32_t slots_offset;
+    uint32_t names_offset;
+    uint32_t data_offset;
+    uint32_t total_size;
+} asset_header_t;
+
+typedef struct {
+    uint32_t hash;                                    /* FNV-1a of the path */
+    uint32_t name_offset;                             /* From the start of the names */
+    uint32_t data_offset;                             /* From the start of the bundle, 0 for an empty slot */
+    uint32_t size;
+} asset_slot_t;
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t pos;
+} asset_file_t;
+
+typedef struct {
+    const uint8_t *base;                              /* Mapped partition */
+    const asset_header_t *header;
+    const asset_slot_t *slots;
+    const char *names;
+    esp_partition_mmap_handle_t mmap;
+    lv_img_dsc_t **imgs;                              /* Per slot, created by app_asset_fs_img() */
+    lv_fs_drv_t drv;
+} asset_fs_t;
+
+static asset_fs_t s_fs;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_asset_fs_stats_t s_stats;
+
+static uint32_t asset_hash(const char *path)
+{
+    uint32_t h = 0x811C9DC5;
+    while (*path) {
+        h = (h ^ (uint8_t)*path++) * 0x01000193;
+    }
+    return h;
+}
+
+static int asset_find(const char *path)
+{
+    if (!s_fs.base || !path) {
+        return -1;
+    }
+    while (*path == '/') {
+        path++;
+    }
+
+    const asset_header_t *header = s_fs.header;
+    uint32_t hash = asset_hash(path);
+    uint32_t mask = header->slot_num - 1;
+    for (uint32_t i = hash & mask, n = 0; n < header->slot_num; i = (i + 1) & mask, n++) {
+        const asset_slot_t *slot = &s_fs.slots[i];
+        if (slot->data_offset == 0) {
+            break;
+        }
+        if (slot->hash == hash && strcmp(s_fs.names + slot->name_offset, path) == 0) {
+            return i;
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.misses++;
+    portEXIT_CRITICAL(&s_lock);
+    return -1;
+}
+
+static void *asset_fs_open(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode)
+{
+    int i = (mode == LV_FS_MODE_RD) ? asset_find(path) : -1;
+    if (i < 0) {
+        return NULL;
+    }
+
+    asset_file_t *file = lv_mem_alloc(sizeof(asset_file_t));
+    if (!file) {
+        return NULL;
+    }
+    file->data = s_fs.base + s_fs.slots[i].data_offset;
+    file->size = s_fs.slots[i].size;
+    file->pos = 0;
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.opens++;
+    portEXIT_CRITICAL(&s_lock);
+    return file;
+}
+
+static lv_fs_res_t asset_fs_close(lv_fs_drv_t *drv, void *file_p)
+{
+    lv_mem_free(file_p);
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_fs_read(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br)
+{
+    asset_file_t *file = (asset_file_t *)file_p;
+    uint32_t n = LV_MIN(btr, file->size - file->pos);
+    memcpy(buf, file->data + file->pos, n);
+    file->pos += n;
+    *br = n;
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.read_bytes += n;
+    portEXIT_CRITICAL(&s_lock);
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_fs_seek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    asset_file_t *file = (asset_file_t *)file_p;
+    uint32_t base = (whence == LV_FS_SEEK_CUR) ? file->pos : (whence == LV_FS_SEEK_END) ? file->size : 0;
+    file->pos = LV_MIN(base + pos, file->size);
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t asset_fs_tell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p)
+{
+    *pos_p = ((asset_file_t *)file_p)->pos;
+    return LV_FS_RES_OK;
+}
+
+static bool asset_header_valid(const asset_header_t *header, size_t partition_size)
+{
+    if (header->magic != ASSET_FS_MAGIC || header->version != ASSET_FS_VERSION) {
+        return false;
+    }
+    return header->slot_num && (header->slot_num & (header->slot_num - 1)) == 0 &&
+           header->slots_offset >= sizeof(asset_header_t) &&
+           header->slots_offset + header->slot_num * sizeof(asset_slot_t) <= header->names_offset &&
+           header->names_offset <= header->data_offset && header->data_offset <= header->total_size &&
+           header->total_size <= partition_size;
+}
+
+esp_err_t app_asset_fs_init(char letter, const char *partition_label)
+{
+    ESP_RETURN_ON_FALSE(s_fs.base == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           partition_label);
+    ESP_RETURN_ON_FALSE(part, ESP_ERR_NOT_FOUND, TAG, "No %s partition", partition_label);
+
+    const void *base = NULL;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &base, &s_fs.mmap), TAG,
+                        "Failed to map the %s partition", partition_label);
+
+    esp_err_t ret = ESP_OK;
+    const asset_header_t *header = (const asset_header_t *)base;
+    ESP_GOTO_ON_FALSE(asset_header_valid(header, part->size), ESP_ERR_INVALID_VERSION, err, TAG,
+                      "No asset bundle in the %s partition", partition_label);
+    s_fs.imgs = heap_caps_calloc(header->slot_num, sizeof(lv_img_dsc_t *), MALLOC_CAP_DEFAULT);
+    ESP_GOTO_ON_FALSE(s_fs.imgs, ESP_ERR_NO_MEM, err, TAG, "No memory for the image descriptors");
+
+    s_fs.base = (const uint8_t *)base;
+    s_fs.header = header;
+    s_fs.slots = (const asset_slot_t *)(s_fs.base + header->slots_offset);
+    s_fs.names = (const char *)(s_fs.base + header->names_offset);
+    s_stats.files = header->file_num;
+    s_stats.size = header->total_size;
+
+    lv_fs_drv_init(&s_fs.drv);
+    s_fs.drv.letter = letter;
+    s_fs.drv.open_cb = asset_fs_open;
+    s_fs.drv.close_cb = asset_fs_close;
+    s_fs.drv.read_cb = asset_fs_read;
+    s_fs.drv.seek_cb = asset_fs_seek;
+    s_fs.drv.tell_cb = asset_fs_tell;
+    lv_fs_drv_register(&s_fs.drv);
+
+    ESP_LOGI(TAG, "%d assets, %d KB, mapped on %c:", (int)header->file_num, (int)(header->total_size / 1024), letter);
+    return ESP_OK;
+
+err:
+    esp_partition_munmap(s_fs.mmap);
+    s_fs.mmap = 0;
+    return ret;
+}
+
+bool app_asset_fs_get(const char *path, const void **data, size_t *size)
+{
+    int i = asset_find(path);
+    if (i < 0) {
+        return false;
+    }
+
+    *data = s_fs.base + s_fs.slots[i].data_offset;
+    *size = s_fs.slots[i].size;
+    portENTER_CRITICAL(&s_lock);
+    s_stats.opens++;
+    portEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+const lv_img_dsc_t *app_asset_fs_img(const char *path)
+{
+    int i = asset_find(path);
+    if (i < 0) {
+        return NULL;
+    }
+    if (s_fs.imgs[i]) {
+        return s_fs.imgs[i];
+    }
+
+    lv_img_dsc_t *img = heap_caps_calloc(1, sizeof(lv_img_dsc_t), MALLOC_CAP_DEFAULT);
+    if (!img) {
+        return NULL;
+    }
+    img->header.cf = LV_IMG_CF_RAW;
+    img->data = s_fs.base + s_fs.slots[i].data_offset;
+    img->data_size = s_fs.slots[i].size;
+    s_fs.imgs[i] = img;
+    return img;
+}
+
+const char *app_asset_fs_file(int index)
+{
+    if (!s_fs.base || index < 0) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < s_fs.header->slot_num; i++) {
+        if (s_fs.slots[i].data_offset && index-- == 0) {
+            return s_fs.names + s_fs.slots[i].name_offset;
+        }
+    }
+    return NULL;
+}
+
+void app_asset_fs_get_stats(app_asset_fs_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
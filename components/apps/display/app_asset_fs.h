@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Asset bundle counters.
+ */
+typedef struct {
+    uint32_t files;                                   /*!< Files in the bundle */
+    uint32_t size;                                    /*!< Bundle size in bytes */
+    uint32_t opens;                                   /*!< Files opened, through LVGL or directly */
+    uint32_t misses;                                  /*!< Paths not in the bundle */
+    uint64_t read_bytes;                              /*!< Bytes copied out by LVGL file reads */
+} app_asset_fs_stats_t;
+
+/**
+ * @brief Serve the asset bundle partition to LVGL.
+ *
+ * Maps the whole partition written by tools/asset_bundle.py into the data address space once
+ * and registers an LVGL file system driver on `letter`, e.g. "B:/gif_making.gif" for the file
+ * packed as gif_making.gif. Opening a file is a hash lookup and reading it a copy out of the
+ * flash cache, without SPIFFS' page walks. app_asset_fs_get() and app_asset_fs_img() skip the
+ * copy altogether.
+ *
+ * Call once with the display lock held.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_NOT_FOUND: No data partition with this label
+ *      - ESP_ERR_INVALID_VERSION: The partition holds no bundle, e.g. it was never flashed
+ */
+esp_err_t app_asset_fs_init(char letter, const char *partition_label);
+
+/**
+ * @brief Find a file in the bundle, for zero copy reads.
+ *
+ * @param path Path in the bundle, a leading '/' is ignored.
+ * @param[out] data Start of the file in the mapped partition, valid for the life of the program.
+ * @param[out] size File size in bytes.
+ * @return false if the bundle is not mapped or has no such file.
+ */
+bool app_asset_fs_get(const char *path, const void **data, size_t *size);
+
+/**
+ * @brief Get an image descriptor of a bundled file, for LVGL to decode straight from flash.
+ *
+ * The descriptor is `LV_IMG_CF_RAW` with the file as its data, which is what lv_gif_set_src()
+ * and the image decoders of encoded formats take. Descriptors are created on first use and live
+ * as long as the program. Must be called with the display lock held.
+ *
+ * @return NULL if the file is not in the bundle.
+ */
+const lv_img_dsc_t *app_asset_fs_img(const char *path);
+
+/**
+ * @brief Path of the `index`th file of the bundle, NULL past the last one.
+ */
+const char *app_asset_fs_file(int index);
+
+/**
+ * @brief Read the counters.
+ */
+void app_asset_fs_get_stats(app_asset_fs_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,245 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_cache.h"
+#include "esp_heap_caps.h"
+#include "driver/ppa.h"
+#include "app_draw_buf.h"
+
+#define DRAW_BUF_WAIT_TIMEOUT_MS            (100)
+
+static const char *TAG = "app_draw_buf";
+
+typedef struct {
+    lv_disp_t *disp;
+    size_t align;
+    ppa_client_handle_t ppa;
+    SemaphoreHandle_t done_sem;
+
+    /* The display's own setup */
+    lv_disp_draw_buf_t *own_draw_buf;
+    void (*own_flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+    void (*own_wait_cb)(lv_disp_drv_t *drv);
+    bool own_full_refresh;
+
+    /* Partial setup */
+    bool partial;
+    lv_disp_draw_buf_t draw_buf;
+    void *bufs[2];
+    uint8_t *fb;                                      /* Frame buffer on screen, flushed into */
+} draw_buf_t;
+
+static draw_buf_t s_buf;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_draw_buf_stats_t s_stats;
+
+static IRAM_ATTR bool draw_buf_trans_done_cb(ppa_client_handle_t ppa_client, ppa_event_data_t *event_data, void *user_data)
+{
+    BaseType_t task_woken = pdFALSE;
+
+    lv_disp_flush_ready((lv_disp_drv_t *)user_data);
+    xSemaphoreGiveFromISR(s_buf.done_sem, &task_woken);
+    return task_woken == pdTRUE;
+}
+
+static void draw_buf_copy_cpu(const lv_area_t *area, const lv_color_t *color_p, size_t stride)
+{
+    size_t row_bytes = lv_area_get_width(area) * sizeof(lv_color_t);
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(s_buf.fb + y * stride + area->x1 * sizeof(lv_color_t), color_p, row_bytes);
+        color_p += lv_area_get_width(area);
+    }
+    esp_cache_msync(s_buf.fb + area->y1 * stride, lv_area_get_height(area) * stride,
+                    ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+}
+
+static void draw_buf_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    size_t stride = drv->hor_res * sizeof(lv_color_t);
+    lv_coord_t w = lv_area_get_width(area);
+    lv_coord_t h = lv_area_get_height(area);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.flushes++;
+    s_stats.flush_px += lv_area_get_size(area);
+    if (lv_disp_flush_is_last(drv)) {
+        s_stats.frames++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    // Whole rows of the frame buffer, so the driver's cache maintenance stays within them
+    ppa_srm_oper_config_t srm = {
+        .in = {
+            .buffer = color_p,
+            .pic_w = w,
+            .pic_h = h,
+            .block_w = w,
+            .block_h = h,
+            .block_offset_x = 0,
+            .block_offset_y = 0,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .out = {
+            .buffer = s_buf.fb + area->y1 * stride,
+            .buffer_size = h * stride,
+            .pic_w = drv->hor_res,
+            .pic_h = h,
+            .block_offset_x = area->x1,
+            .block_offset_y = 0,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+        .scale_x = 1.0f,
+        .scale_y = 1.0f,
+        .mode = PPA_TRANS_MODE_NON_BLOCKING,
+        .user_data = drv,
+    };
+    if (!s_buf.align || (stride % s_buf.align) != 0 || ppa_do_scale_rotate_mirror(s_buf.ppa, &srm) != ESP_OK) {
+        draw_buf_copy_cpu(area, color_p, stride);
+        lv_disp_flush_ready(drv);
+    }
+}
+
+static void draw_buf_wait_cb(lv_disp_drv_t *drv)
+{
+    // LVGL calls this in a loop until the flush is ready, a stale give only costs one more round
+    int64_t start_us = esp_timer_get_time();
+    xSemaphoreTake(s_buf.done_sem, pdMS_TO_TICKS(DRAW_BUF_WAIT_TIMEOUT_MS));
+    int64_t end_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.wait_us += end_us - start_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void draw_buf_free(void)
+{
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(s_buf.bufs[i]);
+        s_buf.bufs[i] = NULL;
+    }
+}
+
+static void draw_buf_restore(void)
+{
+    lv_disp_drv_t *drv = s_buf.disp->driver;
+
+    if (s_buf.partial) {
+        while (s_buf.draw_buf.flushing) {
+            draw_buf_wait_cb(drv);
+        }
+        drv->draw_buf = s_buf.own_draw_buf;
+        drv->flush_cb = s_buf.own_flush_cb;
+        drv->wait_cb = s_buf.own_wait_cb;
+        drv->full_refresh = s_buf.own_full_refresh;
+        drv->direct_mode = 1;
+        s_buf.partial = false;
+    }
+    draw_buf_free();
+}
+
+static esp_err_t draw_buf_init(lv_disp_t *disp)
+{
+    lv_disp_drv_t *drv = disp->driver;
+    lv_disp_draw_buf_t *draw_buf = drv->draw_buf;
+    uint32_t px = (uint32_t)drv->hor_res * drv->ver_res;
+    ESP_RETURN_ON_FALSE(drv->direct_mode && draw_buf && draw_buf->buf1 && draw_buf->size >= px,
+                        ESP_ERR_NOT_SUPPORTED, TAG, "Display does not render to full frame buffers");
+
+    esp_err_t ret = ESP_OK;
+    s_buf.done_sem = xSemaphoreCreateBinary();
+    ESP_RETURN_ON_FALSE(s_buf.done_sem, ESP_ERR_NO_MEM, TAG, "Failed to create semaphore");
+
+    ppa_client_config_t ppa_config = {
+        .oper_type = PPA_OPERATION_SRM,
+        .max_pending_trans_num = 1,
+    };
+    ESP_GOTO_ON_ERROR(ppa_register_client(&ppa_config, &s_buf.ppa), err, TAG, "Failed to register PPA client");
+    ppa_event_callbacks_t cbs = {
+        .on_trans_done = draw_buf_trans_done_cb,
+    };
+    ESP_GOTO_ON_ERROR(ppa_client_register_event_callbacks(s_buf.ppa, &cbs), err, TAG, "Failed to register PPA callback");
+
+    esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &s_buf.align);
+    s_buf.disp = disp;
+    return ESP_OK;
+
+err:
+    if (s_buf.ppa) {
+        ppa_unregister_client(s_buf.ppa);
+        s_buf.ppa = NULL;
+    }
+    vSemaphoreDelete(s_buf.done_sem);
+    s_buf.done_sem = NULL;
+    return ret;
+}
+
+esp_err_t app_draw_buf_set(lv_disp_t *disp, const app_draw_buf_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->driver, ESP_ERR_INVALID_ARG, TAG, "Invalid display");
+    if (s_buf.disp == NULL) {
+        ESP_RETURN_ON_ERROR(draw_buf_init(disp), TAG, "Failed to initialize");
+    }
+    ESP_RETURN_ON_FALSE(disp == s_buf.disp, ESP_ERR_INVALID_ARG, TAG, "Only one display is supported");
+
+    lv_disp_drv_t *drv = disp->driver;
+    draw_buf_restore();
+    if (!config || config->lines == 0) {
+        lv_obj_invalidate(lv_scr_act());
+        return ESP_OK;
+    }
+
+    // The direct mode buffer LVGL renders to next is the one not on screen
+    lv_disp_draw_buf_t *own = drv->draw_buf;
+    s_buf.fb = (uint8_t *)((own->buf2 && own->buf_act == own->buf1) ? own->buf2 : own->buf1);
+
+    lv_coord_t lines = LV_MIN(config->lines, drv->ver_res);
+    size_t size = (size_t)drv->hor_res * lines * sizeof(lv_color_t);
+    uint32_t caps = config->spiram ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA);
+    size_t align = s_buf.align ? s_buf.align : 4;
+    for (int i = 0; i < (config->double_buffer ? 2 : 1); i++) {
+        s_buf.bufs[i] = heap_caps_aligned_calloc(align, 1, size, caps | MALLOC_CAP_8BIT);
+        if (!s_buf.bufs[i]) {
+            draw_buf_free();
+            lv_obj_invalidate(lv_scr_act());
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    lv_disp_draw_buf_init(&s_buf.draw_buf, s_buf.bufs[0], s_buf.bufs[1], (uint32_t)drv->hor_res * lines);
+
+    s_buf.own_draw_buf = own;
+    s_buf.own_flush_cb = drv->flush_cb;
+    s_buf.own_wait_cb = drv->wait_cb;
+    s_buf.own_full_refresh = drv->full_refresh;
+    drv->draw_buf = &s_buf.draw_buf;
+    drv->flush_cb = draw_buf_flush_cb;
+    drv->wait_cb = draw_buf_wait_cb;
+    drv->full_refresh = 0;
+    drv->direct_mode = 0;
+    s_buf.partial = true;
+
+    lv_obj_invalidate(lv_scr_act());
+    ESP_LOGD(TAG, "%d line draw buffer%s in %s", lines, config->double_buffer ? "s" : "",
+             config->spiram ? "PSRAM" : "internal RAM");
+    return ESP_OK;
+}
+
+void app_draw_buf_get_stats(app_draw_buf_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
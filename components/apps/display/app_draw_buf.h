@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Draw buffer setup.
+ */
+typedef struct {
+    uint16_t lines;                                   /*!< Draw buffer height, 0 for the display's own setup */
+    bool spiram;                                      /*!< Draw buffers in PSRAM, otherwise in internal RAM */
+    bool double_buffer;                               /*!< Render into one buffer while the other is flushed */
+} app_draw_buf_config_t;
+
+/**
+ * @brief Partial draw buffer counters.
+ */
+typedef struct {
+    uint32_t frames;                                  /*!< Refreshes flushed to the frame buffer */
+    uint32_t flushes;                                 /*!< Draw buffers flushed, several per frame */
+    uint64_t flush_px;                                /*!< Pixels flushed */
+    uint64_t wait_us;                                 /*!< Time LVGL waited for a flush to finish */
+} app_draw_buf_stats_t;
+
+/**
+ * @brief Switch a direct mode display to partial draw buffers, or back to its own setup.
+ *
+ * Lets the draw buffer setup be measured on the real screens without rebuilding: LVGL renders
+ * into `lines` high buffers which the PPA copies into the frame buffer on screen, signalling
+ * LVGL when done, so a second buffer is rendered while the first is copied. With
+ * `config->lines` 0 or `config` NULL the display is put back on its own direct mode frame
+ * buffers and redrawn.
+ *
+ * The display must render in direct mode to full frame buffers. Call with the display lock held.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_NOT_SUPPORTED: The display does not render to full frame buffers
+ *      - ESP_ERR_NO_MEM: The draw buffers do not fit, the display is back on its own setup
+ */
+esp_err_t app_draw_buf_set(lv_disp_t *disp, const app_draw_buf_config_t *config);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period.
+ */
+void app_draw_buf_get_stats(app_draw_buf_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
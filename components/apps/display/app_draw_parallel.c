@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "sdkconfig.h"
+#include "app_draw_parallel.h"
+#if CONFIG_APP_DRAW_PPA_ENABLE
+#include "app_draw_ppa.h"
+#endif
+
+#define DRAW_PARALLEL_TASK_STACK_SIZE       (4 * 1024)
+
+static const char *TAG = "app_draw_parallel";
+
+typedef enum {
+    TILE_IDLE,
+    TILE_QUEUED,
+    TILE_CLAIMED,
+} tile_state_t;
+
+typedef struct {
+    lv_draw_sw_ctx_t ctx;                             /* Copy of the caller's context, clipped to the band */
+    lv_area_t clip;
+    const lv_draw_sw_blend_dsc_t *dsc;
+    tile_state_t state;
+} draw_tile_t;
+
+typedef struct {
+    lv_disp_t *disp;
+    atomic_bool enabled;                              /* Written by the camera state machine on any task */
+    TaskHandle_t worker;
+    SemaphoreHandle_t done_sem;
+    void (*prev_blend)(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc);
+    draw_tile_t tile;
+} draw_parallel_t;
+
+static draw_parallel_t s_par;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_draw_parallel_stats_t s_stats;
+
+static bool tile_claim(void)
+{
+    bool claimed = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_par.tile.state == TILE_QUEUED) {
+        s_par.tile.state = TILE_CLAIMED;
+        claimed = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return claimed;
+}
+
+static void draw_parallel_task(void *arg)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // A band the LVGL task already took back leaves a stale notification, nothing to claim then
+        if (tile_claim()) {
+            s_par.prev_blend((lv_draw_ctx_t *)&s_par.tile.ctx, s_par.tile.dsc);
+            xSemaphoreGive(s_par.done_sem);
+        }
+    }
+}
+
+static bool draw_parallel_worth(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc, lv_area_t *area)
+{
+    if (!atomic_load(&s_par.enabled) || !_lv_area_intersect(area, dsc->blend_area, draw_ctx->clip_area)) {
+        return false;
+    }
+    if (lv_area_get_height(area) < 2 || lv_area_get_size(area) < CONFIG_APP_DRAW_PARALLEL_MIN_PX) {
+        return false;
+    }
+    if (dsc->mask_buf && (dsc->mask_res == LV_DRAW_MASK_RES_TRANSP || !s_par.disp->driver->antialiasing)) {
+        // Without anti-aliasing the blend rewrites the whole mask in place
+        return false;
+    }
+#if CONFIG_APP_DRAW_PPA_ENABLE
+    if (app_draw_ppa_can_draw(draw_ctx, dsc)) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+static void draw_parallel_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    lv_area_t area;
+    if (!draw_parallel_worth(draw_ctx, dsc, &area)) {
+        s_par.prev_blend(draw_ctx, dsc);
+        return;
+    }
+
+    lv_coord_t mid = area.y1 + lv_area_get_height(&area) / 2;
+
+    draw_tile_t *tile = &s_par.tile;
+    memcpy(&tile->ctx, draw_ctx, sizeof(lv_draw_sw_ctx_t));
+    tile->clip = area;
+    tile->clip.y1 = mid;
+    tile->ctx.base_draw.clip_area = &tile->clip;
+    tile->dsc = dsc;
+    portENTER_CRITICAL(&s_lock);
+    tile->state = TILE_QUEUED;
+    portEXIT_CRITICAL(&s_lock);
+    xTaskNotifyGive(s_par.worker);
+
+    lv_draw_sw_ctx_t own;
+    lv_area_t own_clip = area;
+    own_clip.y2 = mid - 1;
+    memcpy(&own, draw_ctx, sizeof(lv_draw_sw_ctx_t));
+    own.base_draw.clip_area = &own_clip;
+    s_par.prev_blend((lv_draw_ctx_t *)&own, dsc);
+
+    bool stolen = tile_claim();
+    if (stolen) {
+        s_par.prev_blend((lv_draw_ctx_t *)&tile->ctx, dsc);
+    } else {
+        xSemaphoreTake(s_par.done_sem, portMAX_DELAY);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    tile->state = TILE_IDLE;
+    s_stats.splits++;
+    s_stats.split_px += lv_area_get_size(&area);
+    if (stolen) {
+        s_stats.stolen_tiles++;
+    } else {
+        s_stats.worker_tiles++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t app_draw_parallel_init(lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->driver && disp->driver->draw_ctx, ESP_ERR_INVALID_ARG, TAG, "Invalid display");
+    ESP_RETURN_ON_FALSE(s_par.disp == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    // Every draw context LVGL 8 builds for this port is a software one with a blend step
+    lv_draw_sw_ctx_t *sw_ctx = (lv_draw_sw_ctx_t *)disp->driver->draw_ctx;
+    ESP_RETURN_ON_FALSE(sw_ctx->blend, ESP_ERR_NOT_SUPPORTED, TAG, "Draw context has no blend step");
+
+    s_par.done_sem = xSemaphoreCreateBinary();
+    ESP_RETURN_ON_FALSE(s_par.done_sem, ESP_ERR_NO_MEM, TAG, "Failed to create semaphore");
+
+    // No affinity: the worker runs on whichever core the LVGL task is not using
+    BaseType_t res = xTaskCreatePinnedToCore(draw_parallel_task, "LVGL Band", DRAW_PARALLEL_TASK_STACK_SIZE, NULL,
+                                             CONFIG_APP_DRAW_PARALLEL_TASK_PRIORITY, &s_par.worker, tskNO_AFFINITY);
+    if (res != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create worker task");
+        vSemaphoreDelete(s_par.done_sem);
+        s_par.done_sem = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_par.prev_blend = sw_ctx->blend;
+    sw_ctx->blend = draw_parallel_blend;
+    s_par.disp = disp;
+    atomic_store(&s_par.enabled, true);
+
+    ESP_LOGI(TAG, "Blends of %d px and more rendered on both cores", CONFIG_APP_DRAW_PARALLEL_MIN_PX);
+    return ESP_OK;
+}
+
+void app_draw_parallel_set_enabled(bool enabled)
+{
+    atomic_store(&s_par.enabled, enabled && s_par.disp);
+}
+
+void app_draw_parallel_get_stats(app_draw_parallel_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
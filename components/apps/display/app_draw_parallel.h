@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Parallel draw counters.
+ */
+typedef struct {
+    uint32_t splits;                                  /*!< Blends split across both cores */
+    uint32_t worker_tiles;                            /*!< Bands rendered by the worker */
+    uint32_t stolen_tiles;                            /*!< Bands taken back by the LVGL task, worker still busy */
+    uint64_t split_px;                                /*!< Pixels of the split blends */
+} app_draw_parallel_stats_t;
+
+/**
+ * @brief Render large software blends of a display on both cores.
+ *
+ * LVGL 8 renders the object tree on one task and is not safe to call from two, so the split
+ * happens where most of the CPU time of a full screen redraw goes: the blend step. Blends of at
+ * least `CONFIG_APP_DRAW_PARALLEL_MIN_PX` pixels are cut into two bands of rows; the LVGL task
+ * renders the top one while a worker task on the other core renders the bottom one. The bands do
+ * not overlap and each pixel is blended exactly as before, so the frame is identical to a single
+ * core render. If the worker has not started its band when the LVGL task is done, the LVGL task
+ * renders it too.
+ *
+ * Chains the blend step of the display's draw context: call it after app_draw_ppa_init(), with
+ * the display lock held. Blends the PPA takes are not split.
+ */
+esp_err_t app_draw_parallel_init(lv_disp_t *disp);
+
+/**
+ * @brief Turn splitting on or off, e.g. while face recognition needs the other core. Safe to call from any task.
+ */
+void app_draw_parallel_set_enabled(bool enabled);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period.
+ */
+void app_draw_parallel_get_stats(app_draw_parallel_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,379 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_cache.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "driver/ppa.h"
+#include "app_draw_ppa.h"
+
+#define DRAW_PPA_MAX_IMG_COPIES             (8)
+
+static const char *TAG = "app_draw_ppa";
+
+typedef lv_draw_sw_ctx_t app_draw_ppa_ctx_t;
+
+typedef struct {
+    lv_disp_t *disp;
+    bool enabled;
+    size_t align;
+    ppa_client_handle_t srm;
+    ppa_client_handle_t blend;
+    ppa_client_handle_t fill;
+    uint8_t *a8;                                      /* Foreground for translucent fills, only its size matters */
+    size_t a8_size;
+    const lv_img_dsc_t *img_src[DRAW_PPA_MAX_IMG_COPIES];
+    const lv_img_dsc_t *img_copy[DRAW_PPA_MAX_IMG_COPIES];
+    int img_num;
+} draw_ppa_t;
+
+static draw_ppa_t s_draw;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_draw_ppa_stats_t s_stats;
+
+static bool draw_ppa_readable(const void *ptr)
+{
+    return esp_ptr_dma_capable(ptr) || esp_ptr_dma_ext_capable(ptr);
+}
+
+static esp_err_t draw_ppa_fill(uint8_t *rows, size_t rows_size, int stride_px, const lv_area_t *dst,
+                               const lv_draw_sw_blend_dsc_t *dsc)
+{
+    ppa_fill_oper_config_t fill = {
+        .out = {
+            .buffer = rows,
+            .buffer_size = rows_size,
+            .pic_w = stride_px,
+            .pic_h = lv_area_get_height(dst),
+            .block_offset_x = dst->x1,
+            .block_offset_y = 0,
+            .fill_cm = PPA_FILL_COLOR_MODE_RGB565,
+        },
+        .fill_block_w = lv_area_get_width(dst),
+        .fill_block_h = lv_area_get_height(dst),
+        .fill_argb_color = {
+            .val = lv_color_to32(dsc->color),
+        },
+        .mode = PPA_TRANS_MODE_BLOCKING,
+    };
+    return ppa_do_fill(s_draw.fill, &fill);
+}
+
+static esp_err_t draw_ppa_copy(uint8_t *rows, size_t rows_size, int stride_px, const lv_area_t *dst,
+                               const lv_draw_sw_blend_dsc_t *dsc, const lv_area_t *src)
+{
+    ppa_srm_oper_config_t srm = {
+        .in = {
+            .buffer = dsc->src_buf,
+            .pic_w = lv_area_get_width(dsc->blend_area),
+            .pic_h = lv_area_get_height(dsc->blend_area),
+            .block_w = lv_area_get_width(src),
+            .block_h = lv_area_get_height(src),
+            .block_offset_x = src->x1,
+            .block_offset_y = src->y1,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .out = {
+            .buffer = rows,
+            .buffer_size = rows_size,
+            .pic_w = stride_px,
+            .pic_h = lv_area_get_height(dst),
+            .block_offset_x = dst->x1,
+            .block_offset_y = 0,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+        .scale_x = 1.0f,
+        .scale_y = 1.0f,
+        .mode = PPA_TRANS_MODE_BLOCKING,
+    };
+    return ppa_do_scale_rotate_mirror(s_draw.srm, &srm);
+}
+
+static esp_err_t draw_ppa_mix(uint8_t *rows, size_t rows_size, int stride_px, const lv_area_t *dst,
+                              const lv_draw_sw_blend_dsc_t *dsc, const lv_area_t *src)
+{
+    int w = lv_area_get_width(dst);
+    int h = lv_area_get_height(dst);
+    ppa_blend_oper_config_t blend = {
+        .in_bg = {
+            .buffer = rows,
+            .pic_w = stride_px,
+            .pic_h = h,
+            .block_w = w,
+            .block_h = h,
+            .block_offset_x = dst->x1,
+            .block_offset_y = 0,
+            .blend_cm = PPA_BLEND_COLOR_MODE_RGB565,
+        },
+        .out = {
+            .buffer = rows,
+            .buffer_size = rows_size,
+            .pic_w = stride_px,
+            .pic_h = h,
+            .block_offset_x = dst->x1,
+            .block_offset_y = 0,
+            .blend_cm = PPA_BLEND_COLOR_MODE_RGB565,
+        },
+        .bg_alpha_update_mode = PPA_ALPHA_NO_CHANGE,
+        .fg_alpha_update_mode = PPA_ALPHA_FIX_VALUE,
+        .fg_alpha_fix_val = dsc->opa,
+        .mode = PPA_TRANS_MODE_BLOCKING,
+    };
+
+    if (dsc->src_buf) {
+        blend.in_fg.buffer = dsc->src_buf;
+        blend.in_fg.pic_w = lv_area_get_width(dsc->blend_area);
+        blend.in_fg.pic_h = lv_area_get_height(dsc->blend_area);
+        blend.in_fg.block_offset_x = src->x1;
+        blend.in_fg.block_offset_y = src->y1;
+        blend.in_fg.blend_cm = PPA_BLEND_COLOR_MODE_RGB565;
+    } else {
+        // A8 foreground with a fixed color and a fixed alpha: the buffer is read but not used
+        if ((size_t)w * h > s_draw.a8_size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        lv_color32_t color;
+        color.full = lv_color_to32(dsc->color);
+        blend.in_fg.buffer = s_draw.a8;
+        blend.in_fg.pic_w = w;
+        blend.in_fg.pic_h = h;
+        blend.in_fg.blend_cm = PPA_BLEND_COLOR_MODE_A8;
+        blend.fg_fix_rgb_val.r = color.ch.red;
+        blend.fg_fix_rgb_val.g = color.ch.green;
+        blend.fg_fix_rgb_val.b = color.ch.blue;
+    }
+    blend.in_fg.block_w = w;
+    blend.in_fg.block_h = h;
+    return ppa_do_blend(s_draw.blend, &blend);
+}
+
+static bool draw_ppa_accepts(const lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc, const lv_area_t *area)
+{
+    if (!s_draw.enabled || dsc->opa <= LV_OPA_MIN || dsc->blend_mode != LV_BLEND_MODE_NORMAL) {
+        return false;
+    }
+    if ((dsc->mask_buf && dsc->mask_res != LV_DRAW_MASK_RES_FULL_COVER) ||
+            lv_area_get_size(area) < CONFIG_APP_DRAW_PPA_MIN_PX) {
+        return false;
+    }
+    if (s_draw.disp->driver->screen_transp || (dsc->src_buf && !draw_ppa_readable(dsc->src_buf))) {
+        return false;
+    }
+
+    // The PPA writes whole rows of the draw buffer as far as the cache is concerned
+    size_t stride = lv_area_get_width(draw_ctx->buf_area) * sizeof(lv_color_t);
+    uintptr_t rows = (uintptr_t)draw_ctx->buf + (size_t)(area->y1 - draw_ctx->buf_area->y1) * stride;
+    size_t rows_size = (size_t)lv_area_get_height(area) * stride;
+    return (rows % s_draw.align) == 0 && (rows_size % s_draw.align) == 0;
+}
+
+static bool draw_ppa_try(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc, const lv_area_t *area)
+{
+    if (!draw_ppa_accepts(draw_ctx, dsc, area)) {
+        return false;
+    }
+
+    int stride_px = lv_area_get_width(draw_ctx->buf_area);
+    size_t stride = stride_px * sizeof(lv_color_t);
+    uint8_t *rows = (uint8_t *)draw_ctx->buf + (size_t)(area->y1 - draw_ctx->buf_area->y1) * stride;
+    size_t rows_size = (size_t)lv_area_get_height(area) * stride;
+
+    lv_area_t dst = *area;
+    lv_area_move(&dst, -draw_ctx->buf_area->x1, -area->y1);
+    lv_area_t src = *area;
+    lv_area_move(&src, -dsc->blend_area->x1, -dsc->blend_area->y1);
+
+    int64_t start_us = esp_timer_get_time();
+    // Pixels the CPU drew earlier in this frame must reach memory before the driver
+    // invalidates these rows
+    esp_cache_msync(rows, rows_size, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+
+    esp_err_t ret;
+    uint32_t *counter;
+    if (dsc->opa >= LV_OPA_MAX && !dsc->src_buf) {
+        ret = draw_ppa_fill(rows, rows_size, stride_px, &dst, dsc);
+        counter = &s_stats.fills;
+    } else if (dsc->opa >= LV_OPA_MAX) {
+        ret = draw_ppa_copy(rows, rows_size, stride_px, &dst, dsc, &src);
+        counter = &s_stats.blits;
+    } else {
+        ret = draw_ppa_mix(rows, rows_size, stride_px, &dst, dsc, &src);
+        counter = &s_stats.blends;
+    }
+    if (ret != ESP_OK) {
+        return false;
+    }
+    int64_t end_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    (*counter)++;
+    s_stats.ppa_px += lv_area_get_size(area);
+    s_stats.ppa_us += end_us - start_us;
+    portEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+static void draw_ppa_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area)) {
+        return;
+    }
+    if (dsc->mask_buf && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP) {
+        return;
+    }
+
+    if (!draw_ppa_try(draw_ctx, dsc, &area)) {
+        lv_draw_sw_blend_basic(draw_ctx, dsc);
+
+        portENTER_CRITICAL(&s_lock);
+        s_stats.sw_blends++;
+        s_stats.sw_px += lv_area_get_size(&area);
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+static void draw_ppa_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx)
+{
+    lv_draw_sw_init_ctx(drv, draw_ctx);
+
+    app_draw_ppa_ctx_t *ppa_ctx = (app_draw_ppa_ctx_t *)draw_ctx;
+    ppa_ctx->blend = draw_ppa_blend;
+}
+
+static void draw_ppa_ctx_deinit(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx)
+{
+    lv_draw_sw_deinit_ctx(drv, draw_ctx);
+}
+
+static esp_err_t draw_ppa_register(ppa_operation_t oper, ppa_client_handle_t *ret_client)
+{
+    ppa_client_config_t config = {
+        .oper_type = oper,
+        .max_pending_trans_num = 1,
+    };
+    return ppa_register_client(&config, ret_client);
+}
+
+esp_err_t app_draw_ppa_init(lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->driver, ESP_ERR_INVALID_ARG, TAG, "Invalid display");
+    ESP_RETURN_ON_FALSE(s_draw.disp == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    esp_err_t ret = ESP_OK;
+    lv_disp_drv_t *drv = disp->driver;
+    lv_draw_ctx_t *draw_ctx = NULL;
+
+    ESP_GOTO_ON_ERROR(draw_ppa_register(PPA_OPERATION_SRM, &s_draw.srm), err, TAG, "Failed to register PPA SRM client");
+    ESP_GOTO_ON_ERROR(draw_ppa_register(PPA_OPERATION_BLEND, &s_draw.blend), err, TAG, "Failed to register PPA blend client");
+    ESP_GOTO_ON_ERROR(draw_ppa_register(PPA_OPERATION_FILL, &s_draw.fill), err, TAG, "Failed to register PPA fill client");
+
+    esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &s_draw.align);
+    if (s_draw.align == 0) {
+        s_draw.align = 1;
+    }
+    s_draw.a8_size = (size_t)drv->hor_res * drv->ver_res;
+    s_draw.a8 = heap_caps_aligned_calloc(s_draw.align, 1, s_draw.a8_size, MALLOC_CAP_SPIRAM);
+    ESP_GOTO_ON_FALSE(s_draw.a8, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate A8 buffer");
+
+    draw_ctx = lv_mem_alloc(sizeof(app_draw_ppa_ctx_t));
+    ESP_GOTO_ON_FALSE(draw_ctx, ESP_ERR_NO_MEM, err, TAG, "Failed to allocate draw context");
+
+    // Same steps as lv_disp_drv_register() takes, on a display that already has a context
+    if (drv->draw_ctx) {
+        drv->draw_ctx_deinit(drv, drv->draw_ctx);
+        lv_mem_free(drv->draw_ctx);
+    }
+    drv->draw_ctx_init = draw_ppa_ctx_init;
+    drv->draw_ctx_deinit = draw_ppa_ctx_deinit;
+    drv->draw_ctx_size = sizeof(app_draw_ppa_ctx_t);
+    drv->draw_ctx_init(drv, draw_ctx);
+    drv->draw_ctx = draw_ctx;
+
+    s_draw.disp = disp;
+    s_draw.enabled = true;
+    ESP_LOGI(TAG, "PPA draw enabled for blends of %d px and more", CONFIG_APP_DRAW_PPA_MIN_PX);
+    return ESP_OK;
+
+err:
+    heap_caps_free(s_draw.a8);
+    s_draw.a8 = NULL;
+    if (s_draw.fill) {
+        ppa_unregister_client(s_draw.fill);
+        s_draw.fill = NULL;
+    }
+    if (s_draw.blend) {
+        ppa_unregister_client(s_draw.blend);
+        s_draw.blend = NULL;
+    }
+    if (s_draw.srm) {
+        ppa_unregister_client(s_draw.srm);
+        s_draw.srm = NULL;
+    }
+    return ret;
+}
+
+bool app_draw_ppa_can_draw(const lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    lv_area_t area;
+    if (!_lv_area_intersect(&area, dsc->blend_area, draw_ctx->clip_area)) {
+        return false;
+    }
+    return draw_ppa_accepts(draw_ctx, dsc, &area);
+}
+
+void app_draw_ppa_set_enabled(bool enabled)
+{
+    s_draw.enabled = enabled && s_draw.disp;
+}
+
+const lv_img_dsc_t *app_draw_ppa_dma_img(const lv_img_dsc_t *img)
+{
+    if (img == NULL || img->header.cf != LV_IMG_CF_TRUE_COLOR || draw_ppa_readable(img->data)) {
+        return img;
+    }
+    for (int i = 0; i < s_draw.img_num; i++) {
+        if (s_draw.img_src[i] == img) {
+            return s_draw.img_copy[i];
+        }
+    }
+    if (s_draw.img_num >= DRAW_PPA_MAX_IMG_COPIES) {
+        return img;
+    }
+
+    lv_img_dsc_t *copy = heap_caps_malloc(sizeof(lv_img_dsc_t), MALLOC_CAP_DEFAULT);
+    uint8_t *data = heap_caps_malloc(img->data_size, MALLOC_CAP_SPIRAM);
+    if (copy == NULL || data == NULL) {
+        ESP_LOGW(TAG, "No PSRAM for a %d KB image copy", (int)(img->data_size / 1024));
+        heap_caps_free(copy);
+        heap_caps_free(data);
+        return img;
+    }
+
+    memcpy(data, img->data, img->data_size);
+    *copy = *img;
+    copy->data = data;
+    s_draw.img_src[s_draw.img_num] = img;
+    s_draw.img_copy[s_draw.img_num] = copy;
+    s_draw.img_num++;
+    return copy;
+}
+
+void app_draw_ppa_get_stats(app_draw_ppa_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief PPA draw counters.
+ */
+typedef struct {
+    uint32_t fills;                                   /*!< Opaque fills done by the PPA */
+    uint32_t blends;                                  /*!< Translucent fills and images blended by the PPA */
+    uint32_t blits;                                   /*!< Opaque images copied by the PPA */
+    uint64_t ppa_px;                                  /*!< Pixels written by the PPA */
+    uint64_t ppa_us;                                  /*!< Time spent in PPA operations, cache maintenance included */
+    uint32_t sw_blends;                               /*!< Blends left to the software renderer */
+    uint64_t sw_px;                                   /*!< Pixels written by the software renderer */
+} app_draw_ppa_stats_t;
+
+/**
+ * @brief Render large fills, opacity blends and RGB565 image copies of a display with the PPA.
+ *
+ * Replaces the display's draw context with the software one whose blend step hands unmasked,
+ * normal mode blends of at least `CONFIG_APP_DRAW_PPA_MIN_PX` pixels to the PPA. Everything
+ * else, including masked areas such as rounded corners and text, stays on the CPU.
+ *
+ * Must be called with the display lock held, before anything else hooks the draw context.
+ */
+esp_err_t app_draw_ppa_init(lv_disp_t *disp);
+
+/**
+ * @brief Turn the PPA path on or off at run time, e.g. to compare render times.
+ */
+void app_draw_ppa_set_enabled(bool enabled);
+
+/**
+ * @brief Whether a blend on the display's draw context would be drawn by the PPA.
+ */
+bool app_draw_ppa_can_draw(const lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc);
+
+/**
+ * @brief Get an RGB565 image the PPA can read.
+ *
+ * Images the DMA cannot reach are copied to PSRAM once and the copy is handed out on every
+ * later call; copies live as long as the program. Returns `img` itself if it is already
+ * readable, not a true color image, or could not be copied.
+ *
+ * Must be called with the display lock held.
+ */
+const lv_img_dsc_t *app_draw_ppa_dma_img(const lv_img_dsc_t *img);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period.
+ */
+void app_draw_ppa_get_stats(app_draw_ppa_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,374 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_cache.h"
+#include "esp_heap_caps.h"
+#include "driver/ppa.h"
+#include "app_fb_sync.h"
+
+#define FB_SYNC_WAIT_TIMEOUT_MS             (100)
+#define FB_SYNC_MERGE_SLACK_PX              (4096)    /*!< Extra pixels worth copying to save one DMA setup */
+
+static const char *TAG = "app_fb_sync";
+
+typedef struct {
+    lv_disp_t *disp;
+    void *fbs[2];
+    lv_coord_t hor_res;
+    lv_coord_t ver_res;
+    size_t stride;
+    bool row_buffers;                                 /* Rows start on a cache line, so copies can be row ranges */
+    ppa_client_handle_t ppa;
+    SemaphoreHandle_t done_sem;
+
+    void (*prev_flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+    void (*prev_render_start_cb)(lv_disp_drv_t *drv);
+    void (*prev_buffer_copy)(lv_draw_ctx_t *draw_ctx, void *dest_buf, lv_coord_t dest_stride, const lv_area_t *dest_area,
+                             void *src_buf, lv_coord_t src_stride, const lv_area_t *src_area);
+
+    lv_area_t areas[LV_INV_BUF_SIZE];                 /* Rendered in the current frame */
+    int area_num;
+    lv_area_t rects[APP_FB_SYNC_MAX_RECTS];           /* Copied by DMA after the last flip */
+    int rect_num;
+    void *rects_dst;
+
+    bool busy;
+    int pending;
+    int64_t launch_us;
+    int64_t done_us;
+} fb_sync_t;
+
+static fb_sync_t s_sync;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_fb_sync_stats_t s_stats;
+static int64_t s_start_us;
+
+static uint32_t area_px(const lv_area_t *area)
+{
+    return lv_area_get_size(area);
+}
+
+static bool area_in_rects(const lv_area_t *area)
+{
+    for (int i = 0; i < s_sync.rect_num; i++) {
+        if (_lv_area_is_in(area, &s_sync.rects[i], 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Merge areas into at most APP_FB_SYNC_MAX_RECTS bounding rectangles. Pairs are joined while
+ * their bounding box adds little beyond what they already cover, and unconditionally (least
+ * waste first) while there are too many.
+ */
+static int fb_sync_merge(const lv_area_t *areas, int num, lv_area_t *out)
+{
+    lv_area_t work[LV_INV_BUF_SIZE];
+    memcpy(work, areas, num * sizeof(lv_area_t));
+
+    while (num > 1) {
+        int best_i = -1;
+        int best_j = -1;
+        int64_t best_waste = INT64_MAX;
+        for (int i = 0; i < num; i++) {
+            for (int j = i + 1; j < num; j++) {
+                lv_area_t join;
+                lv_area_t common;
+                _lv_area_join(&join, &work[i], &work[j]);
+                int64_t covered = (int64_t)area_px(&work[i]) + area_px(&work[j]);
+                if (_lv_area_intersect(&common, &work[i], &work[j])) {
+                    covered -= area_px(&common);
+                }
+                int64_t waste = (int64_t)area_px(&join) - covered;
+                if (waste < best_waste) {
+                    best_waste = waste;
+                    best_i = i;
+                    best_j = j;
+                }
+            }
+        }
+
+        if (num <= APP_FB_SYNC_MAX_RECTS && best_waste > FB_SYNC_MERGE_SLACK_PX) {
+            break;
+        }
+        _lv_area_join(&work[best_i], &work[best_i], &work[best_j]);
+        work[best_j] = work[--num];
+    }
+
+    memcpy(out, work, num * sizeof(lv_area_t));
+    return num;
+}
+
+static IRAM_ATTR bool fb_sync_trans_done_cb(ppa_client_handle_t ppa_client, ppa_event_data_t *event_data, void *user_data)
+{
+    BaseType_t task_woken = pdFALSE;
+    bool last = false;
+
+    portENTER_CRITICAL_ISR(&s_lock);
+    if (s_sync.pending > 0 && --s_sync.pending == 0) {
+        s_sync.done_us = esp_timer_get_time();
+        last = true;
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    if (last) {
+        xSemaphoreGiveFromISR(s_sync.done_sem, &task_woken);
+    }
+    return task_woken == pdTRUE;
+}
+
+static void fb_sync_wait_done(void)
+{
+    if (!s_sync.busy) {
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    if (xSemaphoreTake(s_sync.done_sem, pdMS_TO_TICKS(FB_SYNC_WAIT_TIMEOUT_MS)) != pdTRUE) {
+        // Leave everything to the CPU copy rather than trust a half finished sync
+        ESP_LOGW(TAG, "DMA sync timed out, %d copies pending", s_sync.pending);
+        s_sync.rect_num = 0;
+        s_sync.done_us = esp_timer_get_time();
+    }
+    s_sync.busy = false;
+
+    int64_t end_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    s_stats.wait_us += end_us - start_us;
+    s_stats.dma_us += s_sync.done_us - s_sync.launch_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static esp_err_t fb_sync_copy(void *src, void *dst, const lv_area_t *rect)
+{
+    // Limiting the buffers to the rows of the rectangle keeps the driver's cache maintenance
+    // to those rows instead of the whole 1.2 MB frame buffer
+    int y = s_sync.row_buffers ? rect->y1 : 0;
+    int rows = s_sync.row_buffers ? lv_area_get_height(rect) : s_sync.ver_res;
+
+    ppa_srm_oper_config_t srm = {
+        .in = {
+            .buffer = (uint8_t *)src + (size_t)y * s_sync.stride,
+            .pic_w = s_sync.hor_res,
+            .pic_h = rows,
+            .block_w = lv_area_get_width(rect),
+            .block_h = lv_area_get_height(rect),
+            .block_offset_x = rect->x1,
+            .block_offset_y = rect->y1 - y,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .out = {
+            .buffer = (uint8_t *)dst + (size_t)y * s_sync.stride,
+            .buffer_size = (size_t)rows * s_sync.stride,
+            .pic_w = s_sync.hor_res,
+            .pic_h = rows,
+            .block_offset_x = rect->x1,
+            .block_offset_y = rect->y1 - y,
+            .srm_cm = PPA_SRM_COLOR_MODE_RGB565,
+        },
+        .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+        .scale_x = 1.0f,
+        .scale_y = 1.0f,
+        .mode = PPA_TRANS_MODE_NON_BLOCKING,
+    };
+    return ppa_do_scale_rotate_mirror(s_sync.ppa, &srm);
+}
+
+static void fb_sync_launch(void *on_screen)
+{
+    void *off_screen = (on_screen == s_sync.fbs[0]) ? s_sync.fbs[1] : s_sync.fbs[0];
+    lv_area_t rects[APP_FB_SYNC_MAX_RECTS];
+    int num = fb_sync_merge(s_sync.areas, s_sync.area_num, rects);
+
+    s_sync.rect_num = 0;
+    s_sync.rects_dst = off_screen;
+    if (num == 0) {
+        return;
+    }
+
+    // Drop a completion left over from a timed out sync
+    xSemaphoreTake(s_sync.done_sem, 0);
+    portENTER_CRITICAL(&s_lock);
+    s_sync.pending = num;
+    portEXIT_CRITICAL(&s_lock);
+    s_sync.launch_us = esp_timer_get_time();
+    s_sync.busy = true;
+
+    uint64_t px = 0;
+    int launched = 0;
+    for (; launched < num; launched++) {
+        if (fb_sync_copy(on_screen, off_screen, &rects[launched]) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to start DMA sync, %d areas left to the CPU", num - launched);
+            break;
+        }
+        s_sync.rects[launched] = rects[launched];
+        px += area_px(&rects[launched]);
+    }
+    s_sync.rect_num = launched;
+
+    if (launched < num) {
+        bool done = false;
+        portENTER_CRITICAL(&s_lock);
+        s_sync.pending -= num - launched;
+        if (s_sync.pending == 0) {
+            s_sync.done_us = esp_timer_get_time();
+            done = true;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (done) {
+            xSemaphoreGive(s_sync.done_sem);
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.flips++;
+    s_stats.areas += s_sync.area_num;
+    s_stats.rects += launched;
+    s_stats.dma_px += px;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void fb_sync_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    // The buffers are swapped after this returns, so the active one is what goes on screen
+    bool last = lv_disp_flush_is_last(drv);
+    void *on_screen = drv->draw_buf->buf_act;
+
+    s_sync.prev_flush_cb(drv, area, color_p);
+    if (last) {
+        fb_sync_launch(on_screen);
+    }
+}
+
+static void fb_sync_render_start_cb(lv_disp_drv_t *drv)
+{
+    // CPU writes to rows the DMA is still copying could land in the same cache lines
+    fb_sync_wait_done();
+
+    lv_disp_t *disp = s_sync.disp;
+    s_sync.area_num = 0;
+    for (int i = 0; i < disp->inv_p; i++) {
+        if (!disp->inv_area_joined[i]) {
+            s_sync.areas[s_sync.area_num++] = disp->inv_areas[i];
+        }
+    }
+
+    if (s_sync.prev_render_start_cb) {
+        s_sync.prev_render_start_cb(drv);
+    }
+}
+
+static void fb_sync_buffer_copy(lv_draw_ctx_t *draw_ctx, void *dest_buf, lv_coord_t dest_stride, const lv_area_t *dest_area,
+                                void *src_buf, lv_coord_t src_stride, const lv_area_t *src_area)
+{
+    if (dest_buf == s_sync.rects_dst && src_buf != dest_buf && dest_area->x1 == src_area->x1 &&
+            dest_area->y1 == src_area->y1 && area_in_rects(dest_area)) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.skipped++;
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    fb_sync_wait_done();
+
+    int64_t start_us = esp_timer_get_time();
+    s_sync.prev_buffer_copy(draw_ctx, dest_buf, dest_stride, dest_area, src_buf, src_stride, src_area);
+    int64_t end_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.cpu_copies++;
+    s_stats.cpu_px += area_px(dest_area);
+    s_stats.cpu_us += end_us - start_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t app_fb_sync_init(lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->driver, ESP_ERR_INVALID_ARG, TAG, "Invalid display");
+    ESP_RETURN_ON_FALSE(s_sync.disp == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    lv_disp_drv_t *drv = disp->driver;
+    lv_disp_draw_buf_t *draw_buf = drv->draw_buf;
+    uint32_t px = (uint32_t)drv->hor_res * drv->ver_res;
+    ESP_RETURN_ON_FALSE(drv->direct_mode && draw_buf && draw_buf->buf1 && draw_buf->buf2 && draw_buf->size >= px,
+                        ESP_ERR_NOT_SUPPORTED, TAG, "Display does not render to two full frame buffers");
+    ESP_RETURN_ON_FALSE(drv->flush_cb && drv->draw_ctx && drv->draw_ctx->buffer_copy, ESP_ERR_NOT_SUPPORTED,
+                        TAG, "Display has no buffer sync to replace");
+
+    esp_err_t ret = ESP_OK;
+    s_sync.done_sem = xSemaphoreCreateBinary();
+    ESP_RETURN_ON_FALSE(s_sync.done_sem, ESP_ERR_NO_MEM, TAG, "Failed to create semaphore");
+
+    ppa_client_config_t ppa_config = {
+        .oper_type = PPA_OPERATION_SRM,
+        .max_pending_trans_num = APP_FB_SYNC_MAX_RECTS,
+    };
+    ESP_GOTO_ON_ERROR(ppa_register_client(&ppa_config, &s_sync.ppa), err, TAG, "Failed to register PPA client");
+    ppa_event_callbacks_t cbs = {
+        .on_trans_done = fb_sync_trans_done_cb,
+    };
+    ESP_GOTO_ON_ERROR(ppa_client_register_event_callbacks(s_sync.ppa, &cbs), err, TAG, "Failed to register PPA callback");
+
+    size_t align = 0;
+    esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &align);
+    s_sync.fbs[0] = draw_buf->buf1;
+    s_sync.fbs[1] = draw_buf->buf2;
+    s_sync.hor_res = drv->hor_res;
+    s_sync.ver_res = drv->ver_res;
+    s_sync.stride = drv->hor_res * sizeof(lv_color_t);
+    s_sync.row_buffers = align && (s_sync.stride % align) == 0;
+
+    s_sync.prev_flush_cb = drv->flush_cb;
+    s_sync.prev_render_start_cb = drv->render_start_cb;
+    s_sync.prev_buffer_copy = drv->draw_ctx->buffer_copy;
+    drv->flush_cb = fb_sync_flush_cb;
+    drv->render_start_cb = fb_sync_render_start_cb;
+    drv->draw_ctx->buffer_copy = fb_sync_buffer_copy;
+    s_sync.disp = disp;
+    s_start_us = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "Frame buffer sync by PPA, %s copies", s_sync.row_buffers ? "row range" : "full buffer");
+    return ESP_OK;
+
+err:
+    if (s_sync.ppa) {
+        ppa_unregister_client(s_sync.ppa);
+        s_sync.ppa = NULL;
+    }
+    vSemaphoreDelete(s_sync.done_sem);
+    s_sync.done_sem = NULL;
+    return ret;
+}
+
+void app_fb_sync_wait(void)
+{
+    if (s_sync.disp) {
+        fb_sync_wait_done();
+    }
+}
+
+void app_fb_sync_get_stats(app_fb_sync_stats_t *stats, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->elapsed_us = now - s_start_us;
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+        s_start_us = now;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
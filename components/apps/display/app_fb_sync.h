@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_FB_SYNC_MAX_RECTS               (16)      /*!< DMA copies per flip after merging */
+
+/**
+ * @brief Frame buffer sync counters.
+ */
+typedef struct {
+    uint32_t flips;                                   /*!< Flips followed by a DMA sync */
+    uint32_t areas;                                   /*!< Rendered areas before merging */
+    uint32_t rects;                                   /*!< DMA copies after merging */
+    uint64_t dma_px;                                  /*!< Pixels copied by DMA */
+    uint64_t dma_us;                                  /*!< Launch to completion of the copies, summed */
+    uint64_t wait_us;                                 /*!< Time LVGL waited for copies still running */
+    uint32_t skipped;                                 /*!< LVGL sync areas already covered by DMA */
+    uint32_t cpu_copies;                              /*!< LVGL sync areas copied by the CPU */
+    uint64_t cpu_px;                                  /*!< Pixels copied by the CPU */
+    uint64_t cpu_us;                                  /*!< Time spent in CPU copies */
+    int64_t elapsed_us;                               /*!< Time covered by the counters */
+} app_fb_sync_stats_t;
+
+/**
+ * @brief Sync the two direct mode frame buffers with the PPA.
+ *
+ * In direct mode with two frame buffers, LVGL copies every area rendered in the previous frame
+ * into the buffer it is about to render to, row by row with the CPU. This starts the same
+ * copies with the PPA right after each flip, merged into a few rectangles, so they run while
+ * LVGL is idle; LVGL's own copy then finds them done. Areas the DMA did not cover are still
+ * copied by the CPU.
+ *
+ * Must be called once, with the display lock held.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED if the display does not render in direct mode to two buffers.
+ */
+esp_err_t app_fb_sync_init(lv_disp_t *disp);
+
+/**
+ * @brief Wait for the copies of the last flip to finish.
+ *
+ * For anyone else writing to the frame buffers, with the display lock held. Returns at once if
+ * the sync is not running.
+ */
+void app_fb_sync_wait(void);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period.
+ */
+void app_fb_sync_get_stats(app_fb_sync_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,198 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "app_img_cache.h"
+
+static const char *TAG = "app_img_cache";
+
+typedef struct {
+    const void *src;                                  /* NULL for a free entry */
+    uint8_t *data;
+    size_t size;
+    uint32_t last_use;                                /* Value of the use counter when last opened */
+    uint16_t refs;                                    /* Opens not closed yet */
+    bool pinned;
+} img_cache_entry_t;
+
+typedef struct {
+    bool inited;
+    img_cache_entry_t entries[APP_IMG_CACHE_MAX_IMAGES];
+    const void *pins[APP_IMG_CACHE_MAX_PINS];
+    uint32_t use;
+    int64_t period_start_us;
+} img_cache_t;
+
+static img_cache_t s_cache;
+static app_img_cache_stats_t s_stats;
+
+static img_cache_entry_t *img_cache_find(const void *src)
+{
+    for (int i = 0; i < APP_IMG_CACHE_MAX_IMAGES; i++) {
+        if (s_cache.entries[i].src == src) {
+            return &s_cache.entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool img_cache_is_pinned(const void *src)
+{
+    for (int i = 0; i < APP_IMG_CACHE_MAX_PINS; i++) {
+        if (s_cache.pins[i] == src) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void img_cache_free(img_cache_entry_t *entry)
+{
+    if (entry->pinned) {
+        s_stats.pinned--;
+    }
+    s_stats.images--;
+    s_stats.bytes -= entry->size;
+    heap_caps_free(entry->data);
+    memset(entry, 0, sizeof(*entry));
+}
+
+// Free the least recently used images that are neither pinned nor open until `size` more bytes fit
+static void img_cache_evict(size_t size)
+{
+    while (s_stats.bytes + size > s_stats.budget) {
+        img_cache_entry_t *lru = NULL;
+        for (int i = 0; i < APP_IMG_CACHE_MAX_IMAGES; i++) {
+            img_cache_entry_t *entry = &s_cache.entries[i];
+            if (entry->src && !entry->pinned && entry->refs == 0 &&
+                    (!lru || (int32_t)(entry->last_use - lru->last_use) < 0)) {
+                lru = entry;
+            }
+        }
+        if (!lru) {
+            return;
+        }
+
+        ESP_LOGD(TAG, "Evicting %p, %d KB", lru->src, (int)(lru->size / 1024));
+        s_stats.evictions++;
+        s_stats.evicted_bytes += lru->size;
+        img_cache_free(lru);
+    }
+}
+
+esp_err_t app_img_cache_init(size_t budget)
+{
+    ESP_RETURN_ON_FALSE(!s_cache.inited, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    s_cache.inited = true;
+    s_cache.period_start_us = esp_timer_get_time();
+    s_stats.budget = budget;
+    return ESP_OK;
+}
+
+const uint8_t *app_img_cache_open(const void *src)
+{
+    img_cache_entry_t *entry = img_cache_find(src);
+    if (!entry) {
+        s_stats.misses++;
+        return NULL;
+    }
+
+    s_stats.hits++;
+    entry->last_use = ++s_cache.use;
+    entry->refs++;
+    return entry->data;
+}
+
+esp_err_t app_img_cache_add(const void *src, uint8_t *data, size_t size)
+{
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(s_cache.inited, ESP_ERR_INVALID_STATE, err, TAG, "Not initialized");
+
+    img_cache_evict(size);
+    img_cache_entry_t *entry = img_cache_find(NULL);
+    ESP_GOTO_ON_FALSE(entry, ESP_ERR_NO_MEM, err, TAG, "All %d images are in use", APP_IMG_CACHE_MAX_IMAGES);
+
+    entry->src = src;
+    entry->data = data;
+    entry->size = size;
+    entry->last_use = ++s_cache.use;
+    entry->refs = 1;
+    entry->pinned = img_cache_is_pinned(src);
+    if (entry->pinned) {
+        s_stats.pinned++;
+    }
+    s_stats.images++;
+    s_stats.bytes += size;
+    if (s_stats.bytes > s_stats.peak_bytes) {
+        s_stats.peak_bytes = s_stats.bytes;
+    }
+    return ESP_OK;
+
+err:
+    heap_caps_free(data);
+    return ret;
+}
+
+void app_img_cache_close(const void *src)
+{
+    img_cache_entry_t *entry = img_cache_find(src);
+    if (!entry || entry->refs == 0) {
+        return;
+    }
+
+    // Images that were kept over budget while in use go as soon as they can
+    entry->refs--;
+    img_cache_evict(0);
+}
+
+esp_err_t app_img_cache_pin(const void *src, bool pin)
+{
+    int slot = -1;
+    for (int i = 0; i < APP_IMG_CACHE_MAX_PINS && slot < 0; i++) {
+        if (s_cache.pins[i] == (pin ? NULL : src)) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        ESP_RETURN_ON_FALSE(!pin, ESP_ERR_NO_MEM, TAG, "More than %d pinned images", APP_IMG_CACHE_MAX_PINS);
+        return ESP_OK;
+    }
+    if (pin && img_cache_is_pinned(src)) {
+        return ESP_OK;
+    }
+    s_cache.pins[slot] = pin ? src : NULL;
+
+    img_cache_entry_t *entry = img_cache_find(src);
+    if (entry && entry->pinned != pin) {
+        entry->pinned = pin;
+        s_stats.pinned += pin ? 1 : -1;
+        if (!pin) {
+            img_cache_evict(0);
+        }
+    }
+    return ESP_OK;
+}
+
+void app_img_cache_get_stats(app_img_cache_stats_t *stats, bool reset)
+{
+    int64_t now_us = esp_timer_get_time();
+    *stats = s_stats;
+    stats->elapsed_us = now_us - s_cache.period_start_us;
+
+    if (reset) {
+        s_stats.hits = 0;
+        s_stats.misses = 0;
+        s_stats.evictions = 0;
+        s_stats.evicted_bytes = 0;
+        s_stats.peak_bytes = s_stats.bytes;
+        s_cache.period_start_us = now_us;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_IMG_CACHE_MAX_IMAGES            (32)      /*!< Decoded images held at once */
+#define APP_IMG_CACHE_MAX_PINS              (8)       /*!< Images pinned at once */
+
+/**
+ * @brief Image cache counters.
+ */
+typedef struct {
+    size_t budget;                                    /*!< Bytes the cache may hold */
+    size_t bytes;                                     /*!< Bytes held */
+    size_t peak_bytes;                                /*!< Most bytes held, over the budget if the images in use did not fit */
+    uint32_t images;                                  /*!< Images held */
+    uint32_t pinned;                                  /*!< Images held that are pinned */
+    uint32_t hits;                                    /*!< Opens served from the cache */
+    uint32_t misses;                                  /*!< Opens that had to decode */
+    uint32_t evictions;                               /*!< Images dropped to stay in the budget */
+    uint64_t evicted_bytes;                           /*!< Their size */
+    int64_t elapsed_us;                               /*!< Time covered by the counters */
+} app_img_cache_stats_t;
+
+/**
+ * @brief Set up the decoded image cache.
+ *
+ * Image decoders keep what they decode here, keyed by the LVGL image source, instead of each
+ * keeping its images for ever or LVGL keeping a number of open images whatever their size.
+ * When an image does not fit in `budget` bytes, the least recently opened images are freed,
+ * except pinned ones and those open for drawing, and decoded again the next time they are
+ * drawn. An image larger than what can be freed is kept anyway and the cache stays over
+ * budget until enough images are closed.
+ *
+ * LVGL's own cache of open images holds them open for as long as they stay in it, so it is
+ * meant to run with `CONFIG_LV_IMG_CACHE_DEF_SIZE` set to 0.
+ *
+ * All functions must be called with the display lock held.
+ */
+esp_err_t app_img_cache_init(size_t budget);
+
+/**
+ * @brief Open a cached image for drawing.
+ *
+ * @return The decoded pixels, or NULL if the image is not cached. Pixels returned stay valid
+ *         until the matching app_img_cache_close().
+ */
+const uint8_t *app_img_cache_open(const void *src);
+
+/**
+ * @brief Add a decoded image, open for drawing.
+ *
+ * Takes ownership of `data`, a heap_caps allocation, even on failure.
+ *
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_STATE: The cache is not set up
+ *      - ESP_ERR_NO_MEM: All APP_IMG_CACHE_MAX_IMAGES entries are pinned or open
+ */
+esp_err_t app_img_cache_add(const void *src, uint8_t *data, size_t size);
+
+/**
+ * @brief Close an image opened by app_img_cache_open() or app_img_cache_add().
+ */
+void app_img_cache_close(const void *src);
+
+/**
+ * @brief Keep an image of a hot screen decoded, cached yet or not.
+ *
+ * @return ESP_ERR_NO_MEM if APP_IMG_CACHE_MAX_PINS images are pinned already.
+ */
+esp_err_t app_img_cache_pin(const void *src, bool pin);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period for the hit, miss and eviction counters.
+ */
+void app_img_cache_get_stats(app_img_cache_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,182 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "driver/jpeg_decode.h"
+#include "app_img_cache.h"
+#include "app_img_jpeg.h"
+
+#define IMG_JPEG_DECODE_TIMEOUT_MS          (200)
+
+static const char *TAG = "app_img_jpeg";
+
+typedef struct {
+    lv_img_decoder_t *decoder;
+    jpeg_decoder_handle_t engine;
+    const lv_img_dsc_t *failed[APP_IMG_JPEG_MAX_FAILED];  /* Not decoded again on every frame */
+    int failed_num;
+} img_jpeg_t;
+
+static img_jpeg_t s_jpeg;
+static app_img_jpeg_stats_t s_stats;
+
+static bool img_jpeg_is_jpeg(const void *src)
+{
+    if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) {
+        return false;
+    }
+    const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+    return img->header.cf == LV_IMG_CF_RAW && img->data_size > 2 && img->data[0] == 0xFF && img->data[1] == 0xD8;
+}
+
+static uint8_t *img_jpeg_decode(const lv_img_dsc_t *img)
+{
+    jpeg_decode_picture_info_t info;
+    if (jpeg_decoder_get_info(img->data, img->data_size, &info) != ESP_OK) {
+        ESP_LOGW(TAG, "Invalid JPEG data");
+        return NULL;
+    }
+
+    // The decoder writes whole blocks: a padded width would change the row stride LVGL expects
+    uint32_t block_w = (info.sample_method == JPEG_DOWN_SAMPLING_YUV444 || info.sample_method == JPEG_DOWN_SAMPLING_GRAY) ? 8 : 16;
+    uint32_t block_h = (info.sample_method == JPEG_DOWN_SAMPLING_YUV420) ? 16 : 8;
+    if (info.width != img->header.w || info.height != img->header.h || (info.width % block_w) != 0) {
+        ESP_LOGW(TAG, "%dx%d JPEG does not fit its %dx%d descriptor", (int)info.width, (int)info.height,
+                 (int)img->header.w, (int)img->header.h);
+        return NULL;
+    }
+
+    jpeg_decode_memory_alloc_cfg_t in_cfg = {
+        .buffer_direction = JPEG_DEC_ALLOC_INPUT_BUFFER,
+    };
+    jpeg_decode_memory_alloc_cfg_t out_cfg = {
+        .buffer_direction = JPEG_DEC_ALLOC_OUTPUT_BUFFER,
+    };
+    size_t in_size = 0;
+    size_t out_size = 0;
+    uint32_t rows = (info.height + block_h - 1) / block_h * block_h;
+    uint8_t *in = (uint8_t *)jpeg_alloc_decoder_mem(img->data_size, &in_cfg, &in_size);
+    uint8_t *out = (uint8_t *)jpeg_alloc_decoder_mem(info.width * rows * sizeof(lv_color_t), &out_cfg, &out_size);
+    if (!in || !out) {
+        ESP_LOGW(TAG, "No memory to decode a %dx%d image", (int)info.width, (int)info.height);
+        heap_caps_free(in);
+        heap_caps_free(out);
+        return NULL;
+    }
+
+    // The JPEG DMA reads an aligned copy rather than the data in flash
+    memcpy(in, img->data, img->data_size);
+    jpeg_decode_cfg_t cfg = {
+        .output_format = JPEG_DECODE_OUT_FORMAT_RGB565,
+        .rgb_order = JPEG_DEC_RGB_ELEMENT_ORDER_BGR,
+        .conv_std = JPEG_YUV_RGB_CONV_STD_BT601,
+    };
+    uint32_t decoded = 0;
+    esp_err_t ret = jpeg_decoder_process(s_jpeg.engine, &cfg, in, img->data_size, out, out_size, &decoded);
+    heap_caps_free(in);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to decode a %dx%d image: %s", (int)info.width, (int)info.height, esp_err_to_name(ret));
+        heap_caps_free(out);
+        return NULL;
+    }
+    return out;
+}
+
+static lv_res_t img_jpeg_info(lv_img_decoder_t *decoder, const void *src, lv_img_header_t *header)
+{
+    if (!img_jpeg_is_jpeg(src)) {
+        return LV_RES_INV;
+    }
+
+    const lv_img_dsc_t *img = (const lv_img_dsc_t *)src;
+    header->always_zero = 0;
+    header->w = img->header.w;
+    header->h = img->header.h;
+    header->cf = LV_IMG_CF_TRUE_COLOR;
+    return LV_RES_OK;
+}
+
+static lv_res_t img_jpeg_open(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    if (!img_jpeg_is_jpeg(dsc->src)) {
+        return LV_RES_INV;
+    }
+
+    const lv_img_dsc_t *img = (const lv_img_dsc_t *)dsc->src;
+    for (int i = 0; i < s_jpeg.failed_num; i++) {
+        if (s_jpeg.failed[i] == img) {
+            return LV_RES_INV;
+        }
+    }
+    const uint8_t *cached = app_img_cache_open(img);
+    if (cached) {
+        dsc->img_data = cached;
+        return LV_RES_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    uint8_t *data = img_jpeg_decode(img);
+    uint32_t time_us = esp_timer_get_time() - start_us;
+    if (!data) {
+        if (s_jpeg.failed_num < APP_IMG_JPEG_MAX_FAILED) {
+            s_jpeg.failed[s_jpeg.failed_num++] = img;
+        }
+        s_stats.failures++;
+        return LV_RES_INV;
+    }
+    if (app_img_cache_add(img, data, (size_t)img->header.w * img->header.h * sizeof(lv_color_t)) != ESP_OK) {
+        return LV_RES_INV;
+    }
+
+    s_stats.images++;
+    s_stats.jpeg_bytes += img->data_size;
+    s_stats.decode_us += time_us;
+    if (time_us > s_stats.max_decode_us) {
+        s_stats.max_decode_us = time_us;
+    }
+    ESP_LOGI(TAG, "%dx%d image decoded from %d KB in %d us", (int)img->header.w, (int)img->header.h,
+             (int)(img->data_size / 1024), (int)time_us);
+
+    dsc->img_data = data;
+    return LV_RES_OK;
+}
+
+static void img_jpeg_close(lv_img_decoder_t *decoder, lv_img_decoder_dsc_t *dsc)
+{
+    // The decoded image stays in the cache for the next open, for as long as the budget allows
+    app_img_cache_close(dsc->src);
+}
+
+esp_err_t app_img_jpeg_init(void)
+{
+    ESP_RETURN_ON_FALSE(s_jpeg.decoder == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    jpeg_decode_engine_cfg_t engine_cfg = {
+        .intr_priority = 0,
+        .timeout_ms = IMG_JPEG_DECODE_TIMEOUT_MS,
+    };
+    ESP_RETURN_ON_ERROR(jpeg_new_decoder_engine(&engine_cfg, &s_jpeg.engine), TAG, "Failed to create JPEG decoder");
+
+    s_jpeg.decoder = lv_img_decoder_create();
+    if (!s_jpeg.decoder) {
+        jpeg_del_decoder_engine(s_jpeg.engine);
+        s_jpeg.engine = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    lv_img_decoder_set_info_cb(s_jpeg.decoder, img_jpeg_info);
+    lv_img_decoder_set_open_cb(s_jpeg.decoder, img_jpeg_open);
+    lv_img_decoder_set_close_cb(s_jpeg.decoder, img_jpeg_close);
+    return ESP_OK;
+}
+
+void app_img_jpeg_get_stats(app_img_jpeg_stats_t *stats)
+{
+    *stats = s_stats;
+}
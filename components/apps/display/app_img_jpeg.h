@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_IMG_JPEG_MAX_FAILED             (16)      /*!< Images that failed to decode remembered */
+
+/**
+ * @brief JPEG decoder counters.
+ */
+typedef struct {
+    uint32_t images;                                  /*!< Images decoded, again after an eviction too */
+    uint64_t jpeg_bytes;                              /*!< Size of their JPEG data */
+    uint64_t decode_us;                               /*!< Time spent decoding, copies and allocation included */
+    uint32_t max_decode_us;                           /*!< Slowest decode */
+    uint32_t failures;                                /*!< Images that could not be decoded */
+} app_img_jpeg_stats_t;
+
+/**
+ * @brief Decode JPEG image descriptors with the hardware JPEG decoder.
+ *
+ * Registers an LVGL image decoder for `LV_IMG_CF_RAW` descriptors whose data is a JPEG file,
+ * as written by tools/png_to_jpeg.py. An image is decoded to RGB565 in PSRAM, where the PPA can
+ * read it, when LVGL opens it and is not in app_img_cache, which keeps it until the budget
+ * needs the room. The image width must be a whole number of JPEG blocks, e.g. a multiple of 8
+ * for 4:4:4 images.
+ *
+ * Call once with the display lock held, after app_img_cache_init().
+ */
+esp_err_t app_img_jpeg_init(void);
+
+/**
+ * @brief Read the counters.
+ */
+void app_img_jpeg_get_stats(app_img_jpeg_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,247 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "app_input_latency.h"
+
+#define INPUT_LATENCY_RESPONSE_TIMEOUT_US   (500 * 1000)
+
+static const char *TAG = "app_input_latency";
+
+static const uint32_t s_bucket_ms[APP_INPUT_LATENCY_BUCKETS - 1] = {
+    8, 16, 24, 33, 50, 67, 100, 150, 250, 500, 1000,
+};
+
+typedef enum {
+    SAMPLE_IDLE,
+    SAMPLE_TOUCHED,                                   /* Finger lifted, nothing invalidated yet */
+    SAMPLE_INVALIDATED,                               /* Waiting for the next frame to start */
+    SAMPLE_RENDERING,                                 /* Waiting for the last flush of that frame */
+    SAMPLE_FLUSHING,                                  /* Last flush still in progress after flush_cb returned */
+    SAMPLE_ON_SCREEN,                                 /* Waiting for the click to be dispatched */
+} sample_state_t;
+
+typedef struct {
+    sample_state_t state;
+    const char *screen;
+    int64_t read_us;
+    int64_t event_us;
+    int64_t invalidate_us;
+    int64_t photon_us;
+} sample_t;
+
+typedef struct {
+    lv_disp_t *disp;
+    bool pressed;
+    int64_t touch_us;                                 /* Controller report behind this read, 0 if unknown */
+    const char *screen;
+    sample_t sample;
+    void (*prev_read_cb)(lv_indev_drv_t *drv, lv_indev_data_t *data);
+    void (*prev_feedback_cb)(lv_indev_drv_t *drv, uint8_t code);
+    void (*prev_rounder_cb)(lv_disp_drv_t *drv, lv_area_t *area);
+    void (*prev_render_start_cb)(lv_disp_drv_t *drv);
+    void (*prev_flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+    void (*prev_monitor_cb)(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
+} input_latency_t;
+
+static input_latency_t s_lat = {
+    .screen = "?",
+};
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_input_latency_stats_t s_stats[APP_INPUT_LATENCY_MAX_SCREENS];
+static int s_stats_num;
+
+static app_input_latency_stats_t *stats_for_screen(const char *screen)
+{
+    for (int i = 0; i < s_stats_num; i++) {
+        if (strcmp(s_stats[i].screen, screen) == 0) {
+            return &s_stats[i];
+        }
+    }
+    if (s_stats_num == APP_INPUT_LATENCY_MAX_SCREENS) {
+        return NULL;
+    }
+    app_input_latency_stats_t *stats = &s_stats[s_stats_num++];
+    memset(stats, 0, sizeof(*stats));
+    stats->screen = screen;
+    return stats;
+}
+
+static void sample_try_finish(void)
+{
+    sample_t *s = &s_lat.sample;
+    if (!s->event_us || !s->photon_us) {
+        return;
+    }
+
+    uint32_t photon_us = s->photon_us - s->read_us;
+    int bucket = 0;
+    while (bucket < APP_INPUT_LATENCY_BUCKETS - 1 && photon_us > s_bucket_ms[bucket] * 1000) {
+        bucket++;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    app_input_latency_stats_t *stats = stats_for_screen(s->screen);
+    if (stats) {
+        stats->samples++;
+        stats->hist[bucket]++;
+        stats->event_us += s->event_us - s->read_us;
+        stats->invalidate_us += s->invalidate_us - s->read_us;
+        stats->photon_us += photon_us;
+        if (photon_us > stats->max_photon_us) {
+            stats->max_photon_us = photon_us;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+    s->state = SAMPLE_IDLE;
+}
+
+static void sample_on_screen(void)
+{
+    s_lat.sample.photon_us = esp_timer_get_time();
+    s_lat.sample.state = SAMPLE_ON_SCREEN;
+    sample_try_finish();
+}
+
+static void input_latency_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    s_lat.touch_us = 0;
+    s_lat.prev_read_cb(drv, data);
+
+    // LVGL sends LV_EVENT_CLICKED on the release, so that is what the user waits on
+    bool pressed = data->state == LV_INDEV_STATE_PRESSED;
+    if (s_lat.pressed && !pressed) {
+        s_lat.sample = (sample_t) {
+            .state = SAMPLE_TOUCHED,
+            .screen = s_lat.screen,
+            .read_us = s_lat.touch_us ? s_lat.touch_us : esp_timer_get_time(),
+        };
+    }
+    s_lat.pressed = pressed;
+}
+
+static void input_latency_feedback_cb(lv_indev_drv_t *drv, uint8_t code)
+{
+    if (s_lat.prev_feedback_cb) {
+        s_lat.prev_feedback_cb(drv, code);
+    }
+
+    // Called after the click's event handlers, which may already have rendered the frame
+    if (code == LV_EVENT_CLICKED && s_lat.sample.state != SAMPLE_IDLE && !s_lat.sample.event_us) {
+        s_lat.sample.event_us = esp_timer_get_time();
+        sample_try_finish();
+    }
+}
+
+static void input_latency_rounder_cb(lv_disp_drv_t *drv, lv_area_t *area)
+{
+    // LVGL rounds every area it invalidates, which makes this the invalidate hook
+    if (s_lat.sample.state == SAMPLE_TOUCHED) {
+        int64_t now = esp_timer_get_time();
+        if (now - s_lat.sample.read_us > INPUT_LATENCY_RESPONSE_TIMEOUT_US) {
+            s_lat.sample.state = SAMPLE_IDLE;
+        } else {
+            s_lat.sample.invalidate_us = now;
+            s_lat.sample.state = SAMPLE_INVALIDATED;
+        }
+    }
+
+    if (s_lat.prev_rounder_cb) {
+        s_lat.prev_rounder_cb(drv, area);
+    }
+}
+
+static void input_latency_render_start_cb(lv_disp_drv_t *drv)
+{
+    if (s_lat.sample.state == SAMPLE_INVALIDATED) {
+        s_lat.sample.state = SAMPLE_RENDERING;
+    }
+    if (s_lat.prev_render_start_cb) {
+        s_lat.prev_render_start_cb(drv);
+    }
+}
+
+static void input_latency_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    bool last = lv_disp_flush_is_last(drv);
+    s_lat.prev_flush_cb(drv, area, color_p);
+
+    // The DPI port swaps the frame buffer and waits for the panel before it returns
+    if (last && s_lat.sample.state == SAMPLE_RENDERING) {
+        if (drv->draw_buf->flushing) {
+            s_lat.sample.state = SAMPLE_FLUSHING;
+        } else {
+            sample_on_screen();
+        }
+    }
+}
+
+static void input_latency_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    if (s_lat.sample.state == SAMPLE_FLUSHING) {
+        sample_on_screen();
+    }
+    if (s_lat.prev_monitor_cb) {
+        s_lat.prev_monitor_cb(drv, time, px);
+    }
+}
+
+esp_err_t app_input_latency_init(lv_disp_t *disp, lv_indev_t *indev)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->driver && disp->driver->flush_cb, ESP_ERR_INVALID_ARG, TAG, "Invalid display");
+    ESP_RETURN_ON_FALSE(indev && indev->driver && indev->driver->read_cb, ESP_ERR_INVALID_ARG, TAG, "Invalid input device");
+    ESP_RETURN_ON_FALSE(s_lat.disp == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+    ESP_RETURN_ON_FALSE(!disp->driver->full_refresh, ESP_ERR_NOT_SUPPORTED, TAG, "Full refresh does not round areas");
+
+    lv_indev_drv_t *indev_drv = indev->driver;
+    s_lat.prev_read_cb = indev_drv->read_cb;
+    s_lat.prev_feedback_cb = indev_drv->feedback_cb;
+    indev_drv->read_cb = input_latency_read_cb;
+    indev_drv->feedback_cb = input_latency_feedback_cb;
+
+    lv_disp_drv_t *drv = disp->driver;
+    s_lat.prev_rounder_cb = drv->rounder_cb;
+    s_lat.prev_render_start_cb = drv->render_start_cb;
+    s_lat.prev_flush_cb = drv->flush_cb;
+    s_lat.prev_monitor_cb = drv->monitor_cb;
+    drv->rounder_cb = input_latency_rounder_cb;
+    drv->render_start_cb = input_latency_render_start_cb;
+    drv->flush_cb = input_latency_flush_cb;
+    drv->monitor_cb = input_latency_monitor_cb;
+    s_lat.disp = disp;
+    return ESP_OK;
+}
+
+void app_input_latency_set_screen(const char *name)
+{
+    s_lat.screen = name;
+}
+
+void app_input_latency_set_touch_time(int64_t time_us)
+{
+    s_lat.touch_us = time_us;
+}
+
+uint32_t app_input_latency_bucket_ms(int bucket)
+{
+    return bucket < APP_INPUT_LATENCY_BUCKETS - 1 ? s_bucket_ms[bucket] : UINT32_MAX;
+}
+
+int app_input_latency_get_stats(app_input_latency_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&s_lock);
+    int num = s_stats_num;
+    memcpy(stats, s_stats, num * sizeof(s_stats[0]));
+    if (reset) {
+        s_stats_num = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return num;
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_INPUT_LATENCY_BUCKETS           (12)
+#define APP_INPUT_LATENCY_MAX_SCREENS       (8)
+
+/**
+ * @brief Touch to photon latency of the clicks on one screen.
+ *
+ * Every time is measured from the touch read that saw the finger lift, or from the controller
+ * report behind it when the read callback gives its time with app_input_latency_set_touch_time().
+ */
+typedef struct {
+    const char *screen;                               /*!< Name given to app_input_latency_set_screen() */
+    uint32_t samples;                                 /*!< Clicks measured */
+    uint32_t hist[APP_INPUT_LATENCY_BUCKETS];         /*!< Touch to photon, see app_input_latency_bucket_ms() */
+    uint64_t event_us;                                /*!< Sum of the times until LVGL had dispatched the click */
+    uint64_t invalidate_us;                           /*!< Sum of the times until the first area was invalidated */
+    uint64_t photon_us;                               /*!< Sum of the times until the last flush of that frame was done */
+    uint32_t max_photon_us;                           /*!< Slowest touch to photon */
+} app_input_latency_stats_t;
+
+/**
+ * @brief Start timing clicks from the touch read to the frame on the panel.
+ *
+ * Chains the read and feedback callbacks of the pointer input device and the rounder, render
+ * start and flush callbacks of the display. A click is timestamped at the touch read that saw
+ * the finger lift, when LVGL has dispatched LV_EVENT_CLICKED, at the first area invalidated
+ * after the read, and when the last flush of the first frame rendered after that invalidate is
+ * done. Clicks that change nothing on screen within 500 ms are not counted.
+ *
+ * Call once with the display lock held, after the other flush callback hooks.
+ */
+esp_err_t app_input_latency_init(lv_disp_t *disp, lv_indev_t *indev);
+
+/**
+ * @brief Attribute the following clicks to a screen.
+ *
+ * @param name Static string, e.g. the screen manager's screen name.
+ */
+void app_input_latency_set_screen(const char *name);
+
+/**
+ * @brief Give the time the touch controller reported the state the current read returns.
+ *
+ * For read callbacks that pass on reports read earlier, e.g. on the controller interrupt.
+ * Call from inside the read callback chained by app_input_latency_init(); applies to that read
+ * only.
+ */
+void app_input_latency_set_touch_time(int64_t time_us);
+
+/**
+ * @brief Upper limit of a histogram bucket in ms, UINT32_MAX for the last one.
+ */
+uint32_t app_input_latency_bucket_ms(int bucket);
+
+/**
+ * @brief Read the counters of every screen clicked so far.
+ *
+ * @param stats Array of at least APP_INPUT_LATENCY_MAX_SCREENS entries.
+ * @param reset Start a new measurement period.
+ * @return Number of entries filled in.
+ */
+int app_input_latency_get_stats(app_input_latency_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
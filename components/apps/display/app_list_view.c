@@ -0,0 +1,207 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "app_list_view.h"
+
+#define LIST_VIEW_NO_ITEM                   (UINT32_MAX)
+
+static const char *TAG = "app_list_view";
+
+typedef struct app_list_view_t {
+    lv_obj_t *obj;
+    lv_obj_t *spacer;                                 /* Invisible, at the end of the last item, sets the scroll range */
+    lv_obj_t *rows[APP_LIST_VIEW_MAX_ROWS];
+    uint32_t row_items[APP_LIST_VIEW_MAX_ROWS];       /* Item shown by each row, LIST_VIEW_NO_ITEM if hidden */
+    uint32_t row_num;
+    uint32_t count;
+    app_list_view_config_t config;
+    int64_t period_start_us;
+    app_list_view_stats_t stats;
+} app_list_view_t;
+
+static lv_coord_t list_view_pitch(const app_list_view_t *view)
+{
+    return view->config.row_height + view->config.row_gap;
+}
+
+// Add rows until the visible items can all be shown, with a row partly visible at each end
+static void list_view_grow(app_list_view_t *view)
+{
+    uint32_t need = lv_obj_get_content_height(view->obj) / list_view_pitch(view) + 2;
+    if (need > APP_LIST_VIEW_MAX_ROWS) {
+        need = APP_LIST_VIEW_MAX_ROWS;
+    }
+
+    while (view->row_num < need) {
+        lv_obj_t *row = lv_obj_create(view->obj);
+        lv_obj_set_size(row, lv_pct(100), view->config.row_height);
+        lv_obj_clear_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+        view->config.create_row(row, 0, view->config.user_data);
+
+        view->rows[view->row_num] = row;
+        view->row_items[view->row_num] = LIST_VIEW_NO_ITEM;
+        view->row_num++;
+    }
+    view->stats.rows = view->row_num;
+}
+
+// Give every row the item it must show at the current scroll position. Item i always goes to
+// row i % row_num, so the rows still showing their item are left alone.
+static void list_view_update(app_list_view_t *view, bool rebind)
+{
+    if (view->row_num == 0) {
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    lv_coord_t pitch = list_view_pitch(view);
+    lv_coord_t scroll_y = lv_obj_get_scroll_y(view->obj);
+    uint32_t first = (scroll_y > 0) ? scroll_y / pitch : 0;
+
+    for (uint32_t i = first; i < first + view->row_num; i++) {
+        uint32_t slot = i % view->row_num;
+        lv_obj_t *row = view->rows[slot];
+        if (i >= view->count) {
+            if (view->row_items[slot] != LIST_VIEW_NO_ITEM) {
+                lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+                view->row_items[slot] = LIST_VIEW_NO_ITEM;
+            }
+            continue;
+        }
+        if (view->row_items[slot] == i && !rebind) {
+            continue;
+        }
+
+        if (view->row_items[slot] != i) {
+            lv_obj_set_pos(row, 0, i * pitch);
+        }
+        view->config.bind_row(row, i, view->config.user_data);
+        lv_obj_clear_flag(row, LV_OBJ_FLAG_HIDDEN);
+        view->row_items[slot] = i;
+        view->stats.binds++;
+    }
+
+    uint32_t time_us = esp_timer_get_time() - start_us;
+    view->stats.updates++;
+    view->stats.update_us += time_us;
+    if (time_us > view->stats.max_update_us) {
+        view->stats.max_update_us = time_us;
+    }
+}
+
+static void list_view_event_cb(lv_event_t *e)
+{
+    app_list_view_t *view = (app_list_view_t *)lv_event_get_user_data(e);
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_SIZE_CHANGED:
+        list_view_grow(view);
+        list_view_update(view, false);
+        break;
+    case LV_EVENT_SCROLL:
+        list_view_update(view, false);
+        break;
+    case LV_EVENT_DELETE:
+        heap_caps_free(view);
+        break;
+    default:
+        break;
+    }
+}
+
+esp_err_t app_list_view_create(lv_obj_t *parent, const app_list_view_config_t *config,
+                               app_list_view_handle_t *ret_view)
+{
+    ESP_RETURN_ON_FALSE(parent && config && config->create_row && config->bind_row && ret_view,
+                        ESP_ERR_INVALID_ARG, TAG, "Invalid arguments");
+    ESP_RETURN_ON_FALSE(config->row_height > 0 && config->row_gap >= 0, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid row height %d, gap %d", (int)config->row_height, (int)config->row_gap);
+    app_list_view_t *view = heap_caps_calloc(1, sizeof(app_list_view_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(view, ESP_ERR_NO_MEM, TAG, "No memory for the list");
+
+    view->config = *config;
+    view->obj = lv_obj_create(parent);
+    lv_obj_set_scroll_dir(view->obj, LV_DIR_VER);
+    lv_obj_set_scrollbar_mode(view->obj, LV_SCROLLBAR_MODE_AUTO);
+
+    view->spacer = lv_obj_create(view->obj);
+    lv_obj_remove_style_all(view->spacer);
+    lv_obj_set_size(view->spacer, 1, 1);
+    lv_obj_clear_flag(view->spacer, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_flag(view->spacer, LV_OBJ_FLAG_HIDDEN);
+
+    lv_obj_add_event_cb(view->obj, list_view_event_cb, LV_EVENT_SIZE_CHANGED, view);
+    lv_obj_add_event_cb(view->obj, list_view_event_cb, LV_EVENT_SCROLL, view);
+    lv_obj_add_event_cb(view->obj, list_view_event_cb, LV_EVENT_DELETE, view);
+    view->period_start_us = esp_timer_get_time();
+
+    *ret_view = view;
+    return ESP_OK;
+}
+
+lv_obj_t *app_list_view_get_obj(app_list_view_handle_t view)
+{
+    return view->obj;
+}
+
+void app_list_view_set_count(app_list_view_handle_t view, uint32_t count)
+{
+    if (count == view->count) {
+        return;
+    }
+
+    view->count = count;
+    view->stats.count = count;
+    if (count) {
+        lv_obj_set_pos(view->spacer, 0, count * list_view_pitch(view) - view->config.row_gap - 1);
+        lv_obj_clear_flag(view->spacer, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(view->spacer, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    // Bring the last items back into view if the list got shorter than the scroll position
+    lv_obj_update_layout(view->obj);
+    lv_obj_readjust_scroll(view->obj, LV_ANIM_OFF);
+    list_view_update(view, false);
+}
+
+void app_list_view_refresh(app_list_view_handle_t view)
+{
+    list_view_update(view, true);
+}
+
+int app_list_view_get_index(app_list_view_handle_t view, lv_obj_t *obj)
+{
+    while (obj && lv_obj_get_parent(obj) != view->obj) {
+        obj = lv_obj_get_parent(obj);
+    }
+
+    for (uint32_t i = 0; obj && i < view->row_num; i++) {
+        if (view->rows[i] == obj) {
+            return (view->row_items[i] == LIST_VIEW_NO_ITEM) ? -1 : (int)view->row_items[i];
+        }
+    }
+    return -1;
+}
+
+void app_list_view_get_stats(app_list_view_handle_t view, app_list_view_stats_t *stats, bool reset)
+{
+    int64_t now_us = esp_timer_get_time();
+    *stats = view->stats;
+    stats->elapsed_us = now_us - view->period_start_us;
+
+    if (reset) {
+        view->stats.updates = 0;
+        view->stats.binds = 0;
+        view->stats.update_us = 0;
+        view->stats.max_update_us = 0;
+        view->period_start_us = now_us;
+    }
+}
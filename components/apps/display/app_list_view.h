@@ -0,0 +1,108 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_LIST_VIEW_MAX_ROWS              (16)      /*!< Rows in the pool, enough for a full screen of 40 px rows */
+
+typedef struct app_list_view_t *app_list_view_handle_t;
+
+/**
+ * @brief Row callback.
+ *
+ * @param row Pooled row, an lv_obj the size of one item.
+ * @param index Item shown by the row; unused when the row is created.
+ */
+typedef void (*app_list_view_row_cb_t)(lv_obj_t *row, uint32_t index, void *user_data);
+
+/**
+ * @brief List view configuration.
+ */
+typedef struct {
+    lv_coord_t row_height;                            /*!< Height of every row */
+    lv_coord_t row_gap;                               /*!< Space between two rows */
+    app_list_view_row_cb_t create_row;                /*!< Adds the widgets of a row, once per pooled row */
+    app_list_view_row_cb_t bind_row;                  /*!< Fills a row with an item */
+    void *user_data;                                  /*!< Passed to the callbacks */
+} app_list_view_config_t;
+
+/**
+ * @brief List view counters.
+ */
+typedef struct {
+    uint32_t rows;                                    /*!< Rows in the pool */
+    uint32_t count;                                   /*!< Items in the list */
+    uint32_t updates;                                 /*!< Scrolls, resizes and count changes handled */
+    uint32_t binds;                                   /*!< Rows filled with another item */
+    uint64_t update_us;                               /*!< Time spent binding rows */
+    uint32_t max_update_us;                           /*!< Longest update */
+    int64_t elapsed_us;                               /*!< Time covered by the counters */
+} app_list_view_stats_t;
+
+/**
+ * @brief Create a scrollable list with recycled rows.
+ *
+ * The list only has the rows that fit in it, plus two, whatever the number of items. Each item
+ * has a fixed position in the scrollable area; as the list scrolls, a row whose item left the
+ * view is moved to an item coming in and filled with it by `bind_row`, so scrolling by one row
+ * fills one row. Opening or filling a list of thousands of items costs the same as for ten.
+ *
+ * The rows are created as the list gets its size, after app_list_view_create(). The handle is
+ * freed with the object. Must be called with the display lock held.
+ *
+ * @param[out] ret_view List handle.
+ * @return
+ *      - ESP_OK: Success
+ *      - ESP_ERR_INVALID_ARG: Invalid argument
+ *      - ESP_ERR_NO_MEM: No memory for the list
+ */
+esp_err_t app_list_view_create(lv_obj_t *parent, const app_list_view_config_t *config,
+                               app_list_view_handle_t *ret_view);
+
+/**
+ * @brief LVGL object of the list, to place, size and style it.
+ */
+lv_obj_t *app_list_view_get_obj(app_list_view_handle_t view);
+
+/**
+ * @brief Set the number of items.
+ *
+ * Only the rows whose item appears or goes away are bound, so items can be added page by page
+ * at little cost. Use app_list_view_refresh() if the items already shown changed as well.
+ */
+void app_list_view_set_count(app_list_view_handle_t view, uint32_t count);
+
+/**
+ * @brief Bind every visible row again.
+ */
+void app_list_view_refresh(app_list_view_handle_t view);
+
+/**
+ * @brief Item shown by the row holding `obj`.
+ *
+ * @param obj A row or any widget in it, e.g. the target of a click.
+ * @return Item index, or -1 if `obj` is not in a row showing an item.
+ */
+int app_list_view_get_index(app_list_view_handle_t view, lv_obj_t *obj);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period.
+ */
+void app_list_view_get_stats(app_list_view_handle_t view, app_list_view_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "app_touch.h"
+#if CONFIG_APP_INPUT_LATENCY_ENABLE
+#include "app_input_latency.h"
+#endif
+
+#define TOUCH_TASK_STACK_SIZE               (3 * 1024)
+
+static const char *TAG = "app_touch";
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    bool pressed;
+    int64_t irq_us;                                   /* Interrupt that announced the report */
+} touch_point_t;
+
+typedef struct {
+    lv_indev_t *indev;
+    esp_lcd_touch_handle_t tp;
+    bool irq;
+    uint16_t recheck_ms;
+    TaskHandle_t task;
+    QueueHandle_t queue;
+    int64_t irq_us;                                   /* First interrupt not read yet, 0 if none */
+    touch_point_t last;                               /* Last report passed to LVGL */
+    void (*prev_read_cb)(lv_indev_drv_t *drv, lv_indev_data_t *data);
+} touch_t;
+
+static touch_t s_touch;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_touch_stats_t s_stats;
+static int64_t s_start_us;
+static uint64_t s_task_start_us;
+
+static IRAM_ATTR void touch_isr_cb(esp_lcd_touch_handle_t tp)
+{
+    BaseType_t task_woken = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&s_lock);
+    s_stats.interrupts++;
+    if (!s_touch.irq_us) {
+        s_touch.irq_us = esp_timer_get_time();
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    vTaskNotifyGiveFromISR(s_touch.task, &task_woken);
+    if (task_woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void touch_queue_point(const touch_point_t *point)
+{
+    if (xQueueSend(s_touch.queue, point, 0) == pdTRUE) {
+        return;
+    }
+
+    // Keep the newest report, a release must reach LVGL even if it fell behind
+    touch_point_t oldest;
+    xQueueReceive(s_touch.queue, &oldest, 0);
+    xQueueSend(s_touch.queue, point, 0);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.dropped++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void touch_task(void *arg)
+{
+    bool pressed = false;
+
+    while (1) {
+        TickType_t timeout = (pressed && s_touch.recheck_ms) ? pdMS_TO_TICKS(s_touch.recheck_ms) : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, timeout);
+
+        int64_t start_us = esp_timer_get_time();
+        portENTER_CRITICAL(&s_lock);
+        int64_t irq_us = s_touch.irq_us ? s_touch.irq_us : start_us;
+        s_touch.irq_us = 0;
+        portEXIT_CRITICAL(&s_lock);
+
+        uint16_t x[1];
+        uint16_t y[1];
+        uint16_t strength[1];
+        uint8_t count = 0;
+        esp_err_t ret = esp_lcd_touch_read_data(s_touch.tp);
+        bool touched = ret == ESP_OK && esp_lcd_touch_get_coordinates(s_touch.tp, x, y, strength, &count, 1) && count > 0;
+        int64_t end_us = esp_timer_get_time();
+
+        portENTER_CRITICAL(&s_lock);
+        s_stats.reads++;
+        s_stats.read_us += end_us - start_us;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to read touch: %s", esp_err_to_name(ret));
+            continue;
+        }
+        if (!touched && !pressed) {
+            continue;
+        }
+
+        touch_point_t point = {
+            .x = touched ? x[0] : s_touch.last.x,
+            .y = touched ? y[0] : s_touch.last.y,
+            .pressed = touched,
+            .irq_us = irq_us,
+        };
+        touch_queue_point(&point);
+        pressed = touched;
+    }
+}
+
+static void touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    int64_t start_us = esp_timer_get_time();
+    touch_point_t point;
+
+    if (xQueueReceive(s_touch.queue, &point, 0) == pdTRUE) {
+        s_touch.last = point;
+        // Hand every queued report to LVGL in this read, a press and release in between polls included
+        data->continue_reading = uxQueueMessagesWaiting(s_touch.queue) > 0;
+#if CONFIG_APP_INPUT_LATENCY_ENABLE
+        app_input_latency_set_touch_time(point.irq_us);
+#endif
+
+        uint32_t queue_us = start_us - point.irq_us;
+        portENTER_CRITICAL(&s_lock);
+        s_stats.points++;
+        s_stats.queue_us += queue_us;
+        if (queue_us > s_stats.max_queue_us) {
+            s_stats.max_queue_us = queue_us;
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+
+    data->point.x = s_touch.last.x;
+    data->point.y = s_touch.last.y;
+    data->state = s_touch.last.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+
+    int64_t end_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    s_stats.indev_reads++;
+    s_stats.indev_us += end_us - start_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void touch_poll_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    // The port's callback reads the controller over I2C on every poll
+    int64_t start_us = esp_timer_get_time();
+    s_touch.prev_read_cb(drv, data);
+    int64_t end_us = esp_timer_get_time();
+#if CONFIG_APP_INPUT_LATENCY_ENABLE
+    app_input_latency_set_touch_time(start_us);
+#endif
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.reads++;
+    s_stats.read_us += end_us - start_us;
+    s_stats.indev_reads++;
+    s_stats.indev_us += end_us - start_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static uint64_t touch_task_run_time(void)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    return s_touch.task ? ulTaskGetRunTimeCounter(s_touch.task) : 0;
+#else
+    return 0;
+#endif
+}
+
+static esp_err_t touch_irq_init(const app_touch_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(s_touch.tp->config.int_gpio_num != GPIO_NUM_NC, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "Touch controller has no interrupt line");
+
+    s_touch.queue = xQueueCreate(config->queue_len ? config->queue_len : 1, sizeof(touch_point_t));
+    ESP_RETURN_ON_FALSE(s_touch.queue, ESP_ERR_NO_MEM, TAG, "Failed to create queue");
+
+    esp_err_t ret = ESP_OK;
+    BaseType_t res = xTaskCreatePinnedToCore(touch_task, "Touch", TOUCH_TASK_STACK_SIZE, NULL,
+                                             CONFIG_APP_TOUCH_IRQ_TASK_PRIORITY, &s_touch.task, tskNO_AFFINITY);
+    ESP_GOTO_ON_FALSE(res == pdPASS, ESP_ERR_NO_MEM, err, TAG, "Failed to create reader task");
+    ESP_GOTO_ON_ERROR(esp_lcd_touch_register_interrupt_callback(s_touch.tp, touch_isr_cb), err, TAG,
+                      "Failed to register touch interrupt");
+
+    lv_indev_drv_t *drv = s_touch.indev->driver;
+    drv->read_cb = touch_read_cb;
+    if (config->read_period_ms && drv->read_timer) {
+        lv_timer_set_period(drv->read_timer, config->read_period_ms);
+    }
+    s_touch.recheck_ms = config->recheck_ms;
+    s_touch.irq = true;
+
+    // Pick up a finger already on the screen
+    xTaskNotifyGive(s_touch.task);
+    return ESP_OK;
+
+err:
+    if (s_touch.task) {
+        vTaskDelete(s_touch.task);
+        s_touch.task = NULL;
+    }
+    vQueueDelete(s_touch.queue);
+    s_touch.queue = NULL;
+    return ret;
+}
+
+esp_err_t app_touch_init(lv_indev_t *indev, esp_lcd_touch_handle_t tp, const app_touch_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(indev && indev->driver && indev->driver->read_cb && tp && config, ESP_ERR_INVALID_ARG, TAG,
+                        "Invalid argument");
+    ESP_RETURN_ON_FALSE(s_touch.indev == NULL, ESP_ERR_INVALID_STATE, TAG, "Already initialized");
+
+    s_touch.indev = indev;
+    s_touch.tp = tp;
+    s_touch.prev_read_cb = indev->driver->read_cb;
+    if (config->irq) {
+        esp_err_t ret = touch_irq_init(config);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Touch stays polled by LVGL");
+        }
+    }
+    if (!s_touch.irq) {
+        indev->driver->read_cb = touch_poll_read_cb;
+    }
+
+    s_start_us = esp_timer_get_time();
+    s_task_start_us = touch_task_run_time();
+    ESP_LOGI(TAG, "Touch read %s", s_touch.irq ? "on interrupt" : "on every LVGL poll");
+    return ESP_OK;
+}
+
+void app_touch_get_stats(app_touch_stats_t *stats, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+    uint64_t task_us = touch_task_run_time();
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->irq = s_touch.irq;
+    stats->task_us = task_us - s_task_start_us;
+    stats->elapsed_us = now - s_start_us;
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+        s_start_us = now;
+        s_task_start_us = task_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_lcd_touch.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Touch reading setup.
+ */
+typedef struct {
+    bool irq;                                         /*!< Read the controller on its interrupt, otherwise only time the polling */
+    uint16_t queue_len;                               /*!< Touch reports buffered for the input device */
+    uint16_t read_period_ms;                          /*!< Input device read period, 0 keeps LVGL's */
+    uint16_t recheck_ms;                              /*!< Read again after this long without interrupt while pressed */
+} app_touch_config_t;
+
+/**
+ * @brief Touch controller load counters.
+ */
+typedef struct {
+    bool irq;                                         /*!< Read on the interrupt, otherwise polled by LVGL */
+    uint32_t interrupts;                              /*!< Interrupts from the controller */
+    uint32_t reads;                                   /*!< Controller reads over I2C */
+    uint64_t read_us;                                 /*!< Time the reads held the bus */
+    uint64_t task_us;                                 /*!< CPU time of the reader task, 0 if not known */
+    uint32_t indev_reads;                             /*!< Calls of the input device read callback */
+    uint64_t indev_us;                                /*!< Time the LVGL task spent in them */
+    uint32_t points;                                  /*!< Touch reports passed to LVGL */
+    uint32_t dropped;                                 /*!< Touch reports dropped on a full queue */
+    uint64_t queue_us;                                /*!< Interrupt to LVGL reading the report, summed */
+    uint32_t max_queue_us;                            /*!< Slowest interrupt to LVGL */
+    int64_t elapsed_us;                               /*!< Time covered by the counters */
+} app_touch_stats_t;
+
+/**
+ * @brief Read the touch controller when it signals new data instead of on every LVGL poll.
+ *
+ * With `config->irq` set, the controller's interrupt wakes a reader task that reads it over I2C
+ * and queues the touch report; the input device's read callback only takes reports off the
+ * queue, so the LVGL task no longer waits on the bus, which the controller shares with the
+ * camera and the codec, and the bus is idle while nobody touches the screen. Reports arriving
+ * between two polls are all passed to LVGL, so a short tap is not lost, and the poll period can
+ * be shorter since it costs no bus time. While pressed the controller interrupts every report
+ * cycle; if it stays silent for `recheck_ms` the release interrupt was missed and the
+ * controller is read once more.
+ *
+ * Without `config->irq` the input device keeps polling and only the reads are timed, to compare
+ * both modes with app_touch_get_stats().
+ *
+ * Call once with the display lock held, before anything else chains the read callback.
+ */
+esp_err_t app_touch_init(lv_indev_t *indev, esp_lcd_touch_handle_t tp, const app_touch_config_t *config);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period.
+ */
+void app_touch_get_stats(app_touch_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
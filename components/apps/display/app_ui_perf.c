@@ -0,0 +1,97 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "app_ui_perf.h"
+
+static const char *TAG = "app_ui_perf";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static app_ui_perf_stats_t s_stats;
+static int64_t s_start_us;
+static void (*s_prev_monitor_cb)(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
+static void (*s_prev_render_start_cb)(lv_disp_drv_t *drv);
+static void (*s_prev_flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+static int64_t s_render_start_us;
+
+static void ui_perf_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_stats.refreshes++;
+    s_stats.refresh_time_ms += time;
+    s_stats.refresh_px += px;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (s_prev_monitor_cb) {
+        s_prev_monitor_cb(drv, time, px);
+    }
+}
+
+static void ui_perf_render_start_cb(lv_disp_drv_t *drv)
+{
+    s_render_start_us = esp_timer_get_time();
+    if (s_prev_render_start_cb) {
+        s_prev_render_start_cb(drv);
+    }
+}
+
+static void ui_perf_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    // monitor_cb only has tick resolution and includes the wait for the panel
+    if (lv_disp_flush_is_last(drv) && s_render_start_us) {
+        int64_t time_us = esp_timer_get_time() - s_render_start_us;
+        s_render_start_us = 0;
+        portENTER_CRITICAL(&s_lock);
+        s_stats.renders++;
+        s_stats.render_us += time_us;
+        portEXIT_CRITICAL(&s_lock);
+    }
+    s_prev_flush_cb(drv, area, color_p);
+}
+
+esp_err_t app_ui_perf_init(lv_disp_t *disp)
+{
+    ESP_RETURN_ON_FALSE(disp && disp->driver, ESP_ERR_INVALID_ARG, TAG, "Invalid display");
+
+    if (disp->driver->monitor_cb != ui_perf_monitor_cb) {
+        s_prev_monitor_cb = disp->driver->monitor_cb;
+        disp->driver->monitor_cb = ui_perf_monitor_cb;
+    }
+    if (disp->driver->flush_cb && disp->driver->flush_cb != ui_perf_flush_cb) {
+        s_prev_render_start_cb = disp->driver->render_start_cb;
+        s_prev_flush_cb = disp->driver->flush_cb;
+        disp->driver->render_start_cb = ui_perf_render_start_cb;
+        disp->driver->flush_cb = ui_perf_flush_cb;
+    }
+    s_start_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+void app_ui_perf_preview_frame(uint32_t time_us)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_stats.preview_frames++;
+    s_stats.preview_time_us += time_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void app_ui_perf_get_stats(app_ui_perf_stats_t *stats, bool reset)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->elapsed_us = now - s_start_us;
+    if (reset) {
+        memset(&s_stats, 0, sizeof(s_stats));
+        s_start_us = now;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
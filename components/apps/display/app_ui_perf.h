@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief UI performance counters.
+ */
+typedef struct {
+    uint32_t preview_frames;                          /*!< Camera frames put on screen */
+    uint64_t preview_time_us;                         /*!< Time spent putting them on screen */
+    uint32_t refreshes;                               /*!< LVGL refresh cycles that rendered something */
+    uint32_t refresh_time_ms;                         /*!< LVGL render time, in LVGL tick resolution */
+    uint64_t refresh_px;                              /*!< Pixels rendered by LVGL */
+    uint32_t renders;                                 /*!< Refreshes timed from render start to the last flush */
+    uint64_t render_us;                               /*!< Render time of those, without waiting for the panel */
+    int64_t elapsed_us;                               /*!< Time covered by the counters */
+} app_ui_perf_stats_t;
+
+/**
+ * @brief Start counting LVGL refreshes of a display.
+ *
+ * Chains the display's monitor, render start and flush callbacks, so it can be called once at
+ * start-up regardless of what the port installed. Must be called with the display lock held.
+ */
+esp_err_t app_ui_perf_init(lv_disp_t *disp);
+
+/**
+ * @brief Count one camera preview frame.
+ *
+ * @param time_us Time the capture task spent putting the frame on screen.
+ */
+void app_ui_perf_preview_frame(uint32_t time_us);
+
+/**
+ * @brief Read the counters.
+ *
+ * @param reset Start a new measurement period.
+ */
+void app_ui_perf_get_stats(app_ui_perf_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+"""
+Pack UI assets from a directory into one bundle image for the asset partition.
+
+The bundle is read in place through a memory mapped view of the partition by app_asset_fs.c,
+so every file starts on a cache line and is found through a hash index without scanning:
+
+    header      magic 'ABN1', version, file count, slot count, section offsets, total size
+    slots       open addressing hash table of (FNV-1a hash, name offset, data offset, size)
+    names       NUL terminated paths relative to the packed directory, '/' separated
+    data        file contents, each aligned to --align bytes
+
+All fields are little endian 32 bit, except the 16 bit version and flags. An empty slot has a
+data offset of 0. Run by the build, see main/CMakeLists.txt.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x314E4241  # 'ABN1'
+VERSION = 1
+HEADER = struct.Struct('<IHHIIIIII')
+SLOT = struct.Struct('<IIII')
+
+
+def fnv1a(name):
+    h = 0x811C9DC5
+    for b in name.encode():
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def align_up(value, align):
+    return (value + align - 1) // align * align
+
+
+def collect(root, names):
+    if names:
+        return [(name, os.path.join(root, name)) for name in names]
+
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            path = os.path.join(dirpath, filename)
+            files.append((os.path.relpath(path, root).replace(os.sep, '/'), path))
+    return files
+
+
+def pack(files, align):
+    slot_num = 1
+    while slot_num < 2 * max(len(files), 1):
+        slot_num *= 2
+
+    names = bytearray()
+    name_offsets = []
+    for name, _ in files:
+        name_offsets.append(len(names))
+        names += name.encode() + b'\0'
+
+    slots_offset = HEADER.size
+    names_offset = slots_offset + slot_num * SLOT.size
+    data_offset = align_up(names_offset + len(names), align)
+
+    slots = [None] * slot_num
+    data = bytearray()
+    for (name, path), name_offset in zip(files, name_offsets):
+        with open(path, 'rb') as f:
+            content = f.read()
+        data += bytes(align_up(len(data), align) - len(data))
+        h = fnv1a(name)
+        i = h & (slot_num - 1)
+        while slots[i] is not None:
+            i = (i + 1) & (slot_num - 1)
+        slots[i] = (h, name_offset, data_offset + len(data), len(content))
+        data += content
+
+    total = data_offset + len(data)
+    out = bytearray(HEADER.pack(MAGIC, VERSION, 0, len(files), slot_num, slots_offset, names_offset, data_offset, total))
+    for slot in slots:
+        out += SLOT.pack(*(slot or (0, 0, 0, 0)))
+    out += names
+    out += bytes(data_offset - len(out))
+    out += data
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('input', help='directory to pack')
+    parser.add_argument('files', nargs='*', help='files to pack, relative to the directory, all of them if none')
+    parser.add_argument('-o', '--output', required=True, help='bundle image to write')
+    parser.add_argument('--size', type=lambda s: int(s, 0), default=0, help='partition size, to check the bundle fits')
+    parser.add_argument('--align', type=int, default=128, help='file alignment in bytes, a power of 2')
+    args = parser.parse_args()
+    if args.align <= 0 or args.align & (args.align - 1):
+        parser.error('alignment must be a power of 2')
+
+    files = collect(args.input, args.files)
+    missing = [path for _, path in files if not os.path.isfile(path)]
+    if missing:
+        parser.error(f'no such file: {", ".join(missing)}')
+    bundle = pack(files, args.align)
+    if args.size and len(bundle) > args.size:
+        print(f'error: {len(files)} assets take {len(bundle)} bytes, the partition has {args.size}', file=sys.stderr)
+        sys.exit(1)
+
+    with open(args.output, 'wb') as f:
+        f.write(bundle)
+    print(f'{len(files)} assets packed into {len(bundle) // 1024} KB')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+"""
+Convert opaque PNG images into JPEG images for LVGL, as C sources.
+
+Each PNG becomes a baseline JPEG wrapped in an LV_IMG_CF_RAW image descriptor named after the
+file, the same symbol the LVGL image converter gives the raw array, so the source can be swapped
+in without touching the code that uses it. The hardware JPEG decoder in app_img_jpeg.c decodes
+it on first use. Only needs the Python standard library, e.g. to regenerate the coffee UI's
+full screen images:
+
+    python png_to_jpeg.py -o ../../../main/assets ../../../spiffs/img_main_menu.png \\
+        ../../../spiffs/img_making.png ../../../spiffs/making_finish.png ../../../spiffs/preference.png
+
+Also writes the .jpg next to the .c with --jpg, to look at the result.
+"""
+
+import argparse
+import math
+import os
+import struct
+import sys
+import zlib
+
+ZIGZAG = (
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+)
+
+# Quantization tables of the JPEG standard, annex K, in row order
+LUMA_QUANT = (
+    16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99,
+)
+CHROMA_QUANT = (
+    17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+)
+
+# Huffman tables of the JPEG standard, annex K: code counts per length, then symbols
+DC_LUMA = ((0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0), tuple(range(12)))
+DC_CHROMA = ((0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0), tuple(range(12)))
+AC_LUMA = ((0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d), bytes.fromhex(
+    '01020300041105122131410613516107227114328191a1082342b1c11552d1f02433627282090a161718191a25262728292a'
+    '3435363738393a434445464748494a535455565758595a636465666768696a737475767778797a838485868788898a92939495'
+    '969798999aa2a3a4a5a6a7a8a9aab2b3b4b5b6b7b8b9bac2c3c4c5c6c7c8c9cad2d3d4d5d6d7d8d9dae1e2e3e4e5e6e7e8e9ea'
+    'f1f2f3f4f5f6f7f8f9fa'))
+AC_CHROMA = ((0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77), bytes.fromhex(
+    '000102031104052131061241510761711322328108144291a1b1c109233352f0156272d10a162434e125f11718191a262728'
+    '292a35363738393a434445464748494a535455565758595a636465666768696a737475767778797a82838485868788898a92'
+    '939495969798999aa2a3a4a5a6a7a8a9aab2b3b4b5b6b7b8b9bac2c3c4c5c6c7c8c9cad2d3d4d5d6d7d8d9dae2e3e4e5e6e7'
+    'e8e9eaf2f3f4f5f6f7f8f9fa'))
+
+# Orthonormal 8 point DCT-II basis
+DCT = [[(math.sqrt(0.125) if u == 0 else 0.5) * math.cos((2 * x + 1) * u * math.pi / 16) for x in range(8)]
+       for u in range(8)]
+
+
+def read_png(path):
+    """Return width, height and rows of (r, g, b, a) bytes of an 8 bit RGB or RGBA PNG."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError(f'{path}: not a PNG file')
+
+    pos = 8
+    idat = bytearray()
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        if kind == b'IHDR':
+            width, height, depth, color, _, _, interlace = struct.unpack('>IIBBBBB', body)
+        elif kind == b'IDAT':
+            idat += body
+        elif kind == b'IEND':
+            break
+        pos += 12 + length
+    if depth != 8 or color not in (2, 6) or interlace:
+        raise ValueError(f'{path}: only 8 bit, non-interlaced RGB and RGBA PNG files are supported')
+
+    bpp = 4 if color == 6 else 3
+    stride = width * bpp
+    raw = zlib.decompress(bytes(idat))
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        filt = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            left = line[i - bpp] if i >= bpp else 0
+            up = prev[i]
+            if filt == 1:
+                line[i] = (line[i] + left) & 0xFF
+            elif filt == 2:
+                line[i] = (line[i] + up) & 0xFF
+            elif filt == 3:
+                line[i] = (line[i] + ((left + up) >> 1)) & 0xFF
+            elif filt == 4:
+                up_left = prev[i - bpp] if i >= bpp else 0
+                p = left + up - up_left
+                pa, pb, pc = abs(p - left), abs(p - up), abs(p - up_left)
+                pred = left if pa <= pb and pa <= pc else (up if pb <= pc else up_left)
+                line[i] = (line[i] + pred) & 0xFF
+        rows.append(line if bpp == 4 else bytearray(b for px in range(width) for b in (*line[px * 3:px * 3 + 3], 255)))
+        prev = line
+    return width, height, rows
+
+
+def scaled_quant(table, quality):
+    scale = 5000 // quality if quality < 50 else 200 - 2 * quality
+    return [min(255, max(1, (q * scale + 50) // 100)) for q in table]
+
+
+def huffman_codes(table):
+    counts, symbols = table
+    codes = {}
+    code = 0
+    k = 0
+    for length in range(1, 17):
+        for _ in range(counts[length - 1]):
+            codes[symbols[k]] = (code, length)
+            code += 1
+            k += 1
+        code <<= 1
+    return codes
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.bits = 0
+
+    def write(self, code, length):
+        self.acc = (self.acc << length) | code
+        self.bits += length
+        while self.bits >= 8:
+            self.bits -= 8
+            byte = (self.acc >> self.bits) & 0xFF
+            self.out.append(byte)
+            if byte == 0xFF:
+                self.out.append(0)
+        self.acc &= (1 << self.bits) - 1
+
+    def flush(self):
+        if self.bits:
+            self.write((1 << (8 - self.bits)) - 1, 8 - self.bits)
+
+
+def magnitude(value):
+    size = abs(value).bit_length()
+    return size, (value if value >= 0 else value + (1 << size) - 1)
+
+
+def encode_block(block, quant, prev_dc, dc_codes, ac_codes, bits):
+    tmp = [[sum(DCT[u][x] * block[y * 8 + x] for x in range(8)) for u in range(8)] for y in range(8)]
+    coef = [0] * 64
+    for v in range(8):
+        for u in range(8):
+            coef[v * 8 + u] = round(sum(DCT[v][y] * tmp[y][u] for y in range(8)) / quant[v * 8 + u])
+
+    dc = coef[0]
+    size, value = magnitude(dc - prev_dc)
+    bits.write(*dc_codes[size])
+    if size:
+        bits.write(value, size)
+
+    run = 0
+    for k in range(1, 64):
+        c = coef[ZIGZAG[k]]
+        if c == 0:
+            run += 1
+            continue
+        while run > 15:
+            bits.write(*ac_codes[0xF0])
+            run -= 16
+        size, value = magnitude(c)
+        bits.write(*ac_codes[(run << 4) | size])
+        bits.write(value, size)
+        run = 0
+    if run:
+        bits.write(*ac_codes[0x00])
+    return dc
+
+
+def encode_jpeg(width, height, rows, quality):
+    """Baseline JPEG, 4:4:4 so text and thin lines keep their colour."""
+    luma_q = scaled_quant(LUMA_QUANT, quality)
+    chroma_q = scaled_quant(CHROMA_QUANT, quality)
+    tables = ((huffman_codes(DC_LUMA), huffman_codes(AC_LUMA), luma_q),
+              (huffman_codes(DC_CHROMA), huffman_codes(AC_CHROMA), chroma_q))
+
+    # Level shifted YCbCr planes, edges repeated up to whole blocks
+    pw, ph = (width + 7) // 8 * 8, (height + 7) // 8 * 8
+    planes = ([], [], [])
+    for y in range(ph):
+        row = rows[min(y, height - 1)]
+        py, pcb, pcr = [], [], []
+        for x in range(pw):
+            i = min(x, width - 1) * 4
+            r, g, b = row[i], row[i + 1], row[i + 2]
+            py.append(0.299 * r + 0.587 * g + 0.114 * b - 128)
+            pcb.append(-0.168736 * r - 0.331264 * g + 0.5 * b)
+            pcr.append(0.5 * r - 0.418688 * g - 0.081312 * b)
+        planes[0].append(py)
+        planes[1].append(pcb)
+        planes[2].append(pcr)
+
+    bits = BitWriter()
+    prev_dc = [0, 0, 0]
+    for by in range(0, ph, 8):
+        for bx in range(0, pw, 8):
+            for c in range(3):
+                dc_codes, ac_codes, quant = tables[0 if c == 0 else 1]
+                block = [v for r in planes[c][by:by + 8] for v in r[bx:bx + 8]]
+                prev_dc[c] = encode_block(block, quant, prev_dc[c], dc_codes, ac_codes, bits)
+    bits.flush()
+
+    def segment(marker, body):
+        return struct.pack('>HH', marker, len(body) + 2) + body
+
+    def dht(cls_id, table):
+        return bytes((cls_id,)) + bytes(table[0]) + bytes(table[1])
+
+    out = bytearray(b'\xff\xd8')
+    out += segment(0xFFE0, b'JFIF\x00\x01\x01\x00\x00\x01\x00\x01\x00\x00')
+    out += segment(0xFFDB, bytes((0,)) + bytes(luma_q[z] for z in ZIGZAG) +
+                   bytes((1,)) + bytes(chroma_q[z] for z in ZIGZAG))
+    out += segment(0xFFC0, struct.pack('>BHHB', 8, height, width, 3) +
+                   bytes((1, 0x11, 0, 2, 0x11, 1, 3, 0x11, 1)))
+    out += segment(0xFFC4, dht(0x00, DC_LUMA) + dht(0x10, AC_LUMA) + dht(0x01, DC_CHROMA) + dht(0x11, AC_CHROMA))
+    out += segment(0xFFDA, bytes((3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0)))
+    out += bits.out
+    out += b'\xff\xd9'
+    return bytes(out)
+
+
+def write_c(path, name, width, height, jpeg):
+    attr = f'LV_ATTRIBUTE_IMG_{name.upper()}'
+    lines = [', '.join(f'0x{b:02x}' for b in jpeg[i:i + 16]) for i in range(0, len(jpeg), 16)]
+    with open(path, 'w') as f:
+        f.write(f'''#ifdef __has_include
+    #if __has_include("lvgl.h")
+        #ifndef LV_LVGL_H_INCLUDE_SIMPLE
+            #define LV_LVGL_H_INCLUDE_SIMPLE
+        #endif
+    #endif
+#endif
+
+#if defined(LV_LVGL_H_INCLUDE_SIMPLE)
+    #include "lvgl.h"
+#else
+    #include "lvgl/lvgl.h"
+#endif
+
+
+#ifndef LV_ATTRIBUTE_MEM_ALIGN
+#define LV_ATTRIBUTE_MEM_ALIGN
+#endif
+
+#ifndef {attr}
+#define {attr}
+#endif
+
+/* Baseline JPEG generated by png_to_jpeg.py, decoded by app_img_jpeg */
+const LV_ATTRIBUTE_MEM_ALIGN LV_ATTRIBUTE_LARGE_CONST {attr} uint8_t {name}_map[] = {{
+''')
+        f.write(''.join(f'  {line},\n' for line in lines))
+        f.write(f'''}};
+
+const lv_img_dsc_t {name} = {{
+  .header.cf = LV_IMG_CF_RAW,
+  .header.always_zero = 0,
+  .header.reserved = 0,
+  .header.w = {width},
+  .header.h = {height},
+  .data_size = {len(jpeg)},
+  .data = {name}_map,
+}};
+''')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('png', nargs='+', help='opaque 8 bit RGB or RGBA PNG files')
+    parser.add_argument('-o', '--output', default='.', help='directory of the generated C files')
+    parser.add_argument('-q', '--quality', type=int, default=90, help='JPEG quality, 1 to 100')
+    parser.add_argument('--jpg', action='store_true', help='also write the JPEG files')
+    args = parser.parse_args()
+    if not 1 <= args.quality <= 100:
+        parser.error('quality must be between 1 and 100')
+
+    for png in args.png:
+        name = os.path.splitext(os.path.basename(png))[0]
+        width, height, rows = read_png(png)
+        if any(row[i] != 255 for row in rows for i in range(3, len(row), 4)):
+            print(f'{png}: has transparent pixels, JPEG drops them, keep it as a raw array', file=sys.stderr)
+            continue
+
+        jpeg = encode_jpeg(width, height, rows, args.quality)
+        write_c(os.path.join(args.output, name + '.c'), name, width, height, jpeg)
+        if args.jpg:
+            with open(os.path.join(args.output, name + '.jpg'), 'wb') as f:
+                f.write(jpeg)
+        raw = width * height * 2
+        print(f'{name}: {width}x{height}, {len(jpeg) // 1024} KB JPEG for {raw // 1024} KB of RGB565 '
+              f'({raw / len(jpeg):.1f}x smaller)')
+
+
+if __name__ == '__main__':
+    main()
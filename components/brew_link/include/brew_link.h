@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "brew_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************
+ * Brew link
+ * Order queue and UART transport to the machine controller. Orders are queued without blocking
+ * and sent one at a time by the link task: the next order leaves once the controller reported
+ * the previous one done, failed, or went silent for `order_timeout_ms`.
+ **************************************************************************************************/
+
+/**
+ * @brief Brew link configuration.
+ */
+typedef struct {
+    int uart_num;                                     /*!< UART port */
+    int tx_gpio;                                      /*!< TX pin */
+    int rx_gpio;                                      /*!< RX pin */
+    int baud_rate;                                    /*!< Baud rate */
+    uint32_t ack_timeout_ms;                          /*!< Time to wait for an ACK before retransmitting */
+    uint8_t max_retries;                              /*!< Retransmissions before an order fails */
+    uint32_t order_timeout_ms;                        /*!< Silence from the controller before an accepted order fails */
+    int queue_len;                                    /*!< Orders waiting to be sent */
+    int task_priority;                                /*!< Link task priority */
+    int task_core;                                    /*!< Link task core */
+} brew_link_config_t;
+
+#define BREW_LINK_DEFAULT_CONFIG() {                                         \
+        .uart_num = CONFIG_BREW_LINK_UART_NUM,                                \
+        .tx_gpio = CONFIG_BREW_LINK_TX_GPIO,                                  \
+        .rx_gpio = CONFIG_BREW_LINK_RX_GPIO,                                  \
+        .baud_rate = CONFIG_BREW_LINK_BAUD_RATE,                              \
+        .ack_timeout_ms = CONFIG_BREW_LINK_ACK_TIMEOUT_MS,                    \
+        .max_retries = CONFIG_BREW_LINK_MAX_RETRIES,                          \
+        .order_timeout_ms = CONFIG_BREW_LINK_ORDER_TIMEOUT_S * 1000,          \
+        .queue_len = CONFIG_BREW_LINK_QUEUE_LEN,                              \
+        .task_priority = 5,                                                   \
+        .task_core = 0,                                                       \
+    }
+
+typedef enum {
+    BREW_LINK_EVENT_ACCEPTED = 0,                     /*!< Controller acknowledged the order */
+    BREW_LINK_EVENT_PROGRESS,                         /*!< `stage` and `percent` are valid */
+    BREW_LINK_EVENT_DONE,                             /*!< `result` is valid */
+    BREW_LINK_EVENT_FAILED,                           /*!< Not acknowledged, refused, or timed out */
+} brew_link_event_type_t;
+
+/**
+ * @brief Order event.
+ */
+typedef struct {
+    brew_link_event_type_t type;
+    uint16_t order_id;
+    uint8_t stage;                                    /*!< brew_stage_t */
+    uint8_t percent;                                  /*!< 0-100 */
+    uint8_t result;                                   /*!< brew_result_t */
+} brew_link_event_t;
+
+/**
+ * @brief Event callback, runs on the link task and must not block.
+ */
+typedef void (*brew_link_event_cb_t)(const brew_link_event_t *event, void *user_data);
+
+typedef struct brew_link_t brew_link_t;
+
+/**
+ * @brief Install the UART driver and start the link task.
+ */
+esp_err_t brew_link_new(const brew_link_config_t *config, brew_link_event_cb_t event_cb, void *user_data,
+                        brew_link_t **ret_link);
+
+/**
+ * @brief Stop the link task and release the UART.
+ */
+void brew_link_delete(brew_link_t *link);
+
+/**
+ * @brief Queue an order. Never blocks; safe from any task.
+ *
+ * @param order Order to send; `order_id` is assigned by the link and written back.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM when the queue is full.
+ */
+esp_err_t brew_link_submit(brew_link_t *link, brew_order_t *order);
+
+/**
+ * @brief Protocol statistics.
+ */
+void brew_link_get_stats(brew_link_t *link, brew_proto_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
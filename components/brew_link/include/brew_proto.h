@@ -0,0 +1,237 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************
+ * Brew protocol
+ * Framing and stop-and-wait reliability for the link between the UI and the machine controller.
+ * Plain C without any platform dependency: the same code runs in the firmware and in host tools.
+ *
+ * Frame layout (little endian):
+ *   0xA5 0x5A | type | seq | len | payload[len] | crc16
+ * The CRC-16/CCITT-FALSE covers type, seq, len and the payload. Every frame except ACK and NAK
+ * is acknowledged by the receiver with an ACK carrying the same sequence number; the sender keeps
+ * one frame in flight and retransmits it until acknowledged or out of retries. Retransmissions
+ * keep their sequence number so the receiver can drop duplicates.
+ **************************************************************************************************/
+
+#define BREW_PROTO_SOF0                 (0xA5)
+#define BREW_PROTO_SOF1                 (0x5A)
+#define BREW_PROTO_MAX_PAYLOAD          (64)
+#define BREW_PROTO_OVERHEAD             (7)
+#define BREW_PROTO_MAX_FRAME            (BREW_PROTO_MAX_PAYLOAD + BREW_PROTO_OVERHEAD)
+#define BREW_PROTO_NAME_LEN             (24)
+
+typedef enum {
+    BREW_PROTO_OK = 0,
+    BREW_PROTO_ERR_ARG = -1,                          /*!< Invalid argument or payload too long */
+    BREW_PROTO_ERR_BUSY = -2,                         /*!< A frame is still waiting for its ACK */
+    BREW_PROTO_ERR_IO = -3,                           /*!< The write callback failed */
+    BREW_PROTO_ERR_TIMEOUT = -4,                      /*!< No ACK after all retries */
+} brew_proto_err_t;
+
+typedef enum {
+    BREW_FRAME_ACK = 0x01,                            /*!< Both ways, empty payload */
+    BREW_FRAME_NAK = 0x02,                            /*!< Both ways, frame understood but refused; payload: reason */
+    BREW_FRAME_ORDER = 0x10,                          /*!< UI -> controller, brew_order_t */
+    BREW_FRAME_PROGRESS = 0x20,                       /*!< Controller -> UI, brew_progress_t */
+    BREW_FRAME_DONE = 0x21,                           /*!< Controller -> UI, brew_done_t */
+} brew_frame_type_t;
+
+typedef enum {
+    BREW_STAGE_QUEUED = 0,
+    BREW_STAGE_GRINDING,
+    BREW_STAGE_HEATING,
+    BREW_STAGE_BREWING,
+    BREW_STAGE_MILK,
+} brew_stage_t;
+
+typedef enum {
+    BREW_RESULT_OK = 0,
+    BREW_RESULT_CANCELLED,
+    BREW_RESULT_NO_WATER,
+    BREW_RESULT_NO_BEANS,
+    BREW_RESULT_FAULT,
+} brew_result_t;
+
+/**
+ * @brief Decoded frame.
+ */
+typedef struct {
+    uint8_t type;                                     /*!< brew_frame_type_t */
+    uint8_t seq;                                      /*!< Sequence number */
+    uint8_t len;                                      /*!< Payload length */
+    uint8_t payload[BREW_PROTO_MAX_PAYLOAD];          /*!< Payload */
+} brew_frame_t;
+
+/**
+ * @brief Drink order.
+ */
+typedef struct {
+    uint16_t order_id;                                /*!< Assigned by the UI, echoed in progress and done */
+    uint8_t recipe;                                   /*!< Menu index, 0xFF for a profile order */
+    uint8_t coffee_ratio;                             /*!< Coffee ratio (0-100) */
+    uint8_t water_ratio;                              /*!< Water ratio (0-100) */
+    uint8_t milk_ratio;                               /*!< Milk ratio (0-100) */
+    char name[BREW_PROTO_NAME_LEN];                   /*!< Customer name, may be empty */
+} brew_order_t;
+
+/**
+ * @brief Brewing progress.
+ */
+typedef struct {
+    uint16_t order_id;
+    uint8_t stage;                                    /*!< brew_stage_t */
+    uint8_t percent;                                  /*!< 0-100 */
+} brew_progress_t;
+
+/**
+ * @brief End of an order.
+ */
+typedef struct {
+    uint16_t order_id;
+    uint8_t result;                                   /*!< brew_result_t */
+} brew_done_t;
+
+/**
+ * @brief Streaming frame parser, fed byte by byte.
+ */
+typedef struct {
+    uint8_t state;
+    uint8_t pos;
+    uint8_t buf[BREW_PROTO_MAX_FRAME];
+    uint32_t crc_errors;                              /*!< Frames dropped for a bad CRC */
+} brew_proto_parser_t;
+
+/**
+ * @brief Transport write callback. Must not block for long; returns the number of bytes taken
+ *        or a negative value on error.
+ */
+typedef int (*brew_proto_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief Frame delivery callback, called for every new (non duplicate) frame other than ACK.
+ */
+typedef void (*brew_proto_frame_fn)(void *ctx, const brew_frame_t *frame);
+
+/**
+ * @brief Session statistics.
+ */
+typedef struct {
+    uint32_t tx_frames;                               /*!< Frames written, including ACKs and retransmissions */
+    uint32_t rx_frames;                               /*!< Valid frames received */
+    uint32_t retransmits;                             /*!< Retransmissions after an ACK timeout */
+    uint32_t duplicates;                              /*!< Duplicate frames dropped */
+    uint32_t crc_errors;                              /*!< Frames dropped for a bad CRC */
+    uint32_t failures;                                /*!< Frames given up after all retries */
+} brew_proto_stats_t;
+
+/**
+ * @brief Session configuration.
+ */
+typedef struct {
+    uint32_t ack_timeout_ms;                          /*!< Time to wait for an ACK before retransmitting */
+    uint8_t max_retries;                              /*!< Retransmissions before giving up */
+    brew_proto_write_fn write;                        /*!< Transport write */
+    brew_proto_frame_fn on_frame;                     /*!< Frame delivery */
+    void *ctx;                                        /*!< Passed to both callbacks */
+} brew_proto_config_t;
+
+/**
+ * @brief One end of the link.
+ */
+typedef struct {
+    brew_proto_config_t config;
+    brew_proto_parser_t parser;
+    uint8_t next_seq;
+    bool waiting_ack;
+    uint8_t pending[BREW_PROTO_MAX_FRAME];
+    size_t pending_len;
+    uint8_t pending_seq;
+    uint32_t sent_ms;
+    uint8_t retries;
+    int last_rx_seq;
+    brew_proto_stats_t stats;
+} brew_proto_session_t;
+
+/**
+ * @brief CRC-16/CCITT-FALSE.
+ */
+uint16_t brew_proto_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief Encode one frame.
+ *
+ * @return Frame length, or 0 if the payload is too long or `out` too small.
+ */
+size_t brew_proto_encode(uint8_t type, uint8_t seq, const void *payload, size_t len, uint8_t *out, size_t out_size);
+
+/**
+ * @brief Reset a parser.
+ */
+void brew_proto_parser_reset(brew_proto_parser_t *parser);
+
+/**
+ * @brief Feed one byte to a parser.
+ *
+ * @return true when `frame` holds a complete frame with a valid CRC.
+ */
+bool brew_proto_parse_byte(brew_proto_parser_t *parser, uint8_t byte, brew_frame_t *frame);
+
+/**
+ * @brief Serialize and parse the frame payloads.
+ */
+size_t brew_proto_pack_order(const brew_order_t *order, uint8_t *out);
+bool brew_proto_unpack_order(const brew_frame_t *frame, brew_order_t *order);
+size_t brew_proto_pack_progress(const brew_progress_t *progress, uint8_t *out);
+bool brew_proto_unpack_progress(const brew_frame_t *frame, brew_progress_t *progress);
+size_t brew_proto_pack_done(const brew_done_t *done, uint8_t *out);
+bool brew_proto_unpack_done(const brew_frame_t *frame, brew_done_t *done);
+
+/**
+ * @brief Initialize a session.
+ */
+void brew_proto_session_init(brew_proto_session_t *session, const brew_proto_config_t *config);
+
+/**
+ * @brief Whether a new reliable frame can be sent.
+ */
+bool brew_proto_session_idle(const brew_proto_session_t *session);
+
+/**
+ * @brief Send a frame that must be acknowledged.
+ *
+ * @return BREW_PROTO_OK, BREW_PROTO_ERR_BUSY while the previous frame is unacknowledged,
+ *         BREW_PROTO_ERR_ARG or BREW_PROTO_ERR_IO.
+ */
+int brew_proto_session_send(brew_proto_session_t *session, uint8_t type, const void *payload, size_t len,
+                            uint32_t now_ms);
+
+/**
+ * @brief Handle received bytes: ACKs complete the pending frame, other frames are acknowledged
+ *        and delivered through `on_frame` unless they repeat the previous sequence number.
+ */
+void brew_proto_session_input(brew_proto_session_t *session, const uint8_t *data, size_t len, uint32_t now_ms);
+
+/**
+ * @brief Retransmit the pending frame when its ACK is overdue.
+ *
+ * @return BREW_PROTO_OK, or BREW_PROTO_ERR_TIMEOUT once when the frame is given up.
+ */
+int brew_proto_session_poll(brew_proto_session_t *session, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
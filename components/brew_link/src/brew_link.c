@@ -0,0 +1,268 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "brew_link.h"
+
+static const char *TAG = "brew_link";
+
+#define LINK_UART_RX_BUF_SIZE       (1024)
+#define LINK_UART_TX_BUF_SIZE       (1024)
+#define LINK_POLL_MS                (10)
+#define LINK_TASK_STACK             (4096)
+
+struct brew_link_t {
+    brew_link_config_t config;
+    brew_link_event_cb_t event_cb;
+    void *user_data;
+    brew_proto_session_t session;
+    QueueHandle_t orders;
+    TaskHandle_t task;
+    SemaphoreHandle_t exit_sem;
+    atomic_bool running;
+    atomic_uint_fast16_t next_order_id;
+
+    /* Owned by the link task */
+    bool active;                                      /* An order was sent and is not finished */
+    bool accepted;                                    /* ... and the controller acknowledged it */
+    uint16_t active_id;
+    uint32_t active_ms;                               /* Last sign of life for the active order */
+};
+
+static uint32_t link_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void link_emit(brew_link_t *link, brew_link_event_type_t type, uint8_t stage, uint8_t percent, uint8_t result)
+{
+    brew_link_event_t event = {
+        .type = type,
+        .order_id = link->active_id,
+        .stage = stage,
+        .percent = percent,
+        .result = result,
+    };
+    if (link->event_cb) {
+        link->event_cb(&event, link->user_data);
+    }
+}
+
+static void link_finish(brew_link_t *link, brew_link_event_type_t type, uint8_t result)
+{
+    link->active = false;
+    link->accepted = false;
+    link_emit(link, type, 0, type == BREW_LINK_EVENT_DONE ? 100 : 0, result);
+}
+
+static int link_write(void *ctx, const uint8_t *data, size_t len)
+{
+    brew_link_t *link = (brew_link_t *)ctx;
+    /* Copies into the TX ring buffer, the driver drains it from the ISR */
+    return uart_write_bytes(link->config.uart_num, data, len);
+}
+
+static void link_on_frame(void *ctx, const brew_frame_t *frame)
+{
+    brew_link_t *link = (brew_link_t *)ctx;
+    brew_progress_t progress;
+    brew_done_t done;
+
+    switch (frame->type) {
+    case BREW_FRAME_NAK:
+        if (link->active && !link->accepted) {
+            ESP_LOGW(TAG, "Order %u refused by the controller", link->active_id);
+            link_finish(link, BREW_LINK_EVENT_FAILED, BREW_RESULT_FAULT);
+        }
+        break;
+    case BREW_FRAME_PROGRESS:
+        if (brew_proto_unpack_progress(frame, &progress) && link->active && progress.order_id == link->active_id) {
+            link->accepted = true;
+            link->active_ms = link_now_ms();
+            link_emit(link, BREW_LINK_EVENT_PROGRESS, progress.stage, progress.percent, BREW_RESULT_OK);
+        }
+        break;
+    case BREW_FRAME_DONE:
+        if (brew_proto_unpack_done(frame, &done) && link->active && done.order_id == link->active_id) {
+            ESP_LOGI(TAG, "Order %u done, result %u", done.order_id, done.result);
+            link_finish(link, done.result == BREW_RESULT_OK ? BREW_LINK_EVENT_DONE : BREW_LINK_EVENT_FAILED, done.result);
+        }
+        break;
+    default:
+        ESP_LOGW(TAG, "Unexpected frame type 0x%02x", frame->type);
+        break;
+    }
+}
+
+static void link_send_next(brew_link_t *link, uint32_t now_ms)
+{
+    brew_order_t order;
+    uint8_t payload[BREW_PROTO_MAX_PAYLOAD];
+
+    if (xQueueReceive(link->orders, &order, 0) != pdTRUE) {
+        return;
+    }
+
+    size_t len = brew_proto_pack_order(&order, payload);
+    link->active = true;
+    link->accepted = false;
+    link->active_id = order.order_id;
+    link->active_ms = now_ms;
+    if (brew_proto_session_send(&link->session, BREW_FRAME_ORDER, payload, len, now_ms) != BREW_PROTO_OK) {
+        link_finish(link, BREW_LINK_EVENT_FAILED, BREW_RESULT_FAULT);
+        return;
+    }
+    ESP_LOGI(TAG, "Order %u sent: recipe %u, coffee %u, water %u, milk %u, name \"%s\"", order.order_id, order.recipe,
+             order.coffee_ratio, order.water_ratio, order.milk_ratio, order.name);
+}
+
+static void link_task(void *param)
+{
+    brew_link_t *link = (brew_link_t *)param;
+    uint8_t buf[128];
+
+    while (atomic_load(&link->running)) {
+        int len = uart_read_bytes(link->config.uart_num, buf, sizeof(buf), pdMS_TO_TICKS(LINK_POLL_MS));
+        uint32_t now_ms = link_now_ms();
+        if (len > 0) {
+            brew_proto_session_input(&link->session, buf, len, now_ms);
+        }
+
+        if (brew_proto_session_poll(&link->session, now_ms) == BREW_PROTO_ERR_TIMEOUT && link->active) {
+            ESP_LOGW(TAG, "Order %u not acknowledged after %u retries", link->active_id, link->config.max_retries);
+            link_finish(link, BREW_LINK_EVENT_FAILED, BREW_RESULT_FAULT);
+        }
+
+        if (link->active && !link->accepted && brew_proto_session_idle(&link->session)) {
+            link->accepted = true;
+            link->active_ms = now_ms;
+            link_emit(link, BREW_LINK_EVENT_ACCEPTED, BREW_STAGE_QUEUED, 0, BREW_RESULT_OK);
+        }
+
+        if (link->active && link->accepted && (uint32_t)(now_ms - link->active_ms) >= link->config.order_timeout_ms) {
+            ESP_LOGW(TAG, "Order %u timed out", link->active_id);
+            link_finish(link, BREW_LINK_EVENT_FAILED, BREW_RESULT_FAULT);
+        }
+
+        if (!link->active && brew_proto_session_idle(&link->session)) {
+            link_send_next(link, now_ms);
+        }
+    }
+
+    xSemaphoreGive(link->exit_sem);
+    vTaskDelete(NULL);
+}
+
+esp_err_t brew_link_new(const brew_link_config_t *config, brew_link_event_cb_t event_cb, void *user_data,
+                        brew_link_t **ret_link)
+{
+    esp_err_t ret = ESP_OK;
+    bool uart_installed = false;
+
+    ESP_RETURN_ON_FALSE(config && ret_link && config->queue_len > 0, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    brew_link_t *link = (brew_link_t *)heap_caps_calloc(1, sizeof(brew_link_t), MALLOC_CAP_DEFAULT);
+    ESP_RETURN_ON_FALSE(link, ESP_ERR_NO_MEM, TAG, "Failed to allocate brew link");
+    link->config = *config;
+    link->event_cb = event_cb;
+    link->user_data = user_data;
+    atomic_init(&link->next_order_id, 1);
+
+    const uart_config_t uart_config = {
+        .baud_rate = config->baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    ESP_GOTO_ON_ERROR(uart_driver_install(config->uart_num, LINK_UART_RX_BUF_SIZE, LINK_UART_TX_BUF_SIZE, 0, NULL, 0),
+                      err, TAG, "Failed to install UART driver");
+    uart_installed = true;
+    ESP_GOTO_ON_ERROR(uart_param_config(config->uart_num, &uart_config), err, TAG, "Failed to configure UART");
+    ESP_GOTO_ON_ERROR(uart_set_pin(config->uart_num, config->tx_gpio, config->rx_gpio, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE),
+                      err, TAG, "Failed to set UART pins");
+
+    const brew_proto_config_t proto_config = {
+        .ack_timeout_ms = config->ack_timeout_ms,
+        .max_retries = config->max_retries,
+        .write = link_write,
+        .on_frame = link_on_frame,
+        .ctx = link,
+    };
+    brew_proto_session_init(&link->session, &proto_config);
+
+    link->orders = xQueueCreate(config->queue_len, sizeof(brew_order_t));
+    link->exit_sem = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(link->orders && link->exit_sem, ESP_ERR_NO_MEM, err, TAG, "Failed to create queue");
+
+    atomic_store(&link->running, true);
+    ESP_GOTO_ON_FALSE(xTaskCreatePinnedToCore(link_task, "Brew Link", LINK_TASK_STACK, link, config->task_priority,
+                                              &link->task, config->task_core) == pdPASS,
+                      ESP_ERR_NO_MEM, err, TAG, "Failed to create link task");
+
+    ESP_LOGI(TAG, "Brew link on UART%d (TX %d, RX %d, %d baud)", config->uart_num, config->tx_gpio, config->rx_gpio,
+             config->baud_rate);
+    *ret_link = link;
+    return ESP_OK;
+
+err:
+    if (link->orders) {
+        vQueueDelete(link->orders);
+    }
+    if (link->exit_sem) {
+        vSemaphoreDelete(link->exit_sem);
+    }
+    if (uart_installed) {
+        uart_driver_delete(config->uart_num);
+    }
+    heap_caps_free(link);
+    return ret;
+}
+
+void brew_link_delete(brew_link_t *link)
+{
+    if (!link) {
+        return;
+    }
+
+    atomic_store(&link->running, false);
+    xSemaphoreTake(link->exit_sem, portMAX_DELAY);
+    uart_driver_delete(link->config.uart_num);
+    vQueueDelete(link->orders);
+    vSemaphoreDelete(link->exit_sem);
+    heap_caps_free(link);
+}
+
+esp_err_t brew_link_submit(brew_link_t *link, brew_order_t *order)
+{
+    ESP_RETURN_ON_FALSE(link && order, ESP_ERR_INVALID_ARG, TAG, "Invalid argument");
+
+    /* 0 is never used, the UI treats it as "no order" */
+    do {
+        order->order_id = (uint16_t)atomic_fetch_add(&link->next_order_id, 1);
+    } while (order->order_id == 0);
+    if (xQueueSend(link->orders, order, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Order queue full, order %u dropped", order->order_id);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void brew_link_get_stats(brew_link_t *link, brew_proto_stats_t *stats)
+{
+    *stats = link->session.stats;
+}
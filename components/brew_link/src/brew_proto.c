@@ -0,0 +1,292 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "brew_proto.h"
+
+enum {
+    PARSE_SOF0 = 0,
+    PARSE_SOF1,
+    PARSE_HEADER,
+    PARSE_BODY,
+};
+
+#define HEADER_LEN                  (5)               /* SOF0 SOF1 type seq len */
+#define ORDER_PAYLOAD_LEN           (6 + BREW_PROTO_NAME_LEN)
+
+uint16_t brew_proto_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t brew_proto_encode(uint8_t type, uint8_t seq, const void *payload, size_t len, uint8_t *out, size_t out_size)
+{
+    if (len > BREW_PROTO_MAX_PAYLOAD || out_size < len + BREW_PROTO_OVERHEAD || (len && !payload)) {
+        return 0;
+    }
+
+    out[0] = BREW_PROTO_SOF0;
+    out[1] = BREW_PROTO_SOF1;
+    out[2] = type;
+    out[3] = seq;
+    out[4] = (uint8_t)len;
+    if (len) {
+        memcpy(out + HEADER_LEN, payload, len);
+    }
+
+    uint16_t crc = brew_proto_crc16(0xFFFF, out + 2, len + 3);
+    out[HEADER_LEN + len] = crc & 0xFF;
+    out[HEADER_LEN + len + 1] = crc >> 8;
+    return len + BREW_PROTO_OVERHEAD;
+}
+
+void brew_proto_parser_reset(brew_proto_parser_t *parser)
+{
+    parser->state = PARSE_SOF0;
+    parser->pos = 0;
+}
+
+bool brew_proto_parse_byte(brew_proto_parser_t *parser, uint8_t byte, brew_frame_t *frame)
+{
+    switch (parser->state) {
+    case PARSE_SOF0:
+        if (byte == BREW_PROTO_SOF0) {
+            parser->state = PARSE_SOF1;
+        }
+        return false;
+
+    case PARSE_SOF1:
+        if (byte == BREW_PROTO_SOF1) {
+            parser->buf[0] = BREW_PROTO_SOF0;
+            parser->buf[1] = BREW_PROTO_SOF1;
+            parser->pos = 2;
+            parser->state = PARSE_HEADER;
+        } else if (byte != BREW_PROTO_SOF0) {
+            parser->state = PARSE_SOF0;
+        }
+        return false;
+
+    case PARSE_HEADER:
+        parser->buf[parser->pos++] = byte;
+        if (parser->pos == HEADER_LEN) {
+            if (parser->buf[4] > BREW_PROTO_MAX_PAYLOAD) {
+                brew_proto_parser_reset(parser);
+            } else {
+                parser->state = PARSE_BODY;
+            }
+        }
+        return false;
+
+    case PARSE_BODY: {
+        parser->buf[parser->pos++] = byte;
+        uint8_t len = parser->buf[4];
+        if (parser->pos < HEADER_LEN + len + 2) {
+            return false;
+        }
+
+        uint16_t crc = brew_proto_crc16(0xFFFF, parser->buf + 2, len + 3);
+        uint16_t rx_crc = parser->buf[HEADER_LEN + len] | (parser->buf[HEADER_LEN + len + 1] << 8);
+        brew_proto_parser_reset(parser);
+        if (crc != rx_crc) {
+            parser->crc_errors++;
+            return false;
+        }
+
+        frame->type = parser->buf[2];
+        frame->seq = parser->buf[3];
+        frame->len = len;
+        memcpy(frame->payload, parser->buf + HEADER_LEN, len);
+        return true;
+    }
+    }
+
+    brew_proto_parser_reset(parser);
+    return false;
+}
+
+size_t brew_proto_pack_order(const brew_order_t *order, uint8_t *out)
+{
+    out[0] = order->order_id & 0xFF;
+    out[1] = order->order_id >> 8;
+    out[2] = order->recipe;
+    out[3] = order->coffee_ratio;
+    out[4] = order->water_ratio;
+    out[5] = order->milk_ratio;
+    memset(out + 6, 0, BREW_PROTO_NAME_LEN);
+    strncpy((char *)out + 6, order->name, BREW_PROTO_NAME_LEN - 1);
+    return ORDER_PAYLOAD_LEN;
+}
+
+bool brew_proto_unpack_order(const brew_frame_t *frame, brew_order_t *order)
+{
+    if (frame->type != BREW_FRAME_ORDER || frame->len != ORDER_PAYLOAD_LEN) {
+        return false;
+    }
+
+    const uint8_t *p = frame->payload;
+    order->order_id = p[0] | (p[1] << 8);
+    order->recipe = p[2];
+    order->coffee_ratio = p[3];
+    order->water_ratio = p[4];
+    order->milk_ratio = p[5];
+    memcpy(order->name, p + 6, BREW_PROTO_NAME_LEN);
+    order->name[BREW_PROTO_NAME_LEN - 1] = '\0';
+    return true;
+}
+
+size_t brew_proto_pack_progress(const brew_progress_t *progress, uint8_t *out)
+{
+    out[0] = progress->order_id & 0xFF;
+    out[1] = progress->order_id >> 8;
+    out[2] = progress->stage;
+    out[3] = progress->percent;
+    return 4;
+}
+
+bool brew_proto_unpack_progress(const brew_frame_t *frame, brew_progress_t *progress)
+{
+    if (frame->type != BREW_FRAME_PROGRESS || frame->len != 4) {
+        return false;
+    }
+
+    progress->order_id = frame->payload[0] | (frame->payload[1] << 8);
+    progress->stage = frame->payload[2];
+    progress->percent = frame->payload[3] > 100 ? 100 : frame->payload[3];
+    return true;
+}
+
+size_t brew_proto_pack_done(const brew_done_t *done, uint8_t *out)
+{
+    out[0] = done->order_id & 0xFF;
+    out[1] = done->order_id >> 8;
+    out[2] = done->result;
+    return 3;
+}
+
+bool brew_proto_unpack_done(const brew_frame_t *frame, brew_done_t *done)
+{
+    if (frame->type != BREW_FRAME_DONE || frame->len != 3) {
+        return false;
+    }
+
+    done->order_id = frame->payload[0] | (frame->payload[1] << 8);
+    done->result = frame->payload[2];
+    return true;
+}
+
+void brew_proto_session_init(brew_proto_session_t *session, const brew_proto_config_t *config)
+{
+    memset(session, 0, sizeof(*session));
+    session->config = *config;
+    session->last_rx_seq = -1;
+    brew_proto_parser_reset(&session->parser);
+}
+
+bool brew_proto_session_idle(const brew_proto_session_t *session)
+{
+    return !session->waiting_ack;
+}
+
+static int session_write(brew_proto_session_t *session, const uint8_t *data, size_t len)
+{
+    int ret = session->config.write(session->config.ctx, data, len);
+    if (ret != (int)len) {
+        return BREW_PROTO_ERR_IO;
+    }
+    session->stats.tx_frames++;
+    return BREW_PROTO_OK;
+}
+
+int brew_proto_session_send(brew_proto_session_t *session, uint8_t type, const void *payload, size_t len,
+                            uint32_t now_ms)
+{
+    if (session->waiting_ack) {
+        return BREW_PROTO_ERR_BUSY;
+    }
+
+    size_t frame_len = brew_proto_encode(type, session->next_seq, payload, len, session->pending, sizeof(session->pending));
+    if (frame_len == 0) {
+        return BREW_PROTO_ERR_ARG;
+    }
+
+    session->pending_len = frame_len;
+    session->pending_seq = session->next_seq++;
+    session->retries = 0;
+    session->sent_ms = now_ms;
+    session->waiting_ack = true;
+
+    /* A failed write is retried by the poll like a lost frame */
+    session_write(session, session->pending, session->pending_len);
+    return BREW_PROTO_OK;
+}
+
+static void session_ack(brew_proto_session_t *session, uint8_t type, uint8_t seq)
+{
+    uint8_t frame[BREW_PROTO_OVERHEAD];
+    size_t len = brew_proto_encode(type, seq, NULL, 0, frame, sizeof(frame));
+    session_write(session, frame, len);
+}
+
+void brew_proto_session_input(brew_proto_session_t *session, const uint8_t *data, size_t len, uint32_t now_ms)
+{
+    brew_frame_t frame;
+
+    (void)now_ms;
+    for (size_t i = 0; i < len; i++) {
+        if (!brew_proto_parse_byte(&session->parser, data[i], &frame)) {
+            continue;
+        }
+        session->stats.rx_frames++;
+
+        if (frame.type == BREW_FRAME_ACK || frame.type == BREW_FRAME_NAK) {
+            if (session->waiting_ack && frame.seq == session->pending_seq) {
+                session->waiting_ack = false;
+                if (frame.type == BREW_FRAME_NAK && session->config.on_frame) {
+                    session->config.on_frame(session->config.ctx, &frame);
+                }
+            }
+            continue;
+        }
+
+        /* Always acknowledge, the peer may have missed our previous ACK */
+        session_ack(session, BREW_FRAME_ACK, frame.seq);
+        if (frame.seq == session->last_rx_seq) {
+            session->stats.duplicates++;
+            continue;
+        }
+        session->last_rx_seq = frame.seq;
+
+        if (session->config.on_frame) {
+            session->config.on_frame(session->config.ctx, &frame);
+        }
+    }
+    session->stats.crc_errors = session->parser.crc_errors;
+}
+
+int brew_proto_session_poll(brew_proto_session_t *session, uint32_t now_ms)
+{
+    if (!session->waiting_ack || (uint32_t)(now_ms - session->sent_ms) < session->config.ack_timeout_ms) {
+        return BREW_PROTO_OK;
+    }
+
+    if (session->retries >= session->config.max_retries) {
+        session->waiting_ack = false;
+        session->stats.failures++;
+        return BREW_PROTO_ERR_TIMEOUT;
+    }
+
+    session->retries++;
+    session->stats.retransmits++;
+    session->sent_ms = now_ms;
+    session_write(session, session->pending, session->pending_len);
+    return BREW_PROTO_OK;
+}
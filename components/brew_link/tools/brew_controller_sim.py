@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+"""
+Machine controller stand-in for the brew link protocol.
+
+Opens a pseudo terminal and plays the controller side: acknowledges orders, reports progress and
+finally DONE, retransmitting its own frames until they are acknowledged. Frames can be dropped or
+corrupted on purpose to exercise the retry path. Connect the UI side to the printed device, e.g.
+brew_host from this directory, or a USB-UART adapter bridged with socat.
+"""
+
+import argparse
+import os
+import random
+import select
+import struct
+import sys
+import time
+import tty
+
+SOF = b'\xa5\x5a'
+MAX_PAYLOAD = 64
+FRAME_ACK = 0x01
+FRAME_NAK = 0x02
+FRAME_ORDER = 0x10
+FRAME_PROGRESS = 0x20
+FRAME_DONE = 0x21
+STAGES = ((1, 'grinding'), (2, 'heating'), (3, 'brewing'), (4, 'milk'))
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def encode(ftype, seq, payload=b''):
+    body = bytes((ftype, seq, len(payload))) + payload
+    return SOF + body + struct.pack('<H', crc16(body))
+
+
+class Parser:
+    def __init__(self):
+        self.buf = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+        while True:
+            start = self.buf.find(SOF)
+            if start < 0:
+                del self.buf[:-1]
+                return frames
+            del self.buf[:start]
+            if len(self.buf) < 5:
+                return frames
+            length = self.buf[4]
+            if length > MAX_PAYLOAD:
+                del self.buf[:1]
+                continue
+            if len(self.buf) < 7 + length:
+                return frames
+            body = bytes(self.buf[2:5 + length])
+            rx_crc = struct.unpack_from('<H', self.buf, 5 + length)[0]
+            if crc16(body) == rx_crc:
+                frames.append((body[0], body[1], body[3:]))
+                del self.buf[:7 + length]
+            else:
+                self.crc_errors += 1
+                del self.buf[:1]
+
+
+class Controller:
+    def __init__(self, fd, args):
+        self.fd = fd
+        self.args = args
+        self.parser = Parser()
+        self.seq = 0
+        self.last_rx_seq = None
+        self.outbox = []            # frames waiting for their turn
+        self.pending = None         # (seq, frame, sent_at, retries)
+        self.orders = []            # accepted orders, brewed in arrival order
+        self.brewing = None         # (order_id, started_at, last_reported)
+
+    def write(self, frame):
+        if random.random() < self.args.drop:
+            print('  >> dropped')
+            return
+        if random.random() < self.args.corrupt:
+            frame = bytearray(frame)
+            frame[random.randrange(2, len(frame))] ^= 0xFF
+            print('  >> corrupted')
+        os.write(self.fd, bytes(frame))
+
+    def send(self, ftype, payload):
+        self.outbox.append((ftype, payload))
+
+    def handle(self, ftype, seq, payload):
+        if ftype in (FRAME_ACK, FRAME_NAK):
+            if self.pending and self.pending[0] == seq:
+                self.pending = None
+            return
+        self.write(encode(FRAME_ACK, seq))
+        if seq == self.last_rx_seq:
+            print(f'<< duplicate seq {seq}')
+            return
+        self.last_rx_seq = seq
+        if ftype == FRAME_ORDER and len(payload) >= 6:
+            order_id, recipe, coffee, water, milk = struct.unpack_from('<HBBBB', payload)
+            name = payload[6:].split(b'\0')[0].decode(errors='replace')
+            print(f'<< order {order_id}: recipe {recipe}, coffee {coffee}, water {water}, milk {milk}, name "{name}"')
+            self.orders.append(order_id)
+        else:
+            print(f'<< unexpected frame 0x{ftype:02x}')
+
+    def step(self, now):
+        if self.brewing is None and self.orders:
+            self.brewing = (self.orders.pop(0), now, -1)
+        if self.brewing is not None:
+            order_id, started, last = self.brewing
+            percent = min(100, int((now - started) * 100 / self.args.brew_time))
+            if percent >= 100:
+                self.send(FRAME_DONE, struct.pack('<HB', order_id, self.args.result))
+                print(f'>> done {order_id}')
+                self.brewing = None
+            elif percent // 10 != last // 10:
+                stage = STAGES[min(len(STAGES) - 1, percent * len(STAGES) // 100)]
+                self.send(FRAME_PROGRESS, struct.pack('<HBB', order_id, stage[0], percent))
+                print(f'>> progress {order_id}: {stage[1]} {percent}%')
+                self.brewing = (order_id, started, percent)
+
+        if self.pending is None and self.outbox:
+            ftype, payload = self.outbox.pop(0)
+            frame = encode(ftype, self.seq, payload)
+            self.pending = (self.seq, frame, now, 0)
+            self.seq = (self.seq + 1) & 0xFF
+            self.write(frame)
+        elif self.pending and now - self.pending[2] >= self.args.ack_timeout:
+            seq, frame, _, retries = self.pending
+            if retries >= self.args.retries:
+                print(f'>> seq {seq} given up')
+                self.pending = None
+            else:
+                self.pending = (seq, frame, now, retries + 1)
+                self.write(frame)
+
+    def run(self):
+        while True:
+            ready, _, _ = select.select([self.fd], [], [], 0.01)
+            if ready:
+                try:
+                    data = os.read(self.fd, 256)
+                except OSError:
+                    data = b''
+                for ftype, seq, payload in self.parser.feed(data):
+                    self.handle(ftype, seq, payload)
+            self.step(time.monotonic())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--brew-time', type=float, default=5.0, help='seconds per drink')
+    parser.add_argument('--result', type=int, default=0, help='result code reported in DONE')
+    parser.add_argument('--drop', type=float, default=0.0, help='probability of dropping an outgoing frame')
+    parser.add_argument('--corrupt', type=float, default=0.0, help='probability of corrupting an outgoing frame')
+    parser.add_argument('--ack-timeout', type=float, default=0.2, help='seconds before retransmitting')
+    parser.add_argument('--retries', type=int, default=5)
+    parser.add_argument('--seed', type=int, default=None)
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    print(f'Controller listening on {os.ttyname(slave)}', flush=True)
+    try:
+        Controller(master, args).run()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,174 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * UI side of the brew link on Linux: sends orders over a serial device with the firmware's own
+ * protocol code and prints the controller's progress. Exits non-zero if an order fails.
+ *
+ *   cc -I../include -o brew_host brew_host.c ../src/brew_proto.c
+ *   ./brew_host /dev/pts/N [orders] [drop]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "brew_proto.h"
+
+#define HOST_ACK_TIMEOUT_MS     (200)
+#define HOST_MAX_RETRIES        (5)
+#define HOST_ORDER_TIMEOUT_MS   (30000)
+
+typedef struct {
+    int fd;
+    double drop;                                      /* Probability of dropping an outgoing frame */
+    int done;
+    int failed;
+    uint16_t active_id;
+    uint32_t active_ms;
+} host_t;
+
+static uint32_t host_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static int host_write(void *ctx, const uint8_t *data, size_t len)
+{
+    host_t *host = (host_t *)ctx;
+    if ((double)rand() / RAND_MAX < host->drop) {
+        printf("  >> dropped\n");
+        return (int)len;
+    }
+    return (int)write(host->fd, data, len);
+}
+
+static void host_on_frame(void *ctx, const brew_frame_t *frame)
+{
+    host_t *host = (host_t *)ctx;
+    brew_progress_t progress;
+    brew_done_t done;
+
+    if (brew_proto_unpack_progress(frame, &progress) && progress.order_id == host->active_id) {
+        printf("<< order %u: stage %u, %u%%\n", progress.order_id, progress.stage, progress.percent);
+        host->active_ms = host_now_ms();
+    } else if (brew_proto_unpack_done(frame, &done) && done.order_id == host->active_id) {
+        printf("<< order %u done, result %u\n", done.order_id, done.result);
+        host->done = 1;
+        host->failed = done.result != BREW_RESULT_OK;
+    } else if (frame->type == BREW_FRAME_NAK) {
+        printf("<< order %u refused\n", host->active_id);
+        host->done = 1;
+        host->failed = 1;
+    }
+}
+
+static int host_open(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    struct termios tio;
+    tcgetattr(fd, &tio);
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B115200);
+    tcsetattr(fd, TCSANOW, &tio);
+    return fd;
+}
+
+static int host_run_order(host_t *host, brew_proto_session_t *session, uint16_t order_id)
+{
+    brew_order_t order = {
+        .order_id = order_id,
+        .recipe = (uint8_t)(order_id % 7),
+        .coffee_ratio = 40,
+        .water_ratio = 40,
+        .milk_ratio = 20,
+    };
+    uint8_t payload[BREW_PROTO_MAX_PAYLOAD];
+    uint8_t buf[128];
+
+    snprintf(order.name, sizeof(order.name), "host-%u", order_id);
+    host->done = 0;
+    host->failed = 0;
+    host->active_id = order_id;
+    host->active_ms = host_now_ms();
+
+    size_t len = brew_proto_pack_order(&order, payload);
+    brew_proto_session_send(session, BREW_FRAME_ORDER, payload, len, host->active_ms);
+    printf(">> order %u\n", order_id);
+
+    while (!host->done) {
+        struct pollfd pfd = {.fd = host->fd, .events = POLLIN};
+        if (poll(&pfd, 1, 10) > 0) {
+            ssize_t n = read(host->fd, buf, sizeof(buf));
+            if (n > 0) {
+                brew_proto_session_input(session, buf, (size_t)n, host_now_ms());
+            }
+        }
+
+        uint32_t now_ms = host_now_ms();
+        if (brew_proto_session_poll(session, now_ms) == BREW_PROTO_ERR_TIMEOUT) {
+            printf("!! order %u not acknowledged\n", order_id);
+            return -1;
+        }
+        if ((uint32_t)(now_ms - host->active_ms) >= HOST_ORDER_TIMEOUT_MS) {
+            printf("!! order %u timed out\n", order_id);
+            return -1;
+        }
+    }
+    return host->failed ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <tty> [orders] [drop]\n", argv[0]);
+        return 2;
+    }
+
+    host_t host = {
+        .fd = host_open(argv[1]),
+        .drop = argc > 3 ? atof(argv[3]) : 0.0,
+    };
+    if (host.fd < 0) {
+        return 2;
+    }
+    int orders = argc > 2 ? atoi(argv[2]) : 1;
+
+    const brew_proto_config_t config = {
+        .ack_timeout_ms = HOST_ACK_TIMEOUT_MS,
+        .max_retries = HOST_MAX_RETRIES,
+        .write = host_write,
+        .on_frame = host_on_frame,
+        .ctx = &host,
+    };
+    brew_proto_session_t session;
+    brew_proto_session_init(&session, &config);
+    srand((unsigned)host_now_ms());
+
+    int failures = 0;
+    for (int i = 1; i <= orders; i++) {
+        if (host_run_order(&host, &session, (uint16_t)i) != 0) {
+            failures++;
+        }
+    }
+
+    printf("tx %u, rx %u, retransmits %u, duplicates %u, crc errors %u, failures %d\n",
+           (unsigned)session.stats.tx_frames, (unsigned)session.stats.rx_frames, (unsigned)session.stats.retransmits,
+           (unsigned)session.stats.duplicates, (unsigned)session.stats.crc_errors, failures);
+    close(host.fd);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************************
+ * Image kernels
+ * Small set of pixel primitives shared by the camera, detector and recognition code.
+ * All functions clip their arguments once up front, the inner loops carry no bounds checks.
+ * RGB565 pixels are handled in native byte order unless stated otherwise.
+ **************************************************************************************************/
+
+typedef enum {
+    IMG_FMT_RGB565 = 0,
+    IMG_FMT_RGB888,
+    IMG_FMT_Y8,
+} img_fmt_t;
+
+/**
+ * @brief Image buffer view.
+ *
+ * Describes a (sub-)image inside a larger buffer; `stride` is the distance between two rows in bytes.
+ */
+typedef struct {
+    uint8_t *data;                                    /*!< Pointer to the first pixel */
+    int width;                                        /*!< Width in pixels */
+    int height;                                       /*!< Height in pixels */
+    int stride;                                       /*!< Row pitch in bytes */
+    img_fmt_t fmt;                                    /*!< Pixel format */
+} img_buf_t;
+
+/**
+ * @brief Bytes per pixel of a format.
+ */
+int img_fmt_bpp(img_fmt_t fmt);
+
+/**
+ * @brief Fill an image view descriptor for a tightly packed buffer.
+ *
+ * @param img    Descriptor to fill.
+ * @param data   Pixel data.
+ * @param width  Width in pixels.
+ * @param height Height in pixels.
+ * @param fmt    Pixel format.
+ */
+void img_buf_init(img_buf_t *img, void *data, int width, int height, img_fmt_t fmt);
+
+/**
+ * @brief Fill `n` RGB565 pixels with one color.
+ */
+void img_fill_span_rgb565(uint16_t *dst, size_t n, uint16_t color);
+
+/**
+ * @brief Fill a rectangle, clipped to the image.
+ *
+ * @param dst   Destination image.
+ * @param color Pixel value in the format of `dst` (RGB565 value, 0xRRGGBB, or luma).
+ */
+void img_fill_rect(img_buf_t *dst, int x, int y, int w, int h, uint32_t color);
+
+/**
+ * @brief Copy a `w` x `h` block between two images of the same format, clipped to both.
+ *
+ * @return false if the formats differ or nothing was copied.
+ */
+bool img_blit(const img_buf_t *src, int sx, int sy, int w, int h, img_buf_t *dst, int dx, int dy);
+
+/**
+ * @brief Copy the region (`x`, `y`, `dst->width`, `dst->height`) of `src` into `dst`.
+ *
+ * Parts of the region outside of `src` are filled with zero, so a crop around a face near the
+ * frame border keeps its geometry.
+ *
+ * @return false if the formats differ.
+ */
+bool img_crop(const img_buf_t *src, int x, int y, img_buf_t *dst);
+
+/**
+ * @brief Nearest-neighbour resize of `src` into `dst` (same format).
+ */
+bool img_resize_nearest(const img_buf_t *src, img_buf_t *dst);
+
+/**
+ * @brief Bilinear resize of `src` into `dst` (same format).
+ */
+bool img_resize_bilinear(const img_buf_t *src, img_buf_t *dst);
+
+/**
+ * @brief Swap the two bytes of `n` 16-bit pixels in place.
+ */
+void img_byteswap16(uint16_t *buf, size_t n);
+
+/**
+ * @brief Convert `n` RGB565 pixels to 8-bit luma (BT.601 weights).
+ */
+void img_rgb565_to_gray(const uint16_t *src, uint8_t *dst, size_t n);
+
+/**
+ * @brief Convert an RGB565 image to luma while shrinking it by an integer factor.
+ *
+ * Every output pixel is the mean luma of a `factor` x `factor` block, the cheapest way to get
+ * a small grayscale frame for motion or quality checks. `dst` must be Y8 and its size defines
+ * how much of `src` is used.
+ */
+bool img_rgb565_to_gray_downsample(const img_buf_t *src, int factor, img_buf_t *dst);
+
+/**
+ * @brief Sum of the Y8 pixels in a rectangle, clipped to the image.
+ */
+uint32_t img_box_sum_y8(const img_buf_t *src, int x, int y, int w, int h);
+
+/**
+ * @brief Sample an RGB565 image through an affine map into a Y8 image.
+ *
+ * Destination pixel (u, v) takes the bilinear luma of source point
+ * (m[0] * u + m[1] * v + m[2], m[3] * u + m[4] * v + m[5]). Points outside of `src` read as
+ * zero. Used to cut out rotated and scaled face crops.
+ *
+ * @return false if the formats do not match.
+ */
+bool img_rgb565_to_gray_affine(const img_buf_t *src, const float m[6], img_buf_t *dst);
+
+/**
+ * @brief Variance of the 4-neighbour Laplacian of a Y8 image, a cheap sharpness measure.
+ */
+uint32_t img_laplacian_var_y8(const img_buf_t *src);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,460 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "img_kernels.h"
+
+/*
+ * The wide paths move four RGB565 pixels per 64-bit access once the pointer is aligned. They are
+ * used on every target, the per-pixel tails keep them correct for any size and alignment.
+ */
+#define IMG_ALIGNED(p, n)           ((((uintptr_t)(p)) & ((n) - 1)) == 0)
+
+#define RGB565_R(p)                 ((((p) >> 11) & 0x1F) << 3)
+#define RGB565_G(p)                 ((((p) >> 5) & 0x3F) << 2)
+#define RGB565_B(p)                 (((p) & 0x1F) << 3)
+#define RGB565_PACK(r, g, b)        ((uint16_t)((((r) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((b) >> 3)))
+
+/* BT.601 luma, 8-bit fixed point: 77R + 150G + 29B */
+#define GRAY_FROM_RGB(r, g, b)      ((uint8_t)(((r) * 77 + (g) * 150 + (b) * 29) >> 8))
+
+static inline uint8_t *img_row(const img_buf_t *img, int y)
+{
+    return img->data + (size_t)y * img->stride;
+}
+
+static inline uint8_t rgb565_to_gray(uint16_t p)
+{
+    return GRAY_FROM_RGB(RGB565_R(p), RGB565_G(p), RGB565_B(p));
+}
+
+/* Clip (x, y, w, h) to [0, width) x [0, height). Returns false when nothing is left. */
+static bool img_clip(int width, int height, int *x, int *y, int *w, int *h)
+{
+    if (*x < 0) {
+        *w += *x;
+        *x = 0;
+    }
+    if (*y < 0) {
+        *h += *y;
+        *y = 0;
+    }
+    if (*x + *w > width) {
+        *w = width - *x;
+    }
+    if (*y + *h > height) {
+        *h = height - *y;
+    }
+
+    return *w > 0 && *h > 0;
+}
+
+int img_fmt_bpp(img_fmt_t fmt)
+{
+    switch (fmt) {
+    case IMG_FMT_RGB565:
+        return 2;
+    case IMG_FMT_RGB888:
+        return 3;
+    case IMG_FMT_Y8:
+    default:
+        return 1;
+    }
+}
+
+void img_buf_init(img_buf_t *img, void *data, int width, int height, img_fmt_t fmt)
+{
+    img->data = (uint8_t *)data;
+    img->width = width;
+    img->height = height;
+    img->stride = width * img_fmt_bpp(fmt);
+    img->fmt = fmt;
+}
+
+void img_fill_span_rgb565(uint16_t *dst, size_t n, uint16_t color)
+{
+    while (n && !IMG_ALIGNED(dst, 8)) {
+        *dst++ = color;
+        n--;
+    }
+
+    uint64_t quad = (uint64_t)color * 0x0001000100010001ULL;
+    uint64_t *dst64 = (uint64_t *)dst;
+    size_t n4 = n >> 2;
+    for (size_t i = 0; i < n4; i++) {
+        dst64[i] = quad;
+    }
+
+    dst += n4 << 2;
+    for (size_t i = 0; i < (n & 3); i++) {
+        dst[i] = color;
+    }
+}
+
+void img_fill_rect(img_buf_t *dst, int x, int y, int w, int h, uint32_t color)
+{
+    if (!img_clip(dst->width, dst->height, &x, &y, &w, &h)) {
+        return;
+    }
+
+    for (int row = y; row < y + h; row++) {
+        uint8_t *p = img_row(dst, row);
+
+        switch (dst->fmt) {
+        case IMG_FMT_RGB565:
+            img_fill_span_rgb565((uint16_t *)p + x, w, (uint16_t)color);
+            break;
+        case IMG_FMT_Y8:
+            memset(p + x, (uint8_t)color, w);
+            break;
+        case IMG_FMT_RGB888:
+            p += x * 3;
+            for (int i = 0; i < w; i++) {
+                p[0] = (uint8_t)(color >> 16);
+                p[1] = (uint8_t)(color >> 8);
+                p[2] = (uint8_t)color;
+                p += 3;
+            }
+            break;
+        }
+    }
+}
+
+bool img_blit(const img_buf_t *src, int sx, int sy, int w, int h, img_buf_t *dst, int dx, int dy)
+{
+    if (src->fmt != dst->fmt) {
+        return false;
+    }
+
+    /* Clip against the source, shifting the destination along, then against the destination */
+    int x = sx, y = sy;
+    if (!img_clip(src->width, src->height, &x, &y, &w, &h)) {
+        return false;
+    }
+    dx += x - sx;
+    dy += y - sy;
+    sx = x;
+    sy = y;
+
+    x = dx;
+    y = dy;
+    if (!img_clip(dst->width, dst->height, &x, &y, &w, &h)) {
+        return false;
+    }
+    sx += x - dx;
+    sy += y - dy;
+    dx = x;
+    dy = y;
+
+    int bpp = img_fmt_bpp(src->fmt);
+    size_t row_bytes = (size_t)w * bpp;
+    for (int row = 0; row < h; row++) {
+        memcpy(img_row(dst, dy + row) + dx * bpp, img_row(src, sy + row) + sx * bpp, row_bytes);
+    }
+
+    return true;
+}
+
+bool img_crop(const img_buf_t *src, int x, int y, img_buf_t *dst)
+{
+    if (src->fmt != dst->fmt) {
+        return false;
+    }
+
+    int cx = x, cy = y, cw = dst->width, ch = dst->height;
+    if (!img_clip(src->width, src->height, &cx, &cy, &cw, &ch) ||
+            cw != dst->width || ch != dst->height) {
+        /* Part of the region lies outside the source */
+        for (int row = 0; row < dst->height; row++) {
+            memset(img_row(dst, row), 0, (size_t)dst->width * img_fmt_bpp(dst->fmt));
+        }
+    }
+    img_blit(src, x, y, dst->width, dst->height, dst, 0, 0);
+
+    return true;
+}
+
+/*
+ * Source pixel under the center of each destination pixel, floor((2 * i + 1) * src / (2 * dst)),
+ * stepped with an integer remainder so it does not drift as a truncated fixed point step does.
+ */
+typedef struct {
+    int pos;
+    int rem;
+    int step;
+    int rem_step;
+    int den;
+} nearest_step_t;
+
+static inline void nearest_step_init(nearest_step_t *n, int src, int dst)
+{
+    n->den = 2 * dst;
+    n->pos = src / n->den;
+    n->rem = src % n->den;
+    n->step = (2 * src) / n->den;
+    n->rem_step = (2 * src) % n->den;
+}
+
+static inline void nearest_step_next(nearest_step_t *n)
+{
+    n->pos += n->step;
+    n->rem += n->rem_step;
+    if (n->rem >= n->den) {
+        n->rem -= n->den;
+        n->pos++;
+    }
+}
+
+bool img_resize_nearest(const img_buf_t *src, img_buf_t *dst)
+{
+    if (src->fmt != dst->fmt || dst->width <= 0 || dst->height <= 0 || src->width <= 0 || src->height <= 0) {
+        return false;
+    }
+
+    nearest_step_t sy;
+    nearest_step_init(&sy, src->height, dst->height);
+    for (int y = 0; y < dst->height; y++, nearest_step_next(&sy)) {
+        const uint8_t *s = img_row(src, sy.pos);
+        uint8_t *d = img_row(dst, y);
+        nearest_step_t sx;
+        nearest_step_init(&sx, src->width, dst->width);
+
+        switch (dst->fmt) {
+        case IMG_FMT_RGB565: {
+            const uint16_t *s16 = (const uint16_t *)s;
+            uint16_t *d16 = (uint16_t *)d;
+            for (int x = 0; x < dst->width; x++, nearest_step_next(&sx)) {
+                d16[x] = s16[sx.pos];
+            }
+            break;
+        }
+        case IMG_FMT_Y8:
+            for (int x = 0; x < dst->width; x++, nearest_step_next(&sx)) {
+                d[x] = s[sx.pos];
+            }
+            break;
+        case IMG_FMT_RGB888:
+            for (int x = 0; x < dst->width; x++, nearest_step_next(&sx)) {
+                const uint8_t *sp = s + sx.pos * 3;
+                d[0] = sp[0];
+                d[1] = sp[1];
+                d[2] = sp[2];
+                d += 3;
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+static inline uint32_t lerp8(uint32_t a, uint32_t b, uint32_t w)
+{
+    /* w in [0, 256] */
+    return (a * (256 - w) + b * w) >> 8;
+}
+
+bool img_resize_bilinear(const img_buf_t *src, img_buf_t *dst)
+{
+    if (src->fmt != dst->fmt || dst->width <= 0 || dst->height <= 0 || src->width <= 0 || src->height <= 0) {
+        return false;
+    }
+
+    int bpp = img_fmt_bpp(src->fmt);
+    int32_t step_x = ((int32_t)src->width << 16) / dst->width;
+    int32_t step_y = ((int32_t)src->height << 16) / dst->height;
+    int32_t fy = (step_y >> 1) - (1 << 15);
+
+    for (int y = 0; y < dst->height; y++, fy += step_y) {
+        int32_t cy = fy < 0 ? 0 : fy;
+        int y0 = cy >> 16;
+        int y1 = y0 + 1 < src->height ? y0 + 1 : y0;
+        uint32_t wy = (cy >> 8) & 0xFF;
+        const uint8_t *r0 = img_row(src, y0);
+        const uint8_t *r1 = img_row(src, y1);
+        uint8_t *d = img_row(dst, y);
+        int32_t fx = (step_x >> 1) - (1 << 15);
+
+        for (int x = 0; x < dst->width; x++, fx += step_x) {
+            int32_t cx = fx < 0 ? 0 : fx;
+            int x0 = cx >> 16;
+            int x1 = x0 + 1 < src->width ? x0 + 1 : x0;
+            uint32_t wx = (cx >> 8) & 0xFF;
+
+            if (src->fmt == IMG_FMT_RGB565) {
+                uint16_t p00 = ((const uint16_t *)r0)[x0], p01 = ((const uint16_t *)r0)[x1];
+                uint16_t p10 = ((const uint16_t *)r1)[x0], p11 = ((const uint16_t *)r1)[x1];
+                uint32_t r = lerp8(lerp8(RGB565_R(p00), RGB565_R(p01), wx), lerp8(RGB565_R(p10), RGB565_R(p11), wx), wy);
+                uint32_t g = lerp8(lerp8(RGB565_G(p00), RGB565_G(p01), wx), lerp8(RGB565_G(p10), RGB565_G(p11), wx), wy);
+                uint32_t b = lerp8(lerp8(RGB565_B(p00), RGB565_B(p01), wx), lerp8(RGB565_B(p10), RGB565_B(p11), wx), wy);
+                ((uint16_t *)d)[x] = RGB565_PACK(r, g, b);
+            } else {
+                for (int c = 0; c < bpp; c++) {
+                    uint32_t top = lerp8(r0[x0 * bpp + c], r0[x1 * bpp + c], wx);
+                    uint32_t bottom = lerp8(r1[x0 * bpp + c], r1[x1 * bpp + c], wx);
+                    d[x * bpp + c] = (uint8_t)lerp8(top, bottom, wy);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void img_byteswap16(uint16_t *buf, size_t n)
+{
+    while (n && !IMG_ALIGNED(buf, 8)) {
+        *buf = (uint16_t)((*buf << 8) | (*buf >> 8));
+        buf++;
+        n--;
+    }
+
+    uint64_t *buf64 = (uint64_t *)buf;
+    size_t n4 = n >> 2;
+    for (size_t i = 0; i < n4; i++) {
+        uint64_t v = buf64[i];
+        buf64[i] = ((v & 0x00FF00FF00FF00FFULL) << 8) | ((v >> 8) & 0x00FF00FF00FF00FFULL);
+    }
+
+    buf += n4 << 2;
+    for (size_t i = 0; i < (n & 3); i++) {
+        buf[i] = (uint16_t)((buf[i] << 8) | (buf[i] >> 8));
+    }
+}
+
+void img_rgb565_to_gray(const uint16_t *src, uint8_t *dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        dst[i] = rgb565_to_gray(src[i]);
+        dst[i + 1] = rgb565_to_gray(src[i + 1]);
+        dst[i + 2] = rgb565_to_gray(src[i + 2]);
+        dst[i + 3] = rgb565_to_gray(src[i + 3]);
+    }
+    for (; i < n; i++) {
+        dst[i] = rgb565_to_gray(src[i]);
+    }
+}
+
+bool img_rgb565_to_gray_downsample(const img_buf_t *src, int factor, img_buf_t *dst)
+{
+    if (src->fmt != IMG_FMT_RGB565 || dst->fmt != IMG_FMT_Y8 || factor <= 0 ||
+            dst->width * factor > src->width || dst->height * factor > src->height) {
+        return false;
+    }
+
+    uint32_t area = (uint32_t)factor * factor;
+    for (int y = 0; y < dst->height; y++) {
+        uint8_t *d = img_row(dst, y);
+
+        for (int x = 0; x < dst->width; x++) {
+            uint32_t r = 0, g = 0, b = 0;
+            for (int by = 0; by < factor; by++) {
+                const uint16_t *s = (const uint16_t *)img_row(src, y * factor + by) + x * factor;
+                for (int bx = 0; bx < factor; bx++) {
+                    uint16_t p = s[bx];
+                    r += RGB565_R(p);
+                    g += RGB565_G(p);
+                    b += RGB565_B(p);
+                }
+            }
+            d[x] = GRAY_FROM_RGB(r / area, g / area, b / area);
+        }
+    }
+
+    return true;
+}
+
+uint32_t img_box_sum_y8(const img_buf_t *src, int x, int y, int w, int h)
+{
+    if (src->fmt != IMG_FMT_Y8 || !img_clip(src->width, src->height, &x, &y, &w, &h)) {
+        return 0;
+    }
+
+    uint32_t sum = 0;
+    for (int row = y; row < y + h; row++) {
+        const uint8_t *p = img_row(src, row) + x;
+        int i = 0;
+        for (; i + 4 <= w; i += 4) {
+            sum += p[i] + p[i + 1] + p[i + 2] + p[i + 3];
+        }
+        for (; i < w; i++) {
+            sum += p[i];
+        }
+    }
+
+    return sum;
+}
+
+static inline uint32_t gray_at(const img_buf_t *src, int x, int y)
+{
+    if ((unsigned)x >= (unsigned)src->width || (unsigned)y >= (unsigned)src->height) {
+        return 0;
+    }
+    return rgb565_to_gray(((const uint16_t *)img_row(src, y))[x]);
+}
+
+bool img_rgb565_to_gray_affine(const img_buf_t *src, const float m[6], img_buf_t *dst)
+{
+    if (src->fmt != IMG_FMT_RGB565 || dst->fmt != IMG_FMT_Y8) {
+        return false;
+    }
+
+    /* 16.16 fixed point, stepping along a row is two additions */
+    int32_t dxu = (int32_t)(m[0] * 65536.0f), dxv = (int32_t)(m[1] * 65536.0f);
+    int32_t dyu = (int32_t)(m[3] * 65536.0f), dyv = (int32_t)(m[4] * 65536.0f);
+    int32_t x0 = (int32_t)(m[2] * 65536.0f), y0 = (int32_t)(m[5] * 65536.0f);
+
+    for (int v = 0; v < dst->height; v++) {
+        uint8_t *d = img_row(dst, v);
+        int32_t fx = x0 + v * dxv;
+        int32_t fy = y0 + v * dyv;
+
+        for (int u = 0; u < dst->width; u++, fx += dxu, fy += dyu) {
+            int sx = fx >> 16, sy = fy >> 16;
+            uint32_t wx = (fx >> 8) & 0xFF, wy = (fy >> 8) & 0xFF;
+
+            if (sx >= 0 && sy >= 0 && sx + 1 < src->width && sy + 1 < src->height) {
+                const uint16_t *r0 = (const uint16_t *)img_row(src, sy) + sx;
+                const uint16_t *r1 = (const uint16_t *)img_row(src, sy + 1) + sx;
+                uint32_t top = lerp8(rgb565_to_gray(r0[0]), rgb565_to_gray(r0[1]), wx);
+                uint32_t bottom = lerp8(rgb565_to_gray(r1[0]), rgb565_to_gray(r1[1]), wx);
+                d[u] = (uint8_t)lerp8(top, bottom, wy);
+            } else {
+                uint32_t top = lerp8(gray_at(src, sx, sy), gray_at(src, sx + 1, sy), wx);
+                uint32_t bottom = lerp8(gray_at(src, sx, sy + 1), gray_at(src, sx + 1, sy + 1), wx);
+                d[u] = (uint8_t)lerp8(top, bottom, wy);
+            }
+        }
+    }
+
+    return true;
+}
+
+uint32_t img_laplacian_var_y8(const img_buf_t *src)
+{
+    if (src->fmt != IMG_FMT_Y8 || src->width < 3 || src->height < 3) {
+        return 0;
+    }
+
+    int64_t sum = 0;
+    uint64_t sum_sq = 0;
+    for (int y = 1; y < src->height - 1; y++) {
+        const uint8_t *up = img_row(src, y - 1);
+        const uint8_t *p = img_row(src, y);
+        const uint8_t *down = img_row(src, y + 1);
+
+        for (int x = 1; x < src->width - 1; x++) {
+            int32_t lap = up[x] + down[x] + p[x - 1] + p[x + 1] - 4 * p[x];
+            sum += lap;
+            sum_sq += (uint32_t)(lap * lap);
+        }
+    }
+
+    uint32_t n = (uint32_t)(src->width - 2) * (src->height - 2);
+    int64_t mean = sum / n;
+    return (uint32_t)(sum_sq / n - (uint64_t)(mean * mean));
+}
@@ -55,6 +55,15 @@ esp_err_t bsp_touch_new(const bsp_touch_config_t *config, esp_lcd_touch_handle_t
  */
 void bsp_touch_delete(void);
 
+/**
+ * @brief Get the touchscreen handle
+ *
+ * @note The touchscreen is initialized in bsp_display_start() function.
+ *
+ * @return esp_lcd_touch touchscreen handle or NULL when not initialized
+ */
+esp_lcd_touch_handle_t bsp_touch_get_handle(void);
+
 /** @} */ // end of display
 #ifdef __cplusplus
 }
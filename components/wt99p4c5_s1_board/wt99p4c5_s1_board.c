@@ -678,6 +678,11 @@ void bsp_touch_delete(void)
     }
 }
 
+esp_lcd_touch_handle_t bsp_touch_get_handle(void)
+{
+    return tp;
+}
+
 static lv_display_t *bsp_display_lcd_init(const bsp_display_cfg_t *cfg)
 {
     assert(cfg != NULL);
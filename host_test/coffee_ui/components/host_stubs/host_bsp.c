@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_private/esp_cache_private.h"
+#include "bsp/esp-bsp.h"
+
+#define HOST_CACHE_LINE_SIZE        (64)
+
+static SemaphoreHandle_t s_lvgl_mux;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int s_brightness = 100;
+
+bool bsp_display_lock(uint32_t timeout_ms)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (s_lvgl_mux == NULL) {
+        s_lvgl_mux = xSemaphoreCreateRecursiveMutex();
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    const TickType_t timeout_ticks = (timeout_ms == 0) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xSemaphoreTakeRecursive(s_lvgl_mux, timeout_ticks) == pdTRUE;
+}
+
+void bsp_display_unlock(void)
+{
+    xSemaphoreGiveRecursive(s_lvgl_mux);
+}
+
+esp_err_t bsp_display_brightness_set(int brightness_percent)
+{
+    s_brightness = brightness_percent;
+    return ESP_OK;
+}
+
+int host_bsp_get_brightness(void)
+{
+    return s_brightness;
+}
+
+i2c_master_bus_handle_t bsp_i2c_get_handle(void)
+{
+    return NULL;
+}
+
+esp_err_t esp_cache_get_alignment(uint32_t heap_caps, size_t *out_alignment)
+{
+    *out_alignment = (heap_caps & MALLOC_CAP_SPIRAM) ? HOST_CACHE_LINE_SIZE : 0;
+    return ESP_OK;
+}
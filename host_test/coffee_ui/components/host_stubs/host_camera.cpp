@@ -0,0 +1,189 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "camera/app_video.h"
+#include "camera/app_humanface_detect.h"
+#include "camera/app_pedestrian_detect.h"
+#include "camera/app_video_plane.h"
+#include "host_camera.h"
+
+#define HOST_CAM_WIDTH              (1280)
+#define HOST_CAM_HEIGHT             (960)
+#define HOST_CAM_BUF_SIZE           (HOST_CAM_WIDTH * HOST_CAM_HEIGHT * 2)
+
+static const char *TAG = "host_camera";
+
+static struct {
+    int fd;
+    uint32_t fb_num;
+    uint8_t *fb[EXAMPLE_CAM_BUF_NUM];
+    uint32_t fb_index;
+    uint32_t frame;
+    bool streaming;
+    app_video_frame_operation_cb_t operation_cb;
+} s_cam = {
+    .fd = -1,
+};
+
+static HumanFaceDetect s_face_detect;
+static PedestrianDetect s_pedestrian_detect;
+
+esp_err_t app_video_main(i2c_master_bus_handle_t i2c_bus_handle)
+{
+    ESP_LOGI(TAG, "Test pattern camera, %dx%d RGB565", HOST_CAM_WIDTH, HOST_CAM_HEIGHT);
+    return ESP_OK;
+}
+
+int app_video_open(const char *dev, video_fmt_t init_fmt)
+{
+    // The UI reads the format with ioctl(); that fails on /dev/null and it keeps its 1280x960 default
+    s_cam.fd = open("/dev/null", O_RDONLY);
+    return s_cam.fd;
+}
+
+esp_err_t app_video_set_bufs(int video_fd, uint32_t fb_num, const void **fb)
+{
+    if (fb_num == 0 || fb_num > EXAMPLE_CAM_BUF_NUM || fb == NULL) {
+        return ESP_FAIL;
+    }
+    s_cam.fb_num = fb_num;
+    for (uint32_t i = 0; i < fb_num; i++) {
+        s_cam.fb[i] = (uint8_t *)fb[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_video_get_bufs(int fb_num, void **fb)
+{
+    if (fb_num <= 0 || (uint32_t)fb_num > s_cam.fb_num) {
+        return ESP_FAIL;
+    }
+    for (int i = 0; i < fb_num; i++) {
+        fb[i] = s_cam.fb[i];
+    }
+    return ESP_OK;
+}
+
+uint32_t app_video_get_buf_size(void)
+{
+    return HOST_CAM_BUF_SIZE;
+}
+
+esp_err_t app_video_stream_task_start(int video_fd, int core_id)
+{
+    s_cam.streaming = true;
+    return ESP_OK;
+}
+
+esp_err_t app_video_stream_task_stop(int video_fd)
+{
+    s_cam.streaming = false;
+    return ESP_OK;
+}
+
+esp_err_t app_video_set_frame_interval(uint32_t interval_ms)
+{
+    return ESP_OK;
+}
+
+esp_err_t app_video_register_frame_operation_cb(app_video_frame_operation_cb_t operation_cb)
+{
+    s_cam.operation_cb = operation_cb;
+    return ESP_OK;
+}
+
+esp_err_t app_video_stream_wait_stop(void)
+{
+    return ESP_OK;
+}
+
+bool host_camera_feed(void)
+{
+    if (!s_cam.streaming || !s_cam.operation_cb || s_cam.fb_num == 0) {
+        return false;
+    }
+
+    // Vertical bars scrolling by 4 px per frame, enough for the motion gate to see a change
+    uint16_t *px = (uint16_t *)s_cam.fb[s_cam.fb_index];
+    uint32_t shift = s_cam.frame * 4;
+    for (int x = 0; x < HOST_CAM_WIDTH; x++) {
+        px[x] = ((x + shift) & 0x80) ? 0x7BEF : 0x2104;
+    }
+    for (int y = 1; y < HOST_CAM_HEIGHT; y++) {
+        memcpy(px + y * HOST_CAM_WIDTH, px, HOST_CAM_WIDTH * 2);
+    }
+
+    uint32_t index = s_cam.fb_index;
+    s_cam.fb_index = (s_cam.fb_index + 1) % s_cam.fb_num;
+    s_cam.frame++;
+    s_cam.operation_cb(s_cam.fb[index], index, HOST_CAM_WIDTH, HOST_CAM_HEIGHT, HOST_CAM_BUF_SIZE);
+    return true;
+}
+
+std::list<dl::detect::result_t> app_humanface_detect(uint16_t *frame, int width, int height)
+{
+    return {};
+}
+
+HumanFaceDetect *get_humanface_detect()
+{
+    return &s_face_detect;
+}
+
+void delete_humanface_detect()
+{
+}
+
+std::list<dl::detect::result_t> app_pedestrian_detect(uint16_t *frame, int width, int height)
+{
+    return {};
+}
+
+PedestrianDetect *get_pedestrian_detect()
+{
+    return &s_pedestrian_detect;
+}
+
+void delete_pedestrian_detect()
+{
+}
+
+/* Preview frames stay on the LVGL canvas, there is no PPA to copy them into a frame buffer */
+
+esp_err_t app_video_plane_new(lv_disp_t *disp, app_video_plane_t **ret_plane)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_video_plane_delete(app_video_plane_t *plane)
+{
+}
+
+void app_video_plane_set_window(app_video_plane_t *plane, const lv_area_t *area, int src_x, int src_y)
+{
+}
+
+esp_err_t app_video_plane_exclude(app_video_plane_t *plane, lv_obj_t *obj)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_video_plane_clear_excludes(app_video_plane_t *plane)
+{
+}
+
+void app_video_plane_set_boxes(app_video_plane_t *plane, const std::list<dl::detect::result_t> &results, bool show_keypoints)
+{
+}
+
+esp_err_t app_video_plane_draw(app_video_plane_t *plane, const void *frame, uint32_t width, uint32_t height)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
@@ -0,0 +1,44 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Take the LVGL lock, as the board's LVGL port does. A timeout of 0 waits forever.
+ */
+bool bsp_display_lock(uint32_t timeout_ms);
+
+/**
+ * @brief Give the LVGL lock back.
+ */
+void bsp_display_unlock(void);
+
+/**
+ * @brief Record the backlight brightness, see host_bsp_get_brightness().
+ */
+esp_err_t bsp_display_brightness_set(int brightness_percent);
+
+/**
+ * @brief There is no I2C bus on the host, always NULL.
+ */
+i2c_master_bus_handle_t bsp_i2c_get_handle(void);
+
+/**
+ * @brief Last brightness set by the UI, in percent.
+ */
+int host_bsp_get_brightness(void);
+
+#ifdef __cplusplus
+}
+#endif
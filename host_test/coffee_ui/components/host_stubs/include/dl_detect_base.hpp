@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <list>
+#include <vector>
+
+namespace dl {
+namespace detect {
+
+/**
+ * @brief Detection result, with the fields of esp-dl's result_t the UI reads.
+ */
+typedef struct {
+    int category;
+    float score;
+    std::vector<int> box;                             /*!< x1, y1, x2, y2 */
+    std::vector<int> keypoint;                        /*!< x, y pairs */
+} result_t;
+
+} // namespace detect
+} // namespace dl
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Cache line size of the board's PSRAM, so buffers are laid out as on the target.
+ */
+esp_err_t esp_cache_get_alignment(uint32_t heap_caps, size_t *out_alignment);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Hand the UI one camera frame if its stream is running.
+ *
+ * The frame is a test pattern that moves a little every frame. It goes to the callback
+ * registered with app_video_register_frame_operation_cb() on the calling task, which must not
+ * hold the display lock.
+ *
+ * @return Whether a frame was delivered.
+ */
+bool host_camera_feed(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "dl_detect_base.hpp"
+
+/* No model on the host, app_humanface_detect() finds no faces */
+class HumanFaceDetect {
+};
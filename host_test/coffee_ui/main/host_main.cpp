@@ -0,0 +1,444 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Runs the coffee machine UI on Linux: LVGL renders into a frame buffer in memory, a script
+ * plays the touch input and the render time, object count and heap use of every screen shown
+ * are printed at the end. Exits non-zero if a screen renders slower than the script allows.
+ *
+ *   COFFEE_UI_SCRIPT=scripts/tour.txt ./build/coffee_ui_host.elf
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "bsp/esp-bsp.h"
+#include "host_camera.h"
+#include "display/app_ui_perf.h"
+#include "display/app_input_latency.h"
+#include "camera/app_face_gallery.h"
+#include "CoffeeMachine.hpp"
+
+#define HOST_HOR_RES                (1024)
+#define HOST_VER_RES                (600)
+#define HOST_STEP_MS                (CONFIG_HOST_UI_STEP_MS)
+#define HOST_CAMERA_PERIOD_MS       (1000 / CONFIG_HOST_UI_CAMERA_FPS)
+#define HOST_TAP_HOLD_MS            (60)
+#define HOST_DEFAULT_SCRIPT         HOST_SCRIPT_DIR "/tour.txt"
+
+static const char *TAG = "coffee_ui_host";
+
+typedef struct {
+    std::string name;
+    std::vector<uint32_t> frame_us;                   // Render time of every frame drawn on this screen
+    uint32_t max_objects;
+    size_t max_heap;
+} screen_stats_t;
+
+typedef struct {
+    int line;
+    std::string op;
+    std::vector<std::string> args;
+} script_cmd_t;
+
+static lv_color_t *s_fb;
+static struct {
+    bool pressed;
+    lv_coord_t x;
+    lv_coord_t y;
+} s_touch;
+static CoffeeMachine *s_machine;
+static std::vector<screen_stats_t> s_screens;
+static uint32_t s_now_ms;
+static uint32_t s_next_frame_ms;
+static uint32_t s_max_frame_us;
+
+static void host_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    int width = lv_area_get_width(area);
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&s_fb[y * HOST_HOR_RES + area->x1], color_p, width * sizeof(lv_color_t));
+        color_p += width;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void host_touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    data->point.x = s_touch.x;
+    data->point.y = s_touch.y;
+    data->state = s_touch.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+static lv_disp_t *host_display_start(void)
+{
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_disp_drv_t disp_drv;
+    static lv_indev_drv_t indev_drv;
+
+    // Full screen draw buffer, like the firmware's direct mode, so every area renders in one pass
+    s_fb = (lv_color_t *)calloc(HOST_HOR_RES * HOST_VER_RES, sizeof(lv_color_t));
+    lv_color_t *buf = (lv_color_t *)malloc(HOST_HOR_RES * HOST_VER_RES * sizeof(lv_color_t));
+    if (!s_fb || !buf) {
+        return nullptr;
+    }
+    lv_disp_draw_buf_init(&draw_buf, buf, nullptr, HOST_HOR_RES * HOST_VER_RES);
+
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = HOST_HOR_RES;
+    disp_drv.ver_res = HOST_VER_RES;
+    disp_drv.flush_cb = host_flush_cb;
+    disp_drv.draw_buf = &draw_buf;
+    lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
+
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    indev_drv.read_cb = host_touch_read_cb;
+    lv_indev_drv_register(&indev_drv);
+    return disp;
+}
+
+static uint32_t count_objects(lv_obj_t *obj)
+{
+    uint32_t count = 1;
+    uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    for (uint32_t i = 0; i < child_cnt; i++) {
+        count += count_objects(lv_obj_get_child(obj, i));
+    }
+    return count;
+}
+
+static const char *screen_name(void)
+{
+    lv_obj_t *scr = lv_scr_act();
+    if (s_machine->overlay_active) {
+        return "brewing";
+    }
+    if (scr == s_machine->main_screen) {
+        return "main";
+    }
+    if (scr == s_machine->settings_screen) {
+        return "settings";
+    }
+    if (scr == s_machine->camera_screen) {
+        return "camera";
+    }
+    if (scr == s_machine->_face_name_screen) {
+        return "face_name";
+    }
+    if (scr == s_machine->_face_list_screen) {
+        return "face_list";
+    }
+    return "other";
+}
+
+static screen_stats_t *screen_stats(const char *name)
+{
+    for (auto &s : s_screens) {
+        if (s.name == name) {
+            return &s;
+        }
+    }
+    s_screens.push_back({name, {}, 0, 0});
+    return &s_screens.back();
+}
+
+static void host_step(void)
+{
+    // Camera frames come from the capture task on the board, which takes the display lock itself
+    if (s_now_ms >= s_next_frame_ms) {
+        host_camera_feed();
+        s_next_frame_ms = s_now_ms + HOST_CAMERA_PERIOD_MS;
+    }
+
+    bsp_display_lock(0);
+    lv_tick_inc(HOST_STEP_MS);
+    lv_timer_handler();
+
+    app_ui_perf_stats_t perf;
+    app_ui_perf_get_stats(&perf, true);
+    screen_stats_t *stats = screen_stats(screen_name());
+    if (perf.renders) {
+        stats->frame_us.push_back((uint32_t)(perf.render_us / perf.renders));
+    }
+    // The brewing overlay lives on the top layer, over whichever screen is loaded
+    stats->max_objects = std::max(stats->max_objects, count_objects(lv_scr_act()) +
+                                  (s_machine->overlay_active ? count_objects(s_machine->overlay_screen) : 0));
+    bsp_display_unlock();
+
+    stats->max_heap = std::max(stats->max_heap, (size_t)mallinfo2().uordblks);
+    s_now_ms += HOST_STEP_MS;
+
+    // Let the face worker and the camera init task run, as the other core would
+    vTaskDelay(1);
+}
+
+static void host_wait(uint32_t ms)
+{
+    for (uint32_t t = 0; t < ms; t += HOST_STEP_MS) {
+        host_step();
+    }
+}
+
+static void host_drag(int x1, int y1, int x2, int y2, uint32_t ms)
+{
+    uint32_t steps = std::max<uint32_t>(ms / HOST_STEP_MS, 1);
+    s_touch.pressed = true;
+    for (uint32_t i = 0; i <= steps; i++) {
+        s_touch.x = x1 + (x2 - x1) * (int)i / (int)steps;
+        s_touch.y = y1 + (y2 - y1) * (int)i / (int)steps;
+        host_step();
+    }
+    s_touch.pressed = false;
+    host_wait(HOST_TAP_HOLD_MS);
+}
+
+static bool host_show(const std::string &screen, int arg)
+{
+    bool ok = true;
+    bsp_display_lock(0);
+    if (screen == "main") {
+        s_machine->showMainScreen();
+    } else if (screen == "settings") {
+        s_machine->showSettingsScreen();
+    } else if (screen == "camera") {
+        s_machine->showCameraScreen();
+    } else if (screen == "brewing") {
+        s_machine->showOverlayForIndex(arg);
+    } else if (screen == "face_name") {
+        s_machine->showFaceNameScreen();
+    } else if (screen == "face_list") {
+        s_machine->showFaceListScreen();
+    } else {
+        ok = false;
+    }
+    bsp_display_unlock();
+    return ok;
+}
+
+static bool host_snapshot(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", HOST_HOR_RES, HOST_VER_RES);
+    for (int i = 0; i < HOST_HOR_RES * HOST_VER_RES; i++) {
+        uint8_t rgb[3] = {
+            (uint8_t)(s_fb[i].ch.red << 3),
+            (uint8_t)(s_fb[i].ch.green << 2),
+            (uint8_t)(s_fb[i].ch.blue << 3),
+        };
+        fwrite(rgb, 1, sizeof(rgb), f);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool seed_face_gallery(int count)
+{
+    // Start from the same gallery on every run, so the face list looks the same
+    unlink(CONFIG_APP_FACE_GALLERY_PATH);
+    if (count == 0) {
+        return true;
+    }
+
+    app_face_gallery_config_t config = {
+        .path = CONFIG_APP_FACE_GALLERY_PATH,
+        .sync_writes = false,
+        .compact_min_bytes = 0,
+    };
+    app_face_gallery_t *gallery = nullptr;
+    if (app_face_gallery_open(&config, &gallery) != ESP_OK) {
+        return false;
+    }
+
+    float feature[APP_FACE_FEATURE_DIM];
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k < APP_FACE_FEATURE_DIM; k++) {
+            feature[k] = (float)(((i + 1) * 31 + k * 17) % 64 - 32) / 32.0f;
+        }
+        app_face_gallery_record_t record = {};
+        snprintf(record.name, sizeof(record.name), "Guest %d", i + 1);
+        record.coffee_ratio = 50;
+        record.water_ratio = 30;
+        record.milk_ratio = 20;
+        app_face_gallery_quantize(feature, &record);
+        if (app_face_gallery_put(gallery, &record) != ESP_OK) {
+            app_face_gallery_close(gallery);
+            return false;
+        }
+    }
+    app_face_gallery_close(gallery);
+    return true;
+}
+
+static bool load_script(const char *path, std::vector<script_cmd_t> &cmds)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+
+    char line[256];
+    int line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        script_cmd_t cmd = {line_no, "", {}};
+        for (char *tok = strtok(line, " \t\r\n"); tok; tok = strtok(nullptr, " \t\r\n")) {
+            if (cmd.op.empty()) {
+                cmd.op = tok;
+            } else {
+                cmd.args.push_back(tok);
+            }
+        }
+        if (!cmd.op.empty()) {
+            cmds.push_back(cmd);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static bool run_command(const script_cmd_t &cmd)
+{
+    auto arg = [&cmd](size_t i) {
+        return i < cmd.args.size() ? atoi(cmd.args[i].c_str()) : 0;
+    };
+
+    if (cmd.op == "faces") {
+        // Applied before the UI starts, see app_main()
+    } else if (cmd.op == "wait" && cmd.args.size() == 1) {
+        host_wait(arg(0));
+    } else if (cmd.op == "tap" && cmd.args.size() == 2) {
+        host_drag(arg(0), arg(1), arg(0), arg(1), HOST_TAP_HOLD_MS);
+    } else if (cmd.op == "drag" && cmd.args.size() == 5) {
+        host_drag(arg(0), arg(1), arg(2), arg(3), arg(4));
+    } else if (cmd.op == "press" && cmd.args.size() == 2) {
+        s_touch = {true, (lv_coord_t)arg(0), (lv_coord_t)arg(1)};
+        host_step();
+    } else if (cmd.op == "release" && cmd.args.empty()) {
+        s_touch.pressed = false;
+        host_step();
+    } else if (cmd.op == "show" && !cmd.args.empty()) {
+        return host_show(cmd.args[0], arg(1));
+    } else if (cmd.op == "snapshot" && cmd.args.size() == 1) {
+        return host_snapshot(cmd.args[0].c_str());
+    } else if (cmd.op == "max_frame_us" && cmd.args.size() == 1) {
+        s_max_frame_us = arg(0);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool print_report(void)
+{
+    bool ok = true;
+
+    printf("\n%-10s %7s %8s %8s %8s %8s %9s\n", "screen", "frames", "avg_us", "p95_us", "max_us", "objects", "heap_kb");
+    for (auto &s : s_screens) {
+        if (s.frame_us.empty()) {
+            continue;
+        }
+        std::vector<uint32_t> sorted = s.frame_us;
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t total_us = 0;
+        for (uint32_t us : sorted) {
+            total_us += us;
+        }
+        uint32_t avg_us = total_us / sorted.size();
+        uint32_t p95_us = sorted[(sorted.size() - 1) * 95 / 100];
+        printf("%-10s %7u %8u %8u %8u %8u %9u\n", s.name.c_str(), (unsigned)sorted.size(), (unsigned)avg_us,
+               (unsigned)p95_us, (unsigned)sorted.back(), (unsigned)s.max_objects, (unsigned)(s.max_heap / 1024));
+
+        if (s_max_frame_us && avg_us > s_max_frame_us) {
+            printf("FAIL: %s renders in %u us on average, more than %u us\n", s.name.c_str(), (unsigned)avg_us,
+                   (unsigned)s_max_frame_us);
+            ok = false;
+        }
+    }
+
+    // Clicks are timed to the flush of the host frame buffer, there is no panel to wait for
+    app_input_latency_stats_t lat[APP_INPUT_LATENCY_MAX_SCREENS];
+    int lat_num = app_input_latency_get_stats(lat, false);
+    if (lat_num) {
+        printf("\n%-10s %7s %8s %8s %8s %8s\n", "clicked", "clicks", "event_us", "inval_us", "shown_us", "max_us");
+    }
+    for (int i = 0; i < lat_num; i++) {
+        const app_input_latency_stats_t &s = lat[i];
+        printf("%-10s %7u %8u %8u %8u %8u\n", s.screen, (unsigned)s.samples, (unsigned)(s.event_us / s.samples),
+               (unsigned)(s.invalidate_us / s.samples), (unsigned)(s.photon_us / s.samples), (unsigned)s.max_photon_us);
+    }
+    return ok;
+}
+
+extern "C" void app_main(void)
+{
+    const char *script = getenv("COFFEE_UI_SCRIPT");
+    if (!script) {
+        script = HOST_DEFAULT_SCRIPT;
+    }
+
+    std::vector<script_cmd_t> cmds;
+    if (!load_script(script, cmds)) {
+        ESP_LOGE(TAG, "Failed to read script %s", script);
+        exit(2);
+    }
+
+    int faces = 0;
+    for (auto &cmd : cmds) {
+        if (cmd.op == "faces" && cmd.args.size() == 1) {
+            faces = atoi(cmd.args[0].c_str());
+        }
+    }
+    if (!seed_face_gallery(faces)) {
+        ESP_LOGE(TAG, "Failed to create %d faces in %s", faces, CONFIG_APP_FACE_GALLERY_PATH);
+        exit(2);
+    }
+
+    lv_init();
+    if (!host_display_start()) {
+        ESP_LOGE(TAG, "Failed to allocate the frame buffer");
+        exit(2);
+    }
+
+    bsp_display_lock(0);
+    s_machine = new CoffeeMachine();
+    bool started = s_machine->init();
+    bsp_display_unlock();
+    if (!started) {
+        ESP_LOGE(TAG, "Failed to initialize coffee machine UI");
+        exit(2);
+    }
+
+    // Frames rendered by init() belong to no screen yet
+    app_ui_perf_stats_t perf;
+    app_ui_perf_get_stats(&perf, true);
+
+    for (auto &cmd : cmds) {
+        if (!run_command(cmd)) {
+            ESP_LOGE(TAG, "%s:%d: can not run '%s'", script, cmd.line, cmd.op.c_str());
+            exit(2);
+        }
+    }
+
+    exit(print_report() ? 0 : 1);
+}
@@ -0,0 +1,137 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "img_kernels.h"
+#include "img_kernels_ref.h"
+
+/*
+ * Time of every kernel and of its scalar reference on a 1280x960 camera frame, the size the
+ * camera app and the detectors work on. Run it before and after changing a kernel.
+ */
+
+#define FRAME_W                 (1280)
+#define FRAME_H                 (960)
+#define SMALL_W                 (320)
+#define SMALL_H                 (240)
+#define FACE_SIZE               (112)
+#define BENCH_MIN_NS            (200 * 1000 * 1000LL)   /* Repeat each kernel for at least this long */
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+typedef void (*bench_fn_t)(void);
+
+static uint16_t *s_frame;                               /* RGB565 camera frame */
+static uint16_t *s_frame_out;
+static uint8_t *s_gray;                                 /* Y8 frame */
+static uint16_t *s_small;                               /* RGB565 320x240 */
+static uint8_t *s_small_gray;
+static uint8_t *s_face;
+static img_buf_t s_frame_img, s_frame_out_img, s_gray_img, s_small_img, s_small_gray_img, s_face_img;
+static const float s_face_map[6] = { 1.6f, -0.4f, 600.0f, 0.4f, 1.6f, 380.0f };
+static volatile uint32_t s_sink;
+static volatile double s_sink_d;
+
+static void k_fill(void)            { img_fill_rect(&s_frame_out_img, 0, 0, FRAME_W, FRAME_H, 0x07E0); }
+static void r_fill(void)            { ref_fill_rect(&s_frame_out_img, 0, 0, FRAME_W, FRAME_H, 0x07E0); }
+static void k_blit(void)            { img_blit(&s_frame_img, 0, 0, FRAME_W, FRAME_H, &s_frame_out_img, 0, 0); }
+static void r_blit(void)            { ref_blit(&s_frame_img, 0, 0, FRAME_W, FRAME_H, &s_frame_out_img, 0, 0); }
+static void k_byteswap(void)        { img_byteswap16(s_frame_out, FRAME_W * FRAME_H); }
+static void r_byteswap(void)        { ref_byteswap16(s_frame_out, FRAME_W * FRAME_H); }
+static void k_gray(void)            { img_rgb565_to_gray(s_frame, s_gray, FRAME_W * FRAME_H); }
+static void r_gray(void)            { ref_rgb565_to_gray(s_frame, s_gray, FRAME_W * FRAME_H); }
+static void k_gray_down(void)       { img_rgb565_to_gray_downsample(&s_frame_img, 4, &s_small_gray_img); }
+static void r_gray_down(void)       { ref_rgb565_to_gray_downsample(&s_frame_img, 4, &s_small_gray_img); }
+static void k_nearest(void)         { img_resize_nearest(&s_frame_img, &s_small_img); }
+static void r_nearest(void)         { ref_resize_nearest(&s_frame_img, &s_small_img); }
+static void k_bilinear(void)        { img_resize_bilinear(&s_frame_img, &s_small_img); }
+static void r_bilinear(void)        { ref_resize_bilinear(&s_frame_img, &s_small_img); }
+static void k_box_sum(void)         { s_sink = img_box_sum_y8(&s_gray_img, 0, 0, FRAME_W, FRAME_H); }
+static void r_box_sum(void)         { s_sink = ref_box_sum_y8(&s_gray_img, 0, 0, FRAME_W, FRAME_H); }
+static void k_affine(void)          { img_rgb565_to_gray_affine(&s_frame_img, s_face_map, &s_face_img); }
+static void r_affine(void)          { ref_rgb565_to_gray_affine(&s_frame_img, s_face_map, &s_face_img); }
+static void k_laplacian(void)       { s_sink = img_laplacian_var_y8(&s_face_img); }
+static void r_laplacian(void)       { s_sink_d = ref_laplacian_var_y8(&s_face_img); }
+
+typedef struct {
+    const char *name;
+    int pixels;                                         /* Output pixels per call */
+    bench_fn_t kernel;
+    bench_fn_t ref;
+} bench_t;
+
+static const bench_t s_benches[] = {
+    { "fill_rect 1280x960 rgb565",          FRAME_W * FRAME_H,      k_fill,         r_fill },
+    { "blit 1280x960 rgb565",               FRAME_W * FRAME_H,      k_blit,         r_blit },
+    { "byteswap16 1280x960",                FRAME_W * FRAME_H,      k_byteswap,     r_byteswap },
+    { "rgb565_to_gray 1280x960",            FRAME_W * FRAME_H,      k_gray,         r_gray },
+    { "rgb565_to_gray_downsample /4",       SMALL_W * SMALL_H,      k_gray_down,    r_gray_down },
+    { "resize_nearest to 320x240 rgb565",   SMALL_W * SMALL_H,      k_nearest,      r_nearest },
+    { "resize_bilinear to 320x240 rgb565",  SMALL_W * SMALL_H,      k_bilinear,     r_bilinear },
+    { "box_sum_y8 1280x960",                FRAME_W * FRAME_H,      k_box_sum,      r_box_sum },
+    { "rgb565_to_gray_affine 112x112",      FACE_SIZE * FACE_SIZE,  k_affine,       r_affine },
+    { "laplacian_var_y8 112x112",           FACE_SIZE * FACE_SIZE,  k_laplacian,    r_laplacian },
+};
+
+/* Average time of one call, in ns */
+static double bench_run(bench_fn_t fn)
+{
+    fn();
+    int64_t start = now_ns(), elapsed;
+    int calls = 0;
+    do {
+        fn();
+        calls++;
+        elapsed = now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+    return (double)elapsed / calls;
+}
+
+int main(void)
+{
+    s_frame = aligned_alloc(16, FRAME_W * FRAME_H * 2);
+    s_frame_out = aligned_alloc(16, FRAME_W * FRAME_H * 2);
+    s_gray = aligned_alloc(16, FRAME_W * FRAME_H);
+    s_small = aligned_alloc(16, SMALL_W * SMALL_H * 2);
+    s_small_gray = aligned_alloc(16, SMALL_W * SMALL_H);
+    s_face = aligned_alloc(16, FACE_SIZE * FACE_SIZE);
+    for (int i = 0; i < FRAME_W * FRAME_H; i++) {
+        s_frame[i] = (uint16_t)(i * 2654435761u >> 16);
+    }
+    img_buf_init(&s_frame_img, s_frame, FRAME_W, FRAME_H, IMG_FMT_RGB565);
+    img_buf_init(&s_frame_out_img, s_frame_out, FRAME_W, FRAME_H, IMG_FMT_RGB565);
+    img_buf_init(&s_gray_img, s_gray, FRAME_W, FRAME_H, IMG_FMT_Y8);
+    img_buf_init(&s_small_img, s_small, SMALL_W, SMALL_H, IMG_FMT_RGB565);
+    img_buf_init(&s_small_gray_img, s_small_gray, SMALL_W, SMALL_H, IMG_FMT_Y8);
+    img_buf_init(&s_face_img, s_face, FACE_SIZE, FACE_SIZE, IMG_FMT_Y8);
+    k_gray();
+    k_affine();
+
+    printf("%-36s %12s %10s %12s %8s\n", "kernel", "us/call", "Mpix/s", "scalar us", "speedup");
+    for (size_t i = 0; i < sizeof(s_benches) / sizeof(s_benches[0]); i++) {
+        const bench_t *b = &s_benches[i];
+        double k_ns = bench_run(b->kernel);
+        double r_ns = bench_run(b->ref);
+        printf("%-36s %12.1f %10.1f %12.1f %7.1fx\n", b->name, k_ns / 1000, b->pixels / k_ns * 1000,
+               r_ns / 1000, r_ns / k_ns);
+    }
+
+    free(s_frame);
+    free(s_frame_out);
+    free(s_gray);
+    free(s_small);
+    free(s_small_gray);
+    free(s_face);
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <string.h>
+#include "img_kernels_ref.h"
+
+static uint8_t *pixel(const img_buf_t *img, int x, int y)
+{
+    return img->data + (size_t)y * img->stride + (size_t)x * img_fmt_bpp(img->fmt);
+}
+
+static bool inside(const img_buf_t *img, int x, int y)
+{
+    return x >= 0 && y >= 0 && x < img->width && y < img->height;
+}
+
+static double gray(double r, double g, double b)
+{
+    return 0.299 * r + 0.587 * g + 0.114 * b;
+}
+
+void ref_fill_rect(img_buf_t *dst, int x, int y, int w, int h, uint32_t color)
+{
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            if (!inside(dst, i, j)) {
+                continue;
+            }
+            uint8_t *p = pixel(dst, i, j);
+            switch (dst->fmt) {
+            case IMG_FMT_RGB565:
+                *(uint16_t *)p = (uint16_t)color;
+                break;
+            case IMG_FMT_RGB888:
+                p[0] = (uint8_t)(color >> 16);
+                p[1] = (uint8_t)(color >> 8);
+                p[2] = (uint8_t)color;
+                break;
+            case IMG_FMT_Y8:
+                *p = (uint8_t)color;
+                break;
+            }
+        }
+    }
+}
+
+void ref_blit(const img_buf_t *src, int sx, int sy, int w, int h, img_buf_t *dst, int dx, int dy)
+{
+    int bpp = img_fmt_bpp(src->fmt);
+    for (int j = 0; j < h; j++) {
+        for (int i = 0; i < w; i++) {
+            if (inside(src, sx + i, sy + j) && inside(dst, dx + i, dy + j)) {
+                memcpy(pixel(dst, dx + i, dy + j), pixel(src, sx + i, sy + j), bpp);
+            }
+        }
+    }
+}
+
+void ref_crop(const img_buf_t *src, int x, int y, img_buf_t *dst)
+{
+    int bpp = img_fmt_bpp(src->fmt);
+    for (int j = 0; j < dst->height; j++) {
+        for (int i = 0; i < dst->width; i++) {
+            if (inside(src, x + i, y + j)) {
+                memcpy(pixel(dst, i, j), pixel(src, x + i, y + j), bpp);
+            } else {
+                memset(pixel(dst, i, j), 0, bpp);
+            }
+        }
+    }
+}
+
+void ref_resize_nearest(const img_buf_t *src, img_buf_t *dst)
+{
+    int bpp = img_fmt_bpp(src->fmt);
+    for (int j = 0; j < dst->height; j++) {
+        int sy = (int)floor((j + 0.5) * src->height / dst->height);
+        for (int i = 0; i < dst->width; i++) {
+            int sx = (int)floor((i + 0.5) * src->width / dst->width);
+            memcpy(pixel(dst, i, j), pixel(src, sx, sy), bpp);
+        }
+    }
+}
+
+/* Channel `c` of a pixel, 8 bits */
+static double channel(const img_buf_t *img, int x, int y, int c)
+{
+    const uint8_t *p = pixel(img, x, y);
+    if (img->fmt != IMG_FMT_RGB565) {
+        return p[c];
+    }
+    uint16_t v = *(const uint16_t *)p;
+    return c == 0 ? ref_r(v) : c == 1 ? ref_g(v) : ref_b(v);
+}
+
+void ref_resize_bilinear(const img_buf_t *src, img_buf_t *dst)
+{
+    int channels = src->fmt == IMG_FMT_Y8 ? 1 : 3;
+    for (int j = 0; j < dst->height; j++) {
+        double fy = fmax((j + 0.5) * src->height / dst->height - 0.5, 0.0);
+        int y0 = (int)fy;
+        int y1 = y0 + 1 < src->height ? y0 + 1 : y0;
+        double wy = fy - y0;
+
+        for (int i = 0; i < dst->width; i++) {
+            double fx = fmax((i + 0.5) * src->width / dst->width - 0.5, 0.0);
+            int x0 = (int)fx;
+            int x1 = x0 + 1 < src->width ? x0 + 1 : x0;
+            double wx = fx - x0;
+
+            double v[3];
+            for (int c = 0; c < channels; c++) {
+                double top = channel(src, x0, y0, c) * (1 - wx) + channel(src, x1, y0, c) * wx;
+                double bottom = channel(src, x0, y1, c) * (1 - wx) + channel(src, x1, y1, c) * wx;
+                v[c] = top * (1 - wy) + bottom * wy;
+            }
+
+            uint8_t *p = pixel(dst, i, j);
+            if (dst->fmt == IMG_FMT_RGB565) {
+                *(uint16_t *)p = (uint16_t)((((int)v[0] & 0xF8) << 8) | (((int)v[1] & 0xFC) << 3) | ((int)v[2] >> 3));
+            } else {
+                for (int c = 0; c < channels; c++) {
+                    p[c] = (uint8_t)v[c];
+                }
+            }
+        }
+    }
+}
+
+void ref_byteswap16(uint16_t *buf, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint8_t *b = (uint8_t *)&buf[i];
+        uint8_t t = b[0];
+        b[0] = b[1];
+        b[1] = t;
+    }
+}
+
+void ref_rgb565_to_gray(const uint16_t *src, uint8_t *dst, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = (uint8_t)gray(ref_r(src[i]), ref_g(src[i]), ref_b(src[i]));
+    }
+}
+
+void ref_rgb565_to_gray_downsample(const img_buf_t *src, int factor, img_buf_t *dst)
+{
+    for (int j = 0; j < dst->height; j++) {
+        for (int i = 0; i < dst->width; i++) {
+            double r = 0, g = 0, b = 0;
+            for (int by = 0; by < factor; by++) {
+                for (int bx = 0; bx < factor; bx++) {
+                    uint16_t p = *(const uint16_t *)pixel(src, i * factor + bx, j * factor + by);
+                    r += ref_r(p);
+                    g += ref_g(p);
+                    b += ref_b(p);
+                }
+            }
+            double area = (double)factor * factor;
+            *pixel(dst, i, j) = (uint8_t)gray(r / area, g / area, b / area);
+        }
+    }
+}
+
+uint32_t ref_box_sum_y8(const img_buf_t *src, int x, int y, int w, int h)
+{
+    uint32_t sum = 0;
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            if (inside(src, i, j)) {
+                sum += *pixel(src, i, j);
+            }
+        }
+    }
+    return sum;
+}
+
+static double gray_at(const img_buf_t *src, int x, int y)
+{
+    if (!inside(src, x, y)) {
+        return 0;
+    }
+    uint16_t p = *(const uint16_t *)pixel(src, x, y);
+    return gray(ref_r(p), ref_g(p), ref_b(p));
+}
+
+void ref_rgb565_to_gray_affine(const img_buf_t *src, const float m[6], img_buf_t *dst)
+{
+    for (int v = 0; v < dst->height; v++) {
+        for (int u = 0; u < dst->width; u++) {
+            double fx = (double)m[0] * u + (double)m[1] * v + m[2];
+            double fy = (double)m[3] * u + (double)m[4] * v + m[5];
+            int x0 = (int)floor(fx), y0 = (int)floor(fy);
+            double wx = fx - x0, wy = fy - y0;
+
+            double top = gray_at(src, x0, y0) * (1 - wx) + gray_at(src, x0 + 1, y0) * wx;
+            double bottom = gray_at(src, x0, y0 + 1) * (1 - wx) + gray_at(src, x0 + 1, y0 + 1) * wx;
+            *pixel(dst, u, v) = (uint8_t)(top * (1 - wy) + bottom * wy);
+        }
+    }
+}
+
+double ref_laplacian_var_y8(const img_buf_t *src)
+{
+    double sum = 0, sum_sq = 0;
+    for (int y = 1; y < src->height - 1; y++) {
+        for (int x = 1; x < src->width - 1; x++) {
+            double lap = (double)*pixel(src, x, y - 1) + *pixel(src, x, y + 1) + *pixel(src, x - 1, y) +
+                         *pixel(src, x + 1, y) - 4.0 * *pixel(src, x, y);
+            sum += lap;
+            sum_sq += lap * lap;
+        }
+    }
+
+    double n = (double)(src->width - 2) * (src->height - 2);
+    double mean = sum / n;
+    return sum_sq / n - mean * mean;
+}
@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "img_kernels.h"
+
+/*
+ * Per-pixel scalar versions of the image kernels: every pixel is bounds checked and computed
+ * from the definition, in floating point where the kernels use fixed point. The tests compare
+ * the kernels against them and the benchmark reports the speedup over them.
+ */
+
+void ref_fill_rect(img_buf_t *dst, int x, int y, int w, int h, uint32_t color);
+void ref_blit(const img_buf_t *src, int sx, int sy, int w, int h, img_buf_t *dst, int dx, int dy);
+void ref_crop(const img_buf_t *src, int x, int y, img_buf_t *dst);
+void ref_resize_nearest(const img_buf_t *src, img_buf_t *dst);
+void ref_resize_bilinear(const img_buf_t *src, img_buf_t *dst);
+void ref_byteswap16(uint16_t *buf, size_t n);
+void ref_rgb565_to_gray(const uint16_t *src, uint8_t *dst, size_t n);
+void ref_rgb565_to_gray_downsample(const img_buf_t *src, int factor, img_buf_t *dst);
+uint32_t ref_box_sum_y8(const img_buf_t *src, int x, int y, int w, int h);
+void ref_rgb565_to_gray_affine(const img_buf_t *src, const float m[6], img_buf_t *dst);
+double ref_laplacian_var_y8(const img_buf_t *src);
+
+/* Channel values of an RGB565 pixel, expanded to 8 bits as the kernels do */
+static inline int ref_r(uint16_t p)
+{
+    return ((p >> 11) & 0x1F) << 3;
+}
+
+static inline int ref_g(uint16_t p)
+{
+    return ((p >> 5) & 0x3F) << 2;
+}
+
+static inline int ref_b(uint16_t p)
+{
+    return (p & 0x1F) << 3;
+}
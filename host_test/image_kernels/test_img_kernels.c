@@ -0,0 +1,412 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "img_kernels.h"
+#include "img_kernels_ref.h"
+
+/*
+ * Every kernel against its scalar reference, on random images with padded rows, at odd sizes
+ * and unaligned addresses, with rectangles partly or fully outside the images.
+ */
+
+#define TEST_ROUNDS             (200)
+#define ROW_PADDING             (6)     /* Bytes after every row, must stay untouched */
+
+#define MIN(a, b)               ((a) < (b) ? (a) : (b))
+#define MAX(a, b)               ((a) > (b) ? (a) : (b))
+
+static int s_failures;
+static uint32_t s_seed = 1;
+
+#define CHECK(cond, ...) do {                                               \
+        if (!(cond)) {                                                      \
+            s_failures++;                                                   \
+            printf("FAIL %s:%d: ", __func__, __LINE__);                     \
+            printf(__VA_ARGS__);                                            \
+            printf("\n");                                                   \
+            return;                                                         \
+        }                                                                   \
+    } while (0)
+
+static uint32_t rnd(void)
+{
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed;
+}
+
+static int rnd_range(int lo, int hi)
+{
+    return lo + (int)(rnd() % (uint32_t)(hi - lo + 1));
+}
+
+/*
+ * An image with padded rows whose first pixel sits `offset` bytes past an aligned address, so
+ * the wide paths of the kernels start on their per-pixel heads.
+ */
+typedef struct {
+    uint8_t *block;
+    size_t size;
+    img_buf_t img;
+} test_img_t;
+
+static void test_img_alloc(test_img_t *t, int width, int height, img_fmt_t fmt, int offset)
+{
+    int stride = width * img_fmt_bpp(fmt) + ROW_PADDING;
+    t->size = (size_t)stride * height + offset;
+    t->block = aligned_alloc(16, (t->size + 15) & ~(size_t)15);
+    for (size_t i = 0; i < t->size; i++) {
+        t->block[i] = (uint8_t)rnd();
+    }
+    t->img.data = t->block + offset;
+    t->img.width = width;
+    t->img.height = height;
+    t->img.stride = stride;
+    t->img.fmt = fmt;
+}
+
+/* Same geometry and contents */
+static void test_img_clone(test_img_t *t, const test_img_t *from)
+{
+    *t = *from;
+    t->block = aligned_alloc(16, (t->size + 15) & ~(size_t)15);
+    memcpy(t->block, from->block, t->size);
+    t->img.data = t->block + (from->img.data - from->block);
+}
+
+static void test_img_free(test_img_t *t)
+{
+    free(t->block);
+}
+
+static int fmt_offset(img_fmt_t fmt)
+{
+    return fmt == IMG_FMT_RGB565 ? 2 * rnd_range(0, 3) : rnd_range(0, 7);
+}
+
+static const img_fmt_t s_fmts[] = { IMG_FMT_RGB565, IMG_FMT_RGB888, IMG_FMT_Y8 };
+
+static void test_fill_rect(void)
+{
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        img_fmt_t fmt = s_fmts[round % 3];
+        test_img_t a, b;
+        test_img_alloc(&a, rnd_range(1, 70), rnd_range(1, 20), fmt, fmt_offset(fmt));
+        test_img_clone(&b, &a);
+
+        int x = rnd_range(-20, a.img.width + 5), y = rnd_range(-10, a.img.height + 5);
+        int w = rnd_range(0, a.img.width + 30), h = rnd_range(0, a.img.height + 20);
+        uint32_t color = rnd() & (fmt == IMG_FMT_RGB565 ? 0xFFFF : fmt == IMG_FMT_Y8 ? 0xFF : 0xFFFFFF);
+        img_fill_rect(&a.img, x, y, w, h, color);
+        ref_fill_rect(&b.img, x, y, w, h, color);
+        bool same = memcmp(a.block, b.block, a.size) == 0;
+        test_img_free(&a);
+        test_img_free(&b);
+        CHECK(same, "fmt %d, rect %d,%d %dx%d", fmt, x, y, w, h);
+    }
+}
+
+static void test_fill_span(void)
+{
+    for (int offset = 0; offset < 4; offset++) {
+        for (size_t n = 0; n < 40; n++) {
+            uint16_t buf[48], ref[48];
+            memset(buf, 0xA5, sizeof(buf));
+            memset(ref, 0xA5, sizeof(ref));
+            img_fill_span_rgb565(buf + offset, n, 0x1234);
+            for (size_t i = 0; i < n; i++) {
+                ref[offset + i] = 0x1234;
+            }
+            CHECK(memcmp(buf, ref, sizeof(buf)) == 0, "offset %d, %d pixels", offset, (int)n);
+        }
+    }
+}
+
+static void test_blit(void)
+{
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        img_fmt_t fmt = s_fmts[round % 3];
+        test_img_t src, a, b;
+        test_img_alloc(&src, rnd_range(1, 60), rnd_range(1, 20), fmt, fmt_offset(fmt));
+        test_img_alloc(&a, rnd_range(1, 60), rnd_range(1, 20), fmt, fmt_offset(fmt));
+        test_img_clone(&b, &a);
+
+        int sx = rnd_range(-20, src.img.width), sy = rnd_range(-10, src.img.height);
+        int dx = rnd_range(-20, a.img.width), dy = rnd_range(-10, a.img.height);
+        int w = rnd_range(0, 70), h = rnd_range(0, 25);
+        bool copied = img_blit(&src.img, sx, sy, w, h, &a.img, dx, dy);
+        ref_blit(&src.img, sx, sy, w, h, &b.img, dx, dy);
+        bool same = memcmp(a.block, b.block, a.size) == 0;
+        // Something is copied when the block overlaps both images, in source coordinates
+        int x0 = MAX(sx, MAX(0, sx - dx)), x1 = MIN(sx + w, MIN(src.img.width, sx - dx + a.img.width));
+        int y0 = MAX(sy, MAX(0, sy - dy)), y1 = MIN(sy + h, MIN(src.img.height, sy - dy + a.img.height));
+        bool overlap = x1 > x0 && y1 > y0;
+        test_img_free(&src);
+        test_img_free(&a);
+        test_img_free(&b);
+        CHECK(same, "fmt %d, %d,%d %dx%d to %d,%d", fmt, sx, sy, w, h, dx, dy);
+        CHECK(copied == overlap, "fmt %d, %d,%d %dx%d to %d,%d returned %d", fmt, sx, sy, w, h, dx, dy, copied);
+    }
+
+    test_img_t y8, rgb;
+    test_img_alloc(&y8, 8, 8, IMG_FMT_Y8, 0);
+    test_img_alloc(&rgb, 8, 8, IMG_FMT_RGB565, 0);
+    bool copied = img_blit(&y8.img, 0, 0, 8, 8, &rgb.img, 0, 0);
+    test_img_free(&y8);
+    test_img_free(&rgb);
+    CHECK(!copied, "blit between formats");
+}
+
+static void test_crop(void)
+{
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        img_fmt_t fmt = s_fmts[round % 3];
+        test_img_t src, a, b;
+        test_img_alloc(&src, rnd_range(1, 60), rnd_range(1, 30), fmt, fmt_offset(fmt));
+        test_img_alloc(&a, rnd_range(1, 40), rnd_range(1, 20), fmt, fmt_offset(fmt));
+        test_img_clone(&b, &a);
+
+        int x = rnd_range(-45, src.img.width + 5), y = rnd_range(-25, src.img.height + 5);
+        img_crop(&src.img, x, y, &a.img);
+        ref_crop(&src.img, x, y, &b.img);
+        bool same = memcmp(a.block, b.block, a.size) == 0;
+        test_img_free(&src);
+        test_img_free(&a);
+        test_img_free(&b);
+        CHECK(same, "fmt %d, %d,%d", fmt, x, y);
+    }
+}
+
+static const int s_sizes[][4] = {
+    { 1280, 960, 320, 240 },
+    { 1280, 720, 160, 120 },
+    { 640, 480, 113, 77 },
+    { 100, 100, 100, 100 },
+    { 17, 13, 50, 41 },
+    { 3, 2, 64, 64 },
+    { 1, 1, 7, 5 },
+};
+
+static void test_resize_nearest(void)
+{
+    for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]); i++) {
+        for (int f = 0; f < 3; f++) {
+            test_img_t src, a, b;
+            test_img_alloc(&src, s_sizes[i][0], s_sizes[i][1], s_fmts[f], 0);
+            test_img_alloc(&a, s_sizes[i][2], s_sizes[i][3], s_fmts[f], fmt_offset(s_fmts[f]));
+            test_img_clone(&b, &a);
+
+            img_resize_nearest(&src.img, &a.img);
+            ref_resize_nearest(&src.img, &b.img);
+            bool same = memcmp(a.block, b.block, a.size) == 0;
+            test_img_free(&src);
+            test_img_free(&a);
+            test_img_free(&b);
+            CHECK(same, "fmt %d, %dx%d to %dx%d", s_fmts[f], s_sizes[i][0], s_sizes[i][1], s_sizes[i][2], s_sizes[i][3]);
+        }
+    }
+}
+
+/* Largest difference of any channel, in 8-bit units */
+static int max_channel_diff(const img_buf_t *a, const img_buf_t *b)
+{
+    int max = 0;
+    for (int y = 0; y < a->height; y++) {
+        const uint8_t *pa = a->data + (size_t)y * a->stride;
+        const uint8_t *pb = b->data + (size_t)y * b->stride;
+        for (int x = 0; x < a->width; x++) {
+            int d[3] = { 0 };
+            if (a->fmt == IMG_FMT_RGB565) {
+                uint16_t va = ((const uint16_t *)pa)[x], vb = ((const uint16_t *)pb)[x];
+                d[0] = abs(ref_r(va) - ref_r(vb));
+                d[1] = abs(ref_g(va) - ref_g(vb));
+                d[2] = abs(ref_b(va) - ref_b(vb));
+            } else {
+                for (int c = 0; c < img_fmt_bpp(a->fmt); c++) {
+                    d[c] = abs(pa[x * img_fmt_bpp(a->fmt) + c] - pb[x * img_fmt_bpp(a->fmt) + c]);
+                }
+            }
+            for (int c = 0; c < 3; c++) {
+                if (d[c] > max) {
+                    max = d[c];
+                }
+            }
+        }
+    }
+    return max;
+}
+
+static void test_resize_bilinear(void)
+{
+    for (size_t i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]); i++) {
+        for (int f = 0; f < 3; f++) {
+            test_img_t src, a, b;
+            test_img_alloc(&src, s_sizes[i][0], s_sizes[i][1], s_fmts[f], 0);
+            test_img_alloc(&a, s_sizes[i][2], s_sizes[i][3], s_fmts[f], fmt_offset(s_fmts[f]));
+            test_img_clone(&b, &a);
+
+            img_resize_bilinear(&src.img, &a.img);
+            ref_resize_bilinear(&src.img, &b.img);
+            // 8-bit weights and two truncations against exact weights, on noise: a few levels,
+            // or one step of a 5-bit channel
+            int diff = max_channel_diff(&a.img, &b.img);
+            int limit = s_fmts[f] == IMG_FMT_RGB565 ? 8 : 3;
+            test_img_free(&src);
+            test_img_free(&a);
+            test_img_free(&b);
+            CHECK(diff <= limit, "fmt %d, %dx%d to %dx%d: off by %d", s_fmts[f],
+                  s_sizes[i][0], s_sizes[i][1], s_sizes[i][2], s_sizes[i][3], diff);
+        }
+    }
+}
+
+static void test_byteswap16(void)
+{
+    for (int offset = 0; offset < 4; offset++) {
+        for (size_t n = 0; n < 40; n++) {
+            uint16_t buf[48], ref[48];
+            for (int i = 0; i < 48; i++) {
+                buf[i] = ref[i] = (uint16_t)rnd();
+            }
+            img_byteswap16(buf + offset, n);
+            ref_byteswap16(ref + offset, n);
+            CHECK(memcmp(buf, ref, sizeof(buf)) == 0, "offset %d, %d pixels", offset, (int)n);
+        }
+    }
+}
+
+static void test_rgb565_to_gray(void)
+{
+    // Every RGB565 value
+    static uint16_t src[65536];
+    static uint8_t a[65536], b[65536];
+    for (int i = 0; i < 65536; i++) {
+        src[i] = (uint16_t)i;
+    }
+    img_rgb565_to_gray(src, a, 65536);
+    ref_rgb565_to_gray(src, b, 65536);
+    for (int i = 0; i < 65536; i++) {
+        CHECK(abs(a[i] - b[i]) <= 2, "0x%04X: %d, reference %d", i, a[i], b[i]);
+    }
+
+    for (size_t n = 0; n < 9; n++) {
+        uint8_t out[10];
+        memset(out, 0xEE, sizeof(out));
+        img_rgb565_to_gray(src + 0x1234, out, n);
+        CHECK(out[n] == 0xEE, "%d pixels written past the end", (int)n);
+    }
+}
+
+static void test_rgb565_to_gray_downsample(void)
+{
+    for (int factor = 1; factor <= 8; factor++) {
+        test_img_t src, a, b;
+        test_img_alloc(&src, rnd_range(8, 90), rnd_range(8, 40), IMG_FMT_RGB565, fmt_offset(IMG_FMT_RGB565));
+        test_img_alloc(&a, src.img.width / factor, src.img.height / factor, IMG_FMT_Y8, 0);
+        test_img_clone(&b, &a);
+
+        bool ok = img_rgb565_to_gray_downsample(&src.img, factor, &a.img);
+        ref_rgb565_to_gray_downsample(&src.img, factor, &b.img);
+        int diff = max_channel_diff(&a.img, &b.img);
+        test_img_free(&src);
+        test_img_free(&a);
+        test_img_free(&b);
+        CHECK(ok && diff <= 2, "factor %d: off by %d", factor, diff);
+    }
+
+    test_img_t src, dst;
+    test_img_alloc(&src, 16, 16, IMG_FMT_RGB565, 0);
+    test_img_alloc(&dst, 5, 5, IMG_FMT_Y8, 0);
+    bool ok = img_rgb565_to_gray_downsample(&src.img, 4, &dst.img);
+    test_img_free(&src);
+    test_img_free(&dst);
+    CHECK(!ok, "destination larger than the source allows");
+}
+
+static void test_box_sum_y8(void)
+{
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        test_img_t src;
+        test_img_alloc(&src, rnd_range(1, 80), rnd_range(1, 30), IMG_FMT_Y8, fmt_offset(IMG_FMT_Y8));
+        int x = rnd_range(-20, src.img.width + 5), y = rnd_range(-10, src.img.height + 5);
+        int w = rnd_range(0, 100), h = rnd_range(0, 40);
+        uint32_t sum = img_box_sum_y8(&src.img, x, y, w, h);
+        uint32_t ref = ref_box_sum_y8(&src.img, x, y, w, h);
+        test_img_free(&src);
+        CHECK(sum == ref, "%d,%d %dx%d: %u, reference %u", x, y, w, h, (unsigned)sum, (unsigned)ref);
+    }
+}
+
+static void test_rgb565_to_gray_affine(void)
+{
+    for (int round = 0; round < 50; round++) {
+        test_img_t src, a, b;
+        test_img_alloc(&src, rnd_range(20, 120), rnd_range(20, 90), IMG_FMT_RGB565, fmt_offset(IMG_FMT_RGB565));
+        test_img_alloc(&a, 112, 112, IMG_FMT_Y8, 0);
+        test_img_clone(&b, &a);
+
+        // Rotated, scaled face crop, partly outside the frame
+        float angle = (float)rnd_range(-45, 45) * 3.14159265f / 180.0f;
+        float scale = (float)rnd_range(30, 150) / 100.0f;
+        float m[6] = {
+            scale * cosf(angle), -scale * sinf(angle), (float)rnd_range(-30, src.img.width),
+            scale * sinf(angle), scale * cosf(angle), (float)rnd_range(-30, src.img.height),
+        };
+        img_rgb565_to_gray_affine(&src.img, m, &a.img);
+        ref_rgb565_to_gray_affine(&src.img, m, &b.img);
+        int diff = max_channel_diff(&a.img, &b.img);
+        test_img_free(&src);
+        test_img_free(&a);
+        test_img_free(&b);
+        // 16.16 coordinates, 8-bit weights and luma: within a few levels
+        CHECK(diff <= 4, "angle %.2f, scale %.2f: off by %d", angle, scale, diff);
+    }
+}
+
+static void test_laplacian_var_y8(void)
+{
+    for (int round = 0; round < 50; round++) {
+        test_img_t src;
+        test_img_alloc(&src, rnd_range(3, 160), rnd_range(3, 120), IMG_FMT_Y8, fmt_offset(IMG_FMT_Y8));
+        // Smooth some rows so the variance is not always that of noise
+        for (int y = 0; y < src.img.height; y += 2) {
+            memset(src.img.data + (size_t)y * src.img.stride, rnd_range(0, 255), src.img.width);
+        }
+        uint32_t var = img_laplacian_var_y8(&src.img);
+        double ref = ref_laplacian_var_y8(&src.img);
+        test_img_free(&src);
+        // Integer mean: off by up to twice the mean, which is small
+        CHECK(fabs(var - ref) <= ref * 0.01 + 4, "%u, reference %.1f", (unsigned)var, ref);
+    }
+}
+
+int main(void)
+{
+    test_fill_span();
+    test_fill_rect();
+    test_blit();
+    test_crop();
+    test_resize_nearest();
+    test_resize_bilinear();
+    test_byteswap16();
+    test_rgb565_to_gray();
+    test_rgb565_to_gray_downsample();
+    test_box_sum_y8();
+    test_rgb565_to_gray_affine();
+    test_laplacian_var_y8();
+
+    if (s_failures) {
+        printf("%d failures\n", s_failures);
+        return 1;
+    }
+    printf("All image kernel tests passed\n");
+    return 0;
+}
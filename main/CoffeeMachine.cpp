@@ -3,9 +3,20 @@
 #include "bsp/esp-bsp.h"
 #include <math.h>
 #include <string.h>
+#include <strings.h>
 #include "esp_heap_caps.h"
 #include "esp_err.h"
 #include "esp_check.h"
+#include "esp_timer.h"
+#include "img_kernels.h"
+#include "CoffeeMachine_styles.hpp"
+#if CONFIG_APP_DISP_BENCHMARK_LVGL_DEMO
+#include "demos/lv_demos.h"
+#endif
+#if CONFIG_APP_TOUCH_IRQ_ENABLE || CONFIG_APP_TOUCH_LOG
+#include "bsp/touch.h"
+#include "display/app_touch.h"
+#endif
 
 extern "C" {
     
@@ -25,6 +36,52 @@ LV_IMG_DECLARE(making_finish);
 LV_IMG_DECLARE(preference);
 
 
+static const lv_img_dsc_t *screen_img(const lv_img_dsc_t *img)
+{
+#if CONFIG_APP_DRAW_PPA_ENABLE
+    // 全屏背景放到 PPA 可读的内存, 由 PPA 直接拷贝
+    return app_draw_ppa_dma_img(img);
+#else
+    return img;
+#endif
+}
+
+// 文字未变时不重设, 避免无谓的重绘
+static void set_label_text(lv_obj_t *label, const char *text)
+{
+    if (strcmp(lv_label_get_text(label), text) != 0) {
+        lv_label_set_text(label, text);
+    }
+}
+
+// 浮层隐藏时暂停动画, 重新显示时从第一帧播放
+static void set_anim_running(app_anim_handle_t anim, bool running)
+{
+    if (!anim) {
+        return;
+    }
+#if CONFIG_APP_ANIM_LOG
+    // 每单动画结束时输出一次动画和渲染的开销
+    app_anim_stats_t stats;
+    app_ui_perf_stats_t perf;
+    app_anim_get_stats(anim, &stats, true);
+    app_ui_perf_get_stats(&perf, true);
+    if (!running && stats.frames > 0 && stats.run_us > 0) {
+        float seconds = stats.run_us / 1e6f;
+        ESP_LOGI(TAG, "Brewing animation (%s): %d frames in %.1f s, %.1f fps, %d late frames skipped, "
+                 "step %d us (max %d), LVGL task %.2f ms/s, %d px invalidated/frame; "
+                 "LVGL %.1f refreshes/s, render %d us/refresh, %d px/refresh",
+                 stats.cached ? "frame cache" : "live GIF", (int)stats.frames, seconds, stats.frames / seconds,
+                 (int)stats.skipped, (int)(stats.step_us / stats.frames), (int)stats.max_step_us,
+                 stats.step_us / 1000.0f / seconds, (int)(stats.dirty_px / stats.frames),
+                 perf.refreshes * 1e6f / perf.elapsed_us, perf.renders ? (int)(perf.render_us / perf.renders) : 0,
+                 perf.refreshes ? (int)(perf.refresh_px / perf.refreshes) : 0);
+    }
+#endif
+    app_anim_set_running(anim, running);
+}
+
+
 static void grid_button_event_cb(lv_event_t * e);
 static void overlay_timer_cb(lv_timer_t * t);
 static void settings_button_event_cb(lv_event_t * e);
@@ -38,15 +95,64 @@ static void face_name_save_btn_cb(lv_event_t * e);
 static void face_name_cancel_btn_cb(lv_event_t * e);
 static void slider_event_cb(lv_event_t * e);
 static void textarea_event_cb(lv_event_t * e);
-static void face_action_timer_cb(lv_timer_t * t);
+static void face_event_timer_cb(lv_timer_t * t);
 static void face_list_back_btn_cb(lv_event_t * e);
 static void face_delete_btn_cb(lv_event_t * e);
-static void face_list_refresh_timer_cb(lv_timer_t * t);
-static void face_list_back_timer_cb(lv_timer_t * t);
+static lv_obj_t *build_main_screen(void *user_data);
+static lv_obj_t *build_overlay(void *user_data);
+static lv_obj_t *build_settings_screen(void *user_data);
+static lv_obj_t *build_camera_screen(void *user_data);
+static lv_obj_t *build_face_name_screen(void *user_data);
+static lv_obj_t *build_face_list_screen(void *user_data);
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE
+static void presence_timer_cb(lv_timer_t * t);
+#endif
+#if CONFIG_BREW_LINK_ENABLE
+static void brew_link_event_cb(const brew_link_event_t *event, void *user_data);
+static void brew_event_timer_cb(lv_timer_t * t);
+#endif
+#if CONFIG_APP_FB_SYNC_LOG
+static void fb_sync_log_timer_cb(lv_timer_t * t);
+#endif
+#if CONFIG_APP_INPUT_LATENCY_LOG
+static void input_latency_log_timer_cb(lv_timer_t * t);
+#endif
+#if CONFIG_APP_TOUCH_LOG
+static void touch_log_timer_cb(lv_timer_t * t);
+#endif
+#if CONFIG_APP_IMG_CACHE_LOG
+static void img_cache_log_timer_cb(lv_timer_t * t);
+#endif
+
+
+#define FACE_DETECT_STATS_PERIOD_US     (10 * 1000 * 1000)
+#define UI_PERF_STATS_PERIOD_US         (10 * 1000 * 1000)
+#define FACE_EVENT_TIMER_PERIOD_MS      (50)
+#define PRESENCE_TIMER_PERIOD_MS        (200)
+#define BREW_EVENT_TIMER_PERIOD_MS      (50)
+#define BREW_EVENT_QUEUE_LEN            (16)
+#define BREW_RECIPE_PROFILE             (0xFF)
+#define FACE_GALLERY_COMPACT_MIN_BYTES  (CONFIG_APP_FACE_GALLERY_COMPACT_MIN_KB * 1024)
+#define FACE_GALLERY_BENCHMARK_PATH     "/sdcard/face_bench.log"
+#define LEGACY_NVS_MAX_FACES            (3)
+#define DRAW_BENCHMARK_FRAMES           (20)
+#define DISP_BENCHMARK_DEMO_TIMEOUT_MS  (5 * 60 * 1000)
+#define OVERLAY_GIF_PATH                "A:/mp4/3.gif"
+#define OVERLAY_GIF_ASSET               "gif_making.gif"
+#define FACE_LIST_ROW_HEIGHT            (110)
+#define FACE_LIST_ROW_GAP               (10)
+#define FACE_LIST_SCAN_PAGE             (64)
+#define FACE_LIST_SCAN_PERIOD_MS        (10)
 
 
-static volatile bool g_face_recognition_active = false;
-static volatile bool g_face_detected_waiting = false;
+struct LegacyFaceData {
+    char name[32];
+    float feature[128];
+    bool is_used;
+    int coffee_ratio;
+    int water_ratio;
+    int milk_ratio;
+};
 
 
 static int find_button_index(CoffeeMachine *machine, lv_obj_t *target_btn)
@@ -80,6 +186,7 @@ static void grid_button_event_cb(lv_event_t * e)
             machine->showCameraScreen();
         } else {
             
+            machine->_recognized_face_id = 0;
             machine->showOverlayForIndex(idx);
         }
     }
@@ -92,34 +199,24 @@ static void overlay_timer_cb(lv_timer_t * t)
     
     if (machine->current_stage == CoffeeMachine::MakingStage::GIF_PLAYING) {
         
+        // 已连接制作控制器时由进度事件驱动
+        if (machine->_brew_link) {
+            return;
+        }
+        
         machine->overlay_seconds++;
         
         
         char buf[32];
         snprintf(buf, sizeof(buf), "%d", 5 - machine->overlay_seconds);
         if (machine->overlay_count_label) {
-            lv_label_set_text(machine->overlay_count_label, buf);
+            set_label_text(machine->overlay_count_label, buf);
         }
         
         
         if (machine->overlay_seconds >= 5) {
             ESP_LOGI(TAG, "Making finished, showing completion screen");
-            
-            
-            if (machine->gif_obj) {
-                lv_obj_add_flag(machine->gif_obj, LV_OBJ_FLAG_HIDDEN);
-            }
-            if (machine->finish_img_obj) {
-                lv_obj_clear_flag(machine->finish_img_obj, LV_OBJ_FLAG_HIDDEN);
-            }
-            
-            
-            if (machine->overlay_count_label) {
-                lv_obj_add_flag(machine->overlay_count_label, LV_OBJ_FLAG_HIDDEN);
-            }
-            
-            machine->current_stage = CoffeeMachine::MakingStage::SHOWING_FINISH;
-            machine->overlay_seconds = 0;  
+            machine->showMakingFinished(true);
         }
     } else if (machine->current_stage == CoffeeMachine::MakingStage::SHOWING_FINISH) {
         
@@ -127,7 +224,15 @@ static void overlay_timer_cb(lv_timer_t * t)
         
         
         if (machine->overlay_seconds >= 2) {
+            
+            if (machine->startNextQueuedOrder()) {
+                return;
+            }
+            
             ESP_LOGI(TAG, "Finish screen timeout, returning to main screen");
+            if (machine->getCameraState() == CameraState::BREWING_SCAN) {
+                machine->stopCameraStream();
+            }
             machine->cleanup_overlay();
             machine->showMainScreen();
         }
@@ -152,39 +257,22 @@ static void back_button_event_cb(lv_event_t * e)
     }
 }
 
-static void face_action_timer_cb(lv_timer_t * t)
-{
-    CoffeeMachine *machine = (CoffeeMachine *)t->user_data;
-    if (!machine || !machine->_pending_face_action) {
-        return;
-    }
-    
-    ESP_LOGI(TAG, "Face action timer: processing recognized face");
-    
-    
-    lv_timer_del(machine->_face_action_timer);
-    machine->_face_action_timer = nullptr;
-    machine->_pending_face_action = false;
-    
-    
-    machine->closeCameraScreen();
-    
-    
-    machine->showOverlayForIndex(0);
-    
-    ESP_LOGI(TAG, "Face action completed: coffee making started");
-}
-
 CoffeeMachine::CoffeeMachine()
 {
     ESP_LOGI(TAG, "CoffeeMachine constructor called");
     
     
     overlay_screen = nullptr;
+    overlay_active = false;
     overlay_btn_label = nullptr;
     overlay_count_label = nullptr;
+    overlay_next_label = nullptr;
     overlay_timer = nullptr;
     overlay_seconds = 0;
+    _brew_link = nullptr;
+    _brew_events = nullptr;
+    _brew_event_timer = nullptr;
+    _brew_order_id = 0;
     
     for (int i = 0; i < 8; i++) {
         grid_buttons[i] = nullptr;
@@ -192,6 +280,7 @@ CoffeeMachine::CoffeeMachine()
     
     current_stage = MakingStage::GIF_PLAYING;
     gif_obj = nullptr;
+    _brew_anim = nullptr;
     finish_img_obj = nullptr;
     making_bg_img = nullptr;
     
@@ -206,6 +295,18 @@ CoffeeMachine::CoffeeMachine()
     for (int i = 0; i < 3; i++) {
         camera_buttons[i] = nullptr;
     }
+    _detect_overlay = nullptr;
+    _video_plane = nullptr;
+    _fb_sync_log_timer = nullptr;
+    _input_latency_log_timer = nullptr;
+    _touch_log_timer = nullptr;
+    _img_cache_log_timer = nullptr;
+    _presence = nullptr;
+    _pedestrian_detector = nullptr;
+    _presence_confirming = false;
+    _presence_timer = nullptr;
+    _presence_present = false;
+    _display_dimmed = false;
     _camera_ctlr_handle = -1;
     _camera_running = false;
     _camera_initialized = false;
@@ -216,9 +317,13 @@ CoffeeMachine::CoffeeMachine()
     }
     
     
-    _face_recognition_enabled = false;
+    _camera_state = CameraState::OFF;
+    _face_worker = nullptr;
+    _face_event_timer = nullptr;
+    _faces_lock = xSemaphoreCreateMutex();
     _face_count = 0;
     _face_detector = nullptr;
+    _motion_gate = nullptr;
     _face_name_screen = nullptr;
     _face_name_textarea = nullptr;
     _face_name_keyboard = nullptr;
@@ -229,19 +334,28 @@ CoffeeMachine::CoffeeMachine()
     _water_label = nullptr;
     _milk_label = nullptr;
     _captured_face_buffer = nullptr;
-    _face_action_timer = nullptr;
-    _recognized_face_idx = -1;
-    _pending_face_action = false;
+    _face_feature = nullptr;
+    _face_tracker = nullptr;
+    _gallery = nullptr;
+    _enrolling = false;
+    _enroll_track_id = 0;
+    memset(&_enroll, 0, sizeof(_enroll));
+    memset(_enroll_feature, 0, sizeof(_enroll_feature));
+    _recognized_face_id = 0;
+    _reported_track_id = 0;
+    _next_customer_count = 0;
     
     
     _face_list_screen = nullptr;
-    _face_list_refresh_timer = nullptr;
-    _face_list_back_timer = nullptr;
-    _pending_delete_idx = -1;
-    for (int i = 0; i < MAX_FACES; i++) {
-        _face_list_items[i] = nullptr;
-        _face_delete_btns[i] = nullptr;
-    }
+    _face_list_count_label = nullptr;
+    _face_list_empty_label = nullptr;
+    _face_list_search = nullptr;
+    _face_list_keyboard = nullptr;
+    _face_list_view = nullptr;
+    _face_list_scan_timer = nullptr;
+    _face_list_match_count = 0;
+    _face_list_scanned = false;
+    _face_list_query[0] = '\0';
     
     for (int i = 0; i < MAX_FACES; i++) {
         memset(&_stored_faces[i], 0, sizeof(FaceData));
@@ -252,7 +366,10 @@ CoffeeMachine::CoffeeMachine()
     }
     
     
-    loadFacesFromNVS();
+#if CONFIG_APP_FACE_GALLERY_BENCHMARK
+    app_face_gallery_benchmark(FACE_GALLERY_BENCHMARK_PATH);
+#endif
+    loadFaceGallery();
 }
 
 CoffeeMachine::~CoffeeMachine()
@@ -262,21 +379,37 @@ CoffeeMachine::~CoffeeMachine()
     closeCameraScreen();
     
     
-    if (_face_action_timer) {
-        lv_timer_del(_face_action_timer);
-        _face_action_timer = nullptr;
+    if (_face_event_timer) {
+        lv_timer_del(_face_event_timer);
+        _face_event_timer = nullptr;
+    }
+    
+    
+    delete _face_worker;
+    _face_worker = nullptr;
+    if (_faces_lock) {
+        vSemaphoreDelete(_faces_lock);
+        _faces_lock = nullptr;
     }
     
     
-    if (_face_list_refresh_timer) {
-        lv_timer_del(_face_list_refresh_timer);
-        _face_list_refresh_timer = nullptr;
+    if (_brew_event_timer) {
+        lv_timer_del(_brew_event_timer);
+        _brew_event_timer = nullptr;
+    }
+#if CONFIG_BREW_LINK_ENABLE
+    brew_link_delete(_brew_link);
+    _brew_link = nullptr;
+#endif
+    if (_brew_events) {
+        vQueueDelete(_brew_events);
+        _brew_events = nullptr;
     }
     
     
-    if (_face_list_back_timer) {
-        lv_timer_del(_face_list_back_timer);
-        _face_list_back_timer = nullptr;
+    if (_presence_timer) {
+        lv_timer_del(_presence_timer);
+        _presence_timer = nullptr;
     }
     
     
@@ -288,16 +421,56 @@ CoffeeMachine::~CoffeeMachine()
     }
     
     
+    app_motion_gate_delete(_motion_gate);
+    _motion_gate = nullptr;
+    app_presence_delete(_presence);
+    _presence = nullptr;
+    app_face_feature_delete(_face_feature);
+    _face_feature = nullptr;
+    app_face_tracker_delete(_face_tracker);
+    _face_tracker = nullptr;
+    app_face_gallery_close(_gallery);
+    _gallery = nullptr;
+    
+    
     if (camera_screen) {
+        app_detect_overlay_delete(_detect_overlay);
+        _detect_overlay = nullptr;
         lv_obj_del(camera_screen);
         camera_screen = nullptr;
     }
+    app_video_plane_delete(_video_plane);
+    _video_plane = nullptr;
+    if (_fb_sync_log_timer) {
+        lv_timer_del(_fb_sync_log_timer);
+        _fb_sync_log_timer = nullptr;
+    }
+    if (_input_latency_log_timer) {
+        lv_timer_del(_input_latency_log_timer);
+        _input_latency_log_timer = nullptr;
+    }
+    if (_touch_log_timer) {
+        lv_timer_del(_touch_log_timer);
+        _touch_log_timer = nullptr;
+    }
+    if (_img_cache_log_timer) {
+        lv_timer_del(_img_cache_log_timer);
+        _img_cache_log_timer = nullptr;
+    }
     
     
+    if (_face_list_scan_timer) {
+        lv_timer_del(_face_list_scan_timer);
+        _face_list_scan_timer = nullptr;
+    }
     if (_face_list_screen) {
         lv_obj_del(_face_list_screen);
         _face_list_screen = nullptr;
     }
+    if (overlay_screen) {
+        lv_obj_del(overlay_screen);
+        overlay_screen = nullptr;
+    }
 }
 
 void CoffeeMachine::cleanup_overlay(void)
@@ -309,17 +482,14 @@ void CoffeeMachine::cleanup_overlay(void)
         overlay_timer = nullptr;
     }
     
-    if (overlay_screen) {
-        lv_obj_del(overlay_screen);
-        overlay_screen = nullptr;
-        overlay_btn_label = nullptr;
-        overlay_count_label = nullptr;
-        gif_obj = nullptr;
-        finish_img_obj = nullptr;
-        making_bg_img = nullptr;
+    if (overlay_active) {
+        set_anim_running(_brew_anim, false);
+        lv_obj_add_flag(overlay_screen, LV_OBJ_FLAG_HIDDEN);
+        overlay_active = false;
     }
     
     overlay_seconds = 0;
+    _brew_order_id = 0;
     current_stage = MakingStage::GIF_PLAYING;
 }
 
@@ -341,13 +511,162 @@ bool CoffeeMachine::init(void)
     
     
     main_screen = lv_scr_act();
+    app_ui_perf_init(display);
+    _screens.attach(display);
+#if CONFIG_APP_IMG_JPEG
+    // 主菜单和制作浮层的背景常驻, 其余图片超出预算时按最久未用淘汰
+    app_img_cache_init(CONFIG_APP_IMG_CACHE_KB * 1024);
+    app_img_cache_pin(&img_main_menu, true);
+    app_img_cache_pin(&img_making, true);
+    if (app_img_jpeg_init() != ESP_OK) {
+        ESP_LOGE(TAG, "JPEG images can not be decoded");
+    }
+#if CONFIG_APP_IMG_CACHE_LOG
+    _img_cache_log_timer = lv_timer_create(img_cache_log_timer_cb, UI_PERF_STATS_PERIOD_US / 1000, this);
+#endif
+#endif
+#if CONFIG_APP_ASSET_BUNDLE
+    if (app_asset_fs_init(CONFIG_APP_ASSET_FS_LETTER, CONFIG_APP_ASSET_PARTITION) != ESP_OK) {
+        ESP_LOGW(TAG, "Assets are only read from SPIFFS and the SD card");
+    }
+#endif
+#if CONFIG_APP_DRAW_PPA_ENABLE
+    if (app_draw_ppa_init(display) != ESP_OK) {
+        ESP_LOGW(TAG, "Drawing stays on the CPU");
+    }
+#endif
+#if CONFIG_APP_DRAW_PARALLEL_ENABLE
+    if (app_draw_parallel_init(display) != ESP_OK) {
+        ESP_LOGW(TAG, "Software drawing stays on one core");
+    }
+#endif
+#if CONFIG_APP_FB_SYNC_ENABLE
+    if (app_fb_sync_init(display) == ESP_OK) {
+#if CONFIG_APP_FB_SYNC_LOG
+        _fb_sync_log_timer = lv_timer_create(fb_sync_log_timer_cb, UI_PERF_STATS_PERIOD_US / 1000, this);
+#endif
+    } else {
+        ESP_LOGW(TAG, "Frame buffer sync stays on the CPU");
+    }
+#endif
+#if CONFIG_APP_TOUCH_IRQ_ENABLE || CONFIG_APP_TOUCH_LOG || CONFIG_APP_INPUT_LATENCY_ENABLE
+    lv_indev_t *touch = lv_indev_get_next(NULL);
+    while (touch && lv_indev_get_type(touch) != LV_INDEV_TYPE_POINTER) {
+        touch = lv_indev_get_next(touch);
+    }
+#endif
+#if CONFIG_APP_TOUCH_IRQ_ENABLE || CONFIG_APP_TOUCH_LOG
+    // 须在其他模块串接触摸读回调之前
+    app_touch_config_t touch_cfg = {};
+#if CONFIG_APP_TOUCH_IRQ_ENABLE
+    touch_cfg.irq = true;
+    touch_cfg.queue_len = CONFIG_APP_TOUCH_IRQ_QUEUE_LEN;
+    touch_cfg.read_period_ms = CONFIG_APP_TOUCH_IRQ_READ_PERIOD_MS;
+    touch_cfg.recheck_ms = CONFIG_APP_TOUCH_IRQ_RECHECK_MS;
+#endif
+    if (touch && app_touch_init(touch, bsp_touch_get_handle(), &touch_cfg) == ESP_OK) {
+#if CONFIG_APP_TOUCH_LOG
+        _touch_log_timer = lv_timer_create(touch_log_timer_cb, UI_PERF_STATS_PERIOD_US / 1000, this);
+#endif
+    } else {
+        ESP_LOGW(TAG, "Touch load is not measured");
+    }
+#endif
+#if CONFIG_APP_INPUT_LATENCY_ENABLE
+    if (touch && app_input_latency_init(display, touch) == ESP_OK) {
+#if CONFIG_APP_INPUT_LATENCY_LOG
+        _input_latency_log_timer = lv_timer_create(input_latency_log_timer_cb, UI_PERF_STATS_PERIOD_US / 1000, this);
+#endif
+    } else {
+        ESP_LOGW(TAG, "Touch latency is not measured");
+    }
+#endif
+    
+    
+    _screens.add(ScreenId::MAIN, build_main_screen, this, false);
+    _screens.add(ScreenId::BREWING, build_overlay, this, true);
+    _screens.add(ScreenId::SETTINGS, build_settings_screen, this, true);
+    _screens.add(ScreenId::CAMERA, build_camera_screen, this, false);     // 画布使用相机缓冲, 随相机初始化创建
+    _screens.add(ScreenId::FACE_NAME, build_face_name_screen, this, true);
+    _screens.add(ScreenId::FACE_LIST, build_face_list_screen, this, true);
+    _screens.get(ScreenId::MAIN);
+#if CONFIG_APP_SCREEN_PREBUILD
+    _screens.startIdleBuild(CONFIG_APP_SCREEN_PREBUILD_IDLE_MS);
+#endif
     
     
+    _face_event_timer = lv_timer_create(face_event_timer_cb, FACE_EVENT_TIMER_PERIOD_MS, this);
+    
+    
+#if CONFIG_BREW_LINK_ENABLE
+    _brew_events = xQueueCreate(BREW_EVENT_QUEUE_LEN, sizeof(brew_link_event_t));
+    brew_link_config_t brew_config = BREW_LINK_DEFAULT_CONFIG();
+    if (_brew_events && brew_link_new(&brew_config, brew_link_event_cb, this, &_brew_link) == ESP_OK) {
+        _brew_event_timer = lv_timer_create(brew_event_timer_cb, BREW_EVENT_TIMER_PERIOD_MS, this);
+    } else {
+        ESP_LOGE(TAG, "Failed to start brew link, orders fall back to the timed countdown");
+        _brew_link = nullptr;
+    }
+#endif
+    
+    
+#if CONFIG_APP_DRAW_BENCHMARK
+    runDrawBenchmark();
+#endif
+#if CONFIG_APP_DISP_BENCHMARK
+    runDisplayBenchmark();
+#endif
+#if CONFIG_APP_ASSET_BENCHMARK
+    runAssetBenchmark();
+#endif
+    
+    
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE
+    _presence_timer = lv_timer_create(presence_timer_cb, PRESENCE_TIMER_PERIOD_MS, this);
+    startPresenceMode();
+#endif
+    
+    ESP_LOGI(TAG, "Coffee Machine UI initialized successfully");
+    return true;
+}
+
+static lv_obj_t *build_main_screen(void *user_data)
+{
+    return ((CoffeeMachine *)user_data)->buildMainScreen();
+}
+
+static lv_obj_t *build_overlay(void *user_data)
+{
+    return ((CoffeeMachine *)user_data)->buildOverlay();
+}
+
+static lv_obj_t *build_settings_screen(void *user_data)
+{
+    return ((CoffeeMachine *)user_data)->buildSettingsScreen();
+}
+
+static lv_obj_t *build_camera_screen(void *user_data)
+{
+    return ((CoffeeMachine *)user_data)->buildCameraScreen();
+}
+
+static lv_obj_t *build_face_name_screen(void *user_data)
+{
+    return ((CoffeeMachine *)user_data)->buildFaceNameScreen();
+}
+
+static lv_obj_t *build_face_list_screen(void *user_data)
+{
+    return ((CoffeeMachine *)user_data)->buildFaceListScreen();
+}
+
+lv_obj_t *CoffeeMachine::buildMainScreen(void)
+{
     lv_obj_clear_flag(main_screen, LV_OBJ_FLAG_SCROLLABLE);
     
     
     lv_obj_t *bg_img = lv_img_create(main_screen);
-    lv_img_set_src(bg_img, &img_main_menu);
+    lv_img_set_src(bg_img, screen_img(&img_main_menu));
     lv_obj_set_pos(bg_img, 0, 0);
     lv_obj_move_background(bg_img);
     
@@ -355,10 +674,7 @@ bool CoffeeMachine::init(void)
     lv_obj_t *cont = lv_obj_create(main_screen);
     lv_obj_set_size(cont, _width, _height);
     lv_obj_set_pos(cont, 0, 0);
-    lv_obj_set_style_bg_opa(cont, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(cont, 0, 0);
-    lv_obj_set_style_radius(cont, 0, 0);
-    lv_obj_set_style_pad_all(cont, 0, 0);
+    ui_style_add(cont, UiStyle::HIT_AREA);
     
     
     int top_margin = 80;
@@ -384,9 +700,7 @@ bool CoffeeMachine::init(void)
             grid_buttons[idx] = lv_btn_create(cont);
             lv_obj_set_size(grid_buttons[idx], btn_width, btn_height);
             lv_obj_set_pos(grid_buttons[idx], x, y);
-            lv_obj_set_style_bg_opa(grid_buttons[idx], LV_OPA_TRANSP, 0);
-            lv_obj_set_style_border_width(grid_buttons[idx], 0, 0);
-            lv_obj_set_style_shadow_width(grid_buttons[idx], 0, 0);
+            ui_style_add(grid_buttons[idx], UiStyle::HIT_AREA);
             
             
             lv_obj_add_event_cb(grid_buttons[idx], grid_button_event_cb, LV_EVENT_CLICKED, this);
@@ -402,45 +716,49 @@ bool CoffeeMachine::init(void)
     lv_obj_set_pos(settings_btn, 50, 0);
     
     
-    lv_obj_set_style_bg_opa(settings_btn, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(settings_btn, 0, 0);
-    lv_obj_set_style_shadow_width(settings_btn, 0, 0);
-    lv_obj_set_style_radius(settings_btn, 0, 0);
+    ui_style_add(settings_btn, UiStyle::HIT_AREA);
     
     
     lv_obj_add_event_cb(settings_btn, settings_button_event_cb, LV_EVENT_CLICKED, this);
     
-    ESP_LOGI(TAG, "Coffee Machine UI initialized successfully");
-    return true;
+    return main_screen;
 }
 
-void CoffeeMachine::showOverlayForIndex(int idx)
+lv_obj_t *CoffeeMachine::buildOverlay(void)
 {
-    ESP_LOGI(TAG, "showOverlayForIndex called for button %d", idx);
-    
-    
-    cleanup_overlay();
-    
-    
-    current_stage = MakingStage::GIF_PLAYING;
-    
-    
-    overlay_screen = lv_obj_create(lv_scr_act());
+    // 放在顶层, 在主菜单和相机界面上都可以直接显示
+    overlay_screen = lv_obj_create(lv_layer_top());
     lv_obj_set_size(overlay_screen, _width, _height);
     lv_obj_set_pos(overlay_screen, 0, 0);
     lv_obj_clear_flag(overlay_screen, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(overlay_screen, lv_color_black(), 0);
-    lv_obj_set_style_bg_opa(overlay_screen, LV_OPA_70, 0);
-    lv_obj_set_style_border_width(overlay_screen, 0, 0);
+    ui_style_add(overlay_screen, UiStyle::DIM_LAYER);
+    lv_obj_add_flag(overlay_screen, LV_OBJ_FLAG_HIDDEN);
     
     
     making_bg_img = lv_img_create(overlay_screen);
-    lv_img_set_src(making_bg_img, &img_making);
+    lv_img_set_src(making_bg_img, screen_img(&img_making));
     lv_obj_center(making_bg_img);
     
     
-    gif_obj = lv_gif_create(overlay_screen);
-    lv_gif_set_src(gif_obj, "A:/mp4/3.gif");
+    const void *gif_src = OVERLAY_GIF_PATH;
+#if CONFIG_APP_ASSET_BUNDLE
+    // 从资源包映射的 flash 直接解码制作动画, 没有资源包时从 SD 卡读取
+    const lv_img_dsc_t *gif_img = app_asset_fs_img(OVERLAY_GIF_ASSET);
+    if (gif_img) {
+        gif_src = gif_img;
+    }
+#endif
+    // 由 LVGL 定时器分片解码全部帧到 PSRAM, 放不下时仍由 lv_gif 边播边解码
+    app_anim_config_t anim_cfg = {};
+#if CONFIG_APP_ANIM_CACHE
+    anim_cfg.cache_max_bytes = CONFIG_APP_ANIM_CACHE_KB * 1024;
+#endif
+    if (app_anim_create(overlay_screen, gif_src, &anim_cfg, &_brew_anim) == ESP_OK) {
+        gif_obj = app_anim_get_obj(_brew_anim);
+    } else {
+        ESP_LOGE(TAG, "No brewing animation");
+        gif_obj = lv_img_create(overlay_screen);
+    }
     lv_obj_set_size(gif_obj, 400, 400);
     lv_obj_align(gif_obj, LV_ALIGN_CENTER, 0, -50);
     
@@ -452,532 +770,1613 @@ void CoffeeMachine::showOverlayForIndex(int idx)
     
     
     overlay_count_label = lv_label_create(overlay_screen);
-    lv_label_set_text(overlay_count_label, "5");
-    lv_obj_set_style_text_font(overlay_count_label, &lv_font_montserrat_48, 0);
-    lv_obj_set_style_text_color(overlay_count_label, lv_color_hex(0xFFFFFF), 0);
+    ui_style_add(overlay_count_label, UiStyle::TEXT_COUNTDOWN);
     lv_obj_align(overlay_count_label, LV_ALIGN_CENTER, 0, 80);
     
     
-    overlay_seconds = 0;
-    overlay_timer = lv_timer_create(overlay_timer_cb, 1000, this);
+    overlay_next_label = lv_label_create(overlay_screen);
+    ui_style_add(overlay_next_label, UiStyle::TEXT_BUTTON);
+    lv_obj_align(overlay_next_label, LV_ALIGN_BOTTOM_MID, 0, -30);
+    lv_obj_add_flag(overlay_next_label, LV_OBJ_FLAG_HIDDEN);
     
-    ESP_LOGI(TAG, "Coffee %d is making", idx + 1);
+    return overlay_screen;
 }
 
-void CoffeeMachine::showSettingsScreen(void)
+void CoffeeMachine::showOverlayForIndex(int idx)
 {
-    ESP_LOGI(TAG, "Showing settings screen");
+    ESP_LOGI(TAG, "showOverlayForIndex called for button %d", idx);
+    int64_t start_us = esp_timer_get_time();
     
     
     cleanup_overlay();
-    
-    
-    if (!settings_screen) {
-        settings_screen = lv_obj_create(NULL);
-        lv_obj_clear_flag(settings_screen, LV_OBJ_FLAG_SCROLLABLE);
-        lv_obj_set_style_bg_color(settings_screen, lv_color_hex(0x000000), 0);
-        
-        
-        lv_obj_t *preference_img = lv_img_create(settings_screen);
-        lv_img_set_src(preference_img, &preference);
-        lv_obj_set_pos(preference_img, 0, 0);
-        
-        
-        back_btn = lv_btn_create(settings_screen);
-        lv_obj_set_size(back_btn, 100, 80);  
-        lv_obj_set_pos(back_btn, 50, 0);
-        
-        
-        lv_obj_set_style_bg_opa(back_btn, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(back_btn, 0, 0);
-        lv_obj_set_style_shadow_width(back_btn, 0, 0);
-        lv_obj_set_style_radius(back_btn, 0, 0);
-        
-        lv_obj_add_event_cb(back_btn, back_button_event_cb, LV_EVENT_CLICKED, this);
+    stopPresenceMode();
+    if (!startBrewingScan()) {
+        stopCameraStream();
     }
+    setDisplayDimmed(false);
     
     
-    lv_scr_load(settings_screen);
-}
-
-void CoffeeMachine::showMainScreen(void)
-{
-    ESP_LOGI(TAG, "Showing main screen");
+    current_stage = MakingStage::GIF_PLAYING;
     
     
-    cleanup_overlay();
+    // 浮层常驻, 只恢复上一单改动过的控件
+    _screens.get(ScreenId::BREWING);
+    lv_obj_clear_flag(gif_obj, LV_OBJ_FLAG_HIDDEN);
+    set_anim_running(_brew_anim, true);
+    lv_obj_add_flag(finish_img_obj, LV_OBJ_FLAG_HIDDEN);
+    set_label_text(overlay_count_label, _brew_link ? "0%" : "5");
+    lv_obj_clear_flag(overlay_count_label, LV_OBJ_FLAG_HIDDEN);
+    updateNextCustomerLabel();
+    lv_obj_clear_flag(overlay_screen, LV_OBJ_FLAG_HIDDEN);
+    overlay_active = true;
     
     
-    if (main_screen) {
-        lv_scr_load(main_screen);
-    }
+    overlay_seconds = 0;
+    overlay_timer = lv_timer_create(overlay_timer_cb, 1000, this);
+    submitBrewOrder(idx);
+    _screens.shown(ScreenId::BREWING, start_us);
+    
+    ESP_LOGI(TAG, "Coffee %d is making", idx + 1);
 }
 
-static CoffeeMachine *g_camera_machine = nullptr;
-static volatile bool g_camera_callback_enabled = false;
-
-static void camera_init_task(void *param)
+void CoffeeMachine::submitBrewOrder(int idx)
 {
-    CoffeeMachine *machine = (CoffeeMachine *)param;
-    
-    ESP_LOGI(TAG, "Camera init task: Setting buffers and starting stream");
-    
-    
-    esp_err_t ret = app_video_set_bufs(machine->_camera_ctlr_handle, machine->_cam_buf_count, 
-                                      (const void **)machine->_cam_buffer);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set video buffers: 0x%x", ret);
-        xSemaphoreGive(machine->_camera_init_sem);
-        vTaskDelete(NULL);
+#if CONFIG_BREW_LINK_ENABLE
+    if (!_brew_link) {
         return;
     }
     
-    
-    ret = app_video_stream_task_start(machine->_camera_ctlr_handle, 0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start video stream: 0x%x", ret);
-        xSemaphoreGive(machine->_camera_init_sem);
-        vTaskDelete(NULL);
-        return;
+    brew_order_t order = {};
+    int face_idx = findFaceById(_recognized_face_id);
+    if (face_idx >= 0) {
+        const FaceData &face = _stored_faces[face_idx];
+        order.recipe = BREW_RECIPE_PROFILE;
+        order.coffee_ratio = face.coffee_ratio;
+        order.water_ratio = face.water_ratio;
+        order.milk_ratio = face.milk_ratio;
+        strlcpy(order.name, face.name, sizeof(order.name));
+    } else {
+        order.recipe = idx;
     }
     
-    ESP_LOGI(TAG, "Camera stream started successfully");
-    machine->_camera_running = true;
     
-    xSemaphoreGive(machine->_camera_init_sem);
-    vTaskDelete(NULL);
+    if (brew_link_submit(_brew_link, &order) != ESP_OK) {
+        showMakingFinished(false);
+        return;
+    }
+    _brew_order_id = order.order_id;
+    ESP_LOGI(TAG, "Order %u queued", order.order_id);
+#endif
 }
 
-static void camera_video_frame_callback(uint8_t *camera_buf, uint8_t camera_buf_index, 
-                                       uint32_t camera_buf_hes, uint32_t camera_buf_ves, 
-                                       size_t camera_buf_len)
+void CoffeeMachine::handleBrewEvent(const brew_link_event_t &event)
 {
-    static bool size_logged = false;
-    static int frame_count = 0;
-    
-    
-    if (!g_camera_callback_enabled || !g_camera_machine || !g_camera_machine->camera_canvas) {
+    if (!overlay_active || event.order_id != _brew_order_id || current_stage != MakingStage::GIF_PLAYING) {
         return;
     }
     
-    
-    if (!size_logged) {
-        ESP_LOGI(TAG, "Camera frame callback: %dx%d", camera_buf_hes, camera_buf_ves);
-        size_logged = true;
+    char buf[16];
+    switch (event.type) {
+    case BREW_LINK_EVENT_ACCEPTED:
+        ESP_LOGI(TAG, "Order %u accepted by the controller", event.order_id);
+        break;
+    case BREW_LINK_EVENT_PROGRESS:
+        snprintf(buf, sizeof(buf), "%d%%", event.percent);
+        set_label_text(overlay_count_label, buf);
+        break;
+    case BREW_LINK_EVENT_DONE:
+        ESP_LOGI(TAG, "Order %u finished, showing completion screen", event.order_id);
+        showMakingFinished(true);
+        break;
+    case BREW_LINK_EVENT_FAILED:
+        ESP_LOGW(TAG, "Order %u failed, result %d", event.order_id, event.result);
+        showMakingFinished(false);
+        break;
+    }
+}
+
+void CoffeeMachine::showMakingFinished(bool success)
+{
+    if (gif_obj) {
+        set_anim_running(_brew_anim, false);
+        lv_obj_add_flag(gif_obj, LV_OBJ_FLAG_HIDDEN);
+    }
+    if (success && finish_img_obj) {
+        lv_obj_clear_flag(finish_img_obj, LV_OBJ_FLAG_HIDDEN);
     }
     
     
-    if (g_face_recognition_active && !g_face_detected_waiting && 
-        g_camera_machine->_face_detector && (frame_count++ % 10 == 0)) {
-        
-        
-        auto detect_results = app_humanface_detect((uint16_t *)camera_buf, camera_buf_hes, camera_buf_ves);
-        
-        if (!detect_results.empty()) {
-            ESP_LOGI(TAG, "Face detected!");
-            
-            
-            int recognized_idx = g_camera_machine->recognizeFace(detect_results);
-            
-            if (recognized_idx >= 0) {
-                
-                FaceData &face = g_camera_machine->_stored_faces[recognized_idx];
-                ESP_LOGI(TAG, "Welcome back, %s!", face.name);
-                ESP_LOGI(TAG, "User preferences - Coffee: %d%%, Water: %d%%, Milk: %d%%", 
-                         face.coffee_ratio, face.water_ratio, face.milk_ratio);
-                
-                
-                printf("COFFEE_FOR: %s, COFFEE:%d, WATER:%d, MILK:%d\n", 
-                       face.name, face.coffee_ratio, face.water_ratio, face.milk_ratio);
-                
-                
-                g_face_recognition_active = false;
-                g_camera_machine->_face_recognition_enabled = false;
-                
-                
-                if (!g_camera_machine->_pending_face_action && bsp_display_lock(0)) {
-                    g_camera_machine->_recognized_face_idx = recognized_idx;
-                    g_camera_machine->_pending_face_action = true;
-                    
-                    
-                    g_camera_machine->_face_action_timer = lv_timer_create(face_action_timer_cb, 100, g_camera_machine);
-                    lv_timer_set_repeat_count(g_camera_machine->_face_action_timer, 1);
-                    
-                    ESP_LOGI(TAG, "Face action scheduled via timer");
-                    bsp_display_unlock();
-                }
-                
-                return;  
-            } else if (recognized_idx == -1) {
-                
-                ESP_LOGI(TAG, "Unknown face detected");
-                
-                
-                if (g_camera_machine->_face_count < MAX_FACES) {
-                    g_face_detected_waiting = true;
-                    
-                    
-                    bsp_display_lock(0);
-                    g_camera_machine->showFaceNameScreen();
-                    bsp_display_unlock();
-                    
-                    return;  
-                } else {
-                    ESP_LOGW(TAG, "Face storage full, cannot add new face");
-                    
-                }
-            }
+    if (overlay_count_label) {
+        if (success) {
+            lv_obj_add_flag(overlay_count_label, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_label_set_text(overlay_count_label, "Order failed");
         }
     }
     
+    current_stage = MakingStage::SHOWING_FINISH;
+    overlay_seconds = 0;
+}
+
+lv_obj_t *CoffeeMachine::buildSettingsScreen(void)
+{
+    settings_screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(settings_screen, LV_OBJ_FLAG_SCROLLABLE);
+    ui_style_add(settings_screen, UiStyle::SCREEN_BLACK);
     
-    if (!bsp_display_lock(100)) {
-        return;  
-    }
     
+    lv_obj_t *preference_img = lv_img_create(settings_screen);
+    lv_img_set_src(preference_img, screen_img(&preference));
+    lv_obj_set_pos(preference_img, 0, 0);
     
-    lv_canvas_set_buffer(g_camera_machine->camera_canvas, camera_buf, 
-                       camera_buf_hes, camera_buf_ves, 
-                       LV_IMG_CF_TRUE_COLOR);
     
+    back_btn = lv_btn_create(settings_screen);
+    lv_obj_set_size(back_btn, 100, 80);  
+    lv_obj_set_pos(back_btn, 50, 0);
     
-    lv_refr_now(NULL);
     
-    bsp_display_unlock();
+    ui_style_add(back_btn, UiStyle::HIT_AREA);
+    
+    lv_obj_add_event_cb(back_btn, back_button_event_cb, LV_EVENT_CLICKED, this);
+    return settings_screen;
 }
 
-static void camera_button_event_cb(lv_event_t * e)
+void CoffeeMachine::showSettingsScreen(void)
 {
-    CoffeeMachine *machine = (CoffeeMachine *)lv_event_get_user_data(e);
-    if (!machine) return;
+    ESP_LOGI(TAG, "Showing settings screen");
     
-    lv_obj_t *btn = lv_event_get_target(e);
     
-    for (int i = 0; i < 3; i++) {
-        if (machine->camera_buttons[i] == btn) {
-            ESP_LOGI(TAG, "Camera button %d clicked", i + 1);
-            
-            if (i == 0) {
-                ESP_LOGI(TAG, "Activating face recognition mode");
-                machine->_face_recognition_enabled = true;
-                g_face_recognition_active = true;
-                
-                if (machine->_face_detector == nullptr) {
-                    machine->_face_detector = get_humanface_detect();
-                }
-            }
-            else if (i == 1) {
-                ESP_LOGI(TAG, "Opening face list screen");
-                machine->_face_recognition_enabled = false;
-                g_face_recognition_active = false;
-                machine->showFaceListScreen();
-            }
-            else if (i == 2) {
-                machine->_face_recognition_enabled = false;
-                g_face_recognition_active = false;
-                machine->closeCameraScreen();
-                machine->showMainScreen();
-            }
-            break;
-        }
-    }
+    cleanup_overlay();
+    _screens.show(ScreenId::SETTINGS);
 }
 
-void CoffeeMachine::showCameraScreen(void)
+void CoffeeMachine::runDrawBenchmark(void)
 {
-    ESP_LOGI(TAG, "Showing camera screen");
+    showSettingsScreen();
     
     
-    cleanup_overlay();
+    struct {
+        const char *name;
+        lv_obj_t *screen;
+        bool overlay;
+    } cases[] = {
+        {"main menu", main_screen, false},
+        {"brewing", main_screen, true},
+        {"settings", settings_screen, false},
+    };
     
+    // 依次: 单核软件渲染, 双核软件渲染, PPA + 双核
+    const char *modes[] = {"1 core", "2 cores", "PPA"};
     
-    if (!_camera_initialized) {
-        ESP_LOGI(TAG, "Initializing camera hardware...");
-        
-        i2c_master_bus_handle_t i2c_bus_handle = bsp_i2c_get_handle();
-        esp_err_t ret = app_video_main(i2c_bus_handle);
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Camera init failed with error 0x%x", ret);
-            return;
-        }
+    for (auto &c : cases) {
+        lv_scr_load(c.screen);
         
-        _camera_ctlr_handle = app_video_open((char*)EXAMPLE_CAM_DEV_PATH, APP_VIDEO_FMT_RGB565);
-        if (_camera_ctlr_handle < 0) {
-            ESP_LOGE(TAG, "Camera open failed");
-            return;
-        }
         
+        lv_obj_t *overlay = c.overlay ? createBenchmarkOverlay(c.screen) : nullptr;
         
-        struct v4l2_format format;
-        memset(&format, 0, sizeof(format));
-        format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         
-        if (ioctl(_camera_ctlr_handle, VIDIOC_G_FMT, &format) == 0) {
-            ESP_LOGI(TAG, "Camera native resolution: %dx%d", 
-                     format.fmt.pix.width, format.fmt.pix.height);
+        int render_us[3] = {0};
+        for (int mode = 0; mode < 3; mode++) {
+#if CONFIG_APP_DRAW_PARALLEL_ENABLE
+            app_draw_parallel_set_enabled(mode >= 1);
+#endif
+#if CONFIG_APP_DRAW_PPA_ENABLE
+            app_draw_ppa_set_enabled(mode == 2);
+#endif
+            lv_obj_invalidate(c.screen);
+            lv_refr_now(NULL);
+            
+            app_ui_perf_stats_t perf;
+            app_ui_perf_get_stats(&perf, true);
+            for (int i = 0; i < DRAW_BENCHMARK_FRAMES; i++) {
+                lv_obj_invalidate(c.screen);
+                lv_refr_now(NULL);
+            }
+            app_ui_perf_get_stats(&perf, true);
+            render_us[mode] = perf.renders ? (int)(perf.render_us / perf.renders) : 0;
         }
         
+        ESP_LOGI(TAG, "Render %s: %s %d us, %s %d us, %s %d us", c.name,
+                 modes[0], render_us[0], modes[1], render_us[1], modes[2], render_us[2]);
         
-        uint32_t cam_width = format.fmt.pix.width ? format.fmt.pix.width : 1280;
-        uint32_t cam_height = format.fmt.pix.height ? format.fmt.pix.height : 960;
-
-        
-        size_t data_cache_line_size = 0;
-        ESP_ERROR_CHECK(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &data_cache_line_size));
-
-        size_t single_buf_size = cam_width * cam_height * BSP_LCD_BITS_PER_PIXEL / 8;
-        bool alloc_ok = false;
-        int try_max = EXAMPLE_CAM_BUF_NUM;
-        for (int fb = try_max; fb >= 2; fb--) {
-            bool ok = true;
-            for (int i = 0; i < fb; i++) {
-                _cam_buffer[i] = (uint8_t *)heap_caps_aligned_alloc(data_cache_line_size, single_buf_size, MALLOC_CAP_SPIRAM);
-                _cam_buffer_size[i] = single_buf_size;
-                if (_cam_buffer[i] == NULL) {
-                    ok = false;
-                    break;
-                }
-            }
+        if (overlay) {
+            lv_obj_del(overlay);
+        }
+    }
+    
+    
+#if CONFIG_APP_DRAW_PARALLEL_ENABLE
+    app_draw_parallel_set_enabled(camera_state_draw_parallel_allowed(getCameraState()));
+#endif
+#if CONFIG_APP_DRAW_PPA_ENABLE
+    app_draw_ppa_set_enabled(true);
+#endif
+    lv_scr_load(main_screen);
+}
 
-            if (ok) {
-                _cam_buf_count = fb;
-                alloc_ok = true;
-                break;
-            }
+lv_obj_t *CoffeeMachine::createBenchmarkOverlay(lv_obj_t *screen)
+{
+    // 与 showOverlayForIndex 相同的暗色层和背景图, 不含 GIF
+    lv_obj_t *overlay = lv_obj_create(screen);
+    lv_obj_set_size(overlay, _width, _height);
+    lv_obj_set_pos(overlay, 0, 0);
+    ui_style_add(overlay, UiStyle::DIM_LAYER);
+    lv_obj_t *img = lv_img_create(overlay);
+    lv_img_set_src(img, screen_img(&img_making));
+    lv_obj_center(img);
+    return overlay;
+}
 
-            
-            for (int j = 0; j < fb; j++) {
-                if (_cam_buffer[j]) {
-                    heap_caps_free(_cam_buffer[j]);
-                    _cam_buffer[j] = NULL;
-                    _cam_buffer_size[j] = 0;
-                }
+#if CONFIG_APP_DISP_BENCHMARK
+void CoffeeMachine::measureFrameTime(lv_obj_t *screen, int *frame_us, int *render_us)
+{
+    lv_obj_invalidate(screen);
+    lv_refr_now(NULL);
+    
+    
+    app_ui_perf_stats_t perf;
+    app_draw_buf_stats_t buf;
+    app_ui_perf_get_stats(&perf, true);
+    app_draw_buf_get_stats(&buf, true);
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < DRAW_BENCHMARK_FRAMES; i++) {
+        lv_obj_invalidate(screen);
+        lv_refr_now(NULL);
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    app_ui_perf_get_stats(&perf, true);
+    app_draw_buf_get_stats(&buf, true);
+    
+    
+    // 直接模式由 app_ui_perf 计时到最后一次 flush; 局部缓冲时去掉等待 PPA 拷贝的时间
+    *frame_us = (int)(elapsed_us / DRAW_BENCHMARK_FRAMES);
+    if (perf.renders) {
+        *render_us = (int)(perf.render_us / perf.renders);
+    } else {
+        *render_us = (int)((elapsed_us - (int64_t)buf.wait_us) / DRAW_BENCHMARK_FRAMES);
+    }
+}
+
+static const struct {
+    const char *name;
+    app_draw_buf_config_t config;
+} s_disp_bench_setups[] = {
+    {"direct, 2 frame buffers", {0, true, true}},
+    {"50 lines PSRAM", {50, true, false}},
+    {"50 lines PSRAM x2", {50, true, true}},
+    {"50 lines SRAM", {50, false, false}},
+    {"50 lines SRAM x2", {50, false, true}},
+    {"100 lines PSRAM", {100, true, false}},
+    {"100 lines PSRAM x2", {100, true, true}},
+    {"100 lines SRAM", {100, false, false}},
+    {"100 lines SRAM x2", {100, false, true}},
+    {"200 lines PSRAM", {200, true, false}},
+    {"200 lines PSRAM x2", {200, true, true}},
+    {"200 lines SRAM", {200, false, false}},
+    {"600 lines PSRAM", {600, true, false}},
+    {"600 lines PSRAM x2", {600, true, true}},
+};
+#endif
+
+#if CONFIG_APP_DISP_BENCHMARK_LVGL_DEMO
+static SemaphoreHandle_t s_bench_demo_done = nullptr;
+
+static void bench_demo_finished_cb(void)
+{
+    xSemaphoreGive(s_bench_demo_done);
+}
+#endif
+
+float CoffeeMachine::runLvglDemoBenchmark(void)
+{
+#if CONFIG_APP_DISP_BENCHMARK_LVGL_DEMO
+    lv_disp_t *display = lv_disp_get_default();
+    if (!s_bench_demo_done) {
+        s_bench_demo_done = xSemaphoreCreateBinary();
+    }
+    
+    
+    lv_obj_t *demo_screen = lv_obj_create(NULL);
+    lv_scr_load(demo_screen);
+    
+    
+    // 演示程序会替换 monitor_cb, 结束后恢复给 app_ui_perf
+    auto monitor_cb = display->driver->monitor_cb;
+    app_ui_perf_stats_t perf;
+    app_draw_buf_stats_t buf;
+    app_ui_perf_get_stats(&perf, true);
+    app_draw_buf_get_stats(&buf, true);
+    int64_t start_us = esp_timer_get_time();
+    lv_demo_benchmark_set_finished_cb(bench_demo_finished_cb);
+    lv_demo_benchmark_set_max_speed(true);
+    lv_demo_benchmark();
+    
+    
+    // 演示由 LVGL 任务驱动, 等待期间释放显示锁
+    bsp_display_unlock();
+    bool finished = xSemaphoreTake(s_bench_demo_done, pdMS_TO_TICKS(DISP_BENCHMARK_DEMO_TIMEOUT_MS)) == pdTRUE;
+    bsp_display_lock(0);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    app_ui_perf_get_stats(&perf, true);
+    app_draw_buf_get_stats(&buf, true);
+    display->driver->monitor_cb = monitor_cb;
+    if (!finished) {
+        ESP_LOGE(TAG, "LVGL benchmark demo did not finish");
+        return -1.0f;
+    }
+    
+    lv_scr_load(main_screen);
+    lv_obj_del(demo_screen);
+    
+    
+    uint32_t frames = perf.renders ? perf.renders : buf.frames;
+    return frames * 1000000.0f / elapsed_us;
+#else
+    return 0.0f;
+#endif
+}
+
+void CoffeeMachine::runDisplayBenchmark(void)
+{
+#if CONFIG_APP_DISP_BENCHMARK
+    lv_disp_t *display = lv_disp_get_default();
+    showSettingsScreen();
+    
+    
+    struct {
+        const char *name;
+        lv_obj_t *screen;
+        bool overlay;
+    } cases[] = {
+        {"main menu", main_screen, false},
+        {"brewing", main_screen, true},
+        {"settings", settings_screen, false},
+    };
+    
+    ESP_LOGI(TAG, "Display benchmark, frame / render time in us over %d frames, render time without waiting for the panel",
+             DRAW_BENCHMARK_FRAMES);
+    ESP_LOGI(TAG, "%-24s %7s %13s %13s %13s %9s", "setup", "buf KB",
+             cases[0].name, cases[1].name, cases[2].name, "demo fps");
+    
+    for (auto &setup : s_disp_bench_setups) {
+#if CONFIG_APP_FB_SYNC_ENABLE
+        app_fb_sync_wait();
+#endif
+        esp_err_t ret = app_draw_buf_set(display, &setup.config);
+        if (ret != ESP_OK) {
+            ESP_LOGI(TAG, "%-24s %s", setup.name, ret == ESP_ERR_NO_MEM ? "does not fit" : esp_err_to_name(ret));
+            continue;
+        }
+        
+        
+        char results[3][16];
+        for (int i = 0; i < 3; i++) {
+            lv_scr_load(cases[i].screen);
+            lv_obj_t *overlay = cases[i].overlay ? createBenchmarkOverlay(cases[i].screen) : nullptr;
+            int frame_us = 0;
+            int render_us = 0;
+            measureFrameTime(cases[i].screen, &frame_us, &render_us);
+            snprintf(results[i], sizeof(results[i]), "%d/%d", frame_us, render_us);
+            if (overlay) {
+                lv_obj_del(overlay);
             }
         }
+        
+        float demo_fps = runLvglDemoBenchmark();
+        if (demo_fps < 0) {
+            break;
+        }
+        
+        
+        int lines = setup.config.lines ? setup.config.lines : _height;
+        int buf_kb = _width * lines * (int)sizeof(lv_color_t) * (setup.config.double_buffer ? 2 : 1) / 1024;
+        ESP_LOGI(TAG, "%-24s %7d %13s %13s %13s %9.1f", setup.name, buf_kb,
+                 results[0], results[1], results[2], demo_fps);
+    }
+    
+    
+    app_draw_buf_set(display, nullptr);
+    lv_scr_load(main_screen);
+#endif
+}
 
-        if (!alloc_ok) {
-            ESP_LOGE(TAG, "Failed to allocate camera buffers (tried up to %d). Aborting camera init.", EXAMPLE_CAM_BUF_NUM);
+void CoffeeMachine::runAssetBenchmark(void)
+{
+#if CONFIG_APP_ASSET_BENCHMARK
+    ESP_LOGI(TAG, "Asset benchmark, time in us to read each file from SPIFFS, from the %c: drive and to find it in the mapping, "
+             "then to open each GIF the same three ways", CONFIG_APP_ASSET_FS_LETTER);
+    ESP_LOGI(TAG, "%-24s %7s %9s %9s %9s", "file", "KB", "SPIFFS", "drive", "mapped");
+    
+    const char *name;
+    for (int i = 0; (name = app_asset_fs_file(i)) != nullptr; i++) {
+        const void *data = nullptr;
+        size_t size = 0;
+        int64_t start_us = esp_timer_get_time();
+        app_asset_fs_get(name, &data, &size);
+        int map_us = esp_timer_get_time() - start_us;
+        
+        uint8_t *buf = (uint8_t *)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (!buf) {
+            ESP_LOGI(TAG, "%-24s %7d does not fit", name, (int)(size / 1024));
+            continue;
+        }
+        
+        
+        // SPIFFS 上的同名文件, 整个读入内存
+        char path[96];
+        snprintf(path, sizeof(path), "%s/%s", CONFIG_BSP_SPIFFS_MOUNT_POINT, name);
+        start_us = esp_timer_get_time();
+        FILE *f = fopen(path, "rb");
+        size_t spiffs_size = f ? fread(buf, 1, size, f) : 0;
+        if (f) {
+            fclose(f);
+        }
+        int spiffs_us = esp_timer_get_time() - start_us;
+        
+        snprintf(path, sizeof(path), "%c:/%s", CONFIG_APP_ASSET_FS_LETTER, name);
+        start_us = esp_timer_get_time();
+        lv_fs_file_t file;
+        uint32_t drive_size = 0;
+        if (lv_fs_open(&file, path, LV_FS_MODE_RD) == LV_FS_RES_OK) {
+            lv_fs_read(&file, buf, size, &drive_size);
+            lv_fs_close(&file);
+        }
+        int drive_us = esp_timer_get_time() - start_us;
+        
+        char spiffs_str[16] = "missing";
+        if (spiffs_size == size) {
+            snprintf(spiffs_str, sizeof(spiffs_str), "%d", spiffs_us);
+        }
+        ESP_LOGI(TAG, "%-24s %7d %9s %9d %9d", name, (int)(size / 1024), spiffs_str, drive_us, map_us);
+        
+        
+        // GIF 打开并解码第一帧: SPIFFS 读入内存后解码, 经 LVGL 驱动读取, 直接从映射解码
+        size_t len = strlen(name);
+        if (len > 4 && strcasecmp(name + len - 4, ".gif") == 0) {
+            lv_img_dsc_t spiffs_img = {};
+            spiffs_img.header.cf = LV_IMG_CF_RAW;
+            spiffs_img.data = buf;
+            spiffs_img.data_size = size;
+            lv_obj_t *gif = lv_gif_create(lv_layer_top());
+            lv_obj_add_flag(gif, LV_OBJ_FLAG_HIDDEN);
+            
+            int gif_spiffs_us = -1;
+            if (spiffs_size == size) {
+                start_us = esp_timer_get_time();
+                lv_gif_set_src(gif, &spiffs_img);
+                gif_spiffs_us = spiffs_us + (int)(esp_timer_get_time() - start_us);
+            }
+            start_us = esp_timer_get_time();
+            lv_gif_set_src(gif, path);
+            int gif_drive_us = esp_timer_get_time() - start_us;
+            start_us = esp_timer_get_time();
+            lv_gif_set_src(gif, app_asset_fs_img(name));
+            int gif_map_us = esp_timer_get_time() - start_us;
+            lv_obj_del(gif);
             
-            if (_camera_ctlr_handle >= 0) {
-                close(_camera_ctlr_handle);
-                _camera_ctlr_handle = -1;
+            if (gif_spiffs_us >= 0) {
+                snprintf(spiffs_str, sizeof(spiffs_str), "%d", gif_spiffs_us);
             }
+            ESP_LOGI(TAG, "%-24s %7s %9s %9d %9d", name, "GIF", spiffs_str, gif_drive_us, gif_map_us);
+        }
+        heap_caps_free(buf);
+    }
+#endif
+}
+
+void CoffeeMachine::showMainScreen(void)
+{
+    ESP_LOGI(TAG, "Showing main screen");
+    
+    
+    cleanup_overlay();
+    _screens.show(ScreenId::MAIN);
+    
+    
+    startPresenceMode();
+}
+
+static CoffeeMachine *g_camera_machine = nullptr;
+
+static void camera_init_task(void *param)
+{
+    CoffeeMachine *machine = (CoffeeMachine *)param;
+    
+    ESP_LOGI(TAG, "Camera init task: Setting buffers and starting stream");
+    
+    
+    esp_err_t ret = app_video_set_bufs(machine->_camera_ctlr_handle, machine->_cam_buf_count, 
+                                      (const void **)machine->_cam_buffer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set video buffers: 0x%x", ret);
+        xSemaphoreGive(machine->_camera_init_sem);
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    
+    ret = app_video_stream_task_start(machine->_camera_ctlr_handle, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start video stream: 0x%x", ret);
+        xSemaphoreGive(machine->_camera_init_sem);
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Camera stream started successfully");
+    machine->_camera_running = true;
+    
+    xSemaphoreGive(machine->_camera_init_sem);
+    vTaskDelete(NULL);
+}
+
+static void camera_presence_frame(uint8_t *camera_buf, uint32_t camera_buf_hes, uint32_t camera_buf_ves)
+{
+    app_presence_t *presence = g_camera_machine->_presence;
+    // 行人确认期间识别线程会改写背景, 暂停分析
+    if (!presence || g_camera_machine->_presence_confirming || !app_presence_due(presence)) {
+        return;
+    }
+    
+    app_presence_event_t event = app_presence_feed(presence, (const uint16_t *)camera_buf);
+    
+    if (event == APP_PRESENCE_EVENT_ENTER && g_camera_machine->_pedestrian_detector) {
+        // 行人检测交给识别线程, 由它上报 PRESENCE_ENTER 或撤销
+        g_camera_machine->_presence_confirming = true;
+        if (g_camera_machine->_face_worker->submit(camera_buf, camera_buf_hes * camera_buf_ves * 2)) {
             return;
         }
+        g_camera_machine->_presence_confirming = false;
+    }
+    
+    if (event == APP_PRESENCE_EVENT_ENTER) {
+        ESP_LOGI(TAG, "Presence detected (area %d)", app_presence_get_area(presence));
+        FaceEvent face_event = {FaceEventType::PRESENCE_ENTER, 0, 0, 0.0f};
+        g_camera_machine->_face_worker->post(face_event);
+    } else if (event == APP_PRESENCE_EVENT_LEAVE) {
+        ESP_LOGI(TAG, "Presence left");
+        FaceEvent face_event = {FaceEventType::PRESENCE_LEAVE, 0, 0, 0.0f};
+        g_camera_machine->_face_worker->post(face_event);
+    }
+}
+
+static void camera_brewing_frame(uint8_t *camera_buf, uint32_t camera_buf_hes, uint32_t camera_buf_ves)
+{
+#if CONFIG_APP_BREW_PIPELINE_ENABLE
+    static int64_t last_submit_us = 0;
+    int64_t now = esp_timer_get_time();
+    if (now - last_submit_us < CONFIG_APP_BREW_SCAN_INTERVAL_MS * 1000LL) {
+        return;
+    }
+    
+    
+    if (g_camera_machine->_face_worker->submit(camera_buf, camera_buf_hes * camera_buf_ves * 2)) {
+        last_submit_us = now;
+    }
+    
+    
+    std::list<dl::detect::result_t> results;
+    g_camera_machine->_face_worker->takeDetections(results, nullptr);
+#endif
+}
+
+static void face_event_timer_cb(lv_timer_t * t)
+{
+    CoffeeMachine *machine = (CoffeeMachine *)t->user_data;
+    if (!machine || !machine->_face_worker) return;
+    
+    FaceEvent event;
+    while (machine->_face_worker->receive(&event)) {
+        machine->handleFaceEvent(event);
+    }
+}
+
+#if CONFIG_BREW_LINK_ENABLE
+static void brew_link_event_cb(const brew_link_event_t *event, void *user_data)
+{
+    CoffeeMachine *machine = (CoffeeMachine *)user_data;
+    if (xQueueSend(machine->_brew_events, event, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Brew event queue full, event for order %u dropped", event->order_id);
+    }
+}
+
+static void brew_event_timer_cb(lv_timer_t * t)
+{
+    CoffeeMachine *machine = (CoffeeMachine *)t->user_data;
+    if (!machine || !machine->_brew_events) return;
+    
+    brew_link_event_t event;
+    while (xQueueReceive(machine->_brew_events, &event, 0) == pdTRUE) {
+        machine->handleBrewEvent(event);
+    }
+}
+#endif
 
+#if CONFIG_APP_FB_SYNC_LOG
+static void fb_sync_log_timer_cb(lv_timer_t * t)
+{
+    app_fb_sync_stats_t stats;
+    app_fb_sync_get_stats(&stats, true);
+    if (stats.flips == 0 && stats.cpu_copies == 0) return;
+    
+    ESP_LOGI(TAG, "FB sync: %.1f flips/s, %d areas -> %d DMA rects, %d KB by DMA in %d us/flip "
+             "(LVGL waited %d us), %d areas skipped, %d areas / %d KB by CPU in %d us",
+             stats.flips * 1e6f / stats.elapsed_us, (int)stats.areas, (int)stats.rects,
+             (int)(stats.dma_px * sizeof(lv_color_t) / 1024),
+             stats.flips ? (int)(stats.dma_us / stats.flips) : 0, (int)stats.wait_us,
+             (int)stats.skipped, (int)stats.cpu_copies,
+             (int)(stats.cpu_px * sizeof(lv_color_t) / 1024), (int)stats.cpu_us);
+}
+#endif
+
+#if CONFIG_APP_INPUT_LATENCY_LOG
+static void input_latency_log_timer_cb(lv_timer_t * t)
+{
+    app_input_latency_stats_t stats[APP_INPUT_LATENCY_MAX_SCREENS];
+    int num = app_input_latency_get_stats(stats, true);
+    for (int i = 0; i < num; i++) {
+        const app_input_latency_stats_t &s = stats[i];
+        char hist[160];
+        int len = 0;
+        for (int b = 0; b < APP_INPUT_LATENCY_BUCKETS && len < (int)sizeof(hist); b++) {
+            if (!s.hist[b]) continue;
+            uint32_t limit_ms = app_input_latency_bucket_ms(b);
+            if (limit_ms == UINT32_MAX) {
+                len += snprintf(hist + len, sizeof(hist) - len, " >%d:%d", (int)app_input_latency_bucket_ms(b - 1), (int)s.hist[b]);
+            } else {
+                len += snprintf(hist + len, sizeof(hist) - len, " <=%d:%d", (int)limit_ms, (int)s.hist[b]);
+            }
+        }
         
-        g_camera_machine = this;
-        ESP_ERROR_CHECK(app_video_register_frame_operation_cb(camera_video_frame_callback));
+        ESP_LOGI(TAG, "Touch latency on %s: %d clicks, dispatched in %.1f ms, invalidated in %.1f ms, "
+                 "on screen in %.1f ms (max %.1f), ms histogram%s",
+                 s.screen, (int)s.samples, s.event_us / 1000.0f / s.samples, s.invalidate_us / 1000.0f / s.samples,
+                 s.photon_us / 1000.0f / s.samples, s.max_photon_us / 1000.0f, hist);
+    }
+}
+#endif
 
-        _camera_initialized = true;
-        ESP_LOGI(TAG, "Camera hardware initialized (buffers=%d size=%d)", _cam_buf_count, (int)single_buf_size);
+#if CONFIG_APP_TOUCH_LOG
+static void touch_log_timer_cb(lv_timer_t * t)
+{
+    app_touch_stats_t stats;
+    app_touch_get_stats(&stats, true);
+    float seconds = stats.elapsed_us / 1e6f;
+    
+    if (stats.irq) {
+        ESP_LOGI(TAG, "Touch on interrupt: %d irqs, %.1f I2C reads/s holding the bus %.2f ms/s, "
+                 "reader task %.2f ms/s, LVGL %.1f polls/s in %.2f ms/s, %d reports (%d dropped), "
+                 "irq to LVGL %.1f ms (max %.1f)",
+                 (int)stats.interrupts, stats.reads / seconds, stats.read_us / 1000.0f / seconds,
+                 stats.task_us / 1000.0f / seconds, stats.indev_reads / seconds, stats.indev_us / 1000.0f / seconds,
+                 (int)stats.points, (int)stats.dropped,
+                 stats.points ? stats.queue_us / 1000.0f / stats.points : 0.0f, stats.max_queue_us / 1000.0f);
+    } else {
+        ESP_LOGI(TAG, "Touch polled: %.1f I2C reads/s holding the bus and the LVGL task %.2f ms/s",
+                 stats.reads / seconds, stats.read_us / 1000.0f / seconds);
+    }
+}
+#endif
+
+#if CONFIG_APP_IMG_CACHE_LOG
+static void img_cache_log_timer_cb(lv_timer_t * t)
+{
+    app_img_cache_stats_t stats;
+    app_img_cache_get_stats(&stats, true);
+    if (stats.hits == 0 && stats.misses == 0) return;
+    
+    app_img_jpeg_stats_t jpeg;
+    app_img_jpeg_get_stats(&jpeg);
+    ESP_LOGI(TAG, "Image cache: %d images (%d pinned) in %d of %d KB, peak %d KB, %d hits, %d misses (%.1f%% hits), "
+             "%d evicted (%d KB); %d JPEG decodes since boot in %d ms",
+             (int)stats.images, (int)stats.pinned, (int)(stats.bytes / 1024), (int)(stats.budget / 1024),
+             (int)(stats.peak_bytes / 1024), (int)stats.hits, (int)stats.misses,
+             stats.hits * 100.0f / (stats.hits + stats.misses), (int)stats.evictions,
+             (int)(stats.evicted_bytes / 1024), (int)jpeg.images, (int)(jpeg.decode_us / 1000));
+}
+#endif
+
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE
+static void presence_timer_cb(lv_timer_t * t)
+{
+    CoffeeMachine *machine = (CoffeeMachine *)t->user_data;
+    if (!machine) return;
+    
+    
+    uint32_t inactive_ms = lv_disp_get_inactive_time(NULL);
+    if (inactive_ms < PRESENCE_TIMER_PERIOD_MS) {
+        machine->setDisplayDimmed(false);
+    } else if (!machine->_presence_present && machine->getCameraState() == CameraState::PRESENCE &&
+               inactive_ms >= CONFIG_APP_PRESENCE_IDLE_TIMEOUT_S * 1000) {
+        machine->setDisplayDimmed(true);
+    }
+}
+#endif
+
+static void camera_video_frame_callback(uint8_t *camera_buf, uint8_t camera_buf_index, 
+                                       uint32_t camera_buf_hes, uint32_t camera_buf_ves, 
+                                       size_t camera_buf_len)
+{
+    static bool size_logged = false;
+    static int frame_count = 0;
+    static std::list<dl::detect::result_t> overlay_results;
+    static bool overlay_dirty = false;
+    
+    if (!g_camera_machine) {
+        return;
+    }
+    
+    CameraState state = g_camera_machine->getCameraState();
+    if (state == CameraState::PRESENCE) {
+        camera_presence_frame(camera_buf, camera_buf_hes, camera_buf_ves);
+        return;
+    }
+    
+    if (state == CameraState::BREWING_SCAN) {
+        camera_brewing_frame(camera_buf, camera_buf_hes, camera_buf_ves);
+        return;
+    }
+    
+    if (state == CameraState::OFF || !g_camera_machine->camera_canvas) {
+        return;
+    }
+    
+    
+    if (!size_logged) {
+        ESP_LOGI(TAG, "Camera frame callback: %dx%d", (int)camera_buf_hes, (int)camera_buf_ves);
+        size_logged = true;
+    }
+    
+    
+    if (state == CameraState::SCANNING && g_camera_machine->_face_detector) {
+        bool run_detect;
+        if (g_camera_machine->_enrolling) {
+            run_detect = true;
+        } else if (g_camera_machine->_motion_gate) {
+            run_detect = app_motion_gate_feed(g_camera_machine->_motion_gate, (const uint16_t *)camera_buf);
+        } else {
+            run_detect = (frame_count++ % 10 == 0);
+        }
+        
+        if (run_detect) {
+            g_camera_machine->_face_worker->submit(camera_buf, camera_buf_hes * camera_buf_ves * 2);
+        }
+    }
+    
+    
+    uint32_t detect_us = 0;
+    if (g_camera_machine->_face_worker->takeDetections(overlay_results, &detect_us)) {
+        if (g_camera_machine->_motion_gate) {
+            app_motion_gate_report(g_camera_machine->_motion_gate, !overlay_results.empty(), detect_us);
+        }
+        overlay_dirty = true;
+    }
+    
+    
+    if (g_camera_machine->_motion_gate) {
+        static int64_t stats_time = 0;
+        int64_t now = esp_timer_get_time();
+        if (now - stats_time >= FACE_DETECT_STATS_PERIOD_US) {
+            app_motion_gate_stats_t stats;
+            if (stats_time != 0 && g_camera_machine->getFaceDetectStats(&stats, true) && stats.frames > 0) {
+                ESP_LOGI(TAG, "Face detect gate: %d frames, motion %d%%, %d detections (%.1f/s, %d%% of frames), "
+                         "detect CPU %.1f%%, motion check %d us/frame",
+                         (int)stats.frames, (int)(stats.motion_frames * 100 / stats.frames),
+                         (int)stats.detect_runs, stats.detect_runs * 1e6f / stats.elapsed_us,
+                         (int)(stats.detect_runs * 100 / stats.frames),
+                         stats.detect_time_us * 100.0f / stats.elapsed_us,
+                         (int)(stats.motion_time_us / stats.frames));
+            }
+            stats_time = now;
+        }
+    }
+    
+    
+    if (state != CameraState::SCANNING && !overlay_results.empty()) {
+        overlay_results.clear();
+        overlay_dirty = true;
+    }
+    
+    
+    int64_t show_start = esp_timer_get_time();
+    if (!bsp_display_lock(100)) {
+        return;  
+    }
+    
+    // 切到其它界面后流停止前的最后几帧不能画, 视频平面会直接覆盖帧缓冲
+    if (lv_scr_act() != g_camera_machine->camera_screen) {
+        bsp_display_unlock();
+        return;
     }
     
     
-    if (!camera_screen) {
-        camera_screen = lv_obj_create(NULL);
-        lv_obj_clear_flag(camera_screen, LV_OBJ_FLAG_SCROLLABLE);
-        lv_obj_set_style_bg_color(camera_screen, lv_color_hex(0x000000), 0);
+    app_video_plane_t *plane = g_camera_machine->_video_plane;
+    if (plane) {
+        // 视频平面: PPA 直接写入帧缓冲, LVGL 只在控件变化时自行重绘
+        if (overlay_dirty) {
+            app_video_plane_set_boxes(plane, overlay_results, true);
+            overlay_dirty = false;
+        }
+        app_video_plane_draw(plane, camera_buf, camera_buf_hes, camera_buf_ves);
+    } else {
+        lv_canvas_set_buffer(g_camera_machine->camera_canvas, camera_buf, 
+                           camera_buf_hes, camera_buf_ves, 
+                           LV_IMG_CF_TRUE_COLOR);
+        
+        if (overlay_dirty) {
+            app_detect_overlay_update(g_camera_machine->_detect_overlay, overlay_results, true);
+            overlay_dirty = false;
+        }
+        
         
+        lv_refr_now(NULL);
+    }
+    
+    bsp_display_unlock();
+    app_ui_perf_preview_frame(esp_timer_get_time() - show_start);
+    
+    
+#if CONFIG_APP_UI_PERF_LOG
+    static int64_t perf_time = 0;
+    if (show_start - perf_time >= UI_PERF_STATS_PERIOD_US) {
+        app_ui_perf_stats_t perf;
+        app_ui_perf_get_stats(&perf, true);
+        if (perf_time != 0 && perf.elapsed_us > 0 && perf.preview_frames > 0) {
+            ESP_LOGI(TAG, "Preview (%s): %.1f fps, %d us/frame on screen, LVGL %.1f refreshes/s, "
+                     "%.1f%% CPU, %d px/refresh",
+                     plane ? "video plane" : "canvas",
+                     perf.preview_frames * 1e6f / perf.elapsed_us,
+                     (int)(perf.preview_time_us / perf.preview_frames),
+                     perf.refreshes * 1e6f / perf.elapsed_us,
+                     perf.refresh_time_ms * 1000 * 100.0f / perf.elapsed_us,
+                     perf.refreshes ? (int)(perf.refresh_px / perf.refreshes) : 0);
+        }
+        perf_time = show_start;
+    }
+#endif
+}
+
+static void camera_button_event_cb(lv_event_t * e)
+{
+    CoffeeMachine *machine = (CoffeeMachine *)lv_event_get_user_data(e);
+    if (!machine) return;
+    
+    lv_obj_t *btn = lv_event_get_target(e);
+    
+    for (int i = 0; i < 3; i++) {
+        if (machine->camera_buttons[i] == btn) {
+            ESP_LOGI(TAG, "Camera button %d clicked", i + 1);
+            
+            if (i == 0) {
+                machine->startFaceRecognition();
+            }
+            else if (i == 1) {
+                ESP_LOGI(TAG, "Opening face list screen");
+                machine->closeCameraScreen();
+                machine->showFaceListScreen();
+            }
+            else if (i == 2) {
+                machine->closeCameraScreen();
+                machine->showMainScreen();
+            }
+            break;
+        }
+    }
+}
+
+bool CoffeeMachine::initCamera(void)
+{
+    if (_camera_initialized) {
+        return true;
+    }
+    
+    ESP_LOGI(TAG, "Initializing camera hardware...");
+    
+    i2c_master_bus_handle_t i2c_bus_handle = bsp_i2c_get_handle();
+    esp_err_t ret = app_video_main(i2c_bus_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Camera init failed with error 0x%x", ret);
+        return false;
+    }
+    
+    _camera_ctlr_handle = app_video_open(EXAMPLE_CAM_DEV_PATH, APP_VIDEO_FMT_RGB565);
+    if (_camera_ctlr_handle < 0) {
+        ESP_LOGE(TAG, "Camera open failed");
+        return false;
+    }
+    
+    
+    struct v4l2_format format;
+    memset(&format, 0, sizeof(format));
+    format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    
+    if (ioctl(_camera_ctlr_handle, VIDIOC_G_FMT, &format) == 0) {
+        ESP_LOGI(TAG, "Camera native resolution: %dx%d", 
+                 (int)format.fmt.pix.width, (int)format.fmt.pix.height);
+    }
+    
+    
+    uint32_t cam_width = format.fmt.pix.width ? format.fmt.pix.width : 1280;
+    uint32_t cam_height = format.fmt.pix.height ? format.fmt.pix.height : 960;
+
+    
+    size_t data_cache_line_size = 0;
+    ESP_ERROR_CHECK(esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &data_cache_line_size));
+
+    size_t single_buf_size = cam_width * cam_height * BSP_LCD_BITS_PER_PIXEL / 8;
+    bool alloc_ok = false;
+    int try_max = EXAMPLE_CAM_BUF_NUM;
+    for (int fb = try_max; fb >= 2; fb--) {
+        bool ok = true;
+        for (int i = 0; i < fb; i++) {
+            _cam_buffer[i] = (uint8_t *)heap_caps_aligned_alloc(data_cache_line_size, single_buf_size, MALLOC_CAP_SPIRAM);
+            _cam_buffer_size[i] = single_buf_size;
+            if (_cam_buffer[i] == NULL) {
+                ok = false;
+                break;
+            }
+        }
+
+        if (ok) {
+            _cam_buf_count = fb;
+            alloc_ok = true;
+            break;
+        }
+
         
-        uint32_t cam_width = 1280;
-        uint32_t cam_height = 960;
+        for (int j = 0; j < fb; j++) {
+            if (_cam_buffer[j]) {
+                heap_caps_free(_cam_buffer[j]);
+                _cam_buffer[j] = NULL;
+                _cam_buffer_size[j] = 0;
+            }
+        }
+    }
+
+    if (!alloc_ok) {
+        ESP_LOGE(TAG, "Failed to allocate camera buffers (tried up to %d). Aborting camera init.", EXAMPLE_CAM_BUF_NUM);
         
-        camera_canvas = lv_canvas_create(camera_screen);
-        lv_obj_set_size(camera_canvas, cam_width, cam_height);
-        lv_canvas_set_buffer(camera_canvas, _cam_buffer[0], cam_width, cam_height, LV_IMG_CF_TRUE_COLOR);
+        if (_camera_ctlr_handle >= 0) {
+            close(_camera_ctlr_handle);
+            _camera_ctlr_handle = -1;
+        }
+        return false;
+    }
+
+    
+#if CONFIG_APP_MOTION_GATE_ENABLE
+    app_motion_gate_config_t gate_config = APP_MOTION_GATE_DEFAULT_CONFIG();
+    if (app_motion_gate_new(&gate_config, cam_width, cam_height, &_motion_gate) != ESP_OK) {
+        ESP_LOGW(TAG, "Motion gate unavailable, detecting on a fixed cadence");
+        _motion_gate = nullptr;
+    }
+#endif
+    
+    
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE
+    app_presence_config_t presence_config = APP_PRESENCE_DEFAULT_CONFIG();
+    if (app_presence_new(&presence_config, cam_width, cam_height, &_presence) != ESP_OK) {
+        ESP_LOGW(TAG, "Presence detector unavailable, presence wake disabled");
+        _presence = nullptr;
+    }
+#endif
+    
+    
+    // 模型只在这里加载一次, 视频流线程和识别线程只使用不创建
+    int64_t model_start = esp_timer_get_time();
+    _face_detector = get_humanface_detect();
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE && CONFIG_APP_PRESENCE_PEDESTRIAN_CONFIRM
+    if (_presence) {
+        _pedestrian_detector = get_pedestrian_detect();
+    }
+#endif
+    if (app_face_feature_new(&_face_feature) != ESP_OK) {
+        ESP_LOGW(TAG, "Face feature extractor unavailable, Face ID disabled");
+        _face_feature = nullptr;
+    }
+    app_face_tracker_config_t tracker_config = APP_FACE_TRACKER_DEFAULT_CONFIG();
+    if (app_face_tracker_new(&tracker_config, &_face_tracker) != ESP_OK) {
+        ESP_LOGW(TAG, "Face tracker unavailable, recognizing every detection");
+        _face_tracker = nullptr;
+    }
+    ESP_LOGI(TAG, "Detection models loaded in %d ms", (int)((esp_timer_get_time() - model_start) / 1000));
+    
+    
+    if (_face_worker == nullptr) {
+        _face_worker = new FaceRecognitionWorker(faceFrameHandler, this);
+    }
+    if (!_face_worker->start(cam_width, cam_height)) {
+        ESP_LOGW(TAG, "Face worker unavailable, Face ID disabled");
+    }
+    
+    
+    g_camera_machine = this;
+    ESP_ERROR_CHECK(app_video_register_frame_operation_cb(camera_video_frame_callback));
+
+    _camera_initialized = true;
+    ESP_LOGI(TAG, "Camera hardware initialized (buffers=%d size=%d)", _cam_buf_count, (int)single_buf_size);
+    return true;
+}
+
+bool CoffeeMachine::startCameraStream(void)
+{
+    if (_camera_running) {
+        return true;
+    }
+    if (!_camera_initialized) {
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "Starting camera stream task...");
+    
+    
+    if (_camera_init_sem == NULL) {
+        _camera_init_sem = xSemaphoreCreateBinary();
+        if (_camera_init_sem == NULL) {
+            ESP_LOGE(TAG, "Failed to create camera init semaphore");
+            return false;
+        }
+    }
+    
+    
+    xTaskCreatePinnedToCore(camera_init_task, "Camera Init", 4096, this, 2, NULL, 0);
+    
+    
+    if (xSemaphoreTake(_camera_init_sem, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        ESP_LOGE(TAG, "Camera init task timeout");
+        return false;
+    }
+    
+    vSemaphoreDelete(_camera_init_sem);
+    _camera_init_sem = NULL;
+    
+    ESP_LOGI(TAG, "Camera stream started successfully");
+    return _camera_running;
+}
+
+void CoffeeMachine::stopCameraStream(void)
+{
+    setCameraState(CameraState::OFF);
+    
+    
+    if (_camera_running && _camera_ctlr_handle >= 0) {
+        ESP_LOGI(TAG, "Stopping camera stream...");
+        app_video_stream_task_stop(_camera_ctlr_handle);
+        app_video_stream_wait_stop();
+        _camera_running = false;
+    }
+}
+
+lv_obj_t *CoffeeMachine::buildCameraScreen(void)
+{
+    camera_screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(camera_screen, LV_OBJ_FLAG_SCROLLABLE);
+    ui_style_add(camera_screen, UiStyle::SCREEN_BLACK);
+    
+    
+    uint32_t cam_width = 1280;
+    uint32_t cam_height = 960;
+    
+    camera_canvas = lv_canvas_create(camera_screen);
+    lv_obj_set_size(camera_canvas, cam_width, cam_height);
+    lv_canvas_set_buffer(camera_canvas, _cam_buffer[0], cam_width, cam_height, LV_IMG_CF_TRUE_COLOR);
+    
+    
+    lv_obj_center(camera_canvas);
+    
+    
+    _detect_overlay = app_detect_overlay_create(camera_canvas, cam_width, cam_height);
+    
+    ESP_LOGI(TAG, "Camera canvas: %dx%d (native resolution, center portion displayed on %dx%d screen)", 
+             (int)cam_width, (int)cam_height, _width, _height);
+    
+    const char *button_labels[] = {"Face ID", "Face List", "Back"};
+    
+    int btn_width = 200;
+    int btn_height = 70;
+    int btn_spacing = 40;
+    int total_width = (btn_width * 3) + (btn_spacing * 2);
+    int start_x = (_width - total_width) / 2;
+    int btn_y = _height - btn_height - 20;
+    
+    for (int i = 0; i < 3; i++) {
+        camera_buttons[i] = lv_btn_create(camera_screen);
         
+        int btn_x = start_x + i * (btn_width + btn_spacing);
+        lv_obj_set_size(camera_buttons[i], btn_width, btn_height);
+        lv_obj_set_pos(camera_buttons[i], btn_x, btn_y);
+        ui_style_add(camera_buttons[i], UiStyle::BTN_PRIMARY);
         
-        lv_obj_center(camera_canvas);
         
-        ESP_LOGI(TAG, "Camera canvas: %dx%d (native resolution, center portion displayed on %dx%d screen)", 
-                 cam_width, cam_height, _width, _height);
+        lv_obj_t *label = lv_label_create(camera_buttons[i]);
+        lv_label_set_text(label, button_labels[i]);
+        ui_style_add(label, UiStyle::TEXT_BUTTON);
+        lv_obj_center(label);
         
-        const char *button_labels[] = {"Face ID", "Face List", "Back"};
         
-        int btn_width = 200;
-        int btn_height = 70;
-        int btn_spacing = 40;
-        int total_width = (btn_width * 3) + (btn_spacing * 2);
-        int start_x = (_width - total_width) / 2;
-        int btn_y = _height - btn_height - 20;
+        lv_obj_add_event_cb(camera_buttons[i], camera_button_event_cb, LV_EVENT_CLICKED, this);
         
+        ESP_LOGI(TAG, "Camera button %d created at (%d, %d) size %dx%d", 
+                 i + 1, btn_x, btn_y, btn_width, btn_height);
+    }
+    
+    
+#if CONFIG_APP_VIDEO_PLANE_ENABLE
+    if (app_video_plane_new(lv_disp_get_default(), &_video_plane) == ESP_OK) {
+        lv_obj_update_layout(camera_screen);
+        lv_area_t canvas_area;
+        lv_obj_get_coords(camera_canvas, &canvas_area);
+        app_video_plane_set_window(_video_plane, &canvas_area, 0, 0);
         for (int i = 0; i < 3; i++) {
-            camera_buttons[i] = lv_btn_create(camera_screen);
-            
-            int btn_x = start_x + i * (btn_width + btn_spacing);
-            lv_obj_set_size(camera_buttons[i], btn_width, btn_height);
-            lv_obj_set_pos(camera_buttons[i], btn_x, btn_y);
-            
-            
-            lv_obj_set_style_bg_color(camera_buttons[i], lv_color_hex(0x0080FF), 0);
-            lv_obj_set_style_bg_opa(camera_buttons[i], LV_OPA_COVER, 0);  
-            
-            
-            lv_obj_set_style_radius(camera_buttons[i], 15, 0);
-            
-            
-            lv_obj_set_style_border_width(camera_buttons[i], 2, 0);
-            lv_obj_set_style_border_color(camera_buttons[i], lv_color_hex(0xFFFFFF), 0);
-            lv_obj_set_style_shadow_width(camera_buttons[i], 10, 0);
-            lv_obj_set_style_shadow_color(camera_buttons[i], lv_color_hex(0x000000), 0);
-            lv_obj_set_style_shadow_opa(camera_buttons[i], LV_OPA_30, 0);
-            
-            
-            lv_obj_t *label = lv_label_create(camera_buttons[i]);
-            lv_label_set_text(label, button_labels[i]);
-            lv_obj_set_style_text_color(label, lv_color_hex(0xFFFFFF), 0);
-            lv_obj_set_style_text_font(label, &lv_font_montserrat_20, 0);
-            lv_obj_center(label);
-            
-            
-            lv_obj_add_event_cb(camera_buttons[i], camera_button_event_cb, LV_EVENT_CLICKED, this);
-            
-            ESP_LOGI(TAG, "Camera button %d created at (%d, %d) size %dx%d", 
-                     i + 1, btn_x, btn_y, btn_width, btn_height);
+            app_video_plane_exclude(_video_plane, camera_buttons[i]);
+        }
+        
+        // 画布只占位, 帧和检测框由视频平面绘制
+        lv_obj_set_style_img_opa(camera_canvas, LV_OPA_TRANSP, 0);
+        ESP_LOGI(TAG, "Camera preview uses the video plane");
+    } else {
+        _video_plane = nullptr;
+        ESP_LOGW(TAG, "Video plane unavailable, camera preview uses the LVGL canvas");
+    }
+#endif
+    
+    return camera_screen;
+}
+
+void CoffeeMachine::showCameraScreen(void)
+{
+    ESP_LOGI(TAG, "Showing camera screen");
+    
+    
+    cleanup_overlay();
+    stopPresenceMode();
+    
+    
+    if (!initCamera()) {
+        return;
+    }
+    
+    
+    _screens.show(ScreenId::CAMERA);
+    
+    
+    setCameraState(CameraState::PREVIEW);
+    if (!startCameraStream()) {
+        setCameraState(CameraState::OFF);
+    }
+}
+
+void CoffeeMachine::closeCameraScreen(void)
+{
+    ESP_LOGI(TAG, "Closing camera screen");
+    
+    
+    stopCameraStream();
+}
+
+void CoffeeMachine::startFaceRecognition(void)
+{
+    ESP_LOGI(TAG, "Activating face recognition mode");
+    
+    xSemaphoreTake(_faces_lock, portMAX_DELAY);
+    _enrolling = false;
+    if (_face_tracker) {
+        app_face_tracker_reset(_face_tracker);
+    }
+    xSemaphoreGive(_faces_lock);
+    
+    
+    setCameraState(CameraState::SCANNING);
+}
+
+void CoffeeMachine::stopFaceRecognition(void)
+{
+    CameraState state = getCameraState();
+    if (state == CameraState::SCANNING || state == CameraState::MATCHED || state == CameraState::ENROLL_NAME ||
+        state == CameraState::BREWING_SCAN) {
+        setCameraState(CameraState::PREVIEW);
+    }
+    
+    xSemaphoreTake(_faces_lock, portMAX_DELAY);
+    _enrolling = false;
+    xSemaphoreGive(_faces_lock);
+}
+
+void CoffeeMachine::startPresenceMode(void)
+{
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE
+    if (getCameraState() == CameraState::PRESENCE) {
+        return;
+    }
+    
+    if (!initCamera() || !_presence) {
+        return;
+    }
+    
+    
+    stopFaceRecognition();
+    app_presence_reset(_presence);
+    _presence_present = false;
+    if (!setCameraState(CameraState::PRESENCE)) {
+        return;
+    }
+    if (!startCameraStream()) {
+        setCameraState(CameraState::OFF);
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Presence mode started");
+#endif
+}
+
+void CoffeeMachine::stopPresenceMode(void)
+{
+    if (getCameraState() == CameraState::PRESENCE) {
+        ESP_LOGI(TAG, "Presence mode stopped");
+        setCameraState(CameraState::OFF);
+    }
+}
+
+void CoffeeMachine::handleFaceEvent(const FaceEvent &event)
+{
+    switch (event.type) {
+    case FaceEventType::RECOGNIZED: {
+        CameraState state = getCameraState();
+        int face_idx = findFaceById(event.face_id);
+        if (face_idx < 0) {
+            // 投票期间这张人脸被删除或替换, 重新识别
+            ESP_LOGI(TAG, "Recognized face %u no longer exists (track %d)", (unsigned)event.face_id, event.track_id);
+            if (state == CameraState::MATCHED) {
+                setCameraState(CameraState::PREVIEW);
+                startFaceRecognition();
+            }
+            break;
+        }
+        
+        if (state == CameraState::MATCHED) {
+            ESP_LOGI(TAG, "Welcome back, %s! (track %d, similarity %.2f)", _stored_faces[face_idx].name,
+                     event.track_id, event.similarity);
+            startFaceOrder(face_idx);
+        } else if (state == CameraState::BREWING_SCAN) {
+            queueNextCustomer(event.face_id);
         }
+        break;
     }
     
+    case FaceEventType::UNKNOWN:
+        if (getCameraState() == CameraState::ENROLL_NAME) {
+            showFaceNameScreen();
+        }
+        break;
+    
+    case FaceEventType::LOST:
+        ESP_LOGI(TAG, "Face track %d lost", event.track_id);
+        break;
+    
+    case FaceEventType::PRESENCE_ENTER:
+        _presence_present = true;
+        setDisplayDimmed(false);
+        
+#if CONFIG_APP_PRESENCE_AUTO_FACE_ID
+        if (getCameraState() == CameraState::PRESENCE && lv_scr_act() == main_screen && !overlay_active) {
+            ESP_LOGI(TAG, "Presence wake: starting Face ID");
+            showCameraScreen();
+            startFaceRecognition();
+        }
+#endif
+        break;
+    
+    case FaceEventType::PRESENCE_LEAVE:
+        _presence_present = false;
+        break;
+    }
+}
+
+bool CoffeeMachine::startBrewingScan(void)
+{
+#if CONFIG_APP_BREW_PIPELINE_ENABLE
+    if (!_camera_initialized || !_face_detector || !_face_feature || _face_count == 0) {
+        return false;
+    }
+    
+    xSemaphoreTake(_faces_lock, portMAX_DELAY);
+    _enrolling = false;
+    _reported_track_id = 0;
+    xSemaphoreGive(_faces_lock);
+    if (!setCameraState(CameraState::BREWING_SCAN)) {
+        return false;
+    }
+    if (!startCameraStream()) {
+        setCameraState(CameraState::OFF);
+        return false;
+    }
+    
+    ESP_LOGI(TAG, "Recognizing the next customer every %d ms while brewing", CONFIG_APP_BREW_SCAN_INTERVAL_MS);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void CoffeeMachine::startFaceOrder(int face_idx)
+{
+    FaceData &face = _stored_faces[face_idx];
+    ESP_LOGI(TAG, "User preferences - Coffee: %d%%, Water: %d%%, Milk: %d%%", 
+             face.coffee_ratio, face.water_ratio, face.milk_ratio);
+    
+    
+#if !CONFIG_BREW_LINK_ENABLE
+    printf("COFFEE_FOR: %s, COFFEE:%d, WATER:%d, MILK:%d\n", 
+           face.name, face.coffee_ratio, face.water_ratio, face.milk_ratio);
+#endif
+    
+    _recognized_face_id = face.id;
+    showOverlayForIndex(0);
+    
+    ESP_LOGI(TAG, "Face action completed: coffee making started");
+}
+
+void CoffeeMachine::queueNextCustomer(uint32_t face_id)
+{
+    
+    if (face_id == _recognized_face_id) {
+        return;
+    }
+    for (int i = 0; i < _next_customer_count; i++) {
+        if (_next_customers[i] == face_id) {
+            return;
+        }
+    }
+    
+    const char *name = _stored_faces[findFaceById(face_id)].name;
+    if (_next_customer_count >= BREW_NEXT_QUEUE_LEN) {
+        ESP_LOGW(TAG, "Customer queue full, %s not queued", name);
+        return;
+    }
+    
+    _next_customers[_next_customer_count++] = face_id;
+    ESP_LOGI(TAG, "Next customer queued: %s (%d waiting)", name, _next_customer_count);
+    updateNextCustomerLabel();
+}
+
+bool CoffeeMachine::startNextQueuedOrder(void)
+{
+    while (_next_customer_count > 0) {
+        int face_idx = findFaceById(_next_customers[0]);
+        _next_customer_count--;
+        memmove(&_next_customers[0], &_next_customers[1], _next_customer_count * sizeof(_next_customers[0]));
+        
+        
+        if (face_idx < 0) {
+            continue;
+        }
+        
+        ESP_LOGI(TAG, "Starting queued order for %s (%d still waiting)", _stored_faces[face_idx].name, _next_customer_count);
+        startFaceOrder(face_idx);
+        return true;
+    }
+    
+    _recognized_face_id = 0;
+    return false;
+}
+
+void CoffeeMachine::updateNextCustomerLabel(void)
+{
+    if (!overlay_next_label) {
+        return;
+    }
     
-    lv_scr_load(camera_screen);
+    if (_next_customer_count == 0) {
+        lv_obj_add_flag(overlay_next_label, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
     
+    char buf[160];
+    int len = snprintf(buf, sizeof(buf), "Next:");
+    for (int i = 0; i < _next_customer_count && len < (int)sizeof(buf); i++) {
+        int face_idx = findFaceById(_next_customers[i]);
+        len += snprintf(buf + len, sizeof(buf) - len, "%s %s", i ? "," : "", face_idx >= 0 ? _stored_faces[face_idx].name : "?");
+    }
+    set_label_text(overlay_next_label, buf);
+    lv_obj_clear_flag(overlay_next_label, LV_OBJ_FLAG_HIDDEN);
+}
+
+void CoffeeMachine::setDisplayDimmed(bool dimmed)
+{
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE
+    if (dimmed == _display_dimmed) {
+        return;
+    }
     
-    if (!_camera_running && _camera_initialized) {
-        ESP_LOGI(TAG, "Starting camera stream task...");
-        
-        
-        if (_camera_init_sem == NULL) {
-            _camera_init_sem = xSemaphoreCreateBinary();
-            if (_camera_init_sem == NULL) {
-                ESP_LOGE(TAG, "Failed to create camera init semaphore");
-                return;
-            }
-        }
-        
-        
-        g_camera_callback_enabled = true;
-        
-        
-        xTaskCreatePinnedToCore(camera_init_task, "Camera Init", 4096, this, 2, NULL, 0);
-        
-        
-        if (xSemaphoreTake(_camera_init_sem, pdMS_TO_TICKS(1000)) != pdTRUE) {
-            ESP_LOGE(TAG, "Camera init task timeout");
-            g_camera_callback_enabled = false;
-            return;
-        }
-        
-        vSemaphoreDelete(_camera_init_sem);
-        _camera_init_sem = NULL;
-        
-        ESP_LOGI(TAG, "Camera stream started successfully");
-    } else if (_camera_running) {
-        
-        g_camera_callback_enabled = true;
+    ESP_LOGI(TAG, "Display %s", dimmed ? "dimmed" : "woken up");
+    bsp_display_brightness_set(dimmed ? CONFIG_APP_PRESENCE_IDLE_BRIGHTNESS : 100);
+    _display_dimmed = dimmed;
+#endif
+}
+
+
+
+bool CoffeeMachine::getFaceDetectStats(app_motion_gate_stats_t *stats, bool reset)
+{
+    if (!_motion_gate || !stats) {
+        return false;
     }
+    
+    app_motion_gate_get_stats(_motion_gate, stats, reset);
+    return true;
 }
 
-void CoffeeMachine::closeCameraScreen(void)
+bool CoffeeMachine::loadFaceGallery(void)
 {
-    ESP_LOGI(TAG, "Closing camera screen");
+    const char *paths[] = {CONFIG_APP_FACE_GALLERY_PATH, CONFIG_APP_FACE_GALLERY_FALLBACK_PATH};
+    
+    for (int i = 0; i < 2 && !_gallery; i++) {
+        app_face_gallery_config_t config = {
+            .path = paths[i],
+            .sync_writes = true,
+            .compact_min_bytes = FACE_GALLERY_COMPACT_MIN_BYTES,
+        };
+        if (app_face_gallery_open(&config, &_gallery) != ESP_OK) {
+            ESP_LOGW(TAG, "Face gallery unavailable at %s", paths[i]);
+            _gallery = nullptr;
+        }
+    }
     
+    if (!_gallery) {
+        ESP_LOGE(TAG, "No face gallery, faces will not be remembered");
+        return false;
+    }
     
-    g_camera_callback_enabled = false;
     
+    if (app_face_gallery_count(_gallery) == 0) {
+        migrateFacesFromNVS();
+    }
     
-    if (_camera_running && _camera_ctlr_handle >= 0) {
-        ESP_LOGI(TAG, "Stopping camera stream...");
-        app_video_stream_task_stop(_camera_ctlr_handle);
-        app_video_stream_wait_stop();
-        _camera_running = false;
+    int count = app_face_gallery_count(_gallery);
+    if (count > MAX_FACES) {
+        ESP_LOGW(TAG, "Gallery holds %d faces, only the first %d are used", count, MAX_FACES);
+        count = MAX_FACES;
     }
     
+    _face_count = 0;
+    for (int i = 0; i < count; i++) {
+        const app_face_gallery_record_t *record = app_face_gallery_get(_gallery, i);
+        FaceData &face = _stored_faces[i];
+        
+        face.id = record->id;
+        face.is_used = true;
+        strncpy(face.name, record->name, sizeof(face.name) - 1);
+        face.name[sizeof(face.name) - 1] = '\0';
+        face.coffee_ratio = record->coffee_ratio;
+        face.water_ratio = record->water_ratio;
+        face.milk_ratio = record->milk_ratio;
+        app_face_gallery_dequantize(record, face.feature);
+        _face_count++;
+        
+        ESP_LOGI(TAG, "Loaded face %d: %s (Coffee:%d%%, Water:%d%%, Milk:%d%%)", 
+                 i, face.name, face.coffee_ratio, face.water_ratio, face.milk_ratio);
+    }
     
-    _face_recognition_enabled = false;
-    g_face_recognition_active = false;
+    return true;
 }
 
-
-
-bool CoffeeMachine::loadFacesFromNVS(void)
+bool CoffeeMachine::saveFaceToGallery(int idx)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open("face_storage", NVS_READONLY, &nvs_handle);
-    if (err != ESP_OK) {
-        ESP_LOGI(TAG, "No face data stored yet");
+    if (!_gallery) {
         return false;
     }
     
-    size_t required_size = sizeof(FaceData) * MAX_FACES;
-    err = nvs_get_blob(nvs_handle, "faces", _stored_faces, &required_size);
-    nvs_close(nvs_handle);
+    FaceData &face = _stored_faces[idx];
+    app_face_gallery_record_t record = {};
+    record.id = face.id;
+    strncpy(record.name, face.name, sizeof(record.name) - 1);
+    record.coffee_ratio = face.coffee_ratio;
+    record.water_ratio = face.water_ratio;
+    record.milk_ratio = face.milk_ratio;
+    app_face_gallery_quantize(face.feature, &record);
     
-    if (err == ESP_OK) {
-        _face_count = 0;
-        for (int i = 0; i < MAX_FACES; i++) {
-            if (_stored_faces[i].is_used) {
-                _face_count++;
-                ESP_LOGI(TAG, "Loaded face %d: %s (Coffee:%d%%, Water:%d%%, Milk:%d%%)", 
-                         i, _stored_faces[i].name,
-                         _stored_faces[i].coffee_ratio,
-                         _stored_faces[i].water_ratio,
-                         _stored_faces[i].milk_ratio);
-            }
-        }
-        return true;
+    if (app_face_gallery_put(_gallery, &record) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save face data");
+        return false;
     }
     
-    return false;
+    face.id = record.id;
+    ESP_LOGI(TAG, "Face %s saved to gallery (id %u)", face.name, (unsigned)face.id);
+    return true;
 }
 
-bool CoffeeMachine::saveFacesToNVS(void)
+bool CoffeeMachine::migrateFacesFromNVS(void)
 {
     nvs_handle_t nvs_handle;
     esp_err_t err = nvs_open("face_storage", NVS_READWRITE, &nvs_handle);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for writing");
         return false;
     }
     
-    err = nvs_set_blob(nvs_handle, "faces", _stored_faces, sizeof(FaceData) * MAX_FACES);
+    LegacyFaceData *legacy = (LegacyFaceData *)heap_caps_calloc(LEGACY_NVS_MAX_FACES, sizeof(LegacyFaceData), MALLOC_CAP_DEFAULT);
+    size_t required_size = sizeof(LegacyFaceData) * LEGACY_NVS_MAX_FACES;
+    err = legacy ? nvs_get_blob(nvs_handle, "faces", legacy, &required_size) : ESP_ERR_NO_MEM;
+    
+    int migrated = 0;
+    int used = 0;
     if (err == ESP_OK) {
-        err = nvs_commit(nvs_handle);
+        for (int i = 0; i < LEGACY_NVS_MAX_FACES; i++) {
+            if (!legacy[i].is_used) {
+                continue;
+            }
+            used++;
+            
+            app_face_gallery_record_t record = {};
+            strncpy(record.name, legacy[i].name, sizeof(record.name) - 1);
+            record.coffee_ratio = legacy[i].coffee_ratio;
+            record.water_ratio = legacy[i].water_ratio;
+            record.milk_ratio = legacy[i].milk_ratio;
+            app_face_gallery_quantize(legacy[i].feature, &record);
+            if (app_face_gallery_put(_gallery, &record) == ESP_OK) {
+                legacy[i].is_used = false;
+                migrated++;
+            }
+        }
+        
+        
+        // 只有全部迁移成功才删除旧数据, 否则只保留失败的条目下次启动重试, 避免重复录入
+        if (migrated == used) {
+            nvs_erase_key(nvs_handle, "faces");
+        } else {
+            ESP_LOGW(TAG, "%d of %d NVS faces not migrated, keeping them for the next boot", used - migrated, used);
+            nvs_set_blob(nvs_handle, "faces", legacy, sizeof(LegacyFaceData) * LEGACY_NVS_MAX_FACES);
+        }
+        nvs_commit(nvs_handle);
+        ESP_LOGI(TAG, "Migrated %d faces from NVS to the gallery", migrated);
     }
     
     nvs_close(nvs_handle);
-    
-    if (err == ESP_OK) {
-        ESP_LOGI(TAG, "Face data saved to NVS");
-        return true;
-    } else {
-        ESP_LOGE(TAG, "Failed to save face data");
-        return false;
+    heap_caps_free(legacy);
+    return migrated > 0;
+}
+
+int CoffeeMachine::findFaceById(uint32_t id) const
+{
+    if (id == 0) {
+        return -1;
     }
+    for (int i = 0; i < MAX_FACES; i++) {
+        if (_stored_faces[i].is_used && _stored_faces[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
 }
 
-int CoffeeMachine::recognizeFace(const std::list<dl::detect::result_t> &results)
+int CoffeeMachine::recognizeFace(const float *feature, float *similarity)
 {
+    int best_idx = -1;
+    float best_similarity = -1.0f;
     
-    
-    
-    if (results.empty()) {
-        return -2;  
+    for (int i = 0; i < MAX_FACES; i++) {
+        if (!_stored_faces[i].is_used) {
+            continue;
+        }
+        
+        float sim = app_face_feature_similarity(feature, _stored_faces[i].feature);
+        if (sim > best_similarity) {
+            best_similarity = sim;
+            best_idx = i;
+        }
     }
     
+    if (similarity) {
+        *similarity = best_similarity;
+    }
     
-    
-    
-    
-    if (_face_count > 0) {
-        
-        for (int i = 0; i < MAX_FACES; i++) {
-            if (_stored_faces[i].is_used) {
-                ESP_LOGI(TAG, "Recognized: %s", _stored_faces[i].name);
-                return i;  
-            }
-        }
+    if (best_idx >= 0 && best_similarity * 100 >= CONFIG_APP_FACE_MATCH_THRESHOLD) {
+        ESP_LOGI(TAG, "Recognized: %s (similarity %.2f)", _stored_faces[best_idx].name, best_similarity);
+        return best_idx;
     }
     
+    if (best_idx >= 0) {
+        ESP_LOGI(TAG, "Closest face %s below threshold (similarity %.2f)", _stored_faces[best_idx].name, best_similarity);
+    }
     return -1;  
 }
 
@@ -988,41 +2387,36 @@ void CoffeeMachine::saveFaceData(const char *name)
     int water_ratio = _water_slider ? lv_slider_get_value(_water_slider) : 50;
     int milk_ratio = _milk_slider ? lv_slider_get_value(_milk_slider) : 50;
     
-    if (_face_count >= MAX_FACES) {
-        ESP_LOGW(TAG, "Face storage full, replacing oldest");
-        
-        for (int i = 0; i < MAX_FACES; i++) {
-            if (_stored_faces[i].is_used) {
-                strncpy(_stored_faces[i].name, name, sizeof(_stored_faces[i].name) - 1);
-                _stored_faces[i].name[sizeof(_stored_faces[i].name) - 1] = '\0';
-                _stored_faces[i].coffee_ratio = coffee_ratio;
-                _stored_faces[i].water_ratio = water_ratio;
-                _stored_faces[i].milk_ratio = milk_ratio;
-                ESP_LOGI(TAG, "Updated face slot %d: %s (Coffee:%d%%, Water:%d%%, Milk:%d%%)", 
-                         i, name, coffee_ratio, water_ratio, milk_ratio);
-                saveFacesToNVS();
-                return;
-            }
-        }
-    } else {
-        
-        for (int i = 0; i < MAX_FACES; i++) {
-            if (!_stored_faces[i].is_used) {
-                _stored_faces[i].is_used = true;
-                strncpy(_stored_faces[i].name, name, sizeof(_stored_faces[i].name) - 1);
-                _stored_faces[i].name[sizeof(_stored_faces[i].name) - 1] = '\0';
-                _stored_faces[i].coffee_ratio = coffee_ratio;
-                _stored_faces[i].water_ratio = water_ratio;
-                _stored_faces[i].milk_ratio = milk_ratio;
-                
-                _face_count++;
-                ESP_LOGI(TAG, "Saved new face in slot %d: %s (Coffee:%d%%, Water:%d%%, Milk:%d%%)", 
-                         i, name, coffee_ratio, water_ratio, milk_ratio);
-                saveFacesToNVS();
+    // 存储已满时识别线程不会开始录入, 这里不替换已有的人脸
+    // 识别线程只读 is_used 的槽位, 先在空槽位里准备好并写入图库, 最后持锁启用
+    for (int i = 0; i < MAX_FACES; i++) {
+        if (!_stored_faces[i].is_used) {
+            _stored_faces[i].id = 0;
+            strncpy(_stored_faces[i].name, name, sizeof(_stored_faces[i].name) - 1);
+            _stored_faces[i].name[sizeof(_stored_faces[i].name) - 1] = '\0';
+            _stored_faces[i].coffee_ratio = coffee_ratio;
+            _stored_faces[i].water_ratio = water_ratio;
+            _stored_faces[i].milk_ratio = milk_ratio;
+            xSemaphoreTake(_faces_lock, portMAX_DELAY);
+            memcpy(_stored_faces[i].feature, _enroll_feature, sizeof(_stored_faces[i].feature));
+            xSemaphoreGive(_faces_lock);
+            
+            // 没有图库 id 的人脸无法被轨迹引用, 保存失败就不录入
+            if (!saveFaceToGallery(i)) {
+                ESP_LOGE(TAG, "Face %s not saved", name);
+                memset(&_stored_faces[i], 0, sizeof(FaceData));
                 return;
             }
+            xSemaphoreTake(_faces_lock, portMAX_DELAY);
+            _stored_faces[i].is_used = true;
+            _face_count++;
+            xSemaphoreGive(_faces_lock);
+            ESP_LOGI(TAG, "Saved new face in slot %d: %s (Coffee:%d%%, Water:%d%%, Milk:%d%%)", 
+                     i, name, coffee_ratio, water_ratio, milk_ratio);
+            return;
         }
     }
+    ESP_LOGW(TAG, "Face storage full, %s not saved", name);
 }
 
 static void face_name_save_btn_cb(lv_event_t * e)
@@ -1093,142 +2487,143 @@ static void textarea_event_cb(lv_event_t * e)
     }
 }
 
+lv_obj_t *CoffeeMachine::buildFaceNameScreen(void)
+{
+    _face_name_screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(_face_name_screen, LV_OBJ_FLAG_SCROLLABLE);
+    ui_style_add(_face_name_screen, UiStyle::SCREEN_DARK);
+    
+    
+    lv_obj_t *title = lv_label_create(_face_name_screen);
+    lv_label_set_text(title, "New Face Setup");
+    ui_style_add(title, UiStyle::TEXT_TITLE);
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 15);
+    
+    
+    _face_name_textarea = lv_textarea_create(_face_name_screen);
+    lv_obj_set_size(_face_name_textarea, 500, 50);
+    lv_obj_align(_face_name_textarea, LV_ALIGN_TOP_MID, 0, 55);
+    lv_textarea_set_placeholder_text(_face_name_textarea, "Enter Name...");
+    lv_textarea_set_max_length(_face_name_textarea, 31);
+    lv_textarea_set_one_line(_face_name_textarea, true);
+    ui_style_add(_face_name_textarea, UiStyle::TEXT_INPUT);
+    
+    // 添加点击事件以显示键盘
+    lv_obj_add_event_cb(_face_name_textarea, textarea_event_cb, LV_EVENT_FOCUSED, this);
+    lv_obj_add_event_cb(_face_name_textarea, textarea_event_cb, LV_EVENT_DEFOCUSED, this);
+    
+    
+    int slider_y = 125;
+    int slider_spacing = 70;
+    int slider_width = 550;
+    int label_x = 80;
+    int slider_x = 200;
+    int value_x = 770;
+    
+    // 咖啡豆滑块
+    lv_obj_t *coffee_title = lv_label_create(_face_name_screen);
+    lv_label_set_text(coffee_title, "Coffee");
+    ui_style_add(coffee_title, UiStyle::TEXT_COFFEE);
+    lv_obj_set_pos(coffee_title, label_x, slider_y);
+    
+    _coffee_slider = lv_slider_create(_face_name_screen);
+    lv_obj_set_size(_coffee_slider, slider_width, 15);
+    lv_obj_set_pos(_coffee_slider, slider_x, slider_y);
+    lv_slider_set_range(_coffee_slider, 0, 100);
+    lv_slider_set_value(_coffee_slider, 50, LV_ANIM_OFF);
+    ui_style_add(_coffee_slider, UiStyle::SLIDER_COFFEE, LV_PART_INDICATOR);
+    lv_obj_add_event_cb(_coffee_slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, this);
+    
+    _coffee_label = lv_label_create(_face_name_screen);
+    lv_label_set_text(_coffee_label, "50%");
+    ui_style_add(_coffee_label, UiStyle::TEXT_BUTTON);
+    lv_obj_set_pos(_coffee_label, value_x, slider_y - 3);
+    
+    // 水滑块
+    lv_obj_t *water_title = lv_label_create(_face_name_screen);
+    lv_label_set_text(water_title, "Water");
+    ui_style_add(water_title, UiStyle::TEXT_WATER);
+    lv_obj_set_pos(water_title, label_x, slider_y + slider_spacing);
+    
+    _water_slider = lv_slider_create(_face_name_screen);
+    lv_obj_set_size(_water_slider, slider_width, 15);
+    lv_obj_set_pos(_water_slider, slider_x, slider_y + slider_spacing);
+    lv_slider_set_range(_water_slider, 0, 100);
+    lv_slider_set_value(_water_slider, 50, LV_ANIM_OFF);
+    ui_style_add(_water_slider, UiStyle::SLIDER_WATER, LV_PART_INDICATOR);
+    lv_obj_add_event_cb(_water_slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, this);
+    
+    _water_label = lv_label_create(_face_name_screen);
+    lv_label_set_text(_water_label, "50%");
+    ui_style_add(_water_label, UiStyle::TEXT_BUTTON);
+    lv_obj_set_pos(_water_label, value_x, slider_y + slider_spacing - 3);
+    
+    // 牛奶滑块
+    lv_obj_t *milk_title = lv_label_create(_face_name_screen);
+    lv_label_set_text(milk_title, "Milk");
+    ui_style_add(milk_title, UiStyle::TEXT_BUTTON);
+    lv_obj_set_pos(milk_title, label_x, slider_y + slider_spacing * 2);
+    
+    _milk_slider = lv_slider_create(_face_name_screen);
+    lv_obj_set_size(_milk_slider, slider_width, 15);
+    lv_obj_set_pos(_milk_slider, slider_x, slider_y + slider_spacing * 2);
+    lv_slider_set_range(_milk_slider, 0, 100);
+    lv_slider_set_value(_milk_slider, 50, LV_ANIM_OFF);
+    ui_style_add(_milk_slider, UiStyle::SLIDER_MILK, LV_PART_INDICATOR);
+    lv_obj_add_event_cb(_milk_slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, this);
+    
+    _milk_label = lv_label_create(_face_name_screen);
+    lv_label_set_text(_milk_label, "50%");
+    ui_style_add(_milk_label, UiStyle::TEXT_BUTTON);
+    lv_obj_set_pos(_milk_label, value_x, slider_y + slider_spacing * 2 - 3);
+    
+    // 添加键盘（默认隐藏）
+    _face_name_keyboard = lv_keyboard_create(_face_name_screen);
+    lv_obj_set_size(_face_name_keyboard, _width, _height / 2);
+    lv_obj_align(_face_name_keyboard, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_keyboard_set_textarea(_face_name_keyboard, _face_name_textarea);
+    lv_obj_add_flag(_face_name_keyboard, LV_OBJ_FLAG_HIDDEN);  // 默认隐藏键盘
+    
+    // 保存和取消按钮
+    lv_obj_t *save_btn = lv_btn_create(_face_name_screen);
+    lv_obj_set_size(save_btn, 180, 60);
+    lv_obj_align(save_btn, LV_ALIGN_BOTTOM_LEFT, 200, -30);
+    ui_style_add(save_btn, UiStyle::BTN_SAVE);
+    
+    lv_obj_t *save_label = lv_label_create(save_btn);
+    lv_label_set_text(save_label, "Save");
+    ui_style_add(save_label, UiStyle::TEXT_BUTTON_LARGE);
+    lv_obj_center(save_label);
+    
+    lv_obj_add_event_cb(save_btn, face_name_save_btn_cb, LV_EVENT_CLICKED, this);
+    
+    
+    lv_obj_t *cancel_btn = lv_btn_create(_face_name_screen);
+    lv_obj_set_size(cancel_btn, 180, 60);
+    lv_obj_align(cancel_btn, LV_ALIGN_BOTTOM_RIGHT, -200, -30);
+    ui_style_add(cancel_btn, UiStyle::BTN_CANCEL);
+    
+    lv_obj_t *cancel_label = lv_label_create(cancel_btn);
+    lv_label_set_text(cancel_label, "Cancel");
+    ui_style_add(cancel_label, UiStyle::TEXT_BUTTON_LARGE);
+    lv_obj_center(cancel_label);
+    
+    lv_obj_add_event_cb(cancel_btn, face_name_cancel_btn_cb, LV_EVENT_CLICKED, this);
+    
+    return _face_name_screen;
+}
+
 void CoffeeMachine::showFaceNameScreen(void)
 {
     ESP_LOGI(TAG, "Showing face name input screen");
     
     
-    if (!_face_name_screen) {
-        _face_name_screen = lv_obj_create(NULL);
-        lv_obj_clear_flag(_face_name_screen, LV_OBJ_FLAG_SCROLLABLE);
-        lv_obj_set_style_bg_color(_face_name_screen, lv_color_hex(0x1a1a1a), 0);
-        
-        
-        lv_obj_t *title = lv_label_create(_face_name_screen);
-        lv_label_set_text(title, "New Face Setup");
-        lv_obj_set_style_text_color(title, lv_color_hex(0xFFFFFF), 0);
-        lv_obj_set_style_text_font(title, &lv_font_montserrat_24, 0);
-        lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 15);
-        
-        
-        _face_name_textarea = lv_textarea_create(_face_name_screen);
-        lv_obj_set_size(_face_name_textarea, 500, 50);
-        lv_obj_align(_face_name_textarea, LV_ALIGN_TOP_MID, 0, 55);
-        lv_textarea_set_placeholder_text(_face_name_textarea, "Enter Name...");
-        lv_textarea_set_max_length(_face_name_textarea, 31);
-        lv_textarea_set_one_line(_face_name_textarea, true);
-        lv_obj_set_style_text_font(_face_name_textarea, &lv_font_montserrat_18, 0);
-        
-        // 添加点击事件以显示键盘
-        lv_obj_add_event_cb(_face_name_textarea, textarea_event_cb, LV_EVENT_FOCUSED, this);
-        lv_obj_add_event_cb(_face_name_textarea, textarea_event_cb, LV_EVENT_DEFOCUSED, this);
-        
-        
-        int slider_y = 125;
-        int slider_spacing = 70;
-        int slider_width = 550;
-        int label_x = 80;
-        int slider_x = 200;
-        int value_x = 770;
-        
-        // 咖啡豆滑块
-        lv_obj_t *coffee_title = lv_label_create(_face_name_screen);
-        lv_label_set_text(coffee_title, "Coffee");
-        lv_obj_set_style_text_color(coffee_title, lv_color_hex(0xFFD700), 0);
-        lv_obj_set_style_text_font(coffee_title, &lv_font_montserrat_20, 0);
-        lv_obj_set_pos(coffee_title, label_x, slider_y);
-        
-        _coffee_slider = lv_slider_create(_face_name_screen);
-        lv_obj_set_size(_coffee_slider, slider_width, 15);
-        lv_obj_set_pos(_coffee_slider, slider_x, slider_y);
-        lv_slider_set_range(_coffee_slider, 0, 100);
-        lv_slider_set_value(_coffee_slider, 50, LV_ANIM_OFF);
-        lv_obj_set_style_bg_color(_coffee_slider, lv_color_hex(0x8B4513), LV_PART_INDICATOR);
-        lv_obj_add_event_cb(_coffee_slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, this);
-        
-        _coffee_label = lv_label_create(_face_name_screen);
-        lv_label_set_text(_coffee_label, "50%");
-        lv_obj_set_style_text_color(_coffee_label, lv_color_hex(0xFFFFFF), 0);
-        lv_obj_set_style_text_font(_coffee_label, &lv_font_montserrat_20, 0);
-        lv_obj_set_pos(_coffee_label, value_x, slider_y - 3);
-        
-        // 水滑块
-        lv_obj_t *water_title = lv_label_create(_face_name_screen);
-        lv_label_set_text(water_title, "Water");
-        lv_obj_set_style_text_color(water_title, lv_color_hex(0x1E90FF), 0);
-        lv_obj_set_style_text_font(water_title, &lv_font_montserrat_20, 0);
-        lv_obj_set_pos(water_title, label_x, slider_y + slider_spacing);
-        
-        _water_slider = lv_slider_create(_face_name_screen);
-        lv_obj_set_size(_water_slider, slider_width, 15);
-        lv_obj_set_pos(_water_slider, slider_x, slider_y + slider_spacing);
-        lv_slider_set_range(_water_slider, 0, 100);
-        lv_slider_set_value(_water_slider, 50, LV_ANIM_OFF);
-        lv_obj_set_style_bg_color(_water_slider, lv_color_hex(0x1E90FF), LV_PART_INDICATOR);
-        lv_obj_add_event_cb(_water_slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, this);
-        
-        _water_label = lv_label_create(_face_name_screen);
-        lv_label_set_text(_water_label, "50%");
-        lv_obj_set_style_text_color(_water_label, lv_color_hex(0xFFFFFF), 0);
-        lv_obj_set_style_text_font(_water_label, &lv_font_montserrat_20, 0);
-        lv_obj_set_pos(_water_label, value_x, slider_y + slider_spacing - 3);
-        
-        // 牛奶滑块
-        lv_obj_t *milk_title = lv_label_create(_face_name_screen);
-        lv_label_set_text(milk_title, "Milk");
-        lv_obj_set_style_text_color(milk_title, lv_color_hex(0xFFFFFF), 0);
-        lv_obj_set_style_text_font(milk_title, &lv_font_montserrat_20, 0);
-        lv_obj_set_pos(milk_title, label_x, slider_y + slider_spacing * 2);
-        
-        _milk_slider = lv_slider_create(_face_name_screen);
-        lv_obj_set_size(_milk_slider, slider_width, 15);
-        lv_obj_set_pos(_milk_slider, slider_x, slider_y + slider_spacing * 2);
-        lv_slider_set_range(_milk_slider, 0, 100);
-        lv_slider_set_value(_milk_slider, 50, LV_ANIM_OFF);
-        lv_obj_set_style_bg_color(_milk_slider, lv_color_hex(0xF5F5DC), LV_PART_INDICATOR);
-        lv_obj_add_event_cb(_milk_slider, slider_event_cb, LV_EVENT_VALUE_CHANGED, this);
-        
-        _milk_label = lv_label_create(_face_name_screen);
-        lv_label_set_text(_milk_label, "50%");
-        lv_obj_set_style_text_color(_milk_label, lv_color_hex(0xFFFFFF), 0);
-        lv_obj_set_style_text_font(_milk_label, &lv_font_montserrat_20, 0);
-        lv_obj_set_pos(_milk_label, value_x, slider_y + slider_spacing * 2 - 3);
-        
-        // 添加键盘（默认隐藏）
-        _face_name_keyboard = lv_keyboard_create(_face_name_screen);
-        lv_obj_set_size(_face_name_keyboard, _width, _height / 2);
-        lv_obj_align(_face_name_keyboard, LV_ALIGN_BOTTOM_MID, 0, 0);
-        lv_keyboard_set_textarea(_face_name_keyboard, _face_name_textarea);
-        lv_obj_add_flag(_face_name_keyboard, LV_OBJ_FLAG_HIDDEN);  // 默认隐藏键盘
-        
-        // 保存和取消按钮
-        lv_obj_t *save_btn = lv_btn_create(_face_name_screen);
-        lv_obj_set_size(save_btn, 180, 60);
-        lv_obj_align(save_btn, LV_ALIGN_BOTTOM_LEFT, 200, -30);
-        lv_obj_set_style_bg_color(save_btn, lv_color_hex(0x00AA00), 0);
-        lv_obj_set_style_radius(save_btn, 12, 0);
-        
-        lv_obj_t *save_label = lv_label_create(save_btn);
-        lv_label_set_text(save_label, "Save");
-        lv_obj_set_style_text_font(save_label, &lv_font_montserrat_22, 0);
-        lv_obj_center(save_label);
-        
-        lv_obj_add_event_cb(save_btn, face_name_save_btn_cb, LV_EVENT_CLICKED, this);
-        
-        
-        lv_obj_t *cancel_btn = lv_btn_create(_face_name_screen);
-        lv_obj_set_size(cancel_btn, 180, 60);
-        lv_obj_align(cancel_btn, LV_ALIGN_BOTTOM_RIGHT, -200, -30);
-        lv_obj_set_style_bg_color(cancel_btn, lv_color_hex(0xCC0000), 0);
-        lv_obj_set_style_radius(cancel_btn, 12, 0);
-        
-        lv_obj_t *cancel_label = lv_label_create(cancel_btn);
-        lv_label_set_text(cancel_label, "Cancel");
-        lv_obj_set_style_text_font(cancel_label, &lv_font_montserrat_22, 0);
-        lv_obj_center(cancel_label);
-        
-        lv_obj_add_event_cb(cancel_btn, face_name_cancel_btn_cb, LV_EVENT_CLICKED, this);
-    }
+    // 离开相机界面, 停止预览 (返回时 showCameraScreen 重新启动)
+    stopCameraStream();
+    
+    
+    // 界面常驻, 只重置输入框、键盘和滑块
+    _screens.get(ScreenId::FACE_NAME);
     
     
     if (_face_name_textarea) {
@@ -1243,19 +2638,19 @@ void CoffeeMachine::showFaceNameScreen(void)
     // 重置滑块值为默认50%
     if (_coffee_slider) {
         lv_slider_set_value(_coffee_slider, 50, LV_ANIM_OFF);
-        lv_label_set_text(_coffee_label, "50%");
+        set_label_text(_coffee_label, "50%");
     }
     if (_water_slider) {
         lv_slider_set_value(_water_slider, 50, LV_ANIM_OFF);
-        lv_label_set_text(_water_label, "50%");
+        set_label_text(_water_label, "50%");
     }
     if (_milk_slider) {
         lv_slider_set_value(_milk_slider, 50, LV_ANIM_OFF);
-        lv_label_set_text(_milk_label, "50%");
+        set_label_text(_milk_label, "50%");
     }
     
     
-    lv_scr_load(_face_name_screen);
+    _screens.show(ScreenId::FACE_NAME);
 }
 
 void CoffeeMachine::closeFaceNameScreen(void)
@@ -1263,266 +2658,319 @@ void CoffeeMachine::closeFaceNameScreen(void)
     ESP_LOGI(TAG, "Closing face name screen");
     
     
-    _face_recognition_enabled = false;
-    g_face_recognition_active = false;
-    g_face_detected_waiting = false;
+    stopFaceRecognition();
 }
 
 
 
-static void face_list_back_timer_cb(lv_timer_t * t)
-{
-    CoffeeMachine *machine = (CoffeeMachine *)t->user_data;
-    if (!machine) return;
-    
-    ESP_LOGI(TAG, "Face list back timer: showing camera and closing face list");
-    
-    
-    lv_timer_del(machine->_face_list_back_timer);
-    machine->_face_list_back_timer = nullptr;
-    
-    
-    machine->showCameraScreen();
-    
-    
-    machine->closeFaceListScreen();
-}
-
 static void face_list_back_btn_cb(lv_event_t * e)
 {
     CoffeeMachine *machine = (CoffeeMachine *)lv_event_get_user_data(e);
     if (machine) {
         ESP_LOGI(TAG, "Face list back button clicked");
-        
-        
-        if (!machine->_face_list_back_timer) {
-            machine->_face_list_back_timer = lv_timer_create(face_list_back_timer_cb, 50, machine);
-            lv_timer_set_repeat_count(machine->_face_list_back_timer, 1);
-        }
+        machine->showCameraScreen();
     }
 }
 
-static void face_list_refresh_timer_cb(lv_timer_t * t)
+static void face_delete_btn_cb(lv_event_t * e)
 {
-    CoffeeMachine *machine = (CoffeeMachine *)t->user_data;
+    CoffeeMachine *machine = (CoffeeMachine *)lv_event_get_user_data(e);
     if (!machine) return;
     
-    ESP_LOGI(TAG, "Face list refresh timer: deleting face and refreshing UI");
     
-    
-    lv_timer_del(machine->_face_list_refresh_timer);
-    machine->_face_list_refresh_timer = nullptr;
-    
-    
-    if (machine->_pending_delete_idx >= 0) {
-        machine->deleteFaceAtIndex(machine->_pending_delete_idx);
-        machine->_pending_delete_idx = -1;
+    int pos = app_list_view_get_index(machine->_face_list_view, lv_event_get_target(e));
+    if (pos < 0 || pos >= machine->_face_list_match_count) {
+        return;
     }
     
+    int idx = machine->_face_list_matches[pos];
+    ESP_LOGI(TAG, "Delete button clicked for face index %d", idx);
     
     
-    machine->showFaceListScreen();
+    // 界面常驻, 只重新绑定可见的行, 可以在按钮自己的事件里直接更新
+    machine->deleteFaceAtIndex(idx);
+    machine->removeFaceListMatch(pos);
 }
 
-static void face_delete_btn_cb(lv_event_t * e)
+static void face_list_search_event_cb(lv_event_t * e)
 {
     CoffeeMachine *machine = (CoffeeMachine *)lv_event_get_user_data(e);
     if (!machine) return;
     
-    lv_obj_t *btn = lv_event_get_target(e);
-    
+    lv_event_code_t code = lv_event_get_code(e);
     
-    for (int i = 0; i < MAX_FACES; i++) {
-        if (machine->_face_delete_btns[i] == btn) {
-            ESP_LOGI(TAG, "Delete button clicked for face index %d", i);
-            
-            
-            machine->_pending_delete_idx = i;
-            
-            
-            if (!machine->_face_list_refresh_timer) {
-                machine->_face_list_refresh_timer = lv_timer_create(face_list_refresh_timer_cb, 50, machine);
-                lv_timer_set_repeat_count(machine->_face_list_refresh_timer, 1);
-            }
-            break;
-        }
+    if (code == LV_EVENT_FOCUSED || code == LV_EVENT_CLICKED) {
+        // 键盘的关闭键会解除绑定, 每次显示时重新绑定
+        lv_keyboard_set_textarea(machine->_face_list_keyboard, machine->_face_list_search);
+        lv_obj_clear_flag(machine->_face_list_keyboard, LV_OBJ_FLAG_HIDDEN);
+    } else if (code == LV_EVENT_READY || code == LV_EVENT_CANCEL) {
+        lv_obj_add_flag(machine->_face_list_keyboard, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_state(machine->_face_list_search, LV_STATE_FOCUSED);
+    } else if (code == LV_EVENT_VALUE_CHANGED) {
+        // 每输入一个字符就重新筛选
+        machine->startFaceListScan();
     }
 }
 
-void CoffeeMachine::showFaceListScreen(void)
+static void face_list_scan_timer_cb(lv_timer_t * t)
 {
-    ESP_LOGI(TAG, "Showing face list screen");
+    CoffeeMachine *machine = (CoffeeMachine *)t->user_data;
+    machine->scanFaceListPage();
+}
+
+// 行的子对象依次为序号、名字、偏好、删除按钮
+static void face_list_create_row(lv_obj_t *row, uint32_t index, void *user_data)
+{
+    ui_style_add(row, UiStyle::LIST_ROW);
     
     
-    bool is_current_screen = (_face_list_screen && lv_scr_act() == _face_list_screen);
+    lv_obj_t *idx_label = lv_label_create(row);
+    lv_label_set_text(idx_label, "");
+    ui_style_add(idx_label, UiStyle::TEXT_INDEX);
+    lv_obj_align(idx_label, LV_ALIGN_LEFT_MID, 10, 0);
     
     
-    if (_face_list_screen && is_current_screen) {
-        
-        lv_obj_t *old_screen = _face_list_screen;
-        _face_list_screen = lv_obj_create(NULL);
-        
-        
-        lv_scr_load(_face_list_screen);
-        
-        
-        lv_obj_del(old_screen);
-    } else if (_face_list_screen) {
-        
+    lv_obj_t *name_label = lv_label_create(row);
+    lv_label_set_text(name_label, "");
+    ui_style_add(name_label, UiStyle::TEXT_TITLE);
+    lv_obj_align(name_label, LV_ALIGN_TOP_LEFT, 60, 10);
+    
+    // 显示偏好设置
+    lv_obj_t *pref_label = lv_label_create(row);
+    lv_label_set_text(pref_label, "");
+    ui_style_add(pref_label, UiStyle::TEXT_DETAIL);
+    lv_obj_align(pref_label, LV_ALIGN_TOP_LEFT, 60, 45);
+    
+    
+    lv_obj_t *delete_btn = lv_btn_create(row);
+    lv_obj_set_size(delete_btn, 120, 60);
+    lv_obj_align(delete_btn, LV_ALIGN_RIGHT_MID, -10, 0);
+    ui_style_add(delete_btn, UiStyle::BTN_DELETE);
+    
+    lv_obj_t *del_label = lv_label_create(delete_btn);
+    lv_label_set_text(del_label, "Delete");
+    ui_style_add(del_label, UiStyle::TEXT_BUTTON);
+    lv_obj_center(del_label);
+    
+    lv_obj_add_event_cb(delete_btn, face_delete_btn_cb, LV_EVENT_CLICKED, user_data);
+}
+
+static void face_list_bind_row(lv_obj_t *row, uint32_t index, void *user_data)
+{
+    CoffeeMachine *machine = (CoffeeMachine *)user_data;
+    const FaceData &face = machine->_stored_faces[machine->_face_list_matches[index]];
+    char buf[64];
+    
+    snprintf(buf, sizeof(buf), "%d", (int)index + 1);
+    set_label_text(lv_obj_get_child(row, 0), buf);
+    set_label_text(lv_obj_get_child(row, 1), face.name);
+    snprintf(buf, sizeof(buf), "C:%d%% W:%d%% M:%d%%", 
+             face.coffee_ratio,
+             face.water_ratio,
+             face.milk_ratio);
+    set_label_text(lv_obj_get_child(row, 2), buf);
+}
+
+lv_obj_t *CoffeeMachine::buildFaceListScreen(void)
+{
+    _face_list_screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(_face_list_screen, LV_OBJ_FLAG_SCROLLABLE);
+    ui_style_add(_face_list_screen, UiStyle::SCREEN_DARK);
+    
+    
+    // 只建可见的几行, 滚动时重新绑定到其他人脸, 打开时间与人脸数无关
+    app_list_view_config_t list_config = {
+        .row_height = FACE_LIST_ROW_HEIGHT,
+        .row_gap = FACE_LIST_ROW_GAP,
+        .create_row = face_list_create_row,
+        .bind_row = face_list_bind_row,
+        .user_data = this,
+    };
+    if (app_list_view_create(_face_list_screen, &list_config, &_face_list_view) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create face list");
         lv_obj_del(_face_list_screen);
-        _face_list_screen = lv_obj_create(NULL);
-    } else {
-        
-        _face_list_screen = lv_obj_create(NULL);
+        _face_list_screen = nullptr;
+        return nullptr;
     }
-    lv_obj_clear_flag(_face_list_screen, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(_face_list_screen, lv_color_hex(0x1a1a1a), 0);
     
     
     lv_obj_t *title = lv_label_create(_face_list_screen);
     lv_label_set_text(title, "Saved Faces");
-    lv_obj_set_style_text_color(title, lv_color_hex(0xFFFFFF), 0);
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_32, 0);
+    ui_style_add(title, UiStyle::TEXT_TITLE_LARGE);
     lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 20);
     
     
-    char count_buf[64];
-    snprintf(count_buf, sizeof(count_buf), "%d / %d faces stored", _face_count, MAX_FACES);
-    lv_obj_t *count_label = lv_label_create(_face_list_screen);
-    lv_label_set_text(count_label, count_buf);
-    lv_obj_set_style_text_color(count_label, lv_color_hex(0xCCCCCC), 0);
-    lv_obj_set_style_text_font(count_label, &lv_font_montserrat_20, 0);
-    lv_obj_align(count_label, LV_ALIGN_TOP_MID, 0, 65);
+    _face_list_count_label = lv_label_create(_face_list_screen);
+    lv_label_set_text(_face_list_count_label, "");
+    ui_style_add(_face_list_count_label, UiStyle::TEXT_STATUS);
+    lv_obj_align(_face_list_count_label, LV_ALIGN_TOP_MID, 0, 65);
     
-    if (_face_count == 0) {
-        
-        lv_obj_t *empty_label = lv_label_create(_face_list_screen);
-        lv_label_set_text(empty_label, "No faces saved yet.\nUse Face ID to add faces.");
-        lv_obj_set_style_text_color(empty_label, lv_color_hex(0x888888), 0);
-        lv_obj_set_style_text_font(empty_label, &lv_font_montserrat_24, 0);
-        lv_obj_set_style_text_align(empty_label, LV_TEXT_ALIGN_CENTER, 0);
-        lv_obj_align(empty_label, LV_ALIGN_CENTER, 0, -30);
-    } else {
-        
-        lv_obj_t *list_cont = lv_obj_create(_face_list_screen);
-        lv_obj_set_size(list_cont, _width - 100, 360);
-        lv_obj_align(list_cont, LV_ALIGN_CENTER, 0, 20);
-        lv_obj_set_style_bg_color(list_cont, lv_color_hex(0x2a2a2a), 0);
-        lv_obj_set_style_border_width(list_cont, 2, 0);
-        lv_obj_set_style_border_color(list_cont, lv_color_hex(0x444444), 0);
-        lv_obj_set_style_radius(list_cont, 10, 0);
-        lv_obj_set_style_pad_all(list_cont, 15, 0);
-        lv_obj_set_flex_flow(list_cont, LV_FLEX_FLOW_COLUMN);
-        lv_obj_set_flex_align(list_cont, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
-        lv_obj_set_scrollbar_mode(list_cont, LV_SCROLLBAR_MODE_AUTO);
-        
-        
-        int display_idx = 0;
-        for (int i = 0; i < MAX_FACES; i++) {
-            if (_stored_faces[i].is_used) {
-                
-                _face_list_items[i] = lv_obj_create(list_cont);
-                lv_obj_set_size(_face_list_items[i], lv_pct(100), 110);  // 增加高度以容纳更多信息
-                lv_obj_set_style_bg_color(_face_list_items[i], lv_color_hex(0x3a3a3a), 0);
-                lv_obj_set_style_border_width(_face_list_items[i], 1, 0);
-                lv_obj_set_style_border_color(_face_list_items[i], lv_color_hex(0x555555), 0);
-                lv_obj_set_style_radius(_face_list_items[i], 8, 0);
-                lv_obj_set_style_pad_all(_face_list_items[i], 10, 0);
-                lv_obj_clear_flag(_face_list_items[i], LV_OBJ_FLAG_SCROLLABLE);
-                
-                
-                lv_obj_t *idx_label = lv_label_create(_face_list_items[i]);
-                char idx_buf[8];
-                snprintf(idx_buf, sizeof(idx_buf), "%d", display_idx + 1);
-                lv_label_set_text(idx_label, idx_buf);
-                lv_obj_set_style_text_color(idx_label, lv_color_hex(0x0080FF), 0);
-                lv_obj_set_style_text_font(idx_label, &lv_font_montserrat_32, 0);
-                lv_obj_align(idx_label, LV_ALIGN_LEFT_MID, 10, 0);
-                
-                
-                lv_obj_t *name_label = lv_label_create(_face_list_items[i]);
-                lv_label_set_text(name_label, _stored_faces[i].name);
-                lv_obj_set_style_text_color(name_label, lv_color_hex(0xFFFFFF), 0);
-                lv_obj_set_style_text_font(name_label, &lv_font_montserrat_24, 0);
-                lv_obj_align(name_label, LV_ALIGN_TOP_LEFT, 60, 10);
-                
-                // 显示偏好设置
-                lv_obj_t *pref_label = lv_label_create(_face_list_items[i]);
-                char pref_buf[64];
-                snprintf(pref_buf, sizeof(pref_buf), "C:%d%% W:%d%% M:%d%%", 
-                         _stored_faces[i].coffee_ratio,
-                         _stored_faces[i].water_ratio,
-                         _stored_faces[i].milk_ratio);
-                lv_label_set_text(pref_label, pref_buf);
-                lv_obj_set_style_text_color(pref_label, lv_color_hex(0xAAAAAA), 0);
-                lv_obj_set_style_text_font(pref_label, &lv_font_montserrat_18, 0);
-                lv_obj_align(pref_label, LV_ALIGN_TOP_LEFT, 60, 45);
-                
-                
-                _face_delete_btns[i] = lv_btn_create(_face_list_items[i]);
-                lv_obj_set_size(_face_delete_btns[i], 120, 60);
-                lv_obj_align(_face_delete_btns[i], LV_ALIGN_RIGHT_MID, -10, 0);
-                lv_obj_set_style_bg_color(_face_delete_btns[i], lv_color_hex(0xFF0000), 0);
-                lv_obj_set_style_radius(_face_delete_btns[i], 8, 0);
-                
-                lv_obj_t *del_label = lv_label_create(_face_delete_btns[i]);
-                lv_label_set_text(del_label, "Delete");
-                lv_obj_set_style_text_color(del_label, lv_color_hex(0xFFFFFF), 0);
-                lv_obj_set_style_text_font(del_label, &lv_font_montserrat_20, 0);
-                lv_obj_center(del_label);
-                
-                lv_obj_add_event_cb(_face_delete_btns[i], face_delete_btn_cb, LV_EVENT_CLICKED, this);
-                
-                display_idx++;
-            }
-        }
-    }
+    
+    _face_list_search = lv_textarea_create(_face_list_screen);
+    lv_obj_set_size(_face_list_search, 260, 50);
+    lv_obj_align(_face_list_search, LV_ALIGN_TOP_RIGHT, -50, 20);
+    lv_textarea_set_placeholder_text(_face_list_search, "Search name...");
+    lv_textarea_set_max_length(_face_list_search, APP_FACE_GALLERY_NAME_LEN - 1);
+    lv_textarea_set_one_line(_face_list_search, true);
+    ui_style_add(_face_list_search, UiStyle::TEXT_INPUT);
+    lv_obj_add_event_cb(_face_list_search, face_list_search_event_cb, LV_EVENT_ALL, this);
+    
+    
+    _face_list_empty_label = lv_label_create(_face_list_screen);
+    lv_label_set_text(_face_list_empty_label, "No faces saved yet.\nUse Face ID to add faces.");
+    ui_style_add(_face_list_empty_label, UiStyle::TEXT_EMPTY);
+    lv_obj_align(_face_list_empty_label, LV_ALIGN_CENTER, 0, -30);
     
     
-    lv_obj_t *back_btn = lv_btn_create(_face_list_screen);
-    lv_obj_set_size(back_btn, 200, 70);
-    lv_obj_align(back_btn, LV_ALIGN_BOTTOM_MID, 0, -20);
-    lv_obj_set_style_bg_color(back_btn, lv_color_hex(0x0080FF), 0);
-    lv_obj_set_style_radius(back_btn, 15, 0);
+    lv_obj_t *list_obj = app_list_view_get_obj(_face_list_view);
+    lv_obj_set_size(list_obj, _width - 100, 360);
+    lv_obj_align(list_obj, LV_ALIGN_CENTER, 0, 20);
+    ui_style_add(list_obj, UiStyle::LIST_PANEL);
     
-    lv_obj_t *back_label = lv_label_create(back_btn);
+    
+    lv_obj_t *list_back_btn = lv_btn_create(_face_list_screen);
+    lv_obj_set_size(list_back_btn, 200, 70);
+    lv_obj_align(list_back_btn, LV_ALIGN_BOTTOM_MID, 0, -20);
+    ui_style_add(list_back_btn, UiStyle::BTN_BACK);
+    
+    lv_obj_t *back_label = lv_label_create(list_back_btn);
     lv_label_set_text(back_label, "Back");
-    lv_obj_set_style_text_color(back_label, lv_color_hex(0xFFFFFF), 0);
-    lv_obj_set_style_text_font(back_label, &lv_font_montserrat_24, 0);
+    ui_style_add(back_label, UiStyle::TEXT_TITLE);
     lv_obj_center(back_label);
     
-    lv_obj_add_event_cb(back_btn, face_list_back_btn_cb, LV_EVENT_CLICKED, this);
+    lv_obj_add_event_cb(list_back_btn, face_list_back_btn_cb, LV_EVENT_CLICKED, this);
     
+    // 搜索键盘（默认隐藏）
+    _face_list_keyboard = lv_keyboard_create(_face_list_screen);
+    lv_obj_set_size(_face_list_keyboard, _width, _height / 2);
+    lv_obj_align(_face_list_keyboard, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_keyboard_set_textarea(_face_list_keyboard, _face_list_search);
+    lv_obj_add_flag(_face_list_keyboard, LV_OBJ_FLAG_HIDDEN);
     
-    if (lv_scr_act() != _face_list_screen) {
-        lv_scr_load(_face_list_screen);
-    }
     
-    ESP_LOGI(TAG, "Face list screen displayed with %d faces", _face_count);
+    _face_list_scan_timer = lv_timer_create(face_list_scan_timer_cb, FACE_LIST_SCAN_PERIOD_MS, this);
+    lv_timer_pause(_face_list_scan_timer);
+    return _face_list_screen;
 }
 
-void CoffeeMachine::closeFaceListScreen(void)
+void CoffeeMachine::refreshFaceList(void)
 {
-    ESP_LOGI(TAG, "Closing face list screen");
+    if (!_face_list_screen) {
+        return;
+    }
     
+    // 人脸可能在界面隐藏时增删过, 上次的结果不能用来缩小范围
+    _face_list_scanned = false;
+    startFaceListScan();
+}
+
+void CoffeeMachine::startFaceListScan(void)
+{
+    const char *query = lv_textarea_get_text(_face_list_search);
+    
+    // 新的搜索词包含上次筛完的搜索词时, 结果只会更少, 只在上次的结果里筛选
+    _face_list_scan_narrow = _face_list_scanned && strcasestr(query, _face_list_query) != nullptr;
+    _face_list_scan_end = _face_list_scan_narrow ? _face_list_match_count : MAX_FACES;
+    _face_list_scan_pos = 0;
+    _face_list_match_count = 0;
+    _face_list_scanned = false;
+    strncpy(_face_list_query, query, sizeof(_face_list_query) - 1);
+    _face_list_query[sizeof(_face_list_query) - 1] = '\0';
+    _face_list_scan_start_us = esp_timer_get_time();
+    
+    
+    app_list_view_set_count(_face_list_view, 0);
+    lv_obj_scroll_to_y(app_list_view_get_obj(_face_list_view), 0, LV_ANIM_OFF);
+    
+    // 第一页立即筛选, 界面一打开就有内容; 其余每个定时周期一页
+    scanFaceListPage();
+    if (!_face_list_scanned) {
+        lv_timer_resume(_face_list_scan_timer);
+    }
+}
+
+void CoffeeMachine::scanFaceListPage(void)
+{
+    int end = _face_list_scan_pos + FACE_LIST_SCAN_PAGE;
+    if (end > _face_list_scan_end) {
+        end = _face_list_scan_end;
+    }
     
-    if (_face_list_screen) {
-        if (lv_scr_act() == _face_list_screen) {
-            ESP_LOGW(TAG, "Cannot delete face list screen - it's still active! Switch to another screen first.");
-            
-        } else {
-            
-            lv_obj_del(_face_list_screen);
-            _face_list_screen = nullptr;
-            ESP_LOGI(TAG, "Face list screen deleted");
+    // 缩小范围时原地筛选, 写入位置不会超过读取位置
+    for (; _face_list_scan_pos < end; _face_list_scan_pos++) {
+        int idx = _face_list_scan_narrow ? _face_list_matches[_face_list_scan_pos] : _face_list_scan_pos;
+        const FaceData &face = _stored_faces[idx];
+        if (face.is_used && strcasestr(face.name, _face_list_query)) {
+            _face_list_matches[_face_list_match_count++] = idx;
         }
     }
     
+    _face_list_scanned = _face_list_scan_pos >= _face_list_scan_end;
+    app_list_view_set_count(_face_list_view, _face_list_match_count);
+    updateFaceListStatus();
     
-    for (int i = 0; i < MAX_FACES; i++) {
-        _face_list_items[i] = nullptr;
-        _face_delete_btns[i] = nullptr;
+    if (_face_list_scanned) {
+        lv_timer_pause(_face_list_scan_timer);
+        ESP_LOGI(TAG, "Face list: %d of %d faces match \"%s\" (%s), %d us", _face_list_match_count, _face_count,
+                 _face_list_query, _face_list_scan_narrow ? "narrowed" : "full scan",
+                 (int)(esp_timer_get_time() - _face_list_scan_start_us));
+    }
+}
+
+void CoffeeMachine::updateFaceListStatus(void)
+{
+    char buf[64];
+    if (_face_list_query[0] == '\0') {
+        snprintf(buf, sizeof(buf), "%d / %d faces stored", _face_count, MAX_FACES);
+    } else {
+        snprintf(buf, sizeof(buf), "%d of %d faces match%s", _face_list_match_count, _face_count,
+                 _face_list_scanned ? "" : "...");
+    }
+    set_label_text(_face_list_count_label, buf);
+    
+    lv_obj_t *list_obj = app_list_view_get_obj(_face_list_view);
+    if (_face_count == 0) {
+        lv_obj_clear_flag(_face_list_empty_label, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_flag(list_obj, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(_face_list_empty_label, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_flag(list_obj, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+void CoffeeMachine::removeFaceListMatch(int pos)
+{
+    // 筛选未完成时结果数组的前后两段都在用, 重新筛选
+    if (!_face_list_scanned) {
+        startFaceListScan();
+        return;
     }
+    
+    memmove(&_face_list_matches[pos], &_face_list_matches[pos + 1],
+            (_face_list_match_count - pos - 1) * sizeof(_face_list_matches[0]));
+    _face_list_match_count--;
+    
+    // 后面的人脸都上移了一行
+    app_list_view_set_count(_face_list_view, _face_list_match_count);
+    app_list_view_refresh(_face_list_view);
+    updateFaceListStatus();
+}
+
+void CoffeeMachine::showFaceListScreen(void)
+{
+    ESP_LOGI(TAG, "Showing face list screen");
+    
+    
+    if (!_screens.get(ScreenId::FACE_LIST)) {
+        return;
+    }
+    lv_obj_add_flag(_face_list_keyboard, LV_OBJ_FLAG_HIDDEN);
+    refreshFaceList();
+    _screens.show(ScreenId::FACE_LIST);
+    
+    app_list_view_stats_t stats;
+    app_list_view_get_stats(_face_list_view, &stats, false);
+    ESP_LOGI(TAG, "Face list screen displayed with %d faces, %d rows", _face_count, (int)stats.rows);
 }
 
 void CoffeeMachine::deleteFaceAtIndex(int idx)
@@ -1540,12 +2988,15 @@ void CoffeeMachine::deleteFaceAtIndex(int idx)
     ESP_LOGI(TAG, "Deleting face at index %d: %s", idx, _stored_faces[idx].name);
     
     
+    if (_gallery && app_face_gallery_delete(_gallery, _stored_faces[idx].id) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to delete face from gallery");
+    }
+    
+    xSemaphoreTake(_faces_lock, portMAX_DELAY);
     memset(&_stored_faces[idx], 0, sizeof(FaceData));
     _stored_faces[idx].is_used = false;
     _face_count--;
-    
-    
-    saveFacesToNVS();
+    xSemaphoreGive(_faces_lock);
     
     ESP_LOGI(TAG, "Face deleted successfully. Remaining faces: %d", _face_count);
 }
@@ -4,8 +4,10 @@
 #include "esp_mac.h"
 #include "esp_brookesia.hpp"
 #include "esp_heap_caps.h"
+#include "sdkconfig.h"
 #include "bsp/esp-bsp.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 
@@ -17,16 +19,45 @@ extern "C" {
 
 
 #include "camera/app_humanface_detect.h"
+#include "camera/app_pedestrian_detect.h"
+#include "camera/app_detect_overlay.h"
+#include "camera/app_motion_detect.h"
+#include "camera/app_presence_detect.h"
+#include "camera/app_face_feature.h"
+#include "camera/app_face_gallery.h"
+#include "camera/app_face_tracker.h"
+#include "camera/app_video_plane.h"
+#include "display/app_ui_perf.h"
+#include "display/app_fb_sync.h"
+#include "display/app_draw_ppa.h"
+#include "display/app_draw_parallel.h"
+#include "display/app_draw_buf.h"
+#include "display/app_input_latency.h"
+#include "display/app_img_cache.h"
+#include "display/app_img_jpeg.h"
+#include "display/app_asset_fs.h"
+#include "display/app_anim.h"
+#include "display/app_list_view.h"
+#include "CoffeeMachine_camera.hpp"
+#include "CoffeeMachine_screens.hpp"
+#include "brew_link.h"
 #include <vector>
 #include <string>
 #include "nvs_flash.h"
 #include "nvs.h"
 
-#define MAX_FACES 3
-#define FACE_FEATURE_SIZE 128
+#define MAX_FACES CONFIG_APP_FACE_MAX_FACES
+#define FACE_FEATURE_SIZE APP_FACE_FEATURE_DIM
+
+#if CONFIG_APP_BREW_PIPELINE_ENABLE
+#define BREW_NEXT_QUEUE_LEN CONFIG_APP_BREW_NEXT_QUEUE_LEN
+#else
+#define BREW_NEXT_QUEUE_LEN 1
+#endif
 
 
 struct FaceData {
+    uint32_t id;        // 图库记录 id
     char name[32];
     float feature[FACE_FEATURE_SIZE];
     bool is_used;
@@ -50,13 +81,20 @@ public:
 
     uint16_t _height;
     uint16_t _width;
+    ScreenManager _screens;
     
     
-    lv_obj_t *overlay_screen = nullptr;
+    lv_obj_t *overlay_screen = nullptr;               // lv_layer_top() 上的制作浮层, 常驻, 不用时隐藏
+    bool overlay_active = false;
     lv_obj_t *overlay_btn_label = nullptr;
     lv_obj_t *overlay_count_label = nullptr;
+    lv_obj_t *overlay_next_label = nullptr;
     lv_timer_t *overlay_timer = nullptr;
     int overlay_seconds = 0;
+    brew_link_t *_brew_link = nullptr;
+    QueueHandle_t _brew_events = nullptr;             // 链路任务 -> UI 线程的订单事件
+    lv_timer_t *_brew_event_timer = nullptr;
+    uint16_t _brew_order_id = 0;                      // 当前制作界面对应的订单, 0 为无
     lv_obj_t *grid_buttons[8] = {nullptr};
     
     
@@ -66,6 +104,7 @@ public:
     };
     MakingStage current_stage = MakingStage::GIF_PLAYING;
     lv_obj_t *gif_obj = nullptr;
+    app_anim_handle_t _brew_anim = nullptr;
     lv_obj_t *finish_img_obj = nullptr;
     lv_obj_t *making_bg_img = nullptr;
     
@@ -79,6 +118,18 @@ public:
     lv_obj_t *camera_screen = nullptr;
     lv_obj_t *camera_canvas = nullptr;
     lv_obj_t *camera_buttons[3] = {nullptr};
+    detect_overlay_t *_detect_overlay = nullptr;
+    app_video_plane_t *_video_plane = nullptr;        // 非空时预览帧由 PPA 直接写入帧缓冲
+    lv_timer_t *_fb_sync_log_timer = nullptr;
+    lv_timer_t *_input_latency_log_timer = nullptr;
+    lv_timer_t *_touch_log_timer = nullptr;
+    lv_timer_t *_img_cache_log_timer = nullptr;
+    app_presence_t *_presence = nullptr;
+    PedestrianDetect *_pedestrian_detector = nullptr;
+    std::atomic<bool> _presence_confirming{false};    // 识别线程正在用行人检测确认有人靠近
+    lv_timer_t *_presence_timer = nullptr;
+    bool _presence_present = false;
+    bool _display_dimmed = false;
     int _camera_ctlr_handle = -1;
     bool _camera_running = false;
     bool _camera_initialized = false;
@@ -89,10 +140,14 @@ public:
     SemaphoreHandle_t _camera_init_sem = nullptr;
     
     
-    bool _face_recognition_enabled = false;
+    std::atomic<CameraState> _camera_state{CameraState::OFF};
+    FaceRecognitionWorker *_face_worker = nullptr;
+    lv_timer_t *_face_event_timer = nullptr;
+    SemaphoreHandle_t _faces_lock = nullptr;          // 保护人脸库, 录入状态和人脸轨迹 (识别线程 / UI 线程)
     FaceData _stored_faces[MAX_FACES];
     int _face_count = 0;
     HumanFaceDetect *_face_detector = nullptr;
+    app_motion_gate_t *_motion_gate = nullptr;
     lv_obj_t *_face_name_screen = nullptr;
     lv_obj_t *_face_name_textarea = nullptr;
     lv_obj_t *_face_name_keyboard = nullptr;
@@ -103,30 +158,92 @@ public:
     lv_obj_t *_water_label = nullptr;        // 水数值标签
     lv_obj_t *_milk_label = nullptr;         // 牛奶数值标签
     uint8_t *_captured_face_buffer = nullptr;
+    app_face_feature_t *_face_feature = nullptr;
+    app_face_tracker_t *_face_tracker = nullptr;
+    app_face_gallery_t *_gallery = nullptr;
+    app_face_enroll_t _enroll;
+    std::atomic<bool> _enrolling{false};
+    int _enroll_track_id = 0;                // 正在录入的人脸轨迹 id
+    float _enroll_feature[FACE_FEATURE_SIZE];
     
     
-    lv_timer_t *_face_action_timer = nullptr;
-    int _recognized_face_idx = -1;
-    bool _pending_face_action = false;
+    uint32_t _recognized_face_id = 0;                 // 正在制作的顾客 (图库记录 id, 0 为按钮下单)
+    int _reported_track_id = 0;                       // 制作中已上报的人脸轨迹
+    uint32_t _next_customers[BREW_NEXT_QUEUE_LEN];    // 排队中的下一位顾客 (图库记录 id)
+    int _next_customer_count = 0;
     
     
     lv_obj_t *_face_list_screen = nullptr;
-    lv_obj_t *_face_list_items[MAX_FACES] = {nullptr};
-    lv_obj_t *_face_delete_btns[MAX_FACES] = {nullptr};
-    lv_timer_t *_face_list_refresh_timer = nullptr;
-    lv_timer_t *_face_list_back_timer = nullptr;
-    int _pending_delete_idx = -1;
+    lv_obj_t *_face_list_count_label = nullptr;
+    lv_obj_t *_face_list_empty_label = nullptr;
+    lv_obj_t *_face_list_search = nullptr;
+    lv_obj_t *_face_list_keyboard = nullptr;
+    app_list_view_handle_t _face_list_view = nullptr;    // 固定数量的行, 滚动时重新绑定
+    lv_timer_t *_face_list_scan_timer = nullptr;         // 分页筛选, 每个周期一页
+    int _face_list_matches[MAX_FACES];                   // 符合搜索的 _stored_faces 下标
+    int _face_list_match_count = 0;
+    int _face_list_scan_pos = 0;                         // 下一个待检查的候选
+    int _face_list_scan_end = 0;
+    bool _face_list_scan_narrow = false;                 // 候选为上次的结果, 否则为所有存储位
+    bool _face_list_scanned = false;                     // _face_list_matches 对 _face_list_query 完整
+    char _face_list_query[APP_FACE_GALLERY_NAME_LEN] = "";
+    int64_t _face_list_scan_start_us = 0;
     
     
     void cleanup_overlay(void);
+    lv_obj_t *buildMainScreen(void);
+    lv_obj_t *buildOverlay(void);
+    lv_obj_t *buildSettingsScreen(void);
+    lv_obj_t *buildCameraScreen(void);
+    lv_obj_t *buildFaceNameScreen(void);
+    lv_obj_t *buildFaceListScreen(void);
+    void submitBrewOrder(int idx);
+    void handleBrewEvent(const brew_link_event_t &event);
+    void showMakingFinished(bool success);
     void showFaceNameScreen(void);
     void closeFaceNameScreen(void);
     void saveFaceData(const char *name);
-    int recognizeFace(const std::list<dl::detect::result_t> &results);
-    bool loadFacesFromNVS(void);
-    bool saveFacesToNVS(void);
+    int recognizeFace(const float *feature, float *similarity);
+    int findFaceById(uint32_t id) const;
+    bool loadFaceGallery(void);
+    bool saveFaceToGallery(int idx);
+    bool migrateFacesFromNVS(void);
     void showFaceListScreen(void);
-    void closeFaceListScreen(void);
+    void refreshFaceList(void);
+    void startFaceListScan(void);
+    void scanFaceListPage(void);
+    void updateFaceListStatus(void);
+    void removeFaceListMatch(int pos);
     void deleteFaceAtIndex(int idx);
+    bool getFaceDetectStats(app_motion_gate_stats_t *stats, bool reset);
+    bool initCamera(void);
+    bool startCameraStream(void);
+    void stopCameraStream(void);
+    void startFaceRecognition(void);
+    void stopFaceRecognition(void);
+    CameraState getCameraState(void) const;
+    bool setCameraState(CameraState to);
+    bool transitionCameraState(CameraState from, CameraState to);
+    void onCameraStateChanged(CameraState to);
+    void processFaceFrame(uint8_t *frame, uint32_t width, uint32_t height);
+    void recognizeDetections(uint8_t *frame, uint32_t width, uint32_t height,
+                             const std::list<dl::detect::result_t> &detect_results, bool background);
+    void confirmPresence(uint8_t *frame, uint32_t width, uint32_t height);
+    static void faceFrameHandler(void *user_data, uint8_t *frame, uint32_t width, uint32_t height);
+    void handleFaceEvent(const FaceEvent &event);
+    bool startBrewingScan(void);
+    void startFaceOrder(int face_idx);
+    void queueNextCustomer(uint32_t face_id);
+    bool startNextQueuedOrder(void);
+    void updateNextCustomerLabel(void);
+    void startPresenceMode(void);
+    void stopPresenceMode(void);
+    void setDisplayDimmed(bool dimmed);
+    void runDrawBenchmark(void);
+    lv_obj_t *createBenchmarkOverlay(lv_obj_t *screen);
+    void measureFrameTime(lv_obj_t *screen, int *frame_us, int *render_us);
+    void runDisplayBenchmark(void);
+    float runLvglDemoBenchmark(void);
+    void runAssetBenchmark(void);
 };
 
@@ -0,0 +1,514 @@
+#include "CoffeeMachine.hpp"
+#include "CoffeeMachine_camera.hpp"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "img_kernels.h"
+#include <string.h>
+
+static const char *TAG = "CoffeeMachine_camera";
+
+#define FACE_WORKER_STACK_SIZE      (12 * 1024)
+#define FACE_WORKER_PRIORITY        (4)
+#define FACE_WORKER_CORE            (1)
+#define FACE_EVENT_QUEUE_LEN        (8)
+#define FACE_TRACK_MAX_BOXES        (8)
+#define FACE_WORKER_STATS_PERIOD_US (10 * 1000 * 1000)
+#define PRESENCE_CONFIRM_WIDTH      (320)
+#define PRESENCE_CONFIRM_HEIGHT     (240)
+
+
+const char *camera_state_name(CameraState state)
+{
+    switch (state) {
+    case CameraState::OFF:          return "OFF";
+    case CameraState::PRESENCE:     return "PRESENCE";
+    case CameraState::PREVIEW:      return "PREVIEW";
+    case CameraState::SCANNING:     return "SCANNING";
+    case CameraState::ENROLL_NAME:  return "ENROLL_NAME";
+    case CameraState::MATCHED:      return "MATCHED";
+    case CameraState::BREWING_SCAN: return "BREWING_SCAN";
+    }
+    return "?";
+}
+
+bool camera_state_transition_allowed(CameraState from, CameraState to)
+{
+    switch (to) {
+    case CameraState::OFF:
+    case CameraState::PREVIEW:
+        return true;
+    case CameraState::PRESENCE:
+        return from == CameraState::OFF || from == CameraState::PREVIEW;
+    case CameraState::BREWING_SCAN:
+        return from != CameraState::ENROLL_NAME;
+    case CameraState::SCANNING:
+        return from == CameraState::PREVIEW || from == CameraState::SCANNING;
+    case CameraState::ENROLL_NAME:
+    case CameraState::MATCHED:
+        return from == CameraState::SCANNING;
+    }
+    return false;
+}
+
+bool camera_state_draw_parallel_allowed(CameraState state)
+{
+    return state != CameraState::SCANNING && state != CameraState::ENROLL_NAME && state != CameraState::BREWING_SCAN;
+}
+
+
+FaceRecognitionWorker::FaceRecognitionWorker(face_frame_handler_t handler, void *user_data)
+    : _handler(handler), _user_data(user_data)
+{
+    _events = xQueueCreate(FACE_EVENT_QUEUE_LEN, sizeof(FaceEvent));
+    _results_lock = xSemaphoreCreateMutex();
+    if (!_events || !_results_lock) {
+        ESP_LOGE(TAG, "Failed to create face worker queue");
+    }
+}
+
+FaceRecognitionWorker::~FaceRecognitionWorker()
+{
+    stop();
+
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(_slots[i]);
+        _slots[i] = nullptr;
+    }
+    if (_events) {
+        vQueueDelete(_events);
+    }
+    if (_results_lock) {
+        vSemaphoreDelete(_results_lock);
+    }
+}
+
+bool FaceRecognitionWorker::start(uint32_t width, uint32_t height)
+{
+    if (_task) {
+        return true;
+    }
+    if (!_events || !_results_lock) {
+        return false;
+    }
+
+
+    _slot_size = width * height * 2;
+    _width = width;
+    _height = height;
+    for (int i = 0; i < 2; i++) {
+        _slots[i] = (uint8_t *)heap_caps_malloc(_slot_size, MALLOC_CAP_SPIRAM);
+        if (!_slots[i]) {
+            ESP_LOGE(TAG, "Failed to allocate face worker frame %d (%d bytes)", i, (int)_slot_size);
+            heap_caps_free(_slots[0]);
+            _slots[0] = nullptr;
+            return false;
+        }
+    }
+    _ready = -1;
+    _busy = -1;
+
+
+    _running = true;
+    if (xTaskCreatePinnedToCore(task, "Face Worker", FACE_WORKER_STACK_SIZE, this,
+                                FACE_WORKER_PRIORITY, &_task, FACE_WORKER_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create face worker task");
+        _running = false;
+        _task = nullptr;
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Face worker started on core %d (%dx%d mailbox)", FACE_WORKER_CORE, (int)width, (int)height);
+    return true;
+}
+
+void FaceRecognitionWorker::stop(void)
+{
+    if (!_task) {
+        return;
+    }
+
+    _exit_sem = xSemaphoreCreateBinary();
+    _running = false;
+    xTaskNotifyGive(_task);
+    if (_exit_sem) {
+        xSemaphoreTake(_exit_sem, portMAX_DELAY);
+        vSemaphoreDelete(_exit_sem);
+        _exit_sem = nullptr;
+    }
+    _task = nullptr;
+}
+
+bool FaceRecognitionWorker::submit(const uint8_t *frame, size_t size)
+{
+    if (!_task || size > _slot_size) {
+        return false;
+    }
+
+
+    taskENTER_CRITICAL(&_mux);
+    int slot = (_busy == 0) ? 1 : 0;
+    bool overwrite = (_ready == slot);
+    if (overwrite) {
+        _ready = -1;
+    }
+    taskEXIT_CRITICAL(&_mux);
+
+    memcpy(_slots[slot], frame, size);
+
+    taskENTER_CRITICAL(&_mux);
+    _ready = slot;
+    taskEXIT_CRITICAL(&_mux);
+
+    _submitted++;
+    if (overwrite) {
+        _dropped++;
+    }
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+bool FaceRecognitionWorker::post(const FaceEvent &event)
+{
+    if (!_events || xQueueSend(_events, &event, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Face event queue full, event %d dropped", (int)event.type);
+        return false;
+    }
+    return true;
+}
+
+bool FaceRecognitionWorker::receive(FaceEvent *event)
+{
+    return _events && xQueueReceive(_events, event, 0) == pdTRUE;
+}
+
+void FaceRecognitionWorker::publishDetections(const std::list<dl::detect::result_t> &results, uint32_t detect_us)
+{
+    xSemaphoreTake(_results_lock, portMAX_DELAY);
+    _results = results;
+    _results_detect_us = detect_us;
+    _results_fresh = true;
+    xSemaphoreGive(_results_lock);
+}
+
+bool FaceRecognitionWorker::takeDetections(std::list<dl::detect::result_t> &results, uint32_t *detect_us)
+{
+    if (!_results_lock || xSemaphoreTake(_results_lock, 0) != pdTRUE) {
+        return false;
+    }
+
+    bool fresh = _results_fresh;
+    if (fresh) {
+        results.swap(_results);
+        _results.clear();
+        if (detect_us) {
+            *detect_us = _results_detect_us;
+        }
+        _results_fresh = false;
+    }
+    xSemaphoreGive(_results_lock);
+    return fresh;
+}
+
+void FaceRecognitionWorker::task(void *param)
+{
+    FaceRecognitionWorker *worker = (FaceRecognitionWorker *)param;
+
+    while (worker->_running) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        taskENTER_CRITICAL(&worker->_mux);
+        int slot = worker->_ready;
+        worker->_ready = -1;
+        worker->_busy = slot;
+        taskEXIT_CRITICAL(&worker->_mux);
+
+        if (slot < 0 || !worker->_running) {
+            continue;
+        }
+
+        worker->_handler(worker->_user_data, worker->_slots[slot], worker->_width, worker->_height);
+        worker->_processed++;
+
+        taskENTER_CRITICAL(&worker->_mux);
+        worker->_busy = -1;
+        taskEXIT_CRITICAL(&worker->_mux);
+    }
+
+    if (worker->_exit_sem) {
+        xSemaphoreGive(worker->_exit_sem);
+    }
+    vTaskDelete(NULL);
+}
+
+
+CameraState CoffeeMachine::getCameraState(void) const
+{
+    return _camera_state.load();
+}
+
+bool CoffeeMachine::setCameraState(CameraState to)
+{
+    CameraState from = _camera_state.load();
+    while (true) {
+        if (from == to) {
+            return true;
+        }
+        if (!camera_state_transition_allowed(from, to)) {
+            ESP_LOGW(TAG, "Camera state %s -> %s refused", camera_state_name(from), camera_state_name(to));
+            return false;
+        }
+        if (_camera_state.compare_exchange_weak(from, to)) {
+            break;
+        }
+    }
+
+    ESP_LOGI(TAG, "Camera state %s -> %s", camera_state_name(from), camera_state_name(to));
+    onCameraStateChanged(to);
+    return true;
+}
+
+bool CoffeeMachine::transitionCameraState(CameraState from, CameraState to)
+{
+    if (!camera_state_transition_allowed(from, to) || !_camera_state.compare_exchange_strong(from, to)) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Camera state %s -> %s", camera_state_name(from), camera_state_name(to));
+    onCameraStateChanged(to);
+    return true;
+}
+
+void CoffeeMachine::onCameraStateChanged(CameraState to)
+{
+#if CONFIG_APP_DRAW_PARALLEL_ENABLE
+    // 只有识别和录入占满另一个核时 LVGL 退回单核渲染, 预览和后台存在检测仍然分带并行
+    app_draw_parallel_set_enabled(camera_state_draw_parallel_allowed(to));
+#endif
+#if CONFIG_APP_PRESENCE_WAKE_ENABLE
+    // 后台存在检测只需要低帧率, 其余帧由驱动丢弃
+    app_video_set_frame_interval(to == CameraState::PRESENCE ? CONFIG_APP_PRESENCE_SAMPLE_INTERVAL_MS : 0);
+#endif
+}
+
+
+void CoffeeMachine::faceFrameHandler(void *user_data, uint8_t *frame, uint32_t width, uint32_t height)
+{
+    ((CoffeeMachine *)user_data)->processFaceFrame(frame, width, height);
+}
+
+void CoffeeMachine::confirmPresence(uint8_t *frame, uint32_t width, uint32_t height)
+{
+    static uint16_t *small_frame = nullptr;
+    if (!small_frame) {
+        small_frame = (uint16_t *)heap_caps_malloc(PRESENCE_CONFIRM_WIDTH * PRESENCE_CONFIRM_HEIGHT * 2, MALLOC_CAP_SPIRAM);
+    }
+
+    bool confirmed = true;
+    if (small_frame && _pedestrian_detector) {
+        int64_t start = esp_timer_get_time();
+        img_buf_t src, dst;
+        img_buf_init(&src, frame, width, height, IMG_FMT_RGB565);
+        img_buf_init(&dst, small_frame, PRESENCE_CONFIRM_WIDTH, PRESENCE_CONFIRM_HEIGHT, IMG_FMT_RGB565);
+        img_resize_nearest(&src, &dst);
+        confirmed = !app_pedestrian_detect(small_frame, PRESENCE_CONFIRM_WIDTH, PRESENCE_CONFIRM_HEIGHT).empty();
+        ESP_LOGI(TAG, "Pedestrian check: %s in %d ms", confirmed ? "confirmed" : "nobody",
+                 (int)((esp_timer_get_time() - start) / 1000));
+    }
+
+    // 期间相机可能已离开 PRESENCE, 结果作废
+    if (getCameraState() == CameraState::PRESENCE) {
+        if (confirmed) {
+            ESP_LOGI(TAG, "Presence detected (area %d)", app_presence_get_area(_presence));
+            FaceEvent event = {FaceEventType::PRESENCE_ENTER, 0, 0, 0.0f};
+            _face_worker->post(event);
+        } else {
+            ESP_LOGI(TAG, "Presence not confirmed by pedestrian detector (area %d)", app_presence_get_area(_presence));
+            app_presence_reject(_presence);
+        }
+    }
+    _presence_confirming = false;
+}
+
+void CoffeeMachine::processFaceFrame(uint8_t *frame, uint32_t width, uint32_t height)
+{
+    // 视频流线程在确认期间不再提交帧, 这一帧就是触发确认的那一帧
+    if (_presence_confirming) {
+        confirmPresence(frame, width, height);
+        return;
+    }
+
+    CameraState state = getCameraState();
+    if ((state != CameraState::SCANNING && state != CameraState::BREWING_SCAN) || !_face_detector) {
+        return;
+    }
+    bool background = (state == CameraState::BREWING_SCAN);
+
+
+    int64_t detect_start = esp_timer_get_time();
+    auto detect_results = app_humanface_detect((uint16_t *)frame, width, height);
+    _face_worker->publishDetections(detect_results, esp_timer_get_time() - detect_start);
+
+
+    static int64_t stats_time = 0;
+    int64_t now = esp_timer_get_time();
+    if (now - stats_time >= FACE_WORKER_STATS_PERIOD_US) {
+        if (stats_time != 0) {
+            ESP_LOGI(TAG, "Face worker: %d frames submitted, %d processed, %d replaced before processing",
+                     (int)_face_worker->submittedFrames(), (int)_face_worker->processedFrames(),
+                     (int)_face_worker->droppedFrames());
+            if (_face_tracker) {
+                app_face_tracker_stats_t track_stats;
+                app_face_tracker_get_stats(_face_tracker, &track_stats);
+                ESP_LOGI(TAG, "Face tracker: %d faces followed, %d recognitions for %d detected faces",
+                         (int)track_stats.tracks, (int)track_stats.recognitions, (int)track_stats.detections);
+            }
+        }
+        stats_time = now;
+    }
+
+
+    // 跟踪, 识别和录入读写人脸库与录入状态, UI 线程改动它们时持同一把锁
+    xSemaphoreTake(_faces_lock, portMAX_DELAY);
+    recognizeDetections(frame, width, height, detect_results, background);
+    xSemaphoreGive(_faces_lock);
+}
+
+void CoffeeMachine::recognizeDetections(uint8_t *frame, uint32_t width, uint32_t height,
+                                        const std::list<dl::detect::result_t> &detect_results, bool background)
+{
+    int box_num = 0;
+    int boxes[FACE_TRACK_MAX_BOXES][4];
+    int slots[FACE_TRACK_MAX_BOXES];
+    const dl::detect::result_t *box_results[FACE_TRACK_MAX_BOXES];
+    for (const auto &res : detect_results) {
+        if (box_num == FACE_TRACK_MAX_BOXES) {
+            break;
+        }
+        for (int k = 0; k < 4; k++) {
+            boxes[box_num][k] = res.box[k];
+        }
+        slots[box_num] = -1;
+        box_results[box_num++] = &res;
+    }
+
+    if (_face_tracker) {
+        int lost_ids[APP_FACE_TRACKER_MAX_TRACKS];
+        int lost_num = app_face_tracker_update(_face_tracker, boxes, box_num, slots, lost_ids, APP_FACE_TRACKER_MAX_TRACKS);
+        for (int i = 0; i < lost_num; i++) {
+            if (_enrolling && lost_ids[i] == _enroll_track_id) {
+                ESP_LOGI(TAG, "Enrollment cancelled, face left the view");
+                _enrolling = false;
+            }
+
+            FaceEvent event = {FaceEventType::LOST, 0, lost_ids[i], 0.0f};
+            _face_worker->post(event);
+        }
+    }
+
+    if (box_num == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "Face detected!");
+
+
+    int face_box = 0;
+    for (int i = 1; i < box_num; i++) {
+        if ((boxes[i][2] - boxes[i][0]) * (boxes[i][3] - boxes[i][1]) >
+            (boxes[face_box][2] - boxes[face_box][0]) * (boxes[face_box][3] - boxes[face_box][1])) {
+            face_box = i;
+        }
+    }
+    const dl::detect::result_t *face_result = box_results[face_box];
+    int face_slot = slots[face_box];
+    const app_face_track_t *track = _face_tracker ? app_face_tracker_get(_face_tracker, face_slot) : nullptr;
+
+
+    bool need_recognition = _face_tracker ? app_face_tracker_needs_recognition(_face_tracker, face_slot) : true;
+    bool need_enroll_frame = !background && track && track->confirmed && track->identity < 0;
+    if (_face_tracker && !track) {
+        ESP_LOGD(TAG, "No free track for face, skipped");
+        need_recognition = false;
+    }
+
+    app_face_quality_t quality = {};
+    float feature[FACE_FEATURE_SIZE];
+    bool usable = false;
+    if (need_recognition || need_enroll_frame) {
+        bool extracted = _face_feature && face_result->keypoint.size() >= 10 &&
+                         app_face_feature_extract(_face_feature, (const uint16_t *)frame, width, height,
+                                                  face_result->keypoint.data(), &quality, feature) == ESP_OK;
+        if (!extracted) {
+            ESP_LOGW(TAG, "Face without usable keypoints, skipped");
+        } else if (quality.score * 100 < CONFIG_APP_FACE_MIN_QUALITY) {
+            ESP_LOGI(TAG, "Face quality %.2f too low (size %.2f, sharpness %.2f, exposure %.2f, pose %.2f)",
+                     quality.score, quality.size, quality.sharpness, quality.exposure, quality.pose);
+        } else {
+            usable = true;
+        }
+    }
+
+
+    // 轨迹身份用图库记录 id, 删除或替换人脸后下标会指向别人; UI 线程处理事件时再换算成下标
+    bool confirmed = false;
+    int recognized_id = -1;
+    float similarity = 0.0f;
+    if (usable && need_recognition) {
+        int idx = recognizeFace(feature, &similarity);
+        recognized_id = idx >= 0 ? (int)_stored_faces[idx].id : -1;
+        if (_face_tracker) {
+            app_face_tracker_vote(_face_tracker, face_slot, recognized_id, similarity);
+        } else {
+            confirmed = true;
+        }
+    }
+    if (track) {
+        confirmed = track->confirmed;
+        recognized_id = track->identity;
+        similarity = track->similarity;
+    }
+
+    if (background) {
+        // 制作中每条轨迹只上报一次, 由 UI 线程排队
+        int track_id = track ? track->track_id : 0;
+        if (confirmed && recognized_id > 0 && (track_id == 0 || track_id != _reported_track_id)) {
+            _reported_track_id = track_id;
+            FaceEvent event = {FaceEventType::RECOGNIZED, (uint32_t)recognized_id, track_id, similarity};
+            _face_worker->post(event);
+        }
+        return;
+    }
+
+    if (confirmed && recognized_id > 0) {
+        if (transitionCameraState(CameraState::SCANNING, CameraState::MATCHED)) {
+            FaceEvent event = {FaceEventType::RECOGNIZED, (uint32_t)recognized_id, track ? track->track_id : 0, similarity};
+            _face_worker->post(event);
+        }
+    } else if (confirmed && recognized_id == -1 && usable) {
+
+        if (_face_count >= MAX_FACES) {
+            ESP_LOGW(TAG, "Face storage full, cannot add new face");
+            return;
+        }
+
+        if (!_enrolling) {
+            ESP_LOGI(TAG, "Unknown face detected, capturing %d frames for enrollment", CONFIG_APP_FACE_ENROLL_FRAMES);
+            app_face_enroll_begin(&_enroll, CONFIG_APP_FACE_ENROLL_KEEP);
+            _enrolling = true;
+            _enroll_track_id = track ? track->track_id : 0;
+        }
+        app_face_enroll_add(&_enroll, quality.score, feature);
+
+        if (_enroll.frames >= CONFIG_APP_FACE_ENROLL_FRAMES) {
+            float mean_quality = app_face_enroll_finish(&_enroll, _enroll_feature);
+            _enrolling = false;
+            ESP_LOGI(TAG, "Enrollment burst done: kept %d of %d frames, mean quality %.2f",
+                     _enroll.count, _enroll.frames, mean_quality);
+
+            if (transitionCameraState(CameraState::SCANNING, CameraState::ENROLL_NAME)) {
+                FaceEvent event = {FaceEventType::UNKNOWN, 0, _enroll_track_id, 0.0f};
+                _face_worker->post(event);
+            }
+        }
+    }
+}
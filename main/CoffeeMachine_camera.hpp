@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "camera/app_humanface_detect.h"
+
+
+// 相机 / Face ID 状态机, 取代原先分散的 volatile bool 标志
+enum class CameraState : uint8_t {
+    OFF,            // 相机流关闭, 帧被丢弃
+    PRESENCE,       // 主菜单后台人体存在检测, 不显示
+    PREVIEW,        // 相机界面预览, 不识别
+    SCANNING,       // Face ID 识别中
+    ENROLL_NAME,    // 未知人脸采集完成, 等待输入名字
+    MATCHED,        // 已识别, 等待界面切换到制作
+    BREWING_SCAN,   // 制作中, 后台低频识别下一位顾客, 不显示
+};
+
+const char *camera_state_name(CameraState state);
+bool camera_state_transition_allowed(CameraState from, CameraState to);
+// 该状态下 LVGL 是否可以分带双核渲染, 识别和录入占满另一个核时不可以
+bool camera_state_draw_parallel_allowed(CameraState state);
+
+
+// 识别线程 / 视频流线程发往 UI 线程的事件
+enum class FaceEventType : uint8_t {
+    RECOGNIZED,     // 已识别的人脸, face_id 有效 (BREWING_SCAN 下为下一位顾客)
+    UNKNOWN,        // 未知人脸录入采集完成, 特征在 _enroll_feature
+    LOST,           // 人脸轨迹离开画面
+    PRESENCE_ENTER, // 后台检测到有人靠近
+    PRESENCE_LEAVE, // 后台检测到人已离开
+};
+
+struct FaceEvent {
+    FaceEventType type;
+    uint32_t face_id;   // RECOGNIZED: 图库记录 id, 可能已被删除
+    int track_id;       // RECOGNIZED / UNKNOWN / LOST: 人脸轨迹 id
+    float similarity;   // RECOGNIZED: 投票平均相似度
+};
+
+
+typedef void (*face_frame_handler_t)(void *user_data, uint8_t *frame, uint32_t width, uint32_t height);
+
+/**
+ * Face ID worker.
+ *
+ * The video stream task hands frames over through a latest-frame mailbox of two buffers: the
+ * worker processes one while the stream task keeps overwriting the other, so a slow inference
+ * drops stale frames instead of stalling the preview. Results reach the UI thread as FaceEvent
+ * messages and as the latest detection list for the overlay.
+ */
+class FaceRecognitionWorker
+{
+public:
+    FaceRecognitionWorker(face_frame_handler_t handler, void *user_data);
+    ~FaceRecognitionWorker();
+
+    bool start(uint32_t width, uint32_t height);
+    void stop(void);
+
+    // 视频流线程: 提交一帧, 覆盖尚未处理的旧帧
+    bool submit(const uint8_t *frame, size_t size);
+
+    // 识别线程 -> UI 线程
+    bool post(const FaceEvent &event);
+    bool receive(FaceEvent *event);
+
+    // 识别线程 -> 视频流线程 (检测框叠加层)
+    void publishDetections(const std::list<dl::detect::result_t> &results, uint32_t detect_us);
+    bool takeDetections(std::list<dl::detect::result_t> &results, uint32_t *detect_us);
+
+    uint32_t submittedFrames(void) const { return _submitted; }
+    uint32_t droppedFrames(void) const { return _dropped; }
+    uint32_t processedFrames(void) const { return _processed; }
+
+private:
+    static void task(void *param);
+
+    face_frame_handler_t _handler;
+    void *_user_data;
+    TaskHandle_t _task = nullptr;
+    QueueHandle_t _events = nullptr;
+    std::atomic<bool> _running{false};
+    SemaphoreHandle_t _exit_sem = nullptr;
+
+    uint8_t *_slots[2] = {nullptr, nullptr};
+    size_t _slot_size = 0;
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    int _ready = -1;        // 最新未处理帧所在缓冲
+    int _busy = -1;         // 识别线程正在处理的缓冲
+
+    SemaphoreHandle_t _results_lock = nullptr;
+    std::list<dl::detect::result_t> _results;
+    uint32_t _results_detect_us = 0;
+    bool _results_fresh = false;
+
+    std::atomic<uint32_t> _submitted{0};
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint32_t> _processed{0};
+};
@@ -0,0 +1,188 @@
+#include "CoffeeMachine_screens.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "display/app_input_latency.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_heap_caps.h"
+#endif
+
+static const char *TAG = "CoffeeMachine_screens";
+
+#define SCREEN_IDLE_BUILD_PERIOD_MS     (100)
+
+static ScreenManager *s_manager;
+static void (*s_prev_monitor_cb)(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
+
+
+const char *screen_id_name(ScreenId id)
+{
+    switch (id) {
+    case ScreenId::MAIN:        return "main";
+    case ScreenId::SETTINGS:    return "settings";
+    case ScreenId::CAMERA:      return "camera";
+    case ScreenId::FACE_NAME:   return "face_name";
+    case ScreenId::FACE_LIST:   return "face_list";
+    case ScreenId::BREWING:     return "brewing";
+    case ScreenId::COUNT:       break;
+    }
+    return "?";
+}
+
+
+// 统计控件树的对象数和本地样式数, 用于对比共享样式
+static void count_tree(lv_obj_t *obj, ScreenStats *stats)
+{
+    stats->objects++;
+    for (uint32_t i = 0; i < obj->style_cnt; i++) {
+        if (obj->styles[i].is_local) {
+            stats->local_styles++;
+        }
+    }
+
+    uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+    for (uint32_t i = 0; i < child_cnt; i++) {
+        count_tree(lv_obj_get_child(obj, i), stats);
+    }
+}
+
+static size_t free_heap(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+#endif
+}
+
+
+ScreenManager::~ScreenManager()
+{
+    if (_idle_timer) {
+        lv_timer_del(_idle_timer);
+        _idle_timer = nullptr;
+    }
+    if (s_manager == this) {
+        s_manager = nullptr;
+    }
+}
+
+void ScreenManager::add(ScreenId id, screen_build_fn_t build, void *user_data, bool prebuild)
+{
+    Screen &screen = _screens[(int)id];
+    screen.build = build;
+    screen.user_data = user_data;
+    screen.prebuild = prebuild;
+}
+
+lv_obj_t *ScreenManager::get(ScreenId id)
+{
+    Screen &screen = _screens[(int)id];
+    if (!screen.obj && screen.build) {
+        size_t heap_before = free_heap();
+        int64_t start_us = esp_timer_get_time();
+        screen.obj = screen.build(screen.user_data);
+        screen.stats.build_us = esp_timer_get_time() - start_us;
+        screen.stats.heap_bytes = (int32_t)(heap_before - free_heap());
+        if (screen.obj) {
+            count_tree(screen.obj, &screen.stats);
+        }
+        ESP_LOGI(TAG, "Screen %s built in %d us, %d objects, %d local styles, %d bytes of heap",
+                 screen_id_name(id), (int)screen.stats.build_us, (int)screen.stats.objects,
+                 (int)screen.stats.local_styles, (int)screen.stats.heap_bytes);
+    }
+    return screen.obj;
+}
+
+void ScreenManager::show(ScreenId id)
+{
+    int64_t start_us = esp_timer_get_time();
+    lv_obj_t *obj = get(id);
+    if (!obj) {
+        ESP_LOGE(TAG, "Screen %s can not be built", screen_id_name(id));
+        return;
+    }
+
+    if (lv_scr_act() != obj) {
+        lv_scr_load(obj);
+    }
+    shown(id, start_us);
+}
+
+void ScreenManager::attach(lv_disp_t *disp)
+{
+    if (disp->driver->monitor_cb != monitorCb) {
+        s_prev_monitor_cb = disp->driver->monitor_cb;
+        disp->driver->monitor_cb = monitorCb;
+    }
+    s_manager = this;
+}
+
+void ScreenManager::shown(ScreenId id, int64_t start_us)
+{
+    // 新界面由正常的刷新周期渲染, 在其 monitor_cb 中结束计时
+#if CONFIG_APP_INPUT_LATENCY_ENABLE
+    app_input_latency_set_screen(screen_id_name(id));
+#endif
+    _pending = id;
+    _pending_start_us = start_us;
+}
+
+void ScreenManager::monitorCb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    if (s_manager && s_manager->_pending != ScreenId::COUNT) {
+        s_manager->finishShow();
+    }
+    if (s_prev_monitor_cb) {
+        s_prev_monitor_cb(drv, time, px);
+    }
+}
+
+void ScreenManager::finishShow(void)
+{
+    ScreenId id = _pending;
+    uint32_t time_us = esp_timer_get_time() - _pending_start_us;
+    _pending = ScreenId::COUNT;
+
+    ScreenStats &stats = _screens[(int)id].stats;
+    stats.shows++;
+    stats.total_us += time_us;
+    stats.last_us = time_us;
+    if (time_us > stats.max_us) {
+        stats.max_us = time_us;
+    }
+
+#if CONFIG_APP_SCREEN_LOG
+    ESP_LOGI(TAG, "Screen %s shown in %d us (avg %d us, max %d us over %d)", screen_id_name(id), (int)time_us,
+             (int)(stats.total_us / stats.shows), (int)stats.max_us, (int)stats.shows);
+#endif
+}
+
+void ScreenManager::startIdleBuild(uint32_t idle_ms)
+{
+    _idle_ms = idle_ms;
+    if (!_idle_timer) {
+        _idle_timer = lv_timer_create(idleBuildTimerCb, SCREEN_IDLE_BUILD_PERIOD_MS, this);
+    }
+}
+
+void ScreenManager::idleBuildTimerCb(lv_timer_t *t)
+{
+    ScreenManager *manager = (ScreenManager *)t->user_data;
+    if (lv_disp_get_inactive_time(NULL) < manager->_idle_ms) {
+        return;
+    }
+
+    // 每次只创建一个界面, 避免长时间占住 LVGL 任务
+    for (int i = 0; i < (int)ScreenId::COUNT; i++) {
+        Screen &screen = manager->_screens[i];
+        if (screen.prebuild && !screen.obj && screen.build) {
+            manager->get((ScreenId)i);
+            return;
+        }
+    }
+
+    ESP_LOGI(TAG, "All screens built");
+    lv_timer_del(manager->_idle_timer);
+    manager->_idle_timer = nullptr;
+}
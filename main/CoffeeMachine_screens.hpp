@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+
+// 常驻界面, BREWING 为 lv_layer_top() 上的制作浮层
+enum class ScreenId : uint8_t {
+    MAIN,
+    SETTINGS,
+    CAMERA,
+    FACE_NAME,
+    FACE_LIST,
+    BREWING,
+    COUNT,
+};
+
+const char *screen_id_name(ScreenId id);
+
+
+typedef lv_obj_t *(*screen_build_fn_t)(void *user_data);
+
+struct ScreenStats {
+    uint32_t build_us;      // 创建控件树的耗时, 0 为尚未创建
+    uint32_t objects;       // 控件树中的对象数
+    uint32_t local_styles;  // 带本地样式的对象/部件数
+    int32_t heap_bytes;     // 创建控件树占用的堆, 模拟器上为 0
+    uint32_t shows;         // 切换到该界面的次数
+    uint64_t total_us;      // 切换耗时合计, 从调用到新界面第一帧刷新完成
+    uint32_t max_us;
+    uint32_t last_us;
+};
+
+/**
+ * Screen manager.
+ *
+ * Every screen is built once, on first use or ahead of time while the user is not touching the
+ * display, and then stays resident: showing a screen only loads it, and the caller updates the
+ * widgets whose content changed. Each transition is timed from the call to the end of the first
+ * LVGL refresh that renders the new screen, seen from the display's monitor callback, so the
+ * timing does not force a render of its own.
+ */
+class ScreenManager
+{
+public:
+    ScreenManager() = default;
+    ~ScreenManager();
+
+    // 链接显示的 monitor_cb, 用于切换计时
+    void attach(lv_disp_t *disp);
+
+    void add(ScreenId id, screen_build_fn_t build, void *user_data, bool prebuild);
+
+    // 返回界面根对象, 尚未创建时立即创建
+    lv_obj_t *get(ScreenId id);
+    bool built(ScreenId id) const { return _screens[(int)id].obj != nullptr; }
+
+    // 加载界面并计时
+    void show(ScreenId id);
+
+    // 调用方自行切换后 (如显示浮层), 记录从 start_us 到下一次刷新完成的耗时
+    void shown(ScreenId id, int64_t start_us);
+
+    // 空闲 idle_ms 后逐个创建标记为 prebuild 的界面, 每个定时周期一个
+    void startIdleBuild(uint32_t idle_ms);
+
+    void getStats(ScreenId id, ScreenStats *stats) const { *stats = _screens[(int)id].stats; }
+
+private:
+    static void idleBuildTimerCb(lv_timer_t *t);
+    static void monitorCb(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
+    void finishShow(void);
+
+    struct Screen {
+        lv_obj_t *obj = nullptr;
+        screen_build_fn_t build = nullptr;
+        void *user_data = nullptr;
+        bool prebuild = false;
+        ScreenStats stats = {};
+    };
+
+    Screen _screens[(int)ScreenId::COUNT];
+    lv_timer_t *_idle_timer = nullptr;
+    uint32_t _idle_ms = 0;
+    ScreenId _pending = ScreenId::COUNT;    // 等待刷新完成计时的界面
+    int64_t _pending_start_us = 0;
+};
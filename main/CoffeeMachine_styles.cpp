@@ -0,0 +1,131 @@
+#include "CoffeeMachine_styles.hpp"
+#include "sdkconfig.h"
+
+
+static lv_style_t s_styles[(int)UiStyle::COUNT];
+static bool s_styles_inited = false;
+
+
+static lv_style_t *init_style(UiStyle id)
+{
+    lv_style_t *style = &s_styles[(int)id];
+    lv_style_init(style);
+    return style;
+}
+
+static void init_text(UiStyle id, uint32_t color, const lv_font_t *font)
+{
+    lv_style_t *style = init_style(id);
+    lv_style_set_text_color(style, lv_color_hex(color));
+    lv_style_set_text_font(style, font);
+}
+
+static void init_button(UiStyle id, uint32_t color, lv_coord_t radius)
+{
+    lv_style_t *style = init_style(id);
+    lv_style_set_bg_color(style, lv_color_hex(color));
+    lv_style_set_radius(style, radius);
+}
+
+static void init_panel(UiStyle id, uint32_t bg_color, lv_coord_t border_width, uint32_t border_color,
+                       lv_coord_t radius, lv_coord_t pad)
+{
+    lv_style_t *style = init_style(id);
+    lv_style_set_bg_color(style, lv_color_hex(bg_color));
+    lv_style_set_border_width(style, border_width);
+    lv_style_set_border_color(style, lv_color_hex(border_color));
+    lv_style_set_radius(style, radius);
+    lv_style_set_pad_all(style, pad);
+}
+
+static void init_styles(void)
+{
+    lv_style_t *style = init_style(UiStyle::HIT_AREA);
+    lv_style_set_bg_opa(style, LV_OPA_TRANSP);
+    lv_style_set_border_width(style, 0);
+    lv_style_set_shadow_width(style, 0);
+    lv_style_set_radius(style, 0);
+    lv_style_set_pad_all(style, 0);
+
+    style = init_style(UiStyle::DIM_LAYER);
+    lv_style_set_bg_color(style, lv_color_black());
+    lv_style_set_bg_opa(style, LV_OPA_70);
+    lv_style_set_border_width(style, 0);
+
+    style = init_style(UiStyle::SCREEN_BLACK);
+    lv_style_set_bg_color(style, lv_color_hex(0x000000));
+
+    style = init_style(UiStyle::SCREEN_DARK);
+    lv_style_set_bg_color(style, lv_color_hex(0x1a1a1a));
+
+    style = init_style(UiStyle::BTN_PRIMARY);
+    lv_style_set_bg_color(style, lv_color_hex(0x0080FF));
+    lv_style_set_bg_opa(style, LV_OPA_COVER);
+    lv_style_set_radius(style, 15);
+    lv_style_set_border_width(style, 2);
+    lv_style_set_border_color(style, lv_color_hex(0xFFFFFF));
+    lv_style_set_shadow_width(style, 10);
+    lv_style_set_shadow_color(style, lv_color_hex(0x000000));
+    lv_style_set_shadow_opa(style, LV_OPA_30);
+
+    init_button(UiStyle::BTN_BACK, 0x0080FF, 15);
+    init_button(UiStyle::BTN_SAVE, 0x00AA00, 12);
+    init_button(UiStyle::BTN_CANCEL, 0xCC0000, 12);
+    init_button(UiStyle::BTN_DELETE, 0xFF0000, 8);
+    init_panel(UiStyle::LIST_PANEL, 0x2a2a2a, 2, 0x444444, 10, 15);
+    init_panel(UiStyle::LIST_ROW, 0x3a3a3a, 1, 0x555555, 8, 10);
+
+    init_text(UiStyle::TEXT_BUTTON, 0xFFFFFF, &lv_font_montserrat_20);
+    style = init_style(UiStyle::TEXT_BUTTON_LARGE);
+    lv_style_set_text_font(style, &lv_font_montserrat_22);
+    init_text(UiStyle::TEXT_TITLE, 0xFFFFFF, &lv_font_montserrat_24);
+    init_text(UiStyle::TEXT_TITLE_LARGE, 0xFFFFFF, &lv_font_montserrat_32);
+    init_text(UiStyle::TEXT_COUNTDOWN, 0xFFFFFF, &lv_font_montserrat_48);
+    init_text(UiStyle::TEXT_STATUS, 0xCCCCCC, &lv_font_montserrat_20);
+    init_text(UiStyle::TEXT_EMPTY, 0x888888, &lv_font_montserrat_24);
+    lv_style_set_text_align(&s_styles[(int)UiStyle::TEXT_EMPTY], LV_TEXT_ALIGN_CENTER);
+    init_text(UiStyle::TEXT_INDEX, 0x0080FF, &lv_font_montserrat_32);
+    init_text(UiStyle::TEXT_DETAIL, 0xAAAAAA, &lv_font_montserrat_18);
+    style = init_style(UiStyle::TEXT_INPUT);
+    lv_style_set_text_font(style, &lv_font_montserrat_18);
+    init_text(UiStyle::TEXT_COFFEE, 0xFFD700, &lv_font_montserrat_20);
+    init_text(UiStyle::TEXT_WATER, 0x1E90FF, &lv_font_montserrat_20);
+
+    style = init_style(UiStyle::SLIDER_COFFEE);
+    lv_style_set_bg_color(style, lv_color_hex(0x8B4513));
+    style = init_style(UiStyle::SLIDER_WATER);
+    lv_style_set_bg_color(style, lv_color_hex(0x1E90FF));
+    style = init_style(UiStyle::SLIDER_MILK);
+    lv_style_set_bg_color(style, lv_color_hex(0xF5F5DC));
+
+    s_styles_inited = true;
+}
+
+#if !CONFIG_APP_UI_SHARED_STYLES
+// 对比用: 把共享样式里用到的属性逐个设为本地样式
+static const lv_style_prop_t s_local_props[] = {
+    LV_STYLE_BG_COLOR, LV_STYLE_BG_OPA, LV_STYLE_RADIUS,
+    LV_STYLE_BORDER_WIDTH, LV_STYLE_BORDER_COLOR,
+    LV_STYLE_SHADOW_WIDTH, LV_STYLE_SHADOW_COLOR, LV_STYLE_SHADOW_OPA,
+    LV_STYLE_PAD_TOP, LV_STYLE_PAD_BOTTOM, LV_STYLE_PAD_LEFT, LV_STYLE_PAD_RIGHT,
+    LV_STYLE_TEXT_COLOR, LV_STYLE_TEXT_FONT, LV_STYLE_TEXT_ALIGN,
+};
+#endif
+
+void ui_style_add(lv_obj_t *obj, UiStyle style, lv_style_selector_t selector)
+{
+    if (!s_styles_inited) {
+        init_styles();
+    }
+
+#if CONFIG_APP_UI_SHARED_STYLES
+    lv_obj_add_style(obj, &s_styles[(int)style], selector);
+#else
+    for (lv_style_prop_t prop : s_local_props) {
+        lv_style_value_t value;
+        if (lv_style_get_prop(&s_styles[(int)style], prop, &value) == LV_RES_OK) {
+            lv_obj_set_local_style_prop(obj, prop, value, selector);
+        }
+    }
+#endif
+}
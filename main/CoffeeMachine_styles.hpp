@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include "lvgl.h"
+
+
+// 界面共用的样式, 按引用添加到控件上
+enum class UiStyle : uint8_t {
+    HIT_AREA,           // 透明触摸区: 无背景、边框、阴影、圆角和内边距
+    DIM_LAYER,          // 制作浮层的 70% 黑色遮罩
+    SCREEN_BLACK,
+    SCREEN_DARK,
+    BTN_PRIMARY,        // 相机界面的蓝色按钮, 带白边和阴影
+    BTN_BACK,
+    BTN_SAVE,
+    BTN_CANCEL,
+    BTN_DELETE,
+    LIST_PANEL,
+    LIST_ROW,
+    TEXT_BUTTON,        // 白色 20 号
+    TEXT_BUTTON_LARGE,  // 22 号, 颜色随主题
+    TEXT_TITLE,         // 白色 24 号
+    TEXT_TITLE_LARGE,   // 白色 32 号
+    TEXT_COUNTDOWN,     // 白色 48 号
+    TEXT_STATUS,
+    TEXT_EMPTY,
+    TEXT_INDEX,
+    TEXT_DETAIL,
+    TEXT_INPUT,
+    TEXT_COFFEE,
+    TEXT_WATER,
+    SLIDER_COFFEE,      // 以下用于 LV_PART_INDICATOR
+    SLIDER_WATER,
+    SLIDER_MILK,
+    COUNT,
+};
+
+/**
+ * Add a shared style to an object.
+ *
+ * The styles are static and initialized on first use, so a hundred widgets of the same kind
+ * share one style instead of each carrying local style storage that LVGL allocates and looks
+ * through on every redraw. With CONFIG_APP_UI_SHARED_STYLES disabled the same properties are
+ * set as local styles, to compare the heap and render time of both.
+ */
+void ui_style_add(lv_obj_t *obj, UiStyle style, lv_style_selector_t selector = 0);
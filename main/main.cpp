@@ -4,6 +4,7 @@
 #include "freertos/task.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "bsp/esp-bsp.h"
 #include "CoffeeMachine.hpp"
@@ -77,7 +78,7 @@ extern "C" void app_main(void)
     
     assert(coffee_machine->init() && "Failed to initialize coffee machine UI");
     
-    ESP_LOGI(TAG, "Coffee Machine UI started successfully");
+    ESP_LOGI(TAG, "Coffee Machine UI started successfully, %d ms after boot", (int)(esp_timer_get_time() / 1000));
 
     
     bsp_display_unlock();